@@ -9,11 +9,22 @@
 #include "UI/UIManager.h"
 #include "Grid.h"
 #include "Axes.h"
+#include "DifferenceImage.h"
+#include "ImageFilter.h"
 #include "ImageLoader.h"
+#include "PhaseCorrelation.h"
+#include "PreviewEngine.h"
+#include "Reprojector.h"
+#include "SourceDetector.h"
+#include "TargetPrefetcher.h"
+#include <chrono>
+#include <future>
 #include <vector>
 #include <string>
 
 class GeometryObject;
+class ImageSurface;
+class LabelDataBrowser;
 
 class Application {
 public:
@@ -36,11 +47,46 @@ public:
     void RemoveImagePoints(const std::string& filepath);
     void Render3DLabels();
 
+    // Far-view LOD for image layers: draw a textured surface, switching to real points
+    // per chunk once one image pixel projects to at least the threshold (screen pixels).
+    bool IsImageLodEnabled() const { return m_ImageLodEnabled; }
+    void SetImageLodEnabled(bool enabled) { m_ImageLodEnabled = enabled; }
+    float GetImageLodThresholdPx() const { return m_ImageLodThresholdPx; }
+    void SetImageLodThresholdPx(float px) { m_ImageLodThresholdPx = px; }
+
 private:
     void Update(float deltaTime);
     void Render();
     void RenderFitsRoiPreviewWindow();
     void CenterCameraOnPixelInCurrentImage(int pixelX, int pixelY);
+    // Make path the current image, through the prefetch cache.
+    bool LoadCurrentImage(const std::string& path);
+    // Queue the neighbours of the label target just shown.
+    void SchedulePrefetch(LabelDataBrowser* labelBrowser);
+    // Rebuild the aligned - template point cloud over the ROI (or whole frame) on a worker.
+    void UpdateDifferenceLayer(LabelDataBrowser* labelBrowser, bool useRoi, int roiX, int roiY, int roiRadius);
+    // Show a finished difference layer, or start the one queued behind it.
+    void PollDifferenceLayer(LabelDataBrowser* labelBrowser);
+    // Resample the template onto the aligned grid on a worker when enabled (cached while
+    // the pair, interpolation and a covering region stay the same). Until it lands the
+    // template shows as loaded.
+    void UpdateReprojectedTemplate(LabelDataBrowser* labelBrowser, const std::string& templatePath, bool useRoi,
+                                   int roiX, int roiY, int roiRadius);
+    // Take over a finished resampling and redraw the template and difference with it.
+    void PollReprojectedTemplate(LabelDataBrowser* labelBrowser);
+    // Redraw images in m_FilterPending whose filtered full frame is ready.
+    void PollFilteredImages();
+    // Source detection / snap-to-source requested in the label browser.
+    void HandleSourceRequest(LabelDataBrowser* labelBrowser);
+    // Hand a finished whole-frame detection to the browser; drops the browser's sources
+    // once the image they were found on is replaced.
+    void PollSourceDetection(LabelDataBrowser* labelBrowser);
+    // Phase-correlation shift at the preview center, and the txt-wide batch check.
+    void UpdateRegistration(LabelDataBrowser* labelBrowser);
+    // ROI mean/std/SNR of the aligned and template images (summed-area lookups, every frame).
+    void UpdateRoiStatistics(LabelDataBrowser* labelBrowser);
+    // Histogram plots of the preview crops (or whole images) around their levels.
+    void UpdateHistogramViews(LabelDataBrowser* labelBrowser);
 
     void LoadImageAndGeneratePointsInternal(const std::string& filepath,
                                             bool replaceExisting,
@@ -48,13 +94,16 @@ private:
                                             int roiPixelX,
                                             int roiPixelY,
                                             int roiRadiusPixels,
-                                            bool useHighlight,
-                                            int highlightCenterX,
-                                            int highlightCenterY,
-                                            int highlightSizePixels,
-                                            const glm::vec4& highlightColor,
-                                            float highlightPointSizeScale,
-                                            int previewSlot /*0:none, 1:aligned, 2:template*/);
+                                            const std::vector<ImageLoader::PointHighlight>& highlights,
+                                            int previewSlot /*0:none, 1:aligned, 2:template*/,
+                                            int previewSizePixels);
+
+    // heights: the image the points came from (filtered, possibly binned).
+    std::shared_ptr<ImageSurface> CreateImageSurfaceFromCurrentImage(const std::string& filepath,
+                                                                     const ImageLoader& heights,
+                                                                     int x0, int y0, int x1, int y1,
+                                                                     float scaleX, float scaleY, float scaleZ);
+    void UpdateImageLayerLod();
 
     void UpdatePreviewTextureFromCurrentImage(int previewSlot,
                                               const std::string& filepath,
@@ -62,7 +111,8 @@ private:
                                               int cropCenterY,
                                               int cropSizePixels,
                                               const glm::vec4& tintColor,
-                                              float tintAlpha);
+                                              float tintAlpha,
+                                              const std::vector<unsigned char>* prebuiltRGBA = nullptr);
 
     std::unique_ptr<Window> m_Window;
     std::unique_ptr<Renderer> m_Renderer;
@@ -71,7 +121,10 @@ private:
     std::unique_ptr<UIManager> m_UIManager;
     std::unique_ptr<Grid> m_Grid;
     std::unique_ptr<Axes> m_Axes;
-    std::unique_ptr<ImageLoader> m_ImageLoader;
+    std::unique_ptr<TargetPrefetcher> m_Prefetcher;
+    std::shared_ptr<const ImageLoader> m_ImageLoader; // current image (shared with the prefetch cache)
+    std::shared_ptr<const ImageLoader> m_AlignedImage;  // last image shown in preview slot 1
+    std::shared_ptr<const ImageLoader> m_TemplateImage; // last image shown in preview slot 2
 
     std::vector<std::shared_ptr<GeometryObject>> m_GeometryObjects;
     std::map<std::string, std::vector<std::shared_ptr<GeometryObject>>> m_ImagePointsMap;
@@ -80,22 +133,85 @@ private:
     float m_LastFrameTime;
     bool m_HasFramedView;
 
+    bool m_ImageLodEnabled;
+    float m_ImageLodThresholdPx;
+
     // ROI preview textures (aligned/template)
-    unsigned int m_AlignedPreviewTex;
-    unsigned int m_TemplatePreviewTex;
-    int m_AlignedPreviewSize;
-    int m_TemplatePreviewSize;
-    int m_AlignedPreviewCenterX;
-    int m_AlignedPreviewCenterY;
-    int m_TemplatePreviewCenterX;
-    int m_TemplatePreviewCenterY;
+    PreviewEngine m_AlignedPreview;
+    PreviewEngine m_TemplatePreview;
+    Histogram::LevelsPreset m_LevelsPreset;
+    ImageLoader::HeightMode m_HeightMode; // point heights, from the label browser
+    ImageFilter::Params m_ImageFilter;    // applied before point generation
+    DifferenceImage m_Difference; // owned by m_DifferenceRun while it is valid
+    // Tile fit, subtraction and points of one difference layer update.
+    struct DifferenceRequest {
+        std::shared_ptr<const ImageLoader> aligned;
+        std::shared_ptr<const ImageLoader> templ;
+        DifferenceImage::Params params;
+        int x0{0}, y0{0}, x1{-1}, y1{-1};
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec4> colors;
+        DifferenceImage::Fit fit;
+        int computed{0};
+        std::size_t cachedTiles{0};
+        double milliseconds{0.0};
+    };
+    // Like the reprojection: a newer request waits in m_DifferenceQueued (no aligned = none).
+    std::future<DifferenceRequest> m_DifferenceRun;
+    DifferenceRequest m_DifferenceQueued;
+    void StartDifference(DifferenceRequest request);
+    // Template resampled onto the aligned grid; replaces the template file's image.
+    struct ReprojectedTemplate {
+        std::string path;
+        std::shared_ptr<const ImageLoader> source; // template as loaded
+        std::shared_ptr<const ImageLoader> target; // aligned image that gave the grid
+        Reprojector::Interpolation interpolation{Reprojector::Interpolation::Lanczos3};
+        int x0{0}, y0{0}, x1{-1}, y1{-1};
+        std::shared_ptr<const ImageLoader> image;
+        ImageFilter::Params filter;                  // what filtered was made with
+        std::shared_ptr<const ImageLoader> filtered; // image after the point filter
+        double milliseconds{0.0};
+    };
+    ReprojectedTemplate m_Reprojected;
+    // Resampling on a worker; it cannot be interrupted, so a newer request waits in
+    // m_ReprojectQueued (no source = none).
+    std::future<ReprojectedTemplate> m_ReprojectRun;
+    ReprojectedTemplate m_ReprojectQueued;
+    // Resample request.source onto request.target's grid in m_ReprojectRun, then point-filter
+    // the region; a request that already has its image is only filtered.
+    void StartReprojection(ReprojectedTemplate request);
+    // How an image was last drawn, to redraw it once its resampling or filter lands.
+    struct PointsLoad {
+        std::string path;
+        bool useRoi{false};
+        int roiX{0}, roiY{0}, roiRadius{0};
+        std::vector<ImageLoader::PointHighlight> highlights;
+        int previewSlot{0};
+        int previewSize{0};
+        ImageFilter::Params filter; // the full-frame filter awaited (m_FilterPending)
+    };
+    PointsLoad m_TemplateLoad;
+    // Whole-frame source detection on a worker, on m_SourceRunImage.
+    std::future<std::vector<SourceDetector::Source>> m_SourceRun;
+    std::shared_ptr<const ImageLoader> m_SourceRunImage;
+    std::chrono::steady_clock::time_point m_SourceRunStart;
+    const ImageLoader* m_SourcesImage; // image the browser's source list was found on
+    // Drawn unfiltered while the prefetch worker filters their full frame.
+    std::vector<PointsLoad> m_FilterPending;
+    PhaseCorrelation::Result m_Registration; // aligned vs template at the preview center
+    const ImageLoader* m_RegistrationImages[2]; // the pair m_Registration was measured on
+    RegistrationBatch m_RegistrationBatch;
+    std::string m_RegistrationTxtPath;       // txt the running batch belongs to
+    std::chrono::steady_clock::time_point m_RegistrationStart;
     bool m_HasAlignedPreviewClick;
     bool m_HasTemplatePreviewClick;
     int m_AlignedPreviewClickX;
     int m_AlignedPreviewClickY;
     int m_TemplatePreviewClickX;
     int m_TemplatePreviewClickY;
-    std::string m_AlignedPreviewName;
-    std::string m_TemplatePreviewName;
+    // Dragging a preview pans both crops live; a press without movement picks a center.
+    bool m_PreviewDragMoved;
+    int m_PreviewDragStartX;
+    int m_PreviewDragStartY;
 };
 
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class ImageLoader;
+
+// SExtractor-style sky background: the image is split into a mesh of cells, each cell's
+// sky level is a sigma-clipped mode estimate (with its scatter as the rms), the mesh is
+// median-filtered to drop cells dominated by bright sources, and per-pixel values are
+// bicubic (Catmull-Rom) interpolations between cell centers. Only the mesh is stored.
+// Blank pixels are left out; mostly blank cells take their neighbours' values.
+// Values are normalized like ImageLoader::GetNormalizedPixelValue.
+class BackgroundMap {
+public:
+    struct Params {
+        int meshSize{64};       // cell edge in pixels
+        int filterSize{3};      // median filter over filterSize^2 cells (1 = off)
+        float clipSigma{3.0f};  // clip around the median at this many sigma
+        int maxIterations{10};
+    };
+
+    BackgroundMap();
+
+    void Build(const ImageLoader& image);
+    void Build(const ImageLoader& image, const Params& params);
+    void Clear();
+
+    bool IsEmpty() const { return m_MeshWidth == 0 || m_MeshHeight == 0; }
+    int GetMeshWidth() const { return m_MeshWidth; }
+    int GetMeshHeight() const { return m_MeshHeight; }
+    std::size_t GetMemoryBytes() const;
+
+    // Interpolated sky level and sky rms at pixel (x, y).
+    float GetBackground(int x, int y) const { return Interpolate(m_Level, x, y); }
+    float GetRms(int x, int y) const { return Interpolate(m_Rms, x, y); }
+    // Median of the filtered mesh: the image's typical sky level.
+    float GetGlobalLevel() const { return m_GlobalLevel; }
+    float GetGlobalRms() const { return m_GlobalRms; }
+
+private:
+    float Interpolate(const std::vector<float>& mesh, int x, int y) const;
+
+    int m_Width;
+    int m_Height;
+    int m_MeshWidth;
+    int m_MeshHeight;
+    float m_CellWidth;  // image width / mesh width
+    float m_CellHeight;
+    std::vector<float> m_Level; // mesh, row-major
+    std::vector<float> m_Rms;
+    float m_GlobalLevel;
+    float m_GlobalRms;
+};
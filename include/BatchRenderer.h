@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Data/TxtTargetParser.h"
+#include "ImageLoader.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+template <typename T> class BoundedQueue;
+
+struct BatchRenderOptions {
+    std::string labelRoot;
+    std::string outDir;
+    int width{1024};
+    int height{768};
+    int roiRadiusPixels{200};
+    int highlightSizePixels{10};
+    float highlightPointSizeScale{4.0f};
+    int previewSizePixels{100};
+    ImageLoader::HeightMode heightMode{ImageLoader::HeightMode::Display};
+    bool useCpuRasterizer{false};
+    int threads{0}; // 0 = all cores
+};
+
+// Command-line snapshot mode: renders the ROI point cloud (fixed camera presets) and the
+// 2D preview crops of every target in every label txt under labelRoot to PNG files.
+// Work flows through bounded queues: decode -> generate (parallel) -> render (one GL
+// context, or the CPU rasterizer) -> PNG encode (parallel).
+class BatchRenderer {
+public:
+    explicit BatchRenderer(const BatchRenderOptions& options);
+    ~BatchRenderer();
+
+    // Returns a process exit code.
+    int Run();
+
+private:
+    // All targets of one txt that share an aligned/template pair; the pair is decoded once.
+    struct PairJob {
+        std::string outSubdir;
+        std::string alignedPath;
+        std::string templatePath;
+        std::vector<TxtTargetRecord> targets;
+    };
+
+    struct DecodedPair {
+        PairJob job;
+        std::shared_ptr<ImageLoader> aligned;
+        std::shared_ptr<ImageLoader> templ;
+    };
+
+    struct TargetItem {
+        std::shared_ptr<DecodedPair> pair;
+        std::size_t targetIndex{0};
+    };
+
+    // Point cloud of one side (aligned/template) of one target, ready to draw.
+    struct RenderItem {
+        std::string outPrefix;
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec4> colors;
+        std::vector<std::uint8_t> groups;
+        glm::vec3 center{0.0f};
+    };
+
+    struct EncodeJob {
+        std::string path;
+        int width{0};
+        int height{0};
+        bool flipVertically{false};
+        std::vector<unsigned char> rgba;
+    };
+
+    void CollectJobs(std::vector<PairJob>& jobs) const;
+    void GenerateTarget(const TargetItem& item,
+                        std::vector<RenderItem>& renderItems,
+                        std::vector<EncodeJob>& crops) const;
+    bool RenderStage(BoundedQueue<RenderItem>& renderQueue, BoundedQueue<EncodeJob>& encodeQueue);
+
+    BatchRenderOptions m_Options;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// Blocking FIFO with a fixed capacity, used between pipeline stages so a fast producer
+// cannot run ahead and hold unbounded memory.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : m_Capacity(capacity > 0 ? capacity : 1), m_Closed(false) {}
+
+    // Blocks while full. Returns false if the queue was closed.
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_NotFull.wait(lock, [this]() { return m_Closed || m_Items.size() < m_Capacity; });
+        if (m_Closed) return false;
+        m_Items.push_back(std::move(item));
+        m_NotEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks while empty. Returns false once the queue is closed and drained.
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_NotEmpty.wait(lock, [this]() { return m_Closed || !m_Items.empty(); });
+        if (m_Items.empty()) return false;
+        item = std::move(m_Items.front());
+        m_Items.pop_front();
+        m_NotFull.notify_one();
+        return true;
+    }
+
+    // No more pushes; consumers drain what is left.
+    void Close() {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Closed = true;
+        m_NotEmpty.notify_all();
+        m_NotFull.notify_all();
+    }
+
+private:
+    std::size_t m_Capacity;
+    bool m_Closed;
+    std::deque<T> m_Items;
+    std::mutex m_Mutex;
+    std::condition_variable m_NotEmpty;
+    std::condition_variable m_NotFull;
+};
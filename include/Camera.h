@@ -21,6 +21,7 @@ public:
     glm::mat4 GetProjectionMatrix() const;
 
     void SetFOV(float fov) { m_FOV = fov; UpdateProjectionMatrix(); }
+    float GetFOV() const { return m_FOV; }
     void SetAspectRatio(float aspectRatio) { m_AspectRatio = aspectRatio; UpdateProjectionMatrix(); }
 
     void Rotate(float yaw, float pitch);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Camera;
+class PointCloud;
+
+// Software point renderer for hosts without a GPU. Points are projected with the same
+// model/view/projection matrices as the GL point shader, binned into screen tiles, and
+// splatted as squares with a GL_LESS depth test; tiles are processed in parallel.
+// Only point clouds are drawn (no grid, axes or surfaces).
+class CpuPointRasterizer {
+public:
+    CpuPointRasterizer();
+
+    void Resize(int width, int height);
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+
+    void Clear(const glm::vec4& color);
+
+    // Draws the points PointCloud::Render would: same draw budget, visible chunks, group
+    // sizes and order. Needs the cloud's chunk layout (PrepareChunks() or Initialize());
+    // without it every point is drawn.
+    void DrawPointCloud(const PointCloud& cloud, const Camera& camera);
+
+    // groups may be empty (all group 0); groupSizes holds PointCloud::kMaxPointGroups sizes.
+    void DrawPoints(const std::vector<glm::vec3>& positions,
+                    const std::vector<glm::vec4>& colors,
+                    const std::vector<std::uint8_t>& groups,
+                    const float* groupSizes,
+                    const glm::mat4& model,
+                    const glm::mat4& view,
+                    const glm::mat4& projection);
+
+    // RGBA8, row 0 at the bottom (same layout as glReadPixels).
+    const std::vector<unsigned char>& GetColorBuffer() const { return m_Color; }
+    const std::vector<float>& GetDepthBuffer() const { return m_Depth; }
+
+private:
+    // A projected point ready for splatting.
+    struct Splat {
+        float x, y;       // window coordinates
+        float depth;      // [0, 1]
+        float halfSize;   // half point size in pixels
+        std::uint32_t rgba;
+    };
+
+    void ProjectRange(std::size_t begin, std::size_t end,
+                      const std::vector<glm::vec3>& positions,
+                      const std::vector<glm::vec4>& colors,
+                      const std::vector<std::uint8_t>& groups,
+                      const float* groupSizes,
+                      const glm::mat4& mvp,
+                      std::vector<Splat>& out) const;
+    void RasterizeTile(int tileIndex, const std::vector<std::vector<Splat>>& splatsPerWorker,
+                       const std::vector<std::vector<std::vector<std::uint32_t>>>& binsPerWorker);
+
+    int m_Width;
+    int m_Height;
+    int m_TilesX;
+    int m_TilesY;
+
+    std::vector<unsigned char> m_Color;
+    std::vector<float> m_Depth;
+
+    // Points gathered from a cloud's draw ranges, reused across DrawPointCloud calls.
+    std::vector<glm::vec3> m_DrawPositions;
+    std::vector<glm::vec4> m_DrawColors;
+    std::vector<std::uint8_t> m_DrawGroups;
+    std::vector<int> m_DrawFirsts;
+    std::vector<int> m_DrawCounts;
+};
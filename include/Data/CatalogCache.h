@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Data/TargetCatalog.h"
+#include <filesystem>
+#include <string>
+
+// Versioned binary snapshot of a TargetCatalog (source files with size/mtime, the
+// directory listings, both string pools and the raw columns). Loading it is a handful
+// of bulk copies, so the browser can show the catalog before the root is re-walked.
+class CatalogCache {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    // <cwd>/catalog_cache/<hash of the absolute root>.bin
+    static std::filesystem::path GetCachePath(const std::filesystem::path& root);
+
+    // Written to a temporary file and renamed into place.
+    static bool Save(const TargetCatalog& catalog, const std::filesystem::path& file, std::string& outError);
+    // Fails (without touching catalog) on a missing file, another version, another
+    // root or a truncated file.
+    static bool Load(const std::filesystem::path& file, const std::filesystem::path& root,
+                     TargetCatalog& catalog, std::string& outError);
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Directory listings for the browser panels, produced off the UI thread. A listing is
+// requested on first use and filled in batches, so callers can show it while the scan
+// is still running. Listed directories are watched (inotify on Linux, a modification
+// time poll elsewhere) and their listings are patched in place when entries change.
+class DirectoryScanner {
+public:
+    struct Entry {
+        std::string name;
+        bool isDirectory{false};
+        std::uintmax_t size{0};
+    };
+
+    DirectoryScanner();
+    ~DirectoryScanner();
+
+    DirectoryScanner(const DirectoryScanner&) = delete;
+    DirectoryScanner& operator=(const DirectoryScanner&) = delete;
+
+    // Current listing of dir (directories first, then by name). The first call for a
+    // directory queues its scan. Returns true once the listing is complete.
+    bool GetListing(const std::filesystem::path& dir, std::vector<Entry>& outEntries);
+    // Queue a full re-list of dir.
+    void Rescan(const std::filesystem::path& dir);
+    // Drop every listing and watch; directories are scanned again on their next use.
+    void Clear();
+    // Drop the listings and watches of every directory not in keep (e.g. folders the
+    // browser no longer shows). They are scanned again on their next use.
+    void Retain(const std::vector<std::filesystem::path>& keep);
+
+    // Bumped whenever any listing changes (scan progress or a notification).
+    std::uint64_t GetGeneration() const { return m_Generation.load(); }
+    // Bumped only for changes seen on disk after a listing was complete.
+    std::uint64_t GetChangeGeneration() const { return m_ChangeGeneration.load(); }
+    bool IsScanning() const { return m_Scanning.load(); }
+
+private:
+    struct Listing {
+        std::map<std::string, Entry> entries;
+        bool complete{false};
+        std::filesystem::file_time_type writeTime;
+        int watch{-1};
+    };
+
+    void WorkerLoop();
+    void ScanDirectory(const std::string& dir);
+    void PollChanges();
+    void UpdateEntry(const std::string& dir, const std::string& name, bool removed);
+    void DropListing(const std::string& dir);
+
+    // Guarded by m_Mutex.
+    std::unordered_map<std::string, Listing> m_Listings;
+    std::unordered_map<int, std::string> m_WatchDirs;
+    std::deque<std::string> m_Pending;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Cv;
+    std::atomic<bool> m_Stop;
+    std::atomic<bool> m_Scanning;
+    std::atomic<std::uint64_t> m_Generation;
+    std::atomic<std::uint64_t> m_ChangeGeneration;
+    int m_NotifyFd;
+    std::thread m_Worker;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Filename -> path index over a set of root directories, used to find FITS files that a
+// label txt references by a path from another machine (e.g. E:\fix_data\...).
+// The index is built on a background thread; later refreshes only re-list directories
+// whose modification time changed. Lookups are a hash-map probe.
+class FileIndex {
+public:
+    FileIndex();
+    ~FileIndex();
+
+    FileIndex(const FileIndex&) = delete;
+    FileIndex& operator=(const FileIndex&) = delete;
+
+    // Replace the roots and rebuild in the background. Earlier roots win when the same
+    // filename exists under several of them.
+    void SetRoots(const std::vector<std::filesystem::path>& roots);
+    // Add one root; already indexed directories are kept.
+    void AddRoot(const std::filesystem::path& root);
+
+    // Re-list changed directories in the background. Cheap to call repeatedly.
+    void RequestRefresh();
+
+    // True once every root has been scanned at least once.
+    bool IsReady() const { return m_Ready.load(); }
+    // Block until IsReady() or the timeout expires. Returns IsReady().
+    bool WaitUntilReady(std::chrono::milliseconds timeout = std::chrono::milliseconds(60000));
+
+    // Look up a bare filename. Never blocks: while the first build is running a miss only
+    // means "not indexed yet" (check IsReady() and retry later). After that, a miss
+    // schedules a (throttled) background refresh so files copied in later are found.
+    bool Find(const std::string& filename, std::filesystem::path& outPath);
+
+    std::size_t GetFileCount() const;
+    std::size_t GetDirectoryCount() const;
+
+    // Prefix remap rules, e.g. "E:\fix_data" -> "/data/fix_data". Matching ignores the
+    // separator style and, for the source prefix, letter case.
+    void AddPrefixRemap(const std::string& from, const std::string& to);
+    void ClearPrefixRemaps();
+    // One rule per line: <from>=<to>. Blank lines and '#' comments are ignored.
+    bool LoadPrefixRemapFile(const std::filesystem::path& file);
+    // Rules separated by ';', same <from>=<to> form (used for an environment variable).
+    void AddPrefixRemapList(const std::string& rules);
+    // Returns true and the rewritten path if a rule matched.
+    bool ApplyPrefixRemap(const std::string& path, std::filesystem::path& outPath) const;
+
+    // Last path component, accepting both '/' and '\' as separators on every platform.
+    static std::string FilenameOf(const std::string& path);
+
+private:
+    struct DirectoryState {
+        std::filesystem::file_time_type writeTime;
+        int rootIndex{0};
+        std::vector<std::string> files;
+        std::vector<std::filesystem::path> subdirectories;
+    };
+
+    struct IndexedFile {
+        std::filesystem::path path;
+        int rootIndex{0};
+    };
+
+    void StartWorker();
+    void WorkerLoop();
+    void ScanPass(const std::vector<std::filesystem::path>& roots);
+    void RefreshKnownDirectories();
+    void ScanDirectoryTree(const std::filesystem::path& dir, int rootIndex);
+    bool ListDirectory(const std::filesystem::path& dir, int rootIndex, DirectoryState& outState) const;
+    void RemoveDirectoryTree(const std::filesystem::path& dir);
+    void IndexDirectory(const std::filesystem::path& dir, const DirectoryState& state);
+    void UnindexDirectory(const std::filesystem::path& dir, const DirectoryState& state);
+
+    // Roots, generation and the request flags are guarded by m_WorkerMutex.
+    std::vector<std::filesystem::path> m_Roots;
+    unsigned int m_RootsGeneration;
+    bool m_ScanRequested;
+    bool m_ResetRequested; // SetRoots: drop the old index before the next pass
+    std::atomic<bool> m_StopWorker;
+    std::thread m_Worker;
+    std::mutex m_WorkerMutex;
+    std::condition_variable m_WorkerCv;
+    std::condition_variable m_ReadyCv;
+    std::atomic<bool> m_Ready;
+    std::chrono::steady_clock::time_point m_LastMissRefresh;
+
+    // Index state; written by the worker, read by lookups.
+    mutable std::shared_mutex m_IndexMutex;
+    std::map<std::filesystem::path, DirectoryState> m_Directories;
+    std::unordered_map<std::string, std::vector<IndexedFile>> m_FilesByName;
+    std::size_t m_FileCount;
+
+    mutable std::mutex m_RemapMutex;
+    std::vector<std::pair<std::string, std::string>> m_PrefixRemaps; // normalized from, raw to
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file (mmap / MapViewOfFile). Parsers read
+// straight from the mapping instead of copying the file through a stream.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::filesystem::path& path, std::string& outError);
+    void Close();
+
+    bool IsOpen() const { return m_Open; }
+    const char* GetData() const { return m_Data; }
+    std::size_t GetSize() const { return m_Size; }
+    std::string_view GetView() const { return std::string_view(m_Data, m_Size); }
+
+private:
+    const char* m_Data;
+    std::size_t m_Size;
+    bool m_Open;
+#ifdef _WIN32
+    void* m_FileHandle;
+    void* m_MappingHandle;
+#else
+    int m_Fd;
+#endif
+};
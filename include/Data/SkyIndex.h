@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Static k-d tree over RA/Dec positions stored as unit vectors, so distances have no
+// RA wrap-around or pole singularities. Cone searches prune by the chord length;
+// RA/Dec box searches prune node bounds against the dec slab and the RA half-planes.
+class SkyIndex {
+public:
+    struct Entry {
+        double ra{0.0};  // degrees
+        double dec{0.0}; // degrees
+        std::uint32_t id{0};
+    };
+
+    struct Match {
+        std::uint32_t id{0};
+        double separationArcsec{0.0};
+    };
+
+    SkyIndex();
+
+    void Build(const std::vector<Entry>& entries);
+    void Clear();
+
+    std::size_t GetPointCount() const { return m_Points.size(); }
+
+    // Everything within radiusArcsec of (ra, dec), nearest first.
+    void QueryCone(double raDeg, double decDeg, double radiusArcsec, std::vector<Match>& outMatches) const;
+
+    // ids inside the box (inclusive, unordered). raMin > raMax wraps through 0/360.
+    void QueryBox(double raMinDeg, double raMaxDeg, double decMinDeg, double decMaxDeg,
+                  std::vector<std::uint32_t>& outIds) const;
+
+    // Great-circle separation in arcseconds.
+    static double SeparationArcsec(double ra1Deg, double dec1Deg, double ra2Deg, double dec2Deg);
+
+private:
+    struct Point {
+        double v[3];
+        double ra;
+        double dec;
+        std::uint32_t id;
+    };
+
+    // Leaves hold points [begin, end); inner nodes have two children.
+    struct Node {
+        float boundsMin[3];
+        float boundsMax[3];
+        std::uint32_t begin;
+        std::uint32_t end;
+        std::uint32_t left;  // 0 = leaf (the root is never a child)
+        std::uint32_t right;
+    };
+
+    std::uint32_t BuildNode(std::uint32_t begin, std::uint32_t end);
+    void QueryBoxRange(double raMinDeg, double raMaxDeg, double decMinDeg, double decMaxDeg,
+                       std::vector<std::uint32_t>& outIds) const;
+
+    std::vector<Point> m_Points;
+    std::vector<Node> m_Nodes;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interning dictionary: every distinct string is stored once and referred to by a
+// 32-bit id. Strings live in a deque so the views used as map keys stay valid.
+class StringPool {
+public:
+    static constexpr std::uint32_t kInvalidId = 0xFFFFFFFFu;
+
+    std::uint32_t Intern(std::string_view s) {
+        auto it = m_Ids.find(s);
+        if (it != m_Ids.end()) return it->second;
+        const std::uint32_t id = static_cast<std::uint32_t>(m_Strings.size());
+        m_Strings.emplace_back(s);
+        m_Bytes += s.size();
+        m_Ids.emplace(std::string_view(m_Strings.back()), id);
+        return id;
+    }
+
+    // kInvalidId if s was never interned.
+    std::uint32_t Find(std::string_view s) const {
+        auto it = m_Ids.find(s);
+        return it != m_Ids.end() ? it->second : kInvalidId;
+    }
+
+    const std::string& Get(std::uint32_t id) const { return m_Strings[id]; }
+    std::size_t Size() const { return m_Strings.size(); }
+
+    // Approximate heap footprint (characters, string headers and hash buckets).
+    std::size_t GetMemoryBytes() const {
+        return m_Bytes + m_Strings.size() * (sizeof(std::string) + sizeof(std::string_view) + 2 * sizeof(void*)) +
+               m_Ids.bucket_count() * sizeof(void*);
+    }
+
+    void Clear() {
+        m_Ids.clear();
+        m_Strings.clear();
+        m_Bytes = 0;
+    }
+
+private:
+    std::deque<std::string> m_Strings;
+    std::unordered_map<std::string_view, std::uint32_t> m_Ids;
+    std::size_t m_Bytes{0};
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "Data/SkyIndex.h"
+#include "Data/StringPool.h"
+#include "Data/TxtTargetParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every target of every label txt under a root, stored column by column
+// (structure of arrays). Directory and file names are interned, so a row costs a few
+// dozen bytes instead of four heap strings. Rows of one txt are contiguous.
+class TargetCatalog {
+public:
+    enum class Label : std::uint8_t {
+        Unknown = 0,
+        Good = 1,
+        Bad = 2,
+    };
+
+    struct SourceFile {
+        std::filesystem::path path;
+        std::string relativePath; // generic form, relative to the root
+        Label label{Label::Unknown};
+        std::uint32_t firstRow{0};
+        std::uint32_t rowCount{0};
+        std::uintmax_t size{0};
+        std::filesystem::file_time_type writeTime;
+    };
+
+    // Listing of one directory under the root, captured by the same walk that finds the
+    // txt files. Directories first, then by name (the browser tree order).
+    struct DirectoryEntry {
+        std::string name;
+        bool isDirectory{false};
+        std::uintmax_t size{0};
+    };
+
+    struct DirectoryListing {
+        std::string relativePath; // generic form, "" for the root
+        std::vector<DirectoryEntry> entries;
+    };
+
+    struct UpdateStats {
+        std::size_t reusedFiles{0};
+        std::size_t parsedFiles{0};
+        std::size_t removedFiles{0};
+        bool IsUnchanged() const { return parsedFiles == 0 && removedFiles == 0; }
+    };
+
+    // Filters are ANDed; disabled ones are ignored.
+    struct Query {
+        bool good{true};
+        bool bad{true};
+        bool unknown{true};
+        // Observation date as YYYYMMDD, inclusive; 0 = open end.
+        std::uint32_t dateMin{0};
+        std::uint32_t dateMax{0};
+        // Pixel rectangle, inclusive; rows without a pixel center never match.
+        bool usePixelRegion{false};
+        int pixelXMin{0};
+        int pixelXMax{10000};
+        int pixelYMin{0};
+        int pixelYMax{10000};
+        // Degrees, inclusive. raMin > raMax wraps through 0/360.
+        bool useRaDecRange{false};
+        double raMin{0.0};
+        double raMax{360.0};
+        double decMin{-90.0};
+        double decMax{90.0};
+        // Restrict to one source txt; -1 = all.
+        int sourceFile{-1};
+    };
+
+    TargetCatalog();
+
+    // Load every *.txt under root (recursively). Replaces the current contents.
+    // Returns false if the root cannot be scanned; unreadable txt files are skipped.
+    bool LoadFromRoot(const std::filesystem::path& root, std::string& outError);
+    // Same, but rows of txt files whose size and mtime match previous are copied from it
+    // instead of being parsed again. previous may be null.
+    bool UpdateFromRoot(const std::filesystem::path& root, const TargetCatalog* previous,
+                        std::string& outError, UpdateStats* outStats = nullptr);
+    void Clear();
+
+    const std::filesystem::path& GetRoot() const { return m_Root; }
+    const std::vector<DirectoryListing>& GetDirectories() const { return m_Directories; }
+    // Listing of an absolute directory under the root, or null if it was not walked.
+    const DirectoryListing* FindDirectory(const std::filesystem::path& dir) const;
+    // Index into GetSourceFiles() of an absolute txt path, or -1.
+    int FindSourceFile(const std::filesystem::path& path) const;
+
+    std::size_t GetRowCount() const { return m_SourceFile.size(); }
+    const std::vector<SourceFile>& GetSourceFiles() const { return m_SourceFiles; }
+    std::size_t GetMemoryBytes() const;
+
+    // Row accessors.
+    std::uint32_t GetSourceFileIndex(std::size_t row) const { return m_SourceFile[row]; }
+    std::uint32_t GetRowInSourceFile(std::size_t row) const;
+    Label GetLabel(std::size_t row) const { return static_cast<Label>(m_Label[row]); }
+    // YYYYMMDDhhmmss from the time column, 0 if missing.
+    std::uint64_t GetEpoch(std::size_t row) const { return m_Epoch[row]; }
+    const std::string& GetIndex(std::size_t row) const { return m_Names.Get(m_IndexId[row]); }
+    const std::string& GetFileDir(std::size_t row) const { return m_Paths.Get(m_FileDirId[row]); }
+    const std::string& GetAlignedFilename(std::size_t row) const { return m_Names.Get(m_AlignedId[row]); }
+    const std::string& GetTemplateFilename(std::size_t row) const { return m_Names.Get(m_TemplateId[row]); }
+    bool HasPixelCenter(std::size_t row) const { return (m_Flags[row] & kHasPixelCenter) != 0; }
+    int GetPixelX(std::size_t row) const { return m_PixelX[row]; }
+    int GetPixelY(std::size_t row) const { return m_PixelY[row]; }
+    bool HasRaDec(std::size_t row) const { return (m_Flags[row] & kHasRaDec) != 0; }
+    double GetRa(std::size_t row) const { return m_Ra[row]; }
+    double GetDec(std::size_t row) const { return m_Dec[row]; }
+
+    // Rebuild the row as a standalone record (allocates).
+    TxtTargetRecord GetRecord(std::size_t row) const;
+
+    // Matching rows in ascending order. RA/Dec ranges are answered by the sky index.
+    void RunQuery(const Query& query, std::vector<std::uint32_t>& outRows) const;
+    bool MatchesRow(const Query& query, std::size_t row) const;
+
+    // Rows within radiusArcsec of (ra, dec) that also pass filters, nearest first.
+    // Match ids are catalog rows.
+    void QueryCone(double raDeg, double decDeg, double radiusArcsec, const Query& filters,
+                   std::vector<SkyIndex::Match>& outMatches) const;
+    const SkyIndex& GetSkyIndex() const { return m_SkyIndex; }
+
+    static const char* GetLabelName(Label label);
+    // From the "# Label:" header, falling back to a good-/bad- filename prefix.
+    static Label DetectLabel(const std::string& headerLabel, const std::filesystem::path& txtPath);
+    // "20250628_190147" -> 20250628190147; 0 if it does not look like a timestamp.
+    static std::uint64_t ParseEpoch(std::string_view time);
+
+private:
+    static constexpr std::uint8_t kHasPixelCenter = 1;
+    static constexpr std::uint8_t kHasRaDec = 2;
+
+    friend class CatalogCache;
+
+    void AppendFileRows(std::uint32_t sourceFile, Label label, const std::vector<TxtTargetRowView>& rows);
+    void CopyFileRows(const TargetCatalog& previous, std::uint32_t previousSourceFile, std::uint32_t sourceFile);
+    void ReserveRows(std::size_t rowCount);
+    // Lookup maps and the sky index, after the columns are filled.
+    void FinalizeLoad();
+    std::string RelativeKey(const std::filesystem::path& path) const;
+
+    std::filesystem::path m_Root;
+    std::vector<DirectoryListing> m_Directories;
+    std::unordered_map<std::string, std::uint32_t> m_DirectoryLookup;
+    std::unordered_map<std::string, std::uint32_t> m_SourceFileLookup;
+
+    std::vector<SourceFile> m_SourceFiles;
+    StringPool m_Paths; // file_dir values
+    StringPool m_Names; // index, aligned and template filenames
+
+    std::vector<std::uint32_t> m_SourceFile;
+    std::vector<std::uint8_t> m_Label;
+    std::vector<std::uint8_t> m_Flags;
+    std::vector<std::uint32_t> m_IndexId;
+    std::vector<std::uint32_t> m_FileDirId;
+    std::vector<std::uint32_t> m_AlignedId;
+    std::vector<std::uint32_t> m_TemplateId;
+    std::vector<std::int32_t> m_PixelX;
+    std::vector<std::int32_t> m_PixelY;
+    std::vector<double> m_Ra;
+    std::vector<double> m_Dec;
+    std::vector<std::uint64_t> m_Epoch;
+
+    SkyIndex m_SkyIndex; // rows with RA/Dec
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Data/FileIndex.h"
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One data row of a label txt:
+// index file_dir aligned_filename template_aligned_filename fits_center_ra fits_center_dec time pixel_x pixel_y ra dec
+struct TxtTargetRecord {
+    std::string index;
+    std::string fileDir;
+    std::string alignedFilename;
+    std::string templateAlignedFilename;
+    bool hasPixelCenter{false};
+    int pixelX{0};
+    int pixelY{0};
+    bool hasRaDec{false};
+    double ra{0.0};
+    double dec{0.0};
+};
+
+// One data row as views into the txt buffer; valid while the buffer is.
+struct TxtTargetRowView {
+    std::string_view index;
+    std::string_view fileDir;
+    std::string_view alignedFilename;
+    std::string_view templateAlignedFilename;
+    std::string_view time;
+    bool hasPixelCenter{false};
+    double fitsCenterRa{0.0};
+    double fitsCenterDec{0.0};
+    int pixelX{0};
+    int pixelY{0};
+    bool hasRaDec{false};
+    double ra{0.0};
+    double dec{0.0};
+};
+
+struct TxtParseIssue {
+    std::size_t lineNumber{0}; // 1-based; 0 for file-level problems
+    std::string message;
+};
+
+// Header checks and malformed-line diagnostics from a parse.
+struct TxtParseReport {
+    static constexpr std::size_t kMaxIssues = 100;
+
+    std::string label; // "# Label:" value (GOOD / BAD), empty if absent
+    bool hasTotalRecords{false};
+    std::size_t declaredRecords{0};
+    bool hasFormat{false};
+    bool formatMatches{false};
+    std::size_t dataLines{0};
+    std::size_t malformedLines{0};
+    std::vector<TxtParseIssue> issues; // first kMaxIssues only
+};
+
+// Parse every data row of a label txt. The file is memory-mapped and large files are
+// parsed in chunks on several threads. Returns false (with a message) if the file cannot
+// be read or has no usable rows; header problems and malformed lines go to report.
+bool ParseTxtTargetFile(const std::filesystem::path& txtPath,
+                        std::vector<TxtTargetRecord>& outTargets,
+                        std::string& outError,
+                        TxtParseReport* report = nullptr);
+
+// Parse to row views into text, without copying any strings.
+bool ParseTxtTargetRows(std::string_view text,
+                        std::vector<TxtTargetRowView>& outRows,
+                        std::string& outError,
+                        TxtParseReport* report = nullptr);
+
+// Same as ParseTxtTargetFile, on text already in memory.
+bool ParseTxtTargetText(std::string_view text,
+                        std::vector<TxtTargetRecord>& outTargets,
+                        std::string& outError,
+                        TxtParseReport* report = nullptr);
+
+// Parse one data line (no trailing newline). Returns false if the line has fewer than
+// the four required columns. Optional columns that fail to parse are left unset and
+// described in outProblem, if given.
+bool ParseTxtTargetRow(std::string_view line, TxtTargetRowView& outRow, std::string* outProblem = nullptr);
+
+// Original std::getline/istringstream parser, kept as the baseline for the parser benchmark.
+bool ParseTxtTargetFileStream(const std::filesystem::path& txtPath,
+                              std::vector<TxtTargetRecord>& outTargets,
+                              std::string& outError);
+
+// Local directories searched by filename when a txt references a path that does not
+// exist here (e.g. E:\... paths from the labeling machine).
+std::vector<std::filesystem::path> GetDefaultFitsSearchRoots();
+
+// Shared index over GetDefaultFitsSearchRoots(). The first call starts the background
+// build and loads prefix remap rules from ./path_remap.txt and $GEOGEBRA3D_PATH_REMAP.
+FileIndex& GetFitsFileIndex();
+
+// Build the aligned/template FITS paths of a record and resolve missing ones: prefix remap
+// first, then a filename lookup in the index. Returns false only if the record has no
+// filenames; resolved paths may still not exist. Does not wait for the index: if a path
+// was not found while its first build is still running, *outIndexPending is set and the
+// caller should try again once the index is ready.
+bool ResolveTxtTargetFitsPaths(const TxtTargetRecord& rec,
+                               FileIndex& index,
+                               std::filesystem::path& outAligned,
+                               std::filesystem::path& outTemplate,
+                               bool* outIndexPending = nullptr);
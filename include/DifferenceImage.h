@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ImageLoader;
+
+// Aligned minus (optionally flux-matched) template, in data units. The difference is
+// computed in 64x64 tiles with an SSE2 row kernel and the tiles are kept, so moving the
+// ROI only computes the tiles it newly covers. The flux match is a sigma-clipped linear
+// fit aligned = offset + scale * template over a regular sample of the frame.
+class DifferenceImage {
+public:
+    static constexpr int kTileSize = 64;
+
+    struct Params {
+        bool matchScale{true};
+        int sampleCount{5000};       // fit sample, spread over the frame
+        float clipSigma{3.0f};
+        int maxIterations{8};
+        float colorSigma{5.0f};      // +/- this many residual rms span the colormap
+        std::size_t maxTiles{4096};  // cache cap (64 MB)
+
+        bool operator==(const Params& other) const;
+        bool operator!=(const Params& other) const { return !(*this == other); }
+    };
+
+    struct Fit {
+        double offset{0.0};
+        double scale{1.0};
+        double rms{0.0};    // scatter of the difference around zero (clipped)
+        int samples{0};     // pairs kept by the clipping
+        bool valid{false};
+    };
+
+    DifferenceImage();
+
+    // Both images must share pixel coordinates. Same images and params keep the cached
+    // tiles; returns true if they were dropped.
+    bool SetInputs(std::shared_ptr<const ImageLoader> aligned, std::shared_ptr<const ImageLoader> templ,
+                   const Params& params);
+    void Clear();
+    bool HasInputs() const { return m_Aligned != nullptr && m_Template != nullptr; }
+
+    const Fit& GetFit() const { return m_Fit; }
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    std::size_t GetTileCount() const { return m_Tiles.size(); }
+    std::size_t GetMemoryBytes() const;
+
+    // Compute the missing tiles under pixels [x0, x1] x [y0, y1]; returns how many were
+    // computed (the rest came from the cache).
+    int Update(int x0, int y0, int x1, int y1);
+    // Difference at (x, y) in data units; NaN if either input is blank there
+    // (ImageLoader::IsBlankPixel) or its tile is not computed.
+    float GetValue(int x, int y) const;
+
+    // Points for [x0, x1] x [y0, y1] (after Update) in the image clouds' world mapping;
+    // blank pixels get no point.
+    // Height and color follow difference / (colorSigma * rms): zero on the ground plane,
+    // +/- half of scaleY at the ends, blue-white-red.
+    void GeneratePointCloud(int x0, int y0, int x1, int y1, float scaleX, float scaleY, float scaleZ,
+                            std::vector<glm::vec3>& positions, std::vector<glm::vec4>& colors) const;
+    // Diverging colormap, t in [-1, 1].
+    static glm::vec4 DivergingColor(float t);
+
+private:
+    void FitScale();
+    void ComputeTile(int tileX, int tileY, std::vector<float>& out) const;
+    std::uint64_t TileKey(int tileX, int tileY) const {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(tileY)) << 32) |
+               static_cast<std::uint32_t>(tileX);
+    }
+
+    std::shared_ptr<const ImageLoader> m_Aligned;
+    std::shared_ptr<const ImageLoader> m_Template;
+    Params m_Params;
+    Fit m_Fit;
+    int m_Width;
+    int m_Height;
+    // difference = m_K0 + m_KAligned * aligned + m_KTemplate * template (normalized inputs)
+    float m_K0;
+    float m_KAligned;
+    float m_KTemplate;
+    std::unordered_map<std::uint64_t, std::vector<float>> m_Tiles;
+};
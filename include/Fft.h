@@ -0,0 +1,56 @@
+#pragma once
+
+#include <complex>
+#include <memory>
+#include <vector>
+
+// Iterative radix-2 complex FFT of one power-of-two size. The bit-reversal order and
+// twiddles are built once; Get() hands out one shared plan per size.
+class FftPlan {
+public:
+    explicit FftPlan(int size);
+
+    int GetSize() const { return m_Size; }
+    // In place. The inverse is unnormalized (a forward + inverse pair scales by size).
+    void Transform(std::complex<float>* data, bool inverse) const;
+
+    // Cached plan for size (thread-safe). size must be a power of two.
+    static std::shared_ptr<const FftPlan> Get(int size);
+    static bool IsPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+    static int NextPowerOfTwo(int n);
+
+private:
+    int m_Size;
+    std::vector<std::pair<int, int>> m_Swaps;     // bit-reversal permutation
+    std::vector<std::complex<float>> m_Twiddles;  // exp(-2 pi i k / size), k < size / 2
+};
+
+// Real-to-complex 2D FFT of a size x size image (power of two, >= 4). Each row is
+// transformed as a half-length complex FFT of its packed even/odd samples, so the
+// spectrum keeps only the size / 2 + 1 non-redundant columns.
+class RealFft2D {
+public:
+    explicit RealFft2D(int size);
+
+    int GetSize() const { return m_Size; }
+    int GetSpectrumWidth() const { return m_Size / 2 + 1; }
+    std::size_t GetSpectrumCount() const {
+        return static_cast<std::size_t>(m_Size) * static_cast<std::size_t>(GetSpectrumWidth());
+    }
+
+    // image: size * size row-major; spectrum: size rows of GetSpectrumWidth() bins.
+    void Forward(const float* image, std::complex<float>* spectrum) const;
+    // Overwrites spectrum. Normalized, so Inverse(Forward(x)) == x.
+    void Inverse(std::complex<float>* spectrum, float* image) const;
+
+    // Cached transform for size (thread-safe).
+    static std::shared_ptr<const RealFft2D> Get(int size);
+
+private:
+    void TransformColumns(std::complex<float>* spectrum, bool inverse) const;
+
+    int m_Size;
+    std::shared_ptr<const FftPlan> m_RowPlan;    // size / 2, packed rows
+    std::shared_ptr<const FftPlan> m_ColumnPlan; // size
+    std::vector<std::complex<float>> m_RowTwiddles; // exp(-2 pi i k / size), k <= size / 2
+};
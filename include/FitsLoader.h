@@ -1,5 +1,9 @@
 #pragma once
 
+#include "Wcs.h"
+
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -12,14 +16,35 @@ public:
 
     // Load FITS file
     bool LoadFits(const std::string& filepath);
+    // Take over data already normalized like `like` (same data range, bit depth and zscale),
+    // e.g. `like` resampled onto another pixel grid, with that grid's WCS. Non-finite
+    // values mark blank pixels.
+    bool LoadNormalized(std::vector<float> data, int width, int height, const FitsLoader& like, const Wcs& wcs);
 
     // Get image dimensions
     int GetWidth() const { return m_Width; }
     int GetHeight() const { return m_Height; }
     int GetBitDepth() const { return m_BitDepth; }
+    // Raw data range that was normalized to [0, 1]
+    float GetMinValue() const { return m_MinValue; }
+    float GetMaxValue() const { return m_MaxValue; }
+    // ZScale display limits from a sparse sample, in normalized units (computed on load)
+    float GetZScaleLow() const { return m_ZScaleLow; }
+    float GetZScaleHigh() const { return m_ZScaleHigh; }
+    // Celestial WCS from the header; IsValid() is false if there is none we support.
+    const Wcs& GetWcs() const { return m_Wcs; }
 
     // Get normalized pixel value [0.0, 1.0]
     float GetNormalizedPixelValue(int x, int y) const;
+    // Normalized row y (GetWidth() values), or nullptr if out of range
+    const float* GetRow(int y) const;
+
+    // Blank pixels have no data (NaN / BLANK in the file, or not covered by a resampling);
+    // they are stored as normalized 0.
+    bool HasBlankPixels() const { return !m_Blank.empty(); }
+    bool IsBlank(int x, int y) const;
+    // Blank flags of row y (1 = blank), or nullptr if out of range or there are none
+    const std::uint8_t* GetBlankRow(int y) const;
 
     // Get RGB color (grayscale for FITS)
     void GetPixelColor(int x, int y, float& r, float& g, float& b) const;
@@ -30,14 +55,26 @@ public:
     // Unload data
     void Unload();
 
+    // cfitsio is built without thread support; anything else that opens FITS files
+    // (e.g. the frame stacker) must hold this while calling into it.
+    static std::mutex& GetCfitsioMutex();
+
 private:
     std::vector<float> m_Data;  // Normalized float data [0.0, 1.0]
+    std::vector<std::uint8_t> m_Blank;  // per pixel, empty if no pixel is blank
     int m_Width;
     int m_Height;
     int m_BitDepth;  // BITPIX value from FITS header
 
+    // Zero and flag non-finite values of m_Data.
+    void MarkBlankPixels();
+
     // Data range for normalization
     float m_MinValue;
     float m_MaxValue;
+
+    float m_ZScaleLow;
+    float m_ZScaleHigh;
+    Wcs m_Wcs;
 };
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <string>
+#include <vector>
+
+// Combines registered frames of the same field (same pixel grid) into a deep reference
+// FITS. The frames are never held whole: horizontal strips sized to a memory budget are
+// read from every input, combined pixel by pixel across worker threads while the next
+// strip is read, and appended to the output. The result is BITPIX -32 with the first
+// frame's header (WCS included), so it opens like any other image.
+class FrameStacker {
+public:
+    enum class Method : int { Median = 0, SigmaClip = 1 };
+
+    struct Params {
+        Method method{Method::Median};
+        float clipSigma{3.0f};       // sigma clip: reject |v - median| > clipSigma * sigma (from MAD)
+        int maxIterations{5};
+        bool matchBackground{true};  // offset every frame's sky level to the first frame's
+        std::size_t memoryBudgetBytes{256u * 1024u * 1024u};
+    };
+
+    struct Result {
+        bool ok{false};
+        std::string message;
+        int width{0};
+        int height{0};
+        int frames{0};
+        int stripRows{0};
+        std::size_t bufferBytes{0};  // strip buffers actually allocated
+        double seconds{0.0};
+    };
+
+    static const char* GetMethodName(Method method);
+
+    FrameStacker();
+    ~FrameStacker();
+
+    FrameStacker(const FrameStacker&) = delete;
+    FrameStacker& operator=(const FrameStacker&) = delete;
+
+    // Stack on the calling thread. output is overwritten; it is removed again on failure.
+    Result Run(const std::vector<std::string>& inputs, const std::string& output, const Params& params);
+
+    // Same on a background thread. Ignored (false) while a run is in progress.
+    bool Start(std::vector<std::string> inputs, std::string output, Params params);
+    void Cancel();
+    void Wait();
+
+    bool IsRunning() const { return m_Run.valid(); }
+    // True once, on the frame the run has finished; the outcome is then in GetResult().
+    bool Poll();
+    int GetStripsDone() const { return m_StripsDone.load(); }
+    int GetStripCount() const { return m_StripCount.load(); }
+    const Result& GetResult() const { return m_Result; }
+
+private:
+    std::future<Result> m_Run;
+    std::atomic<bool> m_Cancelled;
+    std::atomic<int> m_StripsDone;
+    std::atomic<int> m_StripCount;
+    Result m_Result;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "GeometryObject.h"
+#include <vector>
+#include <glm/glm.hpp>
+
+// Low-resolution textured heightfield standing in for an image point cloud when the
+// camera is far away. Triangles are grouped into the same XZ tiles as PointCloud
+// chunks, so individual tiles can be handed over to real points.
+class ImageSurface : public GeometryObject {
+public:
+    ImageSurface();
+    ~ImageSurface() override;
+
+    void Initialize() override;
+    void Render(Shader* shader) override;
+
+    // Row-major grid of gridWidth x gridHeight vertices.
+    void SetGrid(int gridWidth, int gridHeight,
+                 const std::vector<glm::vec3>& positions,
+                 const std::vector<glm::vec2>& texCoords);
+
+    // Same meaning as PointCloud::SetChunkSize. Takes effect on the next Initialize().
+    void SetChunkSize(float worldSize) { m_ChunkSize = worldSize; }
+
+    // Takes ownership of a GL texture created by the caller.
+    void SetTexture(unsigned int texture);
+    unsigned int GetTexture() const { return m_Texture; }
+
+    struct Chunk {
+        int firstIndex;
+        int indexCount;
+        int tileX;
+        int tileZ;
+        bool visible;
+    };
+
+    const std::vector<Chunk>& GetChunks() const { return m_Chunks; }
+    void SetChunkVisible(size_t index, bool visible);
+    void SetAllChunksVisible(bool visible);
+
+private:
+    int m_GridWidth;
+    int m_GridHeight;
+    std::vector<glm::vec3> m_Positions;
+    std::vector<glm::vec2> m_TexCoords;
+
+    float m_ChunkSize;
+    std::vector<Chunk> m_Chunks;
+    unsigned int m_Texture;
+
+    // Scratch arrays for glMultiDrawElements, reused across frames.
+    std::vector<int> m_DrawCounts;
+    std::vector<const void*> m_DrawOffsets;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GeometryObject.h"
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -14,22 +15,85 @@ public:
     void Render(Shader* shader) override;
 
     // Set point cloud data
-    void SetPointData(const std::vector<glm::vec3>& positions, 
+    void SetPointData(const std::vector<glm::vec3>& positions,
                       const std::vector<glm::vec4>& colors);
-    
+
     void SetPointSize(float size) { m_PointSize = size; }
     float GetPointSize() const { return m_PointSize; }
-    
+
     int GetPointCount() const { return m_PointCount; }
 
+    const std::vector<glm::vec3>& GetPositions() const { return m_Positions; }
+    const std::vector<glm::vec4>& GetColors() const { return m_Colors; }
+    const std::vector<std::uint8_t>& GetPointGroups() const { return m_Groups; }
+
+    // Optional per-point group (default 0). Points in groups > 0 (e.g. target highlights)
+    // are pinned: always drawn in full, ignoring chunk visibility and the draw budget.
+    // Takes effect on the next Initialize().
+    static constexpr int kMaxPointGroups = 8;
+    void SetPointGroups(const std::vector<std::uint8_t>& groups);
+    // Point size of a group relative to SetPointSize (group 0 is always 1).
+    void SetGroupPointSizeScale(int group, float scale);
+    float GetGroupPointSizeScale(int group) const;
+    int GetPinnedPointCount() const { return m_PinnedCount; }
+
+    // Limit how many points are drawn (-1 = all). Vertices are uploaded in a shuffled
+    // order, so any prefix is a uniform subsample of the whole cloud.
+    void SetDrawBudget(int maxPoints) { m_DrawBudget = maxPoints; }
+    int GetDrawCount() const;
+
+    // Group points into square XZ tiles of this world size (0 = one chunk) so parts of
+    // the cloud can be switched on and off. Takes effect on the next Initialize().
+    void SetChunkSize(float worldSize) { m_ChunkSize = worldSize; }
+    float GetChunkSize() const { return m_ChunkSize; }
+
+    struct Chunk {
+        int first;
+        int count;
+        int tileX;
+        int tileZ;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        bool visible;
+    };
+
+    const std::vector<Chunk>& GetChunks() const { return m_Chunks; }
+    void SetChunkVisible(size_t index, bool visible);
+    void SetAllChunksVisible(bool visible);
+
+    // Points in visible chunks; the draw budget applies to these.
+    int GetActivePointCount() const { return m_ActivePointCount; }
+
+    // Chunk layout and vertex order on the CPU only (Initialize() also does this), for
+    // renderers without a GL context.
+    void PrepareChunks();
+    // Vertex slot -> index into GetPositions().
+    const std::vector<int>& GetDrawOrder() const { return m_DrawOrder; }
+    // Slot ranges Render() draws under the current budget and chunk visibility, and the
+    // point size of each group (kMaxPointGroups entries). False if nothing is drawn.
+    bool BuildDrawRanges(std::vector<int>& firsts, std::vector<int>& counts, float* groupSizes) const;
+
 private:
     void UpdateBuffers();
 
     std::vector<glm::vec3> m_Positions;
     std::vector<glm::vec4> m_Colors;
-    
+
     float m_PointSize;
     int m_PointCount;
+    int m_DrawBudget;
     bool m_NeedsUpdate;
-};
 
+    std::vector<std::uint8_t> m_Groups;
+    float m_GroupPointSizeScale[kMaxPointGroups];
+    int m_PinnedCount;
+
+    float m_ChunkSize;
+    std::vector<Chunk> m_Chunks;
+    int m_ActivePointCount;
+    std::vector<int> m_DrawOrder;
+
+    // Scratch arrays for glMultiDrawArrays, reused across frames.
+    std::vector<int> m_DrawFirsts;
+    std::vector<int> m_DrawCounts;
+};
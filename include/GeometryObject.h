@@ -13,7 +13,8 @@ enum class GeometryType {
     Sphere,
     Cube,
     Cylinder,
-    Cone
+    Cone,
+    Surface
 };
 
 class GeometryObject {
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Renders an image's point cloud offscreen for a fixed number of frames while orbiting
+// the camera, and prints frame-time statistics. Runs without a display (see HeadlessContext).
+// A final frame is also drawn by CpuPointRasterizer and compared with the GL readback.
+// Returns a process exit code.
+int RunHeadlessBenchmark(const std::string& imagePath, int frames, int width, int height);
+
+// Times the label txt parsers (std::getline/istringstream baseline vs. the mapped
+// from_chars parser) and checks they agree. If replicateRows > 0, the data rows are
+// repeated into a temporary file of that many rows first. Returns a process exit code.
+int RunTxtParseBenchmark(const std::string& txtPath, int iterations, std::size_t replicateRows);
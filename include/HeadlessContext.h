@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+// OpenGL 3.3 core context without a visible window, rendering into an offscreen
+// framebuffer. Uses EGL surfaceless (e.g. Mesa llvmpipe on display-less Linux hosts)
+// when built with EGL support, otherwise falls back to a hidden GLFW window.
+class HeadlessContext {
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    bool Initialize(int width, int height);
+    void Shutdown();
+
+    // Recreate the offscreen color/depth attachments at a new size.
+    bool Resize(int width, int height);
+
+    // Bind the offscreen framebuffer and set the viewport to cover it.
+    void Bind();
+
+    // Read the framebuffer as RGBA8, row 0 at the bottom (glReadPixels order).
+    void ReadPixels(std::vector<unsigned char>& rgba);
+
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    float GetAspectRatio() const { return m_Height > 0 ? (float)m_Width / (float)m_Height : 1.0f; }
+
+    // "egl-surfaceless" or "glfw-hidden"
+    const std::string& GetBackendName() const { return m_BackendName; }
+
+private:
+    bool CreateEglContext();
+    bool CreateGlfwContext();
+    bool CreateFramebuffer();
+    void DestroyFramebuffer();
+
+    int m_Width;
+    int m_Height;
+    std::string m_BackendName;
+
+    // EGL handles (void* so this header does not pull in EGL).
+    void* m_EglDisplay;
+    void* m_EglContext;
+
+    GLFWwindow* m_GlfwWindow;
+
+    unsigned int m_Framebuffer;
+    unsigned int m_ColorBuffer;
+    unsigned int m_DepthBuffer;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ImageLoader;
+
+// Fine histogram of an image's gray values (whole image or a rectangle), counted on
+// worker threads into private bins that are merged at the end. Whole-image bins span
+// the normalized range [0, 1]; a region's bins span its own [min, max] (found in a first
+// pass), so a faint crop is not squeezed into a handful of global bins. Exact
+// min/max/mean/stddev are kept alongside, so every auto-levels preset is a walk over the
+// bins rather than over the pixels. Blank pixels (ImageLoader::IsBlankPixel) are skipped.
+// Rebuilding at the same bin count reuses the buffers.
+class Histogram {
+public:
+    // How display levels are derived.
+    struct LevelsPreset {
+        enum class Mode : int {
+            MinMax = 0,
+            Percentile = 1,
+            MeanSigma = 2,
+            ZScale = 3, // sampled line fit (see ZScale.h); needs the image, not just bins
+        };
+
+        Mode mode{Mode::ZScale};
+        float lowPercent{1.0f};
+        float highPercent{99.0f};
+        float sigmaLow{2.0f};  // mean - sigmaLow * stddev
+        float sigmaHigh{5.0f}; // mean + sigmaHigh * stddev
+        bool fromRoi{true};    // histogram of the crop, otherwise of the whole image
+
+        bool operator==(const LevelsPreset& other) const;
+        bool operator!=(const LevelsPreset& other) const { return !(*this == other); }
+    };
+
+    static constexpr int kDefaultBinCount = 16384;
+
+    explicit Histogram(int binCount = kDefaultBinCount);
+
+    void Build(const ImageLoader& image);
+    // Pixels [x0, x1] x [y0, y1], inclusive and clamped to the image.
+    void BuildRegion(const ImageLoader& image, int x0, int y0, int x1, int y1);
+    void Clear();
+
+    bool IsEmpty() const { return m_Count == 0; }
+    int GetBinCount() const { return static_cast<int>(m_Bins.size()); }
+    const std::vector<std::uint32_t>& GetBins() const { return m_Bins; }
+    std::uint64_t GetCount() const { return m_Count; }
+
+    // Normalized values ([0, 1] of the image's data range).
+    float GetBinLow() const { return m_BinLow; }
+    float GetBinHigh() const { return m_BinHigh; }
+    float GetMin() const { return m_Min; }
+    float GetMax() const { return m_Max; }
+    double GetMean() const { return m_Mean; }
+    double GetStddev() const { return m_Stddev; }
+    // Value below which a fraction q of the pixels lie, interpolated inside the bin.
+    float GetPercentile(float q) const;
+    // Display range for a preset; falls back to [min, max] when the result is degenerate.
+    // ZScale is not derivable from the bins and also yields [min, max] here.
+    void ComputeLevels(const LevelsPreset& preset, float& outLow, float& outHigh) const;
+
+    // Data value = GetDataOffset() + GetDataScale() * normalized value.
+    double GetDataOffset() const { return m_Offset; }
+    double GetDataScale() const { return m_Scale; }
+
+private:
+    void Count(const ImageLoader& image, int x0, int y0, int x1, int y1, bool fitRange);
+
+    std::vector<std::uint32_t> m_Bins;
+    std::vector<std::uint32_t> m_WorkerBins; // per-thread bins, merged into m_Bins
+    std::uint64_t m_Count;
+    float m_BinLow;
+    float m_BinHigh;
+    float m_Min;
+    float m_Max;
+    double m_Mean;
+    double m_Stddev;
+    double m_Offset;
+    double m_Scale;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+class ImageLoader;
+
+// Clean-up of a FITS image before point generation, so hot pixels and cosmic rays do not
+// become spikes in the 3D view: a 3x3 / 5x5 median, then a separable Gaussian, then
+// block averaging (binning), which also cuts the point count. Kernels run on row strips
+// across worker threads; their inner loops walk blocks of a row over plain float arrays
+// so the compiler vectorizes them (the median is a sorting network applied lane-wise).
+class ImageFilter {
+public:
+    struct Params {
+        int medianSize{0};          // 0 (off), 3 or 5
+        float gaussianSigma{0.0f};  // pixels, used in steps of 0.1 (QuantizeSigma); 0 = off
+        int binFactor{1};           // 1, 2 or 4
+
+        // Sigma rounded to the 0.1 pixel step it is applied, compared and keyed with.
+        static float QuantizeSigma(float sigma) { return GetSigmaTenths(sigma) * 0.1f; }
+        static int GetSigmaTenths(float sigma) {
+            return sigma > 0.0f ? static_cast<int>(std::lround(sigma * 10.0f)) : 0;
+        }
+
+        bool IsIdentity() const { return medianSize < 3 && GetSigmaTenths(gaussianSigma) == 0 && binFactor <= 1; }
+        // Short description, also used as a cache key.
+        std::string GetKey() const;
+        bool operator==(const Params& other) const {
+            return medianSize == other.medianSize &&
+                   GetSigmaTenths(gaussianSigma) == GetSigmaTenths(other.gaussianSigma) &&
+                   binFactor == other.binFactor;
+        }
+        bool operator!=(const Params& other) const { return !(*this == other); }
+    };
+
+    // Filtered copy of source, normalized like it; binned images are binFactor times
+    // smaller with the WCS scaled to match (binned pixel x covers source pixels
+    // [x * binFactor, (x + 1) * binFactor)). The kernels skip blank pixels, which stay
+    // blank (a binned pixel with any blank source pixel is blank). Null (with a message)
+    // for non-FITS images.
+    static std::shared_ptr<ImageLoader> Apply(const ImageLoader& source, const Params& params);
+    // Same for source pixels [x0, x1] x [y0, y1] only (grown to whole bins, clamped): the
+    // kernels read just the region plus their radius, and the result is region sized
+    // with its place on the frame in GetFrameGrid(). Matches Apply inside the region.
+    static std::shared_ptr<ImageLoader> Apply(const ImageLoader& source, const Params& params, int x0, int y0,
+                                              int x1, int y1);
+};
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <glm/glm.hpp>
+#include "BackgroundMap.h"
+#include "Histogram.h"
+#include "IntegralImage.h"
 
 class FitsLoader;
+class Wcs;
 
 class ImageLoader {
 public:
@@ -13,6 +19,9 @@ public:
     ~ImageLoader();
 
     bool LoadImage(const std::string& filepath);
+    // FITS image from data normalized like the FITS image `like` (see
+    // FitsLoader::LoadNormalized), e.g. a resampled copy of it.
+    bool LoadResampled(const ImageLoader& like, std::vector<float> normalized, int width, int height, const Wcs& wcs);
     void UnloadImage();
 
     bool IsLoaded() const { return m_Data != nullptr || m_FitsLoader != nullptr; }
@@ -21,6 +30,26 @@ public:
     int GetChannels() const { return m_Channels; }
     bool IsFits() const { return m_FitsLoader != nullptr; }
 
+    // Celestial WCS of a FITS image, or nullptr if it has none we support.
+    const Wcs* GetWcs() const;
+
+    // Where a derived image (filtered, binned, cropped) sits on the frame it came from:
+    // pixel x covers frame pixels [originX + x * bin, originX + (x + 1) * bin).
+    struct FrameGrid {
+        int originX{0};
+        int originY{0};
+        int bin{1};
+    };
+    const FrameGrid& GetFrameGrid() const { return m_FrameGrid; }
+    void SetFrameGrid(const FrameGrid& grid) { m_FrameGrid = grid; }
+
+    // Data values that normalized 0 and 1 map to (FITS data range, or 0..255).
+    void GetDataRange(double& minValue, double& maxValue) const;
+    // Summed-area tables, built on load, for constant-time region statistics.
+    const IntegralImage& GetIntegralImage() const { return m_Integral; }
+    // Whole-image histogram, built on load.
+    const Histogram& GetHistogram() const { return m_Histogram; }
+
     // Get pixel value at (x, y) - returns grayscale value [0, 255]
     unsigned char GetPixelValue(int x, int y) const;
 
@@ -30,16 +59,48 @@ public:
     // Get normalized pixel value [0.0, 1.0]
     float GetNormalizedPixelValue(int x, int y) const;
 
+    // Normalized values of pixels [x0, x0 + count) of row y into out; pixels outside the
+    // image read as 0. Contiguous copy for FITS, for kernels that work on whole rows.
+    void GetNormalizedRow(int y, int x0, int count, float* out) const;
+
+    // FITS pixels without data (see FitsLoader::IsBlank); they read as normalized 0.
+    bool HasBlankPixels() const;
+    bool IsBlankPixel(int x, int y) const;
+    // Blank flags (1 = blank) matching GetNormalizedRow; pixels outside the image are blank.
+    void GetBlankRow(int y, int x0, int count, std::uint8_t* out) const;
+
+    // ZScale display limits of the whole image (normalized values), computed on load.
+    void GetZScale(float& low, float& high) const;
+    // ZScale limits of pixels [x0, x1] x [y0, y1]; recent regions are cached.
+    void GetRegionZScale(int x0, int y0, int x1, int y1, float& low, float& high) const;
+    // Value used for point heights and FITS gray: FITS data mapped through the whole-image
+    // zscale limits and clamped to [0, 1]; standard images as normalized.
+    float GetDisplayValue(int x, int y) const;
+
+    // Sky background mesh, built on load.
+    const BackgroundMap& GetBackgroundMap() const { return m_Background; }
+
+    // What point heights show. The background modes flatten the sky to its global level
+    // (additive gradients / multiplicative vignetting) before the display mapping.
+    enum class HeightMode : int {
+        Display = 0,
+        BackgroundSubtracted = 1,
+        BackgroundNormalized = 2,
+    };
+    float GetHeightValue(int x, int y, HeightMode mode) const;
+
     // Generate point cloud from image
     // x, y = pixel coordinates, z = pixel value (normalized)
-    std::vector<glm::vec3> GeneratePointCloud(float scaleX = 1.0f, float scaleY = 1.0f, float scaleZ = 1.0f) const;
+    std::vector<glm::vec3> GeneratePointCloud(float scaleX = 1.0f, float scaleY = 1.0f, float scaleZ = 1.0f,
+                                              HeightMode heightMode = HeightMode::Display) const;
 
     // Generate point cloud with original colors
     void GeneratePointCloudWithColors(std::vector<glm::vec3>& positions,
                                       std::vector<glm::vec4>& colors,
                                       float scaleX = 1.0f,
                                       float scaleY = 1.0f,
-                                      float scaleZ = 1.0f) const;
+                                      float scaleZ = 1.0f,
+                                      HeightMode heightMode = HeightMode::Display) const;
 
     // Generate point cloud with original colors, but recolor pixels in a square highlight region.
     // highlightSizePixels: e.g. 10 means [cx-5..cx+4] × [cy-5..cy+4]
@@ -51,7 +112,8 @@ public:
                                                const glm::vec4& highlightColor,
                                                float scaleX = 1.0f,
                                                float scaleY = 1.0f,
-                                               float scaleZ = 1.0f) const;
+                                               float scaleZ = 1.0f,
+                                               HeightMode heightMode = HeightMode::Display) const;
 
     // Generate point cloud with original colors, but only within a pixel ROI around (pixelX, pixelY).
     // radiusPixels: neighborhood radius in pixels (e.g. 50-500).
@@ -62,7 +124,8 @@ public:
                                          int radiusPixels,
                                          float scaleX = 1.0f,
                                          float scaleY = 1.0f,
-                                         float scaleZ = 1.0f) const;
+                                         float scaleZ = 1.0f,
+                                         HeightMode heightMode = HeightMode::Display) const;
 
     // ROI version with square highlight recolor around (highlightCenterX, highlightCenterY).
     void GeneratePointCloudWithColorsROIHighlight(std::vector<glm::vec3>& positions,
@@ -76,27 +139,68 @@ public:
                                                   const glm::vec4& highlightColor,
                                                   float scaleX = 1.0f,
                                                   float scaleY = 1.0f,
-                                                  float scaleZ = 1.0f) const;
-
-    // Split highlight points into a separate output buffer so they can be rendered with a different point size.
-    void GeneratePointCloudWithColorsROISplitHighlight(std::vector<glm::vec3>& positions,
-                                                       std::vector<glm::vec4>& colors,
-                                                       std::vector<glm::vec3>& highlightPositions,
-                                                       std::vector<glm::vec4>& highlightColors,
-                                                       int pixelX,
-                                                       int pixelY,
-                                                       int radiusPixels,
-                                                       int highlightCenterX,
-                                                       int highlightCenterY,
-                                                       int highlightSizePixels,
-                                                       const glm::vec4& highlightColor,
-                                                       float scaleX = 1.0f,
-                                                       float scaleY = 1.0f,
-                                                       float scaleZ = 1.0f) const;
+                                                  float scaleZ = 1.0f,
+                                                  HeightMode heightMode = HeightMode::Display) const;
+
+    // Square highlight around (centerX, centerY), drawn as point group `group` (1..7).
+    struct PointHighlight {
+        int centerX{0};
+        int centerY{0};
+        int sizePixels{10};
+        glm::vec4 color{1.0f};
+        std::uint8_t group{1};
+        float pointSizeScale{1.0f}; // for the caller's point cloud; not used by the generator
+    };
+
+    // ROI point cloud with a per-point group: 0 for plain pixels, otherwise the group of the
+    // first highlight containing the pixel (which also replaces its color).
+    void GeneratePointCloudWithColorsROIGroups(std::vector<glm::vec3>& positions,
+                                               std::vector<glm::vec4>& colors,
+                                               std::vector<std::uint8_t>& groups,
+                                               int pixelX,
+                                               int pixelY,
+                                               int radiusPixels,
+                                               const std::vector<PointHighlight>& highlights,
+                                               float scaleX = 1.0f,
+                                               float scaleY = 1.0f,
+                                               float scaleZ = 1.0f,
+                                               HeightMode heightMode = HeightMode::Display) const;
+
+    // Render a region of the image to 8-bit RGBA for texture upload.
+    // srcX/srcY/srcW/srcH select source pixels (clamped at the image border); the region is
+    // resampled (nearest) to outW x outH. With contrastStretch, FITS data gets a local
+    // 1%/99% stretch plus a sqrt curve; otherwise colors match GetPixelColor.
+    void BuildRegionRGBA(int srcX, int srcY, int srcW, int srcH,
+                         int outW, int outH,
+                         bool contrastStretch,
+                         std::vector<unsigned char>& rgba) const;
+
+    // Working memory of BuildRegionRGBA, kept by callers that re-crop every frame so
+    // repeated builds of the same size do not allocate.
+    struct RegionScratch {
+        std::vector<int> columns;
+        std::vector<float> values;
+        std::vector<std::uint32_t> histogram;
+    };
+
+    // Same, writing outW * outH * 4 bytes to rgba (which may be mapped GL memory).
+    // levelLow < levelHigh (normalized values) replaces the local 1%/99% stretch.
+    void BuildRegionRGBA(int srcX, int srcY, int srcW, int srcH,
+                         int outW, int outH,
+                         bool contrastStretch,
+                         unsigned char* rgba,
+                         RegionScratch& scratch,
+                         float levelLow = 0.0f,
+                         float levelHigh = 0.0f) const;
 
 private:
     bool LoadStandardImage(const std::string& filepath);
     bool LoadFitsImage(const std::string& filepath);
+    // Tables built from the pixels once a FITS image is in place.
+    void FinishFitsLoad();
+    void UpdateDisplayScale();
+    // Normalized value -> display value (see GetDisplayValue).
+    float ToDisplayValue(float normalized) const;
 
     unsigned char* m_Data;
     int m_Width;
@@ -104,5 +208,23 @@ private:
     int m_Channels;
 
     std::unique_ptr<FitsLoader> m_FitsLoader;
+    IntegralImage m_Integral;
+    Histogram m_Histogram;
+    BackgroundMap m_Background;
+
+    float m_ZScaleLow;
+    float m_ZScaleHigh;
+    float m_DisplayScale; // 1 / (m_ZScaleHigh - m_ZScaleLow)
+    FrameGrid m_FrameGrid;
+
+    // Per-region zscale results; images are shared with the prefetch thread.
+    struct RegionZScale {
+        int x0, y0, x1, y1;
+        float low, high;
+    };
+    static constexpr std::size_t kRegionZScaleCacheSize = 16;
+    mutable std::mutex m_RegionZScaleMutex;
+    mutable std::vector<RegionZScale> m_RegionZScaleCache;
+    mutable std::size_t m_RegionZScaleNext;
 };
 
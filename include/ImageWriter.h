@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Minimal PNG encoder (8-bit RGBA, fixed-Huffman deflate) for snapshots, so no extra
+// image library is needed. Rows are top-down unless flipVertically is set, which
+// accepts bottom-up data straight from glReadPixels / CpuPointRasterizer.
+class ImageWriter {
+public:
+    static bool WritePngRGBA(const std::string& filepath, int width, int height,
+                             const unsigned char* rgba, bool flipVertically = false);
+
+    // Encode to memory; returns an empty vector on invalid input.
+    static std::vector<unsigned char> EncodePngRGBA(int width, int height,
+                                                    const unsigned char* rgba, bool flipVertically = false);
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ImageLoader;
+
+// Summed-area tables (sum and sum of squares, double precision) of an image's gray
+// values, so the statistics of any axis-aligned rectangle cost four lookups each.
+// Values are in data units: the FITS data range, or 0..255 for 8-bit images. Blank
+// pixels are left out; a third table counts the valid ones when the image has any.
+class IntegralImage {
+public:
+    struct Stats {
+        std::size_t count{0};
+        double sum{0.0};
+        double mean{0.0};
+        double stddev{0.0};
+    };
+
+    // Aperture photometry: aperture square minus the mean of the surrounding background
+    // square (aperture excluded), noise from the background scatter.
+    struct Snr {
+        Stats aperture;
+        Stats background;
+        double signal{0.0}; // background-subtracted aperture sum
+        double snr{0.0};
+        bool valid{false};
+    };
+
+    IntegralImage();
+
+    void Build(const ImageLoader& image);
+    void Clear();
+
+    bool IsEmpty() const { return m_Width == 0 || m_Height == 0; }
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    std::size_t GetMemoryBytes() const;
+
+    // Pixels [x0, x1] x [y0, y1], inclusive and clamped to the image.
+    Stats GetRectStats(int x0, int y0, int x1, int y1) const;
+    // Square of edge 2*halfSize+1 centred on (cx, cy).
+    Stats GetSquareStats(int cx, int cy, int halfSize) const;
+    Snr GetSnr(int cx, int cy, int apertureHalfSize, int backgroundHalfSize) const;
+
+private:
+    // Sums over the valid pixels of the clamped rectangle; count is 0 if it misses the
+    // image or holds only blank pixels.
+    void SumRect(int x0, int y0, int x1, int y1, std::size_t& count, double& sum, double& sumSq) const;
+    Stats MakeStats(std::size_t count, double sum, double sumSq) const;
+
+    int m_Width;
+    int m_Height;
+    // (width+1) x (height+1), row 0 and column 0 are zero. Sums are of normalized values.
+    std::vector<double> m_Sum;
+    std::vector<double> m_SumSq;
+    std::vector<std::uint32_t> m_Count; // valid pixels; empty when none are blank
+    // Data value = m_Offset + m_Scale * normalized value.
+    double m_Offset;
+    double m_Scale;
+};
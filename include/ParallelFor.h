@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Small helpers for splitting CPU work across cores. Threads are started per call,
+// so use these for coarse jobs (whole images, whole clouds), not per-pixel work.
+
+inline unsigned int GetWorkerThreadCount() {
+    const unsigned int n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+// Calls body(begin, end, workerIndex) on contiguous ranges covering [0, count).
+// Ranges are at least minPerWorker long, so small inputs run on the calling thread.
+template <typename Body>
+void ParallelForRanges(std::size_t count, std::size_t minPerWorker, Body&& body) {
+    if (count == 0) return;
+
+    minPerWorker = std::max<std::size_t>(minPerWorker, 1);
+    const std::size_t maxWorkers = (count + minPerWorker - 1) / minPerWorker;
+    const std::size_t workers = std::min<std::size_t>(GetWorkerThreadCount(), maxWorkers);
+    if (workers <= 1) {
+        body(std::size_t(0), count, 0u);
+        return;
+    }
+
+    const std::size_t perWorker = (count + workers - 1) / workers;
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (std::size_t w = 1; w < workers; w++) {
+        const std::size_t begin = w * perWorker;
+        const std::size_t end = std::min(count, begin + perWorker);
+        if (begin >= end) break;
+        threads.emplace_back([&body, begin, end, w]() { body(begin, end, static_cast<unsigned int>(w)); });
+    }
+    body(std::size_t(0), std::min(count, perWorker), 0u);
+    for (auto& t : threads) t.join();
+}
+
+// Calls body(index) for every index in [0, count), handing indices out dynamically
+// so uneven items (tiles, files) balance across workers.
+template <typename Body>
+void ParallelForEach(std::size_t count, Body&& body) {
+    if (count == 0) return;
+
+    const std::size_t workers = std::min<std::size_t>(GetWorkerThreadCount(), count);
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; i++) body(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            body(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (std::size_t w = 1; w < workers; w++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) t.join();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Reprojector.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ImageLoader;
+
+// Sub-pixel shift between the aligned and template images around a pixel, by phase
+// correlation: both crops are mean-subtracted, Hann-windowed and zero-padded to a power
+// of two, the normalized cross-power spectrum is tapered with a Gaussian, transformed
+// back, and its peak refined with a parabola on each axis. The shift is how far the aligned image is displaced
+// from the template (a star at x in the template sits at x + dx in the aligned image).
+class PhaseCorrelation {
+public:
+    static constexpr int kMinCrop = 8;
+    static constexpr int kMaxCrop = 1024;
+
+    struct Result {
+        bool valid{false};
+        float dx{0.0f};
+        float dy{0.0f};
+        float peak{0.0f};   // correlation peak height, 1 for identical crops
+        int centerX{0};     // where it was measured
+        int centerY{0};
+        int cropSize{0};
+        int fftSize{0};     // padded transform edge
+    };
+
+    // Crop edge cropSize (clamped to kMinCrop..kMaxCrop and the frame) around (centerX,
+    // centerY), shifted inside the frame near its edges. Safe to call from several threads.
+    static Result Measure(const ImageLoader& aligned, const ImageLoader& templ, int centerX, int centerY,
+                          int cropSize);
+    // Pixels [x0, x1] x [y0, y1] Measure reads on a width x height frame; false if the
+    // frame is smaller than kMinCrop.
+    static bool GetCropRect(int width, int height, int centerX, int centerY, int cropSize, int& x0, int& y0, int& x1,
+                            int& y1);
+};
+
+// Phase correlation for every target of a txt on a background thread. Targets are grouped
+// by FITS pair so each pair is loaded once, then measured in parallel.
+class RegistrationBatch {
+public:
+    struct Target {
+        int row{0};               // index into the browser's txt targets
+        std::string alignedPath;
+        std::string templatePath;
+        int pixelX{0};
+        int pixelY{0};
+    };
+
+    struct Entry {
+        Target target;
+        PhaseCorrelation::Result result;
+        std::string error;        // empty unless the pair could not be loaded
+    };
+
+    using ImageSource = std::function<std::shared_ptr<const ImageLoader>(const std::string&)>;
+
+    RegistrationBatch();
+    ~RegistrationBatch();
+
+    RegistrationBatch(const RegistrationBatch&) = delete;
+    RegistrationBatch& operator=(const RegistrationBatch&) = delete;
+
+    // Ignored (false) while a run is in progress. source must be safe to call from the
+    // worker thread. With reproject, each pair's template is resampled onto the aligned
+    // grid over the pair's crops before measuring, like the reprojected template in the view.
+    bool Start(std::vector<Target> targets, int cropSize, ImageSource source, bool reproject = false,
+               Reprojector::Params reprojectParams = Reprojector::Params());
+    void Cancel();
+    // Waits for a running batch to stop.
+    void Wait();
+
+    bool IsRunning() const { return m_Run.valid(); }
+    // True once, on the frame the run has finished; the results are then in GetResults().
+    bool Poll();
+    std::size_t GetDoneCount() const { return m_Done.load(); }
+    std::size_t GetTotalCount() const { return m_Total; }
+    const std::vector<Entry>& GetResults() const { return m_Results; }
+
+private:
+    std::future<std::vector<Entry>> m_Run;
+    std::atomic<bool> m_Cancelled;
+    std::atomic<std::size_t> m_Done;
+    std::size_t m_Total;
+    std::vector<Entry> m_Results;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class PointCloud;
+
+// Keeps GPU frame time under a target by adjusting a global point budget.
+// GPU time comes from GL_TIME_ELAPSED queries kept in a small ring, so reading a
+// result never waits on the GPU. The budget is then split across visible clouds.
+class PointBudgetGovernor {
+public:
+    PointBudgetGovernor();
+    ~PointBudgetGovernor();
+
+    bool Initialize();
+    void Shutdown();
+
+    // Bracket the GPU work of one frame (timer queries cannot nest).
+    void BeginFrame();
+    void EndFrame();
+
+    // Assign a draw count to every visible cloud so the total fits the current budget.
+    void Distribute(const std::vector<PointCloud*>& visibleClouds);
+
+    void SetEnabled(bool enabled) { m_Enabled = enabled; }
+    bool IsEnabled() const { return m_Enabled; }
+
+    void SetTargetFrameMs(float ms) { m_TargetFrameMs = ms; }
+    float GetTargetFrameMs() const { return m_TargetFrameMs; }
+
+    float GetLastGpuFrameMs() const { return m_LastGpuFrameMs; }
+    std::int64_t GetPointBudget() const { return m_PointBudget; }
+    std::int64_t GetLastTotalPoints() const { return m_LastTotalPoints; }
+    std::int64_t GetLastDrawnPoints() const { return m_LastDrawnPoints; }
+
+private:
+    void ReadFinishedQueries();
+    void AdjustBudget(float gpuFrameMs);
+
+    static constexpr int kQueryCount = 4;
+
+    unsigned int m_Queries[kQueryCount];
+    bool m_QueryPending[kQueryCount];
+    int m_WriteIndex;
+    bool m_QueryActive;
+
+    bool m_Enabled;
+    float m_TargetFrameMs;
+    float m_LastGpuFrameMs;
+
+    std::int64_t m_PointBudget;
+    std::int64_t m_MinPointBudget;
+    std::int64_t m_MaxPointBudget;
+    std::int64_t m_LastTotalPoints;
+    std::int64_t m_LastDrawnPoints;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Histogram.h"
+#include "ImageLoader.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// One ROI preview texture. The crop is resampled straight into a persistent pixel unpack
+// buffer and uploaded with glTexSubImage2D; the texture is only re-specified when the
+// output size changes. Scratch buffers are reused, so re-cropping at the same size (e.g.
+// while dragging) allocates nothing. Needs a current GL context; call Release() before
+// the context goes away.
+class PreviewEngine {
+public:
+    // Largest crop / output edge in pixels.
+    static constexpr int kMaxSize = 4096;
+
+    PreviewEngine();
+    ~PreviewEngine();
+
+    PreviewEngine(const PreviewEngine&) = delete;
+    PreviewEngine& operator=(const PreviewEngine&) = delete;
+
+    // Square crop of cropSize pixels centred on (centerX, centerY), resampled to
+    // outputSize^2 (0 = cropSize), FITS data stretched by the levels preset.
+    void Update(const ImageLoader& image, int centerX, int centerY, int cropSize, int outputSize = 0);
+    // Move the current crop to a new center, keeping its sizes.
+    void Recenter(const ImageLoader& image, int centerX, int centerY);
+    // Rebuild the current crop (e.g. after the levels preset changed).
+    void Refresh(const ImageLoader& image);
+    // Upload an RGBA buffer that was built elsewhere (e.g. by the prefetcher) with the
+    // same preset as the crop around (centerX, centerY) of image.
+    void Upload(const ImageLoader& image, const unsigned char* rgba, int centerX, int centerY, int cropSize,
+                int outputSize);
+    void Release();
+
+    void SetLevelsPreset(const Histogram::LevelsPreset& preset) { m_LevelsPreset = preset; }
+    const Histogram::LevelsPreset& GetLevelsPreset() const { return m_LevelsPreset; }
+    // Levels of the last crop (normalized values) and the histogram they came from:
+    // the crop's own, or null when the preset uses the whole image.
+    float GetLevelLow() const { return m_LevelLow; }
+    float GetLevelHigh() const { return m_LevelHigh; }
+    const Histogram* GetRoiHistogram() const { return m_LevelsPreset.fromRoi ? &m_RoiHistogram : nullptr; }
+
+    // Display levels of a crop under a preset; roiScratch holds the crop histogram.
+    // Shared with the prefetcher so prefetched crops match.
+    static void ComputeLevels(const ImageLoader& image, const Histogram::LevelsPreset& preset, int centerX,
+                              int centerY, int cropSize, Histogram& roiScratch, float& outLow, float& outHigh);
+
+    unsigned int GetTexture() const { return m_Texture; }
+    bool HasTexture() const { return m_Texture != 0; }
+    int GetCenterX() const { return m_CenterX; }
+    int GetCenterY() const { return m_CenterY; }
+    int GetCropSize() const { return m_CropSize; }
+    int GetOutputSize() const { return m_OutputSize; }
+
+    const std::string& GetName() const { return m_Name; }
+    void SetName(const std::string& name) { m_Name = name; }
+
+private:
+    // Texture and PBO sized for outputSize^2; returns the mapped PBO (or the CPU
+    // fallback buffer) to write the pixels into.
+    unsigned char* BeginUpload(int outputSize);
+    void EndUpload();
+
+    unsigned int m_Texture;
+    unsigned int m_Pbo;
+    int m_TextureSize; // edge of the allocated texture storage
+    bool m_Mapped;
+
+    int m_CenterX;
+    int m_CenterY;
+    int m_CropSize;
+    int m_OutputSize;
+    std::string m_Name;
+
+    Histogram::LevelsPreset m_LevelsPreset;
+    Histogram m_RoiHistogram;
+    float m_LevelLow;
+    float m_LevelHigh;
+
+    ImageLoader::RegionScratch m_Scratch;
+    std::vector<unsigned char> m_Fallback; // used if the PBO cannot be mapped
+};
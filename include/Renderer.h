@@ -6,6 +6,7 @@
 class Camera;
 class Shader;
 class GeometryObject;
+class PointBudgetGovernor;
 
 class Renderer {
 public:
@@ -23,6 +24,7 @@ public:
 
     void RenderGeometry(GeometryObject* object, Camera* camera);
     void RenderPointCloud(GeometryObject* object, Camera* camera);
+    void RenderSurface(GeometryObject* object, Camera* camera);
     void RenderLine(const glm::vec3& start, const glm::vec3& end, const glm::vec4& color, Camera* camera);
     void RenderGrid(float size, int divisions, Camera* camera);
     void RenderAxes(float length, Camera* camera);
@@ -30,6 +32,8 @@ public:
     Shader* GetDefaultShader() { return m_DefaultShader.get(); }
     Shader* GetLineShader() { return m_LineShader.get(); }
     Shader* GetPointCloudShader() { return m_PointCloudShader.get(); }
+    Shader* GetSurfaceShader() { return m_SurfaceShader.get(); }
+    PointBudgetGovernor* GetPointBudgetGovernor() { return m_PointBudget.get(); }
 
 private:
     void SetupShaders();
@@ -37,6 +41,8 @@ private:
     std::unique_ptr<Shader> m_DefaultShader;
     std::unique_ptr<Shader> m_LineShader;
     std::unique_ptr<Shader> m_PointCloudShader;
+    std::unique_ptr<Shader> m_SurfaceShader;
+    std::unique_ptr<PointBudgetGovernor> m_PointBudget;
 
     unsigned int m_LineVAO;
     unsigned int m_LineVBO;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+
+class ImageLoader;
+
+// Resamples a FITS image onto another image's pixel grid through both WCS, so a template
+// that was never aligned overlays the aligned frame. The exact pixel -> sky -> pixel
+// mapping is evaluated on a coarse grid per tile and interpolated in between (distortion
+// polynomials vary slowly); tiles run in parallel.
+class Reprojector {
+public:
+    enum class Interpolation : int { Bilinear = 0, Lanczos3 = 1 };
+
+    struct Params {
+        Interpolation interpolation{Interpolation::Lanczos3};
+        int tileSize{64};
+        int gridStep{8};   // exact mapping every gridStep pixels
+    };
+
+    // source resampled onto target's grid over target pixels [x0, x1] x [y0, y1] (clamped);
+    // the rest of the frame, pixels that fall outside source and pixels landing on blank
+    // source pixels are blank (ImageLoader::IsBlankPixel). Values keep source's
+    // normalization. Null (with a message) if either image has no WCS.
+    static std::shared_ptr<ImageLoader> Reproject(const ImageLoader& source, const ImageLoader& target, int x0, int y0,
+                                                  int x1, int y1, const Params& params);
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class ImageLoader;
+
+// Source extraction on top of the image's background map: pixels more than
+// thresholdSigma * rms above the local sky are grouped by a two-pass connected-component
+// labeling (union-find, 8-connected), and each component of at least minArea pixels
+// becomes a source with a flux-weighted centroid. Values are normalized like
+// ImageLoader::GetNormalizedPixelValue.
+class SourceDetector {
+public:
+    struct Params {
+        float thresholdSigma{3.0f};
+        int minArea{5};
+        int tileSize{512};    // whole-frame pass: tile edge
+        int tileMargin{32};   // whole-frame pass: overlap read around each tile
+    };
+
+    struct Source {
+        float x{0.0f};        // flux-weighted centroid (pixels)
+        float y{0.0f};
+        double flux{0.0};     // sum above the background
+        float peak{0.0f};     // highest value above the background
+        int area{0};          // pixels in the component
+        int x0{0}, y0{0}, x1{0}, y1{0}; // bounding box, inclusive
+    };
+
+    // Sources in pixels [x0, x1] x [y0, y1] (clamped to the image). Components are cut
+    // at the rectangle border. Appends to out.
+    static void DetectRegion(const ImageLoader& image, int x0, int y0, int x1, int y1, const Params& params,
+                             std::vector<Source>& out);
+    // Whole frame, tiles in parallel. Each tile is labeled with a margin and keeps the
+    // sources whose centroid falls inside it, so sources up to about the margin across
+    // are found once. Sorted by flux, brightest first.
+    static void DetectAll(const ImageLoader& image, const Params& params, std::vector<Source>& out);
+
+    // Index of the source whose centroid is closest to (x, y) within maxDistance, or -1.
+    static int FindNearest(const std::vector<Source>& sources, float x, float y, float maxDistance);
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "Data/TxtTargetParser.h"
+#include "Histogram.h"
+#include "ImageFilter.h"
+#include "ImageLoader.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Decoded images and prepared ROI point data for the targets around the one under
+// review, built on a background thread so stepping to a neighbour only uploads to GL.
+// Everything lives in one LRU cache bounded by a memory cap; a new Prefetch() call
+// replaces (cancels) the queued work of the previous one.
+class TargetPrefetcher {
+public:
+    // One image of a target: the inputs of Application's point generation.
+    struct Job {
+        std::string path;
+        bool useRoi{false};
+        int roiX{0};
+        int roiY{0};
+        int roiRadius{0};
+        std::vector<ImageLoader::PointHighlight> highlights;
+        int previewSize{0}; // ROI preview crop edge in pixels; 0 = none
+        Histogram::LevelsPreset levels; // display levels of the preview crop
+        ImageLoader::HeightMode heightMode{ImageLoader::HeightMode::Display};
+        ImageFilter::Params filter; // applied to the image the points come from
+        float scaleX{1.0f};
+        float scaleY{1.0f};
+        float scaleZ{1.0f};
+    };
+
+    // Both images of a label txt target. The jobs' paths are left empty: the worker
+    // resolves them from the record, so the UI thread never waits on the file index.
+    struct TargetJob {
+        TxtTargetRecord record;
+        Job aligned;
+        Job templ;
+    };
+
+    struct PreparedImage {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec4> colors;
+        std::vector<std::uint8_t> groups;
+        std::vector<unsigned char> previewRGBA; // previewSize^2 RGBA, empty if none
+    };
+
+    explicit TargetPrefetcher(std::size_t memoryCapBytes = std::size_t(1) << 30);
+    ~TargetPrefetcher();
+
+    TargetPrefetcher(const TargetPrefetcher&) = delete;
+    TargetPrefetcher& operator=(const TargetPrefetcher&) = delete;
+
+    // Replace the queued work, highest priority first. For txt files only the first
+    // target's FITS pair is decoded.
+    void Prefetch(std::vector<TargetJob> targets, std::vector<std::string> txtFiles);
+    void CancelAll();
+
+    // Decoded image from the cache, or loaded now and cached. Null if it cannot be loaded.
+    // With a filter, the filtered copy (cached per image + filter); images the filter
+    // cannot take come back unfiltered.
+    std::shared_ptr<const ImageLoader> GetImage(const std::string& path,
+                                                const ImageFilter::Params& filter = ImageFilter::Params());
+    // Cached image only (never loads), or null.
+    std::shared_ptr<const ImageLoader> FindImage(const std::string& path,
+                                                 const ImageFilter::Params& filter = ImageFilter::Params());
+    // Load (and filter) path on the worker ahead of the prefetch queue; a new Prefetch()
+    // does not drop it. FindImage() has it once done.
+    void RequestImage(const std::string& path, const ImageFilter::Params& filter);
+    // Prepared data for exactly this job, or null.
+    std::shared_ptr<const PreparedImage> FindPrepared(const Job& job);
+
+    // The point generation Application performs for a job (shared so results match).
+    // Points come from `points` (image after job.filter); the preview crop from image.
+    // On a binned or cropped grid (points.GetFrameGrid()) the job's pixel coordinates are
+    // mapped onto it and the cloud keeps the full image's world placement.
+    static void Prepare(const ImageLoader& image, const ImageLoader& points, const Job& job, PreparedImage& out);
+
+    void SetMemoryCapBytes(std::size_t bytes);
+    std::size_t GetMemoryCapBytes() const { return m_MemoryCap.load(); }
+    std::size_t GetMemoryBytes() const;
+    std::size_t GetPendingCount() const;
+    std::uint64_t GetHitCount() const { return m_Hits.load(); }
+    std::uint64_t GetMissCount() const { return m_Misses.load(); }
+
+private:
+    struct WorkItem {
+        enum class Kind { Target, Txt } kind{Kind::Target};
+        TargetJob target;
+        std::string txtPath;
+    };
+
+    struct CacheEntry {
+        std::shared_ptr<const ImageLoader> image;
+        std::shared_ptr<const PreparedImage> prepared;
+        std::size_t bytes{0};
+        std::uint64_t generation{0};
+        std::list<std::string>::iterator lru;
+    };
+
+    static std::string ImageKey(const std::string& path, const ImageFilter::Params& filter);
+    static std::string PreparedKey(const Job& job);
+
+    void WorkerLoop();
+    struct ImageRequest {
+        std::string path;
+        ImageFilter::Params filter;
+    };
+
+    // Prepare one job (path resolved) unless cached.
+    void PrepareJob(const Job& job, std::uint64_t generation);
+    // Decode (and filter) path unless cached; waits if another thread is already
+    // producing the same image.
+    std::shared_ptr<const ImageLoader> LoadImageCached(const std::string& path, const ImageFilter::Params& filter,
+                                                       std::uint64_t generation);
+    // Caller holds m_Mutex. Returns false if the cap could only be met by evicting
+    // entries of the current request (prefetching should stop).
+    bool InsertLocked(const std::string& key, CacheEntry entry);
+    void TouchLocked(CacheEntry& entry, std::uint64_t generation);
+
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_WorkCv;
+    std::condition_variable m_LoadCv;
+    std::deque<WorkItem> m_Pending;
+    std::deque<ImageRequest> m_Requested; // RequestImage(), served before m_Pending
+    std::vector<std::string> m_Loading; // image keys being decoded / filtered
+    std::unordered_map<std::string, CacheEntry> m_Cache;
+    std::list<std::string> m_Lru; // front = most recently used
+    std::size_t m_Bytes;
+    std::uint64_t m_Generation;
+
+    std::atomic<std::size_t> m_MemoryCap;
+    std::atomic<std::uint64_t> m_Hits;
+    std::atomic<std::uint64_t> m_Misses;
+    std::atomic<bool> m_Stop;
+    std::thread m_Worker;
+};
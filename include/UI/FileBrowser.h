@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Data/DirectoryScanner.h"
+
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <filesystem>
@@ -33,9 +36,12 @@ public:
     const std::string& GetNewUncheckedFile() const { return m_NewUncheckedFile; }
 
 private:
+    // Rebuild m_Files from the scanner's listing of m_CurrentPath (cheap, no disk I/O).
     void RefreshDirectory();
     void RenderDirectoryTree();
     void RenderFileList();
+    // Rebuild m_SortedIndices from the current sort column (directories stay first).
+    void SortFiles();
 
     bool m_IsOpen;
     std::string m_CurrentPath;
@@ -53,7 +59,15 @@ private:
         bool isChecked;
     };
 
+    DirectoryScanner m_Scanner;
+    std::uint64_t m_ScannerGeneration;
+    std::string m_ScannedPath; // folder the scanner keeps; others are dropped on navigation
+    bool m_ListingComplete;
+
     std::vector<FileEntry> m_Files;
+    std::vector<int> m_SortedIndices; // display order into m_Files
+    int m_SortColumn;                 // 1 name, 2 type, 3 size
+    bool m_SortAscending;
     int m_SelectedIndex;
 
     std::string m_NewCheckedFile;
@@ -1,8 +1,27 @@
 #pragma once
 
+#include "Data/DirectoryScanner.h"
+#include "Data/TargetCatalog.h"
+#include "Data/TxtTargetParser.h"
+#include "DifferenceImage.h"
+#include "FrameStacker.h"
+#include "Histogram.h"
+#include "ImageFilter.h"
+#include "ImageLoader.h"
+#include "PhaseCorrelation.h"
+#include "Reprojector.h"
+#include "SourceDetector.h"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <filesystem>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 class LabelDataBrowser {
@@ -45,29 +64,132 @@ public:
     // Highlight controls (recolor a square region around pixel center)
     int GetHighlightSizePixels() const { return m_HighlightSizePixels; }
     float GetHighlightPointSizeScale() const { return m_HighlightPointSizeScale; }
+    // Edge of the ROI preview crop: the highlight size unless set explicitly.
+    int GetPreviewCropPixels() const;
+    // What point heights show; changing it reloads the current pair.
+    ImageLoader::HeightMode GetHeightMode() const { return m_HeightMode; }
+    // Median / Gaussian / binning applied to the images before point generation.
+    const ImageFilter::Params& GetImageFilter() const { return m_ImageFilter; }
+    // Aligned - template layer over the same ROI; toggling it reloads the current pair.
+    bool IsDifferenceEnabled() const { return m_DifferenceEnabled; }
+    const DifferenceImage::Params& GetDifferenceParams() const { return m_DifferenceParams; }
+    void SetDifferenceStatus(const std::string& status) { m_DifferenceStatus = status; }
+
+    // Resample the template onto the aligned pixel grid through both WCS headers; toggling
+    // it reloads the current pair.
+    bool IsReprojectEnabled() const { return m_ReprojectEnabled; }
+    Reprojector::Interpolation GetReprojectInterpolation() const { return m_ReprojectInterpolation; }
+    void SetReprojectStatus(const std::string& status) { m_ReprojectStatus = status; }
+
+    // Other targets of the current txt that live in the same FITS pair as the selected one.
+    bool IsHighlightOtherTargetsEnabled() const { return m_HighlightOtherTargets; }
+    void GetOtherTargetPixelCenters(std::vector<std::pair<int, int>>& centers) const;
+
+    // Neighbours of the selected target for background prefetch: the targets up to
+    // GetPrefetchCount() rows before/after it (next first), then the txt files of as
+    // many sibling epoch folders on each side. FITS paths are left to the prefetch worker
+    // to resolve from the record.
+    struct PrefetchTarget {
+        TxtTargetRecord record;
+        std::vector<std::pair<int, int>> otherCenters; // empty unless highlighting other targets
+    };
+    void GetPrefetchTargets(std::vector<PrefetchTarget>& targets, std::vector<std::string>& siblingTxtFiles);
+    bool IsPrefetchEnabled() const { return m_PrefetchEnabled; }
+    int GetPrefetchCount() const { return m_PrefetchCount; }
+    std::size_t GetPrefetchMemoryBytes() const { return static_cast<std::size_t>(m_PrefetchMemoryMB) << 20; }
+    void SetPrefetchStatus(const std::string& status) { m_PrefetchStatus = status; }
+
+    // Statistics around the active center for the loaded aligned (slot 0) and template
+    // (slot 1) images; set by the application every frame.
+    struct RoiStatistics {
+        bool valid{false};
+        std::size_t roiCount{0};
+        double roiMean{0.0};
+        double roiStddev{0.0};
+        double apertureMean{0.0}; // highlight box
+        bool hasSnr{false};
+        double snr{0.0};          // highlight box against the rest of the ROI
+    };
+    void SetRoiStatistics(int slot, const RoiStatistics& stats);
+
+    // Auto-levels preset for the previews, and the histogram plots the application fills
+    // in for the aligned (slot 0) / template (slot 1) previews. Values are data units.
+    const Histogram::LevelsPreset& GetLevelsPreset() const { return m_LevelsPreset; }
+    struct HistogramView {
+        bool valid{false};
+        std::vector<float> bins; // log10(1 + count) over [viewMin, viewMax]
+        double viewMin{0.0};
+        double viewMax{1.0};
+        double levelLow{0.0};
+        double levelHigh{1.0};
+        float levelLowFraction{0.0f}; // level positions within the plot, 0..1
+        float levelHighFraction{1.0f};
+    };
+    HistogramView& GetHistogramView(int slot) { return m_HistogramViews[slot == 1 ? 1 : 0]; }
 
     // Event: center camera view/rotation on ROI center (pixel_x, pixel_y)
     bool HasCenterCameraOnRoiRequest() const { return m_RequestCenterCameraOnRoi; }
     void ClearCenterCameraOnRoiRequest() { m_RequestCenterCameraOnRoi = false; }
 
-    struct TxtTargetRecord {
-        std::string index;
-        std::string fileDir;
-        std::string alignedFilename;
-        std::string templateAlignedFilename;
-        bool hasPixelCenter{false};
-        int pixelX{0};
-        int pixelY{0};
-        bool hasRaDec{false};
-        double ra{0.0};
-        double dec{0.0};
-    };
+    // Event: source detection around the center / over the ROI / over the whole frame.
+    // Snapping moves the active center to the nearest centroid within GetSnapRadius().
+    enum class SourceRequest { None, SnapToNearest, DetectRoi, DetectFrame };
+    SourceRequest GetSourceRequest() const { return m_SourceRequest; }
+    void ClearSourceRequest() { m_SourceRequest = SourceRequest::None; }
+    const SourceDetector::Params& GetSourceParams() const { return m_SourceParams; }
+    int GetSnapRadius() const { return m_SnapRadius; }
+    void SetSourceStatus(const std::string& status) { m_SourceStatus = status; }
+    // Sources of the last ROI / whole-frame detection, listed in the browser (a row
+    // selects its centroid as the active center).
+    void SetSources(std::vector<SourceDetector::Source> sources) { m_Sources = std::move(sources); }
+    void SetSourceDetectionRunning(bool running) { m_SourceDetectionRunning = running; }
+
+    // Registration check by phase correlation: the application measures the shift at the
+    // preview center, and on request for every target of the txt. A target is flagged when
+    // the shift exceeds the max or the correlation peak is weaker than the min; targets that
+    // could not be measured are listed as a separate category.
+    enum class RegistrationRequest { None, CheckAll, Cancel };
+    RegistrationRequest GetRegistrationRequest() const { return m_RegistrationRequest; }
+    void ClearRegistrationRequest() { m_RegistrationRequest = RegistrationRequest::None; }
+    void SetRegistrationRequest(RegistrationRequest request) { m_RegistrationRequest = request; }
+    int GetRegistrationCropPixels() const { return m_RegistrationCropPixels; }
+    bool IsMisregistered(const PhaseCorrelation::Result& result) const;
+    // Targets of the current txt with a pixel center and resolvable FITS pair.
+    // False while the FITS file index is still being built; ask again on a later frame.
+    bool GetRegistrationTargets(std::vector<RegistrationBatch::Target>& targets) const;
+    void SetRegistrationResults(const std::string& txtPath, std::vector<RegistrationBatch::Entry> results);
+    void SetRegistrationStatus(bool running, const std::string& status);
+
+    using TxtTargetRecord = ::TxtTargetRecord;
 
 private:
     void ResolveRootPath();
-    void RenderDirectoryTree(const std::filesystem::path& dir);
+    // The tree is flattened into m_TreeRows (open directories only) and drawn clipped.
+    void RenderDirectoryTree();
+    void BuildTreeRows(const std::filesystem::path& dir, int depth);
+    void RenderTxtTargetTable();
+    void RenderLevelsControls();
+    void RenderSourceControls();
+    void RenderRegistrationControls();
+    // Frames picked from the current pair (one per epoch) are stacked into a FITS next to
+    // the first of them, on the stacker's thread.
+    void RenderStackControls();
+    void PollStack();
+    void SortTxtTargets();
     void TryParseFitsPairFromTxtSelection(const std::filesystem::path& txtPath);
     void SelectTxtTargetIndex(int idx, bool triggerReload);
+    void SelectTxtFile(const std::filesystem::path& txtPath, std::uintmax_t size);
+    void GetOtherTargetPixelCenters(int index, std::vector<std::pair<int, int>>& centers) const;
+
+    // Catalog of all txt under the root. The on-disk cache is shown first; the root is
+    // then re-walked on a background thread and only changed txt files are parsed.
+    void RenderCatalogPanel();
+    void StartCatalogLoad();
+    void PollCatalogLoad();
+    void RunCatalogQuery();
+    void OpenCatalogRow(std::uint32_t row);
+    void RenderCatalogResults();
+    void SortCatalogResults();
 
     struct CachedEntry {
         std::filesystem::path path;
@@ -76,6 +198,14 @@ private:
         std::uintmax_t size;
     };
 
+    struct TreeRow {
+        std::filesystem::path path;
+        std::string label;
+        int depth;
+        bool isDirectory;
+        std::uintmax_t size;
+    };
+
     const std::vector<CachedEntry>& GetDirectoryEntriesCached(const std::filesystem::path& dir);
 
     bool m_IsOpen;
@@ -101,15 +231,95 @@ private:
     int m_ActivePixelY;
 
     std::vector<TxtTargetRecord> m_TxtTargets;
+    TxtParseReport m_TxtParseReport; // header/malformed-line warnings of the selected txt
     int m_SelectedTxtTargetIndex;
+    // Selection whose FITS paths wait for the file index; retried each frame until ready.
+    int m_PendingTxtTargetIndex;
+    bool m_PendingTxtTargetReload;
+    std::vector<int> m_TxtTargetOrder; // display order into m_TxtTargets
+    int m_TxtTargetSortColumn;         // -1 = file order
+    bool m_TxtTargetSortAscending;
+    bool m_TxtTargetOrderDirty;
 
     bool m_RoiEnabled;
     int m_RoiRadius;
     int m_HighlightSizePixels;
     float m_HighlightPointSizeScale;
+    int m_PreviewCropPixels; // 0 = follow the highlight size
+    ImageLoader::HeightMode m_HeightMode;
+    ImageFilter::Params m_ImageFilter;
+    bool m_DifferenceEnabled;
+    DifferenceImage::Params m_DifferenceParams;
+    std::string m_DifferenceStatus;
+    bool m_ReprojectEnabled;
+    Reprojector::Interpolation m_ReprojectInterpolation;
+    std::string m_ReprojectStatus;
+    bool m_HighlightOtherTargets;
     bool m_RequestCenterCameraOnRoi;
+    SourceRequest m_SourceRequest;
+    SourceDetector::Params m_SourceParams;
+    int m_SnapRadius;
+    std::string m_SourceStatus;
+    std::vector<SourceDetector::Source> m_Sources;
+    bool m_SourceDetectionRunning;
+    RegistrationRequest m_RegistrationRequest;
+    int m_RegistrationCropPixels;
+    float m_RegistrationMaxShift;   // pixels
+    float m_RegistrationMinPeak;
+    bool m_RegistrationRunning;
+    bool m_RegistrationOnlyFlagged;
+    std::string m_RegistrationStatus;
+    std::vector<RegistrationBatch::Entry> m_RegistrationResults; // rows of the current txt
+    FrameStacker m_FrameStacker;
+    FrameStacker::Params m_StackParams;
+    int m_StackMemoryMB;
+    std::vector<std::string> m_StackInputs;
+    std::string m_StackOutputPath; // last written stack
+    std::string m_StackStatus;
+    RoiStatistics m_RoiStatistics[2];
+    Histogram::LevelsPreset m_LevelsPreset;
+    HistogramView m_HistogramViews[2];
+
+    bool m_PrefetchEnabled;
+    int m_PrefetchCount;     // targets / sibling folders on each side
+    int m_PrefetchMemoryMB;
+    std::string m_PrefetchStatus;
+
+    // Hand-off from the load thread: the cached catalog, published before the refresh.
+    struct CatalogStage {
+        std::mutex mutex;
+        std::shared_ptr<TargetCatalog> cached;
+    };
+
+    std::shared_ptr<TargetCatalog> m_Catalog;
+    std::shared_ptr<CatalogStage> m_CatalogStage;
+    std::future<std::shared_ptr<TargetCatalog>> m_CatalogLoad;
+    bool m_CatalogAutoStarted;
+    std::string m_CatalogMessage;
+    TargetCatalog::Query m_CatalogQuery;
+    int m_CatalogLabelFilter;  // 0 all, 1 GOOD, 2 BAD
+    std::vector<std::uint32_t> m_CatalogResults;
+    std::vector<double> m_CatalogSeparations; // arcsec, parallel to results in cone mode
+    bool m_CatalogConeEnabled;
+    double m_ConeRa;
+    double m_ConeDec;
+    double m_ConeRadiusArcsec;
+    double m_CatalogQueryMs;
+    bool m_CatalogQueryDirty;
+    std::vector<std::uint32_t> m_CatalogOrder; // display order into m_CatalogResults
+    int m_CatalogSortColumn;                   // -1 = query order
+    bool m_CatalogSortAscending;
 
-    // Cache directory listings so the UI doesn't re-scan the filesystem every frame.
+    // Listings come from a background scanner; this per-frame view of them is dropped
+    // whenever the scanner reports a change.
+    DirectoryScanner m_DirectoryScanner;
+    std::uint64_t m_ScannerGeneration;
+    std::uint64_t m_ScannerChangeGeneration;
+    bool m_CatalogRefreshPending; // txt changes seen on disk, refresh once they settle
+    std::chrono::steady_clock::time_point m_LastDiskChange;
     std::unordered_map<std::string, std::vector<CachedEntry>> m_DirectoryCache;
+    std::unordered_set<std::string> m_OpenDirectories;
+    std::vector<TreeRow> m_TreeRows;
+    bool m_TreeRowsDirty;
 };
 
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Celestial WCS of a FITS image: gnomonic (TAN) projection with the linear CD / PC+CDELT /
+// CROTA2 pixel transform, optionally distorted by TPV (PVi_j polynomial on the intermediate
+// coordinates) or SIP (A_p_q / B_p_q polynomial on the pixel offsets). Axis 1 must be RA,
+// axis 2 Dec; LONPOLE is taken as the zenithal default (180).
+class Wcs {
+public:
+    enum class Projection { None, Tan, Tpv, TanSip };
+
+    Wcs();
+
+    // Parse 80-character header cards. False (and IsValid() false) if there is no
+    // supported celestial WCS; message says why.
+    bool Parse(const std::vector<std::string>& cards, std::string& message);
+
+    bool IsValid() const { return m_Projection != Projection::None; }
+    Projection GetProjection() const { return m_Projection; }
+    const char* GetProjectionName() const;
+
+    // Same sky on a grid binned by factor (binned pixel x covers pixels
+    // [x * factor, (x + 1) * factor) of this one).
+    Wcs Binned(int factor) const;
+    // Same sky on the crop whose pixel (0, 0) is pixel (x0, y0) of this grid.
+    Wcs Cropped(int x0, int y0) const;
+
+    // Zero-based pixel coordinates <-> RA/Dec in degrees.
+    bool PixelToWorld(double x, double y, double& ra, double& dec) const;
+    bool WorldToPixel(double ra, double dec, double& x, double& y) const;
+
+private:
+    // Pixel offsets from CRPIX -> intermediate world coordinates (degrees), with distortion.
+    void OffsetToIntermediate(double u, double v, double& xi, double& eta) const;
+    void ApplyTpv(double x, double y, double& xi, double& eta) const;
+    void ApplySip(double u, double v, double& du, double& dv) const;
+
+    Projection m_Projection;
+    double m_CrPix[2];
+    double m_CrVal[2];
+    double m_Cd[2][2];
+    double m_CdInverse[2][2];
+    std::vector<double> m_Pv[2];   // TPV, 40 coefficients per axis
+    int m_SipOrder;
+    std::vector<double> m_SipA;    // (order + 1)^2, index p * (order + 1) + q
+    std::vector<double> m_SipB;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// IRAF zscale display limits: sort a regularly spaced sample of about 1000 pixels, fit
+// a line to the sorted values with iterative sigma clipping, and take the limits from
+// the fitted slope (scaled by the contrast) around the sample median. The cost depends
+// on the sample size only, not on the frame size.
+class ZScale {
+public:
+    struct Params {
+        int sampleCount{1000};
+        float contrast{0.25f};
+        float rejectSigma{2.5f};
+        int maxIterations{5};
+        float maxRejectFraction{0.5f};
+        int minPixels{5};
+    };
+
+    // Sample rectangle [x0, x1] x [y0, y1] (inclusive) on a regular grid through
+    // sample(x, y). Non-finite values are skipped.
+    template <typename Sampler>
+    static void GatherSamples(int x0, int y0, int x1, int y1, int sampleCount, Sampler&& sample,
+                              std::vector<float>& outSamples);
+
+    // Limits from gathered samples (sorted in place). Returns false if there are no
+    // samples; with too few good pixels the limits are the sample min/max.
+    static bool ComputeFromSamples(std::vector<float>& samples, const Params& params, float& outLow, float& outHigh);
+
+    template <typename Sampler>
+    static bool Compute(int x0, int y0, int x1, int y1, Sampler&& sample, const Params& params, float& outLow,
+                        float& outHigh) {
+        std::vector<float> samples;
+        GatherSamples(x0, y0, x1, y1, params.sampleCount, sample, samples);
+        return ComputeFromSamples(samples, params, outLow, outHigh);
+    }
+};
+
+template <typename Sampler>
+void ZScale::GatherSamples(int x0, int y0, int x1, int y1, int sampleCount, Sampler&& sample,
+                           std::vector<float>& outSamples) {
+    outSamples.clear();
+    if (x0 > x1 || y0 > y1 || sampleCount <= 0) return;
+
+    // Same stride on both axes, so the grid is about sampleCount points.
+    const long long width = x1 - x0 + 1;
+    const long long height = y1 - y0 + 1;
+    int stride = 1;
+    while (static_cast<long long>(stride) * stride * sampleCount < width * height) stride++;
+
+    outSamples.reserve(static_cast<std::size_t>(sampleCount) + width / stride + 1);
+    for (int y = y0 + stride / 2; y <= y1; y += stride) {
+        for (int x = x0 + stride / 2; x <= x1; x += stride) {
+            const float v = sample(x, y);
+            if (std::isfinite(v)) outSamples.push_back(v);
+        }
+    }
+}
@@ -4,8 +4,14 @@
 #include "Geometry/Cube.h"
 #include "Geometry/Point.h"
 #include "Geometry/PointCloud.h"
+#include "Geometry/ImageSurface.h"
 #include "UI/FileBrowser.h"
 #include "UI/LabelDataBrowser.h"
+#include "Data/TxtTargetParser.h"
+#include "PointBudgetGovernor.h"
+#include "Reprojector.h"
+#include "SourceDetector.h"
+#include "Wcs.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -15,25 +21,81 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <filesystem>
+#include <unordered_set>
+#include <chrono>
+
+namespace {
+// Image layers are chunked into square tiles of this many pixels for the far-view LOD.
+constexpr int kLodChunkPixels = 128;
+// Far-view surface limits: mesh cells per side and texture size per side.
+constexpr int kSurfaceMaxCells = 256;
+constexpr int kSurfaceMaxTextureSize = 2048;
+
+// Pixel -> world mapping of image layers: pixel x/y -> world x/z, pixel value -> height.
+constexpr float kImageScaleX = 0.1f;
+constexpr float kImageScaleY = 10.0f;
+constexpr float kImageScaleZ = 0.1f;
+
+// m_ImagePointsMap key of the difference layer.
+const char* const kDifferenceLayerKey = "[difference]";
+
+std::int64_t TileKey(int tileX, int tileZ) {
+    return (static_cast<std::int64_t>(tileX) << 32) ^ static_cast<std::uint32_t>(tileZ);
+}
+
+// Highlight groups, drawn in the same point cloud as the image:
+// 1 = selected target, 2 = other targets in the txt.
+std::vector<ImageLoader::PointHighlight> BuildTargetHighlights(bool hasCenter, int centerX, int centerY,
+                                                               const std::vector<std::pair<int, int>>& otherCenters,
+                                                               int highlightSize, float highlightScale,
+                                                               const glm::vec4& primaryColor) {
+    std::vector<ImageLoader::PointHighlight> highlights;
+    if (!hasCenter) return highlights;
+
+    ImageLoader::PointHighlight primary;
+    primary.centerX = centerX;
+    primary.centerY = centerY;
+    primary.sizePixels = highlightSize;
+    primary.color = primaryColor;
+    primary.group = 1;
+    primary.pointSizeScale = highlightScale;
+    highlights.push_back(primary);
+
+    for (const auto& [x, y] : otherCenters) {
+        ImageLoader::PointHighlight other;
+        other.centerX = x;
+        other.centerY = y;
+        other.sizePixels = highlightSize;
+        other.color = glm::vec4(1.0f, 0.8431f, 0.0f, 1.0f); // Gold (#FFD700)
+        other.group = 2;
+        other.pointSizeScale = std::max(1.0f, highlightScale * 0.5f);
+        highlights.push_back(other);
+    }
+    return highlights;
+}
+
+const glm::vec4 kAlignedHighlightColor(1.0f, 0.2706f, 0.0f, 1.0f);       // OrangeRed (#FF4500)
+const glm::vec4 kTemplateHighlightColor(0.5294f, 0.8078f, 0.9216f, 1.0f); // SkyBlue (#87CEEB)
+} // namespace
 
 Application::Application()
     : m_Running(false)
     , m_LastFrameTime(0.0f)
     , m_HasFramedView(false)
-    , m_AlignedPreviewTex(0)
-    , m_TemplatePreviewTex(0)
-    , m_AlignedPreviewSize(0)
-    , m_TemplatePreviewSize(0)
-    , m_AlignedPreviewCenterX(0)
-    , m_AlignedPreviewCenterY(0)
-    , m_TemplatePreviewCenterX(0)
-    , m_TemplatePreviewCenterY(0)
+    , m_ImageLodEnabled(true)
+    , m_ImageLodThresholdPx(1.5f)
+    , m_HeightMode(ImageLoader::HeightMode::Display)
+    , m_SourcesImage(nullptr)
+    , m_RegistrationImages{nullptr, nullptr}
     , m_HasAlignedPreviewClick(false)
     , m_HasTemplatePreviewClick(false)
     , m_AlignedPreviewClickX(0)
     , m_AlignedPreviewClickY(0)
     , m_TemplatePreviewClickX(0)
     , m_TemplatePreviewClickY(0)
+    , m_PreviewDragMoved(false)
+    , m_PreviewDragStartX(0)
+    , m_PreviewDragStartY(0)
 {
 }
 
@@ -78,8 +140,13 @@ bool Application::Initialize() {
     m_Axes = std::make_unique<Axes>(5.0f);
     m_Axes->Initialize();
 
-    // Create image loader
-    m_ImageLoader = std::make_unique<ImageLoader>();
+    // Image cache / background preparation of neighbouring label targets.
+    m_Prefetcher = std::make_unique<TargetPrefetcher>();
+    m_ImageLoader = std::make_shared<ImageLoader>();
+
+    // Start indexing the FITS search roots now so selecting a label target never walks
+    // the directory trees itself.
+    GetFitsFileIndex();
 
     // Add some default objects
     auto sphere = std::make_shared<Sphere>(glm::vec3(0.0f, 1.0f, 0.0f), 1.0f);
@@ -116,19 +183,24 @@ void Application::Run() {
 }
 
 void Application::Shutdown() {
+    // The batch loads through the prefetcher; stop it first.
+    m_RegistrationBatch.Cancel();
+    m_RegistrationBatch.Wait();
+
     // Delete preview textures while OpenGL context is still valid.
-    if (m_AlignedPreviewTex != 0) {
-        glDeleteTextures(1, &m_AlignedPreviewTex);
-        m_AlignedPreviewTex = 0;
-    }
-    if (m_TemplatePreviewTex != 0) {
-        glDeleteTextures(1, &m_TemplatePreviewTex);
-        m_TemplatePreviewTex = 0;
-    }
-    m_AlignedPreviewSize = 0;
-    m_TemplatePreviewSize = 0;
-    m_AlignedPreviewName.clear();
-    m_TemplatePreviewName.clear();
+    m_AlignedPreview.Release();
+    m_TemplatePreview.Release();
+    m_AlignedImage.reset();
+    m_TemplateImage.reset();
+    m_DifferenceQueued = DifferenceRequest();
+    if (m_DifferenceRun.valid()) m_DifferenceRun.wait();
+    m_Difference.Clear();
+    m_FilterPending.clear();
+    if (m_SourceRun.valid()) m_SourceRun.wait();
+    m_SourceRunImage.reset();
+    m_ReprojectQueued = ReprojectedTemplate();
+    if (m_ReprojectRun.valid()) m_ReprojectRun.wait();
+    m_Reprojected = ReprojectedTemplate();
 
     m_GeometryObjects.clear();
     m_Axes.reset();
@@ -169,6 +241,22 @@ void Application::Update(float deltaTime) {
 
     // Check for new FITS pair selection from label txt
     LabelDataBrowser* labelBrowser = m_UIManager->GetLabelDataBrowser();
+    if (labelBrowser && labelBrowser->GetLevelsPreset() != m_LevelsPreset) {
+        // New auto-levels preset: restretch the previews in place.
+        m_LevelsPreset = labelBrowser->GetLevelsPreset();
+        m_AlignedPreview.SetLevelsPreset(m_LevelsPreset);
+        m_TemplatePreview.SetLevelsPreset(m_LevelsPreset);
+        if (m_AlignedImage) m_AlignedPreview.Refresh(*m_AlignedImage);
+        if (m_TemplateImage) m_TemplatePreview.Refresh(*m_TemplateImage);
+    }
+    if (labelBrowser) m_HeightMode = labelBrowser->GetHeightMode();
+    if (labelBrowser) m_ImageFilter = labelBrowser->GetImageFilter();
+    if (labelBrowser && labelBrowser->GetSourceRequest() != LabelDataBrowser::SourceRequest::None) {
+        HandleSourceRequest(labelBrowser);
+        labelBrowser->ClearSourceRequest();
+    }
+    if (labelBrowser) PollSourceDetection(labelBrowser);
+
     if (labelBrowser && labelBrowser->HasCenterCameraOnRoiRequest()) {
         labelBrowser->ClearCenterCameraOnRoiRequest();
 
@@ -185,16 +273,16 @@ void Application::Update(float deltaTime) {
             namespace fs = std::filesystem;
             if (!fitsPath.empty() && fs::exists(fs::path(fitsPath))) {
                 // Load image data so we can sample the ROI center height.
-                if (m_ImageLoader->LoadImage(fitsPath)) {
-                    // Must match the mapping used in LoadImageAndGeneratePointsInternal.
-                    const float scaleX = 0.1f;
-                    const float scaleY = 10.0f;
-                    const float scaleZ = 0.1f;
+                if (LoadCurrentImage(fitsPath)) {
+                    // Same mapping as LoadImageAndGeneratePointsInternal.
+                    const float scaleX = kImageScaleX;
+                    const float scaleY = kImageScaleY;
+                    const float scaleZ = kImageScaleZ;
 
                     const float centerX = m_ImageLoader->GetWidth() * 0.5f;
                     const float centerZ = m_ImageLoader->GetHeight() * 0.5f;
 
-                    const float height = m_ImageLoader->GetNormalizedPixelValue(roiX, roiY) * scaleY;
+                    const float height = m_ImageLoader->GetHeightValue(roiX, roiY, m_HeightMode) * scaleY;
                     const glm::vec3 newTarget(
                         (roiX - centerX) * scaleX,
                         height,
@@ -238,45 +326,78 @@ void Application::Update(float deltaTime) {
                 centerFits = templateFits;
             }
             if (!centerFits.empty() && fs::exists(fs::path(centerFits))) {
-                if (m_ImageLoader->LoadImage(centerFits)) {
+                if (LoadCurrentImage(centerFits)) {
                     CenterCameraOnPixelInCurrentImage(roiX, roiY);
                 }
             }
         }
 
+        int highlightSize = labelBrowser->GetHighlightSizePixels();
+        if (highlightSize < 1) highlightSize = 1;
+        if (highlightSize > 300) highlightSize = 300;
+        float highlightScale = labelBrowser->GetHighlightPointSizeScale();
+        if (highlightScale < 1.0f) highlightScale = 1.0f;
+        if (highlightScale > 20.0f) highlightScale = 20.0f;
+        const int previewSize = labelBrowser->GetPreviewCropPixels();
+
+        std::vector<std::pair<int, int>> otherCenters;
+        if (labelBrowser->IsHighlightOtherTargetsEnabled()) {
+            labelBrowser->GetOtherTargetPixelCenters(otherCenters);
+        }
+
+        // Aligned -> orange-red, template -> sky-blue.
         if (!alignedFits.empty() && fs::exists(fs::path(alignedFits))) {
-            // Highlight 10x10 around ROI center:
-            // aligned -> orange-red, template -> sky-blue
-            const bool doHighlight = labelBrowser->HasActivePixelCenter();
-            int highlightSize = labelBrowser->GetHighlightSizePixels();
-            if (highlightSize < 1) highlightSize = 1;
-            if (highlightSize > 300) highlightSize = 300;
-            float highlightScale = labelBrowser->GetHighlightPointSizeScale();
-            if (highlightScale < 1.0f) highlightScale = 1.0f;
-            if (highlightScale > 20.0f) highlightScale = 20.0f;
-            const glm::vec4 alignedHighlight(1.0f, 0.2706f, 0.0f, 1.0f);   // OrangeRed (#FF4500)
             LoadImageAndGeneratePointsInternal(alignedFits, /*replaceExisting*/ true, useRoi, roiX, roiY, roiR,
-                                               doHighlight, roiX, roiY, highlightSize, alignedHighlight, highlightScale,
-                                               /*previewSlot*/ 1);
+                                               BuildTargetHighlights(labelBrowser->HasActivePixelCenter(), roiX, roiY,
+                                                                     otherCenters, highlightSize, highlightScale,
+                                                                     kAlignedHighlightColor),
+                                               /*previewSlot*/ 1, previewSize);
         } else {
             std::cerr << "Aligned FITS not found: " << alignedFits << std::endl;
         }
 
         if (!templateFits.empty() && fs::exists(fs::path(templateFits))) {
-            const bool doHighlight = labelBrowser->HasActivePixelCenter();
-            int highlightSize = labelBrowser->GetHighlightSizePixels();
-            if (highlightSize < 1) highlightSize = 1;
-            if (highlightSize > 300) highlightSize = 300;
-            float highlightScale = labelBrowser->GetHighlightPointSizeScale();
-            if (highlightScale < 1.0f) highlightScale = 1.0f;
-            if (highlightScale > 20.0f) highlightScale = 20.0f;
-            const glm::vec4 templateHighlight(0.5294f, 0.8078f, 0.9216f, 1.0f); // SkyBlue (#87CEEB)
+            m_TemplateLoad.path = templateFits;
+            m_TemplateLoad.useRoi = useRoi;
+            m_TemplateLoad.roiX = roiX;
+            m_TemplateLoad.roiY = roiY;
+            m_TemplateLoad.roiRadius = roiR;
+            m_TemplateLoad.highlights = BuildTargetHighlights(labelBrowser->HasActivePixelCenter(), roiX, roiY,
+                                                              otherCenters, highlightSize, highlightScale,
+                                                              kTemplateHighlightColor);
+            m_TemplateLoad.previewSlot = 2;
+            m_TemplateLoad.previewSize = previewSize;
+            UpdateReprojectedTemplate(labelBrowser, templateFits, useRoi, roiX, roiY, roiR);
             LoadImageAndGeneratePointsInternal(templateFits, /*replaceExisting*/ true, useRoi, roiX, roiY, roiR,
-                                               doHighlight, roiX, roiY, highlightSize, templateHighlight, highlightScale,
-                                               /*previewSlot*/ 2);
+                                               m_TemplateLoad.highlights, /*previewSlot*/ 2, previewSize);
         } else {
+            m_TemplateLoad = PointsLoad();
             std::cerr << "Template FITS not found: " << templateFits << std::endl;
         }
+
+        UpdateDifferenceLayer(labelBrowser, useRoi, roiX, roiY, roiR);
+        SchedulePrefetch(labelBrowser);
+    }
+
+    if (labelBrowser && m_Prefetcher) {
+        m_Prefetcher->SetMemoryCapBytes(labelBrowser->GetPrefetchMemoryBytes());
+        if (!labelBrowser->IsPrefetchEnabled() && m_Prefetcher->GetPendingCount() > 0) m_Prefetcher->CancelAll();
+
+        char status[160];
+        std::snprintf(status, sizeof(status), "cache %.0f / %.0f MB, %zu queued, %llu hits / %llu misses",
+                      m_Prefetcher->GetMemoryBytes() / 1048576.0, m_Prefetcher->GetMemoryCapBytes() / 1048576.0,
+                      m_Prefetcher->GetPendingCount(), static_cast<unsigned long long>(m_Prefetcher->GetHitCount()),
+                      static_cast<unsigned long long>(m_Prefetcher->GetMissCount()));
+        labelBrowser->SetPrefetchStatus(status);
+    }
+
+    PollFilteredImages();
+    if (labelBrowser) {
+        PollReprojectedTemplate(labelBrowser);
+        PollDifferenceLayer(labelBrowser);
+        UpdateRoiStatistics(labelBrowser);
+        UpdateHistogramViews(labelBrowser);
+        UpdateRegistration(labelBrowser);
     }
 
     for (auto& object : m_GeometryObjects) {
@@ -286,18 +407,559 @@ void Application::Update(float deltaTime) {
     }
 }
 
+bool Application::LoadCurrentImage(const std::string& path) {
+    std::shared_ptr<const ImageLoader> image = m_Prefetcher->GetImage(path);
+    if (!image) return false;
+    m_ImageLoader = std::move(image);
+    return true;
+}
+
+void Application::SchedulePrefetch(LabelDataBrowser* labelBrowser) {
+    std::vector<LabelDataBrowser::PrefetchTarget> targets;
+    std::vector<std::string> siblingTxtFiles;
+    labelBrowser->GetPrefetchTargets(targets, siblingTxtFiles);
+    if (targets.empty() && siblingTxtFiles.empty()) {
+        m_Prefetcher->CancelAll();
+        return;
+    }
+
+    // Same parameters LabelDataBrowser will hand us when the neighbour is selected.
+    const int roiR = std::clamp(labelBrowser->GetRoiRadius(), 50, 500);
+    const int highlightSize = std::clamp(labelBrowser->GetHighlightSizePixels(), 1, 300);
+    const float highlightScale = std::clamp(labelBrowser->GetHighlightPointSizeScale(), 1.0f, 20.0f);
+
+    std::vector<TargetPrefetcher::TargetJob> jobs;
+    for (auto& target : targets) {
+        const TxtTargetRecord& rec = target.record;
+        TargetPrefetcher::Job job;
+        job.useRoi = rec.hasPixelCenter && labelBrowser->IsRoiEnabled();
+        job.roiX = rec.pixelX;
+        job.roiY = rec.pixelY;
+        job.roiRadius = roiR;
+        job.previewSize = labelBrowser->GetPreviewCropPixels();
+        job.levels = m_LevelsPreset;
+        job.heightMode = m_HeightMode;
+        job.filter = m_ImageFilter;
+        job.scaleX = kImageScaleX;
+        job.scaleY = kImageScaleY;
+        job.scaleZ = kImageScaleZ;
+
+        TargetPrefetcher::TargetJob targetJob;
+        targetJob.aligned = job;
+        targetJob.aligned.highlights = BuildTargetHighlights(rec.hasPixelCenter, rec.pixelX, rec.pixelY,
+                                                             target.otherCenters, highlightSize, highlightScale,
+                                                             kAlignedHighlightColor);
+        targetJob.templ = std::move(job);
+        targetJob.templ.highlights = BuildTargetHighlights(rec.hasPixelCenter, rec.pixelX, rec.pixelY,
+                                                           target.otherCenters, highlightSize, highlightScale,
+                                                           kTemplateHighlightColor);
+        targetJob.record = std::move(target.record);
+        jobs.push_back(std::move(targetJob));
+    }
+    m_Prefetcher->Prefetch(std::move(jobs), std::move(siblingTxtFiles));
+}
+
+void Application::UpdateDifferenceLayer(LabelDataBrowser* labelBrowser, bool useRoi, int roiX, int roiY,
+                                        int roiRadius) {
+    if (m_ImagePointsMap.find(kDifferenceLayerKey) != m_ImagePointsMap.end()) {
+        RemoveImagePoints(kDifferenceLayerKey);
+    }
+    m_DifferenceQueued = DifferenceRequest();
+    if (!labelBrowser->IsDifferenceEnabled() || !m_AlignedImage || !m_TemplateImage) {
+        // A running update finds itself stale in PollDifferenceLayer and clears there.
+        if (!m_DifferenceRun.valid()) m_Difference.Clear();
+        labelBrowser->SetDifferenceStatus(labelBrowser->IsDifferenceEnabled() ? "Needs both aligned and template FITS"
+                                                                             : "");
+        return;
+    }
+
+    DifferenceRequest request;
+    request.aligned = m_AlignedImage;
+    request.templ = m_TemplateImage;
+    request.params = labelBrowser->GetDifferenceParams();
+    request.x1 = m_AlignedImage->GetWidth() - 1;
+    request.y1 = m_AlignedImage->GetHeight() - 1;
+    if (useRoi) {
+        request.x0 = roiX - roiRadius;
+        request.y0 = roiY - roiRadius;
+        request.x1 = roiX + roiRadius;
+        request.y1 = roiY + roiRadius;
+    }
+    labelBrowser->SetDifferenceStatus("Computing difference...");
+    if (m_DifferenceRun.valid()) {
+        m_DifferenceQueued = std::move(request);
+        return;
+    }
+    StartDifference(std::move(request));
+}
+
+void Application::StartDifference(DifferenceRequest request) {
+    DifferenceImage* difference = &m_Difference;
+    m_DifferenceRun = std::async(std::launch::async, [difference, request = std::move(request)]() mutable {
+        // Same pair and fit settings keep the cached tiles; only newly covered ones are computed.
+        const auto start = std::chrono::steady_clock::now();
+        difference->SetInputs(request.aligned, request.templ, request.params);
+        request.computed = difference->Update(request.x0, request.y0, request.x1, request.y1);
+        request.milliseconds =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        difference->GeneratePointCloud(request.x0, request.y0, request.x1, request.y1, kImageScaleX, kImageScaleY,
+                                       kImageScaleZ, request.positions, request.colors);
+        request.fit = difference->GetFit();
+        request.cachedTiles = difference->GetTileCount();
+        return request;
+    });
+}
+
+void Application::PollDifferenceLayer(LabelDataBrowser* labelBrowser) {
+    if (!m_DifferenceRun.valid() ||
+        m_DifferenceRun.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    DifferenceRequest done = m_DifferenceRun.get();
+    if (m_DifferenceQueued.aligned) {
+        // Superseded while it ran.
+        DifferenceRequest next = std::move(m_DifferenceQueued);
+        m_DifferenceQueued = DifferenceRequest();
+        StartDifference(std::move(next));
+        return;
+    }
+    // Turned off, or the pair changed, since it started.
+    if (!labelBrowser->IsDifferenceEnabled() || done.aligned != m_AlignedImage || done.templ != m_TemplateImage) {
+        if (!labelBrowser->IsDifferenceEnabled()) m_Difference.Clear();
+        return;
+    }
+
+    char status[256];
+    std::snprintf(status, sizeof(status),
+                  "aligned = %.4g + %.4g * template, rms %.4g; %d tiles computed, %zu cached (%.1f ms)",
+                  done.fit.offset, done.fit.scale, done.fit.rms, done.computed, done.cachedTiles, done.milliseconds);
+    labelBrowser->SetDifferenceStatus(status);
+    if (m_ImagePointsMap.find(kDifferenceLayerKey) != m_ImagePointsMap.end()) {
+        RemoveImagePoints(kDifferenceLayerKey);
+    }
+    if (done.positions.empty()) return;
+
+    auto pointCloud = std::make_shared<PointCloud>();
+    pointCloud->SetPointData(done.positions, done.colors);
+    pointCloud->SetPointSize(3.0f);
+    pointCloud->SetChunkSize(kLodChunkPixels * kImageScaleX);
+    pointCloud->SetName("PointCloud_difference");
+    pointCloud->Initialize();
+    AddGeometryObject(pointCloud);
+    m_ImagePointsMap[kDifferenceLayerKey] = {pointCloud};
+}
+
+void Application::UpdateReprojectedTemplate(LabelDataBrowser* labelBrowser, const std::string& templatePath,
+                                            bool useRoi, int roiX, int roiY, int roiRadius) {
+    m_ReprojectQueued = ReprojectedTemplate();
+    if (!labelBrowser->IsReprojectEnabled()) {
+        m_Reprojected = ReprojectedTemplate();
+        labelBrowser->SetReprojectStatus("");
+        return;
+    }
+    auto fail = [&](const char* status) {
+        m_Reprojected = ReprojectedTemplate();
+        labelBrowser->SetReprojectStatus(status);
+    };
+    if (!m_AlignedImage || !m_AlignedImage->IsFits()) return fail("No aligned FITS to reproject onto");
+    std::shared_ptr<const ImageLoader> source = m_Prefetcher->GetImage(templatePath);
+    if (!source || !source->IsFits()) return fail("Template FITS not loaded");
+    if (!m_AlignedImage->GetWcs()) return fail("No supported WCS (TAN/TPV/TAN-SIP) in the aligned header");
+    if (!source->GetWcs()) return fail("No supported WCS (TAN/TPV/TAN-SIP) in the template header");
+
+    // The ROI, grown to hold the preview and registration crops around its center.
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = m_AlignedImage->GetWidth() - 1;
+    int y1 = m_AlignedImage->GetHeight() - 1;
+    if (useRoi) {
+        const int half = std::max({roiRadius, labelBrowser->GetPreviewCropPixels() / 2 + 1,
+                                   labelBrowser->GetRegistrationCropPixels() / 2 + 1});
+        x0 = std::max(x0, roiX - half);
+        y0 = std::max(y0, roiY - half);
+        x1 = std::min(x1, roiX + half);
+        y1 = std::min(y1, roiY + half);
+    }
+
+    const Reprojector::Interpolation interpolation = labelBrowser->GetReprojectInterpolation();
+    if (m_Reprojected.image && m_Reprojected.path == templatePath && m_Reprojected.source == source &&
+        m_Reprojected.target == m_AlignedImage && m_Reprojected.interpolation == interpolation &&
+        m_Reprojected.x0 <= x0 && m_Reprojected.y0 <= y0 && m_Reprojected.x1 >= x1 && m_Reprojected.y1 >= y1) {
+        return; // the cached resampling already covers this region
+    }
+
+    ReprojectedTemplate request;
+    request.path = templatePath;
+    request.source = std::move(source);
+    request.target = m_AlignedImage;
+    request.interpolation = interpolation;
+    request.x0 = x0;
+    request.y0 = y0;
+    request.x1 = x1;
+    request.y1 = y1;
+    request.filter = m_ImageFilter;
+    m_Reprojected = ReprojectedTemplate();
+    labelBrowser->SetReprojectStatus("Reprojecting...");
+    if (m_ReprojectRun.valid()) {
+        m_ReprojectQueued = std::move(request);
+        return;
+    }
+    StartReprojection(std::move(request));
+}
+
+void Application::StartReprojection(ReprojectedTemplate request) {
+    m_ReprojectRun = std::async(std::launch::async, [request = std::move(request)]() mutable {
+        if (!request.image) {
+            Reprojector::Params params;
+            params.interpolation = request.interpolation;
+            const auto start = std::chrono::steady_clock::now();
+            request.image = Reprojector::Reproject(*request.source, *request.target, request.x0, request.y0,
+                                                   request.x1, request.y1, params);
+            request.milliseconds =
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        // The point filter too (over the resampled region only), so the template's points
+        // do not wait for it on the UI thread.
+        request.filtered.reset();
+        if (request.image && !request.filter.IsIdentity()) {
+            request.filtered = ImageFilter::Apply(*request.image, request.filter, request.x0, request.y0, request.x1,
+                                                  request.y1);
+        }
+        return request;
+    });
+}
+
+void Application::PollReprojectedTemplate(LabelDataBrowser* labelBrowser) {
+    if (!m_ReprojectRun.valid() ||
+        m_ReprojectRun.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    ReprojectedTemplate done = m_ReprojectRun.get();
+    if (m_ReprojectQueued.source) {
+        // Superseded while it ran.
+        ReprojectedTemplate next = std::move(m_ReprojectQueued);
+        m_ReprojectQueued = ReprojectedTemplate();
+        StartReprojection(std::move(next));
+        return;
+    }
+    // The pair changed (or reprojection was turned off) since it started.
+    if (!labelBrowser->IsReprojectEnabled() || done.target != m_AlignedImage || done.path != m_TemplateLoad.path) {
+        return;
+    }
+    if (!done.image) {
+        labelBrowser->SetReprojectStatus("Reprojection failed");
+        return;
+    }
+
+    char status[192];
+    std::snprintf(status, sizeof(status), "%s -> %s, %dx%d px, %s, %.1f ms",
+                  done.source->GetWcs()->GetProjectionName(), done.target->GetWcs()->GetProjectionName(),
+                  done.x1 - done.x0 + 1, done.y1 - done.y0 + 1,
+                  done.interpolation == Reprojector::Interpolation::Lanczos3 ? "Lanczos-3" : "bilinear",
+                  done.milliseconds);
+    std::cout << "Reprojected template: " << status << std::endl;
+    labelBrowser->SetReprojectStatus(status);
+    m_Reprojected = std::move(done);
+
+    const PointsLoad& load = m_TemplateLoad;
+    LoadImageAndGeneratePointsInternal(load.path, /*replaceExisting*/ true, load.useRoi, load.roiX, load.roiY,
+                                       load.roiRadius, load.highlights, /*previewSlot*/ 2, load.previewSize);
+    UpdateDifferenceLayer(labelBrowser, load.useRoi, load.roiX, load.roiY, load.roiRadius);
+}
+
+void Application::PollFilteredImages() {
+    if (m_FilterPending.empty() || !m_Prefetcher) return;
+    std::vector<PointsLoad> ready;
+    for (auto it = m_FilterPending.begin(); it != m_FilterPending.end();) {
+        // Dropped if the filter changed or the image was unloaded / redrawn since.
+        if (it->filter != m_ImageFilter || m_ImagePointsMap.find(it->path) == m_ImagePointsMap.end()) {
+            it = m_FilterPending.erase(it);
+        } else if (m_Prefetcher->FindImage(it->path, it->filter)) {
+            ready.push_back(std::move(*it));
+            it = m_FilterPending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (const PointsLoad& load : ready) {
+        LoadImageAndGeneratePointsInternal(load.path, /*replaceExisting*/ true, load.useRoi, load.roiX, load.roiY,
+                                           load.roiRadius, load.highlights, load.previewSlot, load.previewSize);
+    }
+}
+
+void Application::HandleSourceRequest(LabelDataBrowser* labelBrowser) {
+    // Detect on the aligned image when there is one; both images share pixel coordinates.
+    const std::shared_ptr<const ImageLoader>& imageRef = m_AlignedImage ? m_AlignedImage : m_TemplateImage;
+    const ImageLoader* image = imageRef.get();
+    if (!image || !image->IsLoaded()) {
+        labelBrowser->SetSourceStatus("No FITS pair loaded");
+        return;
+    }
+
+    const bool hasCenter = labelBrowser->HasActivePixelCenter() || labelBrowser->HasPixelCenter();
+    const int centerX = labelBrowser->HasActivePixelCenter() ? labelBrowser->GetActivePixelX() : labelBrowser->GetPixelX();
+    const int centerY = labelBrowser->HasActivePixelCenter() ? labelBrowser->GetActivePixelY() : labelBrowser->GetPixelY();
+    const SourceDetector::Params& params = labelBrowser->GetSourceParams();
+    const auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&start]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<SourceDetector::Source> sources;
+    char status[256];
+    switch (labelBrowser->GetSourceRequest()) {
+    case LabelDataBrowser::SourceRequest::SnapToNearest: {
+        if (!hasCenter) {
+            labelBrowser->SetSourceStatus("No pixel center to snap");
+            return;
+        }
+        // Label the search box plus some margin so a source at its edge is not cut.
+        const int radius = std::max(labelBrowser->GetSnapRadius(), 1);
+        const int box = radius + 16;
+        SourceDetector::DetectRegion(*image, centerX - box, centerY - box, centerX + box, centerY + box, params, sources);
+        const int nearest = SourceDetector::FindNearest(sources, static_cast<float>(centerX),
+                                                        static_cast<float>(centerY), static_cast<float>(radius));
+        if (nearest < 0) {
+            std::snprintf(status, sizeof(status), "No source within %d px of (%d, %d)", radius, centerX, centerY);
+            break;
+        }
+        const SourceDetector::Source& source = sources[nearest];
+        const int snappedX = static_cast<int>(std::lround(source.x));
+        const int snappedY = static_cast<int>(std::lround(source.y));
+        std::snprintf(status, sizeof(status), "Snapped (%d, %d) -> (%.2f, %.2f), %d px, peak %.4g", centerX, centerY,
+                      source.x, source.y, source.area, source.peak);
+        if (snappedX != centerX || snappedY != centerY) {
+            labelBrowser->SetActivePixelCenter(snappedX, snappedY);
+        }
+        break;
+    }
+    case LabelDataBrowser::SourceRequest::DetectRoi: {
+        if (!hasCenter) {
+            labelBrowser->SetSourceStatus("No pixel center for the ROI");
+            return;
+        }
+        const int roiR = std::clamp(labelBrowser->GetRoiRadius(), 50, 500);
+        SourceDetector::DetectRegion(*image, centerX - roiR, centerY - roiR, centerX + roiR, centerY + roiR, params,
+                                     sources);
+        const int nearest = SourceDetector::FindNearest(sources, static_cast<float>(centerX),
+                                                        static_cast<float>(centerY), static_cast<float>(roiR) * 2.0f);
+        if (nearest >= 0) {
+            std::snprintf(status, sizeof(status), "%zu sources in ROI (%.1f ms), nearest at (%.2f, %.2f)",
+                          sources.size(), elapsedMs(), sources[nearest].x, sources[nearest].y);
+        } else {
+            std::snprintf(status, sizeof(status), "No sources in ROI (%.1f ms)", elapsedMs());
+        }
+        // Brightest first, like the whole-frame list.
+        std::sort(sources.begin(), sources.end(),
+                  [](const SourceDetector::Source& a, const SourceDetector::Source& b) { return a.flux > b.flux; });
+        labelBrowser->SetSources(std::move(sources));
+        m_SourcesImage = image;
+        break;
+    }
+    case LabelDataBrowser::SourceRequest::DetectFrame:
+        // Seconds on a large frame: run it on a worker, PollSourceDetection picks it up.
+        if (m_SourceRun.valid()) return;
+        m_SourceRunImage = imageRef;
+        m_SourceRunStart = start;
+        m_SourceRun = std::async(std::launch::async, [image = m_SourceRunImage, params]() {
+            std::vector<SourceDetector::Source> found;
+            SourceDetector::DetectAll(*image, params, found);
+            return found;
+        });
+        labelBrowser->SetSourceDetectionRunning(true);
+        labelBrowser->SetSourceStatus("Detecting sources in the whole frame...");
+        return;
+    case LabelDataBrowser::SourceRequest::None:
+        return;
+    }
+    labelBrowser->SetSourceStatus(status);
+}
+
+void Application::PollSourceDetection(LabelDataBrowser* labelBrowser) {
+    const ImageLoader* current = m_AlignedImage ? m_AlignedImage.get() : m_TemplateImage.get();
+    if (m_SourcesImage && m_SourcesImage != current) {
+        labelBrowser->SetSources({});
+        labelBrowser->SetSourceStatus("");
+        m_SourcesImage = nullptr;
+    }
+    if (!m_SourceRun.valid() ||
+        m_SourceRun.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    std::vector<SourceDetector::Source> sources = m_SourceRun.get();
+    const std::shared_ptr<const ImageLoader> image = std::move(m_SourceRunImage);
+    labelBrowser->SetSourceDetectionRunning(false);
+    if (image.get() != current) {
+        labelBrowser->SetSourceStatus("Image changed during detection; sources dropped");
+        return;
+    }
+    char status[128];
+    std::snprintf(status, sizeof(status), "%zu sources in frame (%.1f ms)", sources.size(),
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_SourceRunStart)
+                      .count());
+    labelBrowser->SetSourceStatus(status);
+    labelBrowser->SetSources(std::move(sources));
+    m_SourcesImage = current;
+}
+
+void Application::UpdateRegistration(LabelDataBrowser* labelBrowser) {
+    const LabelDataBrowser::RegistrationRequest request = labelBrowser->GetRegistrationRequest();
+    labelBrowser->ClearRegistrationRequest();
+    const int cropSize = labelBrowser->GetRegistrationCropPixels();
+
+    if (request == LabelDataBrowser::RegistrationRequest::CheckAll && !m_RegistrationBatch.IsRunning() && m_Prefetcher) {
+        std::vector<RegistrationBatch::Target> targets;
+        if (!labelBrowser->GetRegistrationTargets(targets)) {
+            // Paths wait for the FITS file index; keep the request for a later frame.
+            labelBrowser->SetRegistrationRequest(request);
+            labelBrowser->SetRegistrationStatus(false, "Waiting for the FITS file index...");
+        } else if (targets.empty()) {
+            labelBrowser->SetRegistrationStatus(false, "No targets with a pixel center and FITS pair");
+        } else {
+            // Measured against the template as the view shows it: resampled onto the aligned
+            // grid when reprojection is on.
+            TargetPrefetcher* prefetcher = m_Prefetcher.get();
+            Reprojector::Params reprojectParams;
+            reprojectParams.interpolation = labelBrowser->GetReprojectInterpolation();
+            m_RegistrationBatch.Start(std::move(targets), cropSize,
+                                      [prefetcher](const std::string& path) { return prefetcher->GetImage(path); },
+                                      labelBrowser->IsReprojectEnabled(), reprojectParams);
+            m_RegistrationTxtPath = labelBrowser->GetNewFitsSourceTxtPath();
+            m_RegistrationStart = std::chrono::steady_clock::now();
+        }
+    } else if (request == LabelDataBrowser::RegistrationRequest::Cancel) {
+        m_RegistrationBatch.Cancel();
+    }
+
+    if (m_RegistrationBatch.IsRunning()) {
+        char status[160];
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - m_RegistrationStart).count();
+        if (m_RegistrationBatch.Poll()) {
+            std::vector<RegistrationBatch::Entry> results = m_RegistrationBatch.GetResults();
+            std::size_t measured = 0;
+            std::size_t failed = 0;
+            for (const auto& entry : results) {
+                if (entry.result.valid) measured++;
+                if (!entry.error.empty()) failed++;
+            }
+            std::snprintf(status, sizeof(status), "Measured %zu of %zu targets in %.1f s (%zu failed)", measured,
+                          results.size(), seconds, failed);
+            std::cout << "Registration check: " << status << std::endl;
+            labelBrowser->SetRegistrationResults(m_RegistrationTxtPath, std::move(results));
+            labelBrowser->SetRegistrationStatus(false, status);
+        } else {
+            std::snprintf(status, sizeof(status), "Checking %zu / %zu targets (%.1f s)",
+                          m_RegistrationBatch.GetDoneCount(), m_RegistrationBatch.GetTotalCount(), seconds);
+            labelBrowser->SetRegistrationStatus(true, status);
+        }
+    }
+
+    // Shift at the preview center; not while a preview is being dragged.
+    if (!m_AlignedImage || !m_TemplateImage || !m_AlignedPreview.HasTexture()) {
+        m_Registration = PhaseCorrelation::Result();
+        return;
+    }
+    const int centerX = m_AlignedPreview.GetCenterX();
+    const int centerY = m_AlignedPreview.GetCenterY();
+    const bool stale = m_RegistrationImages[0] != m_AlignedImage.get() ||
+                       m_RegistrationImages[1] != m_TemplateImage.get() || m_Registration.centerX != centerX ||
+                       m_Registration.centerY != centerY ||
+                       m_Registration.cropSize !=
+                           std::clamp(cropSize, PhaseCorrelation::kMinCrop, PhaseCorrelation::kMaxCrop);
+    if (!stale || ImGui::IsMouseDown(ImGuiMouseButton_Left)) return;
+
+    m_Registration = PhaseCorrelation::Measure(*m_AlignedImage, *m_TemplateImage, centerX, centerY, cropSize);
+    m_RegistrationImages[0] = m_AlignedImage.get();
+    m_RegistrationImages[1] = m_TemplateImage.get();
+}
+
+void Application::UpdateRoiStatistics(LabelDataBrowser* labelBrowser) {
+    const bool hasCenter = labelBrowser->HasActivePixelCenter() || labelBrowser->HasPixelCenter();
+    const int centerX = labelBrowser->HasActivePixelCenter() ? labelBrowser->GetActivePixelX() : labelBrowser->GetPixelX();
+    const int centerY = labelBrowser->HasActivePixelCenter() ? labelBrowser->GetActivePixelY() : labelBrowser->GetPixelY();
+    const int roiR = std::clamp(labelBrowser->GetRoiRadius(), 50, 500);
+    const int apertureHalf = std::clamp(labelBrowser->GetHighlightSizePixels(), 1, 300) / 2;
+
+    const ImageLoader* images[2] = {m_AlignedImage.get(), m_TemplateImage.get()};
+    for (int slot = 0; slot < 2; slot++) {
+        LabelDataBrowser::RoiStatistics stats;
+        const ImageLoader* image = images[slot];
+        if (hasCenter && image && !image->GetIntegralImage().IsEmpty()) {
+            const IntegralImage& integral = image->GetIntegralImage();
+            const IntegralImage::Stats roi = integral.GetSquareStats(centerX, centerY, roiR);
+            const IntegralImage::Snr snr = integral.GetSnr(centerX, centerY, apertureHalf, roiR);
+            stats.valid = roi.count > 0;
+            stats.roiCount = roi.count;
+            stats.roiMean = roi.mean;
+            stats.roiStddev = roi.stddev;
+            stats.apertureMean = snr.aperture.mean;
+            stats.hasSnr = snr.valid;
+            stats.snr = snr.snr;
+        }
+        labelBrowser->SetRoiStatistics(slot, stats);
+    }
+}
+
+void Application::UpdateHistogramViews(LabelDataBrowser* labelBrowser) {
+    constexpr int kViewBins = 128;
+    const ImageLoader* images[2] = {m_AlignedImage.get(), m_TemplateImage.get()};
+    const PreviewEngine* previews[2] = {&m_AlignedPreview, &m_TemplatePreview};
+    for (int slot = 0; slot < 2; slot++) {
+        LabelDataBrowser::HistogramView& view = labelBrowser->GetHistogramView(slot);
+        view.valid = false;
+        if (!images[slot] || !previews[slot]->HasTexture()) continue;
+
+        const Histogram* histogram = previews[slot]->GetRoiHistogram();
+        if (!histogram) histogram = &images[slot]->GetHistogram();
+        if (histogram->IsEmpty()) continue;
+
+        // Window around the levels (half their width on each side) so outliers do not
+        // squash the interesting part of the plot.
+        const float levelLow = previews[slot]->GetLevelLow();
+        const float levelHigh = previews[slot]->GetLevelHigh();
+        const float pad = 0.5f * (levelHigh - levelLow);
+        const float viewLow = std::max(histogram->GetMin(), levelLow - pad);
+        const float viewHigh = std::min(histogram->GetMax(), levelHigh + pad);
+        if (viewHigh - viewLow < 1e-6f) continue;
+
+        const std::vector<std::uint32_t>& bins = histogram->GetBins();
+        const int binCount = histogram->GetBinCount();
+        const float binLow = histogram->GetBinLow();
+        const float binsPerUnit = binCount / (histogram->GetBinHigh() - binLow);
+        const int first = std::clamp(static_cast<int>((viewLow - binLow) * binsPerUnit), 0, binCount - 1);
+        const int last = std::clamp(static_cast<int>((viewHigh - binLow) * binsPerUnit), first, binCount - 1);
+        view.bins.assign(kViewBins, 0.0f);
+        for (int b = first; b <= last; b++) {
+            const int v = std::min(kViewBins - 1, (b - first) * kViewBins / (last - first + 1));
+            view.bins[v] += static_cast<float>(bins[b]);
+        }
+        for (float& count : view.bins) count = std::log10(1.0f + count);
+
+        const double offset = histogram->GetDataOffset();
+        const double scale = histogram->GetDataScale();
+        view.valid = true;
+        view.viewMin = offset + scale * viewLow;
+        view.viewMax = offset + scale * viewHigh;
+        view.levelLow = offset + scale * levelLow;
+        view.levelHigh = offset + scale * levelHigh;
+        view.levelLowFraction = (levelLow - viewLow) / (viewHigh - viewLow);
+        view.levelHighFraction = (levelHigh - viewLow) / (viewHigh - viewLow);
+    }
+}
+
 void Application::CenterCameraOnPixelInCurrentImage(int pixelX, int pixelY) {
     if (!m_Camera || !m_ImageLoader || !m_ImageLoader->IsLoaded()) return;
 
-    // Must match the mapping used in LoadImageAndGeneratePointsInternal.
-    const float scaleX = 0.1f;
-    const float scaleY = 10.0f;
-    const float scaleZ = 0.1f;
+    // Same mapping as LoadImageAndGeneratePointsInternal.
+    const float scaleX = kImageScaleX;
+    const float scaleY = kImageScaleY;
+    const float scaleZ = kImageScaleZ;
 
     const float centerX = m_ImageLoader->GetWidth() * 0.5f;
     const float centerZ = m_ImageLoader->GetHeight() * 0.5f;
 
-    const float height = m_ImageLoader->GetNormalizedPixelValue(pixelX, pixelY) * scaleY;
+    const float height = m_ImageLoader->GetHeightValue(pixelX, pixelY, m_HeightMode) * scaleY;
     const glm::vec3 newTarget(
         (pixelX - centerX) * scaleX,
         height,
@@ -322,6 +984,21 @@ void Application::Render() {
         m_Axes->Render(m_Renderer->GetLineShader(), m_Camera.get());
     }
 
+    // Pick points vs. far-view surface per chunk, then fit what is left into the point budget.
+    UpdateImageLayerLod();
+
+    // Fit visible point clouds into the frame-time point budget before drawing.
+    if (PointBudgetGovernor* budget = m_Renderer->GetPointBudgetGovernor()) {
+        std::vector<PointCloud*> visibleClouds;
+        for (auto& object : m_GeometryObjects) {
+            if (!object->IsVisible()) continue;
+            if (auto* cloud = dynamic_cast<PointCloud*>(object.get())) {
+                visibleClouds.push_back(cloud);
+            }
+        }
+        budget->Distribute(visibleClouds);
+    }
+
     // Render geometry objects
     for (auto& object : m_GeometryObjects) {
         if (object->IsVisible()) {
@@ -329,6 +1006,8 @@ void Application::Render() {
             if (object->GetType() == GeometryType::Point &&
                 dynamic_cast<PointCloud*>(object.get()) != nullptr) {
                 m_Renderer->RenderPointCloud(object.get(), m_Camera.get());
+            } else if (object->GetType() == GeometryType::Surface) {
+                m_Renderer->RenderSurface(object.get(), m_Camera.get());
             } else {
                 m_Renderer->RenderGeometry(object.get(), m_Camera.get());
             }
@@ -361,112 +1040,49 @@ static void EnsureTexture2D(unsigned int& tex) {
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+// Upload path for far-view surface textures (ROI previews go through PreviewEngine).
+static void UploadTextureRGBA(unsigned int& tex, int width, int height, const std::vector<unsigned char>& rgba) {
+    EnsureTexture2D(tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void Application::UpdatePreviewTextureFromCurrentImage(int previewSlot,
                                                        const std::string& filepath,
                                                        int cropCenterX,
                                                        int cropCenterY,
                                                        int cropSizePixels,
                                                        const glm::vec4& tintColor,
-                                                       float tintAlpha) {
+                                                       float tintAlpha,
+                                                       const std::vector<unsigned char>* prebuiltRGBA) {
     if (previewSlot != 1 && previewSlot != 2) return;
     if (!m_ImageLoader || !m_ImageLoader->IsLoaded()) return;
 
-    cropSizePixels = std::clamp(cropSizePixels, 1, 300);
+    cropSizePixels = std::clamp(cropSizePixels, 1, PreviewEngine::kMaxSize);
     // NOTE: Preview should show original FITS brightness (no tint). We keep the params for API stability.
     (void)tintColor;
     (void)tintAlpha;
 
-    unsigned int* texPtr = (previewSlot == 1) ? &m_AlignedPreviewTex : &m_TemplatePreviewTex;
-    int* sizePtr = (previewSlot == 1) ? &m_AlignedPreviewSize : &m_TemplatePreviewSize;
-    std::string* namePtr = (previewSlot == 1) ? &m_AlignedPreviewName : &m_TemplatePreviewName;
-    int* centerXPtr = (previewSlot == 1) ? &m_AlignedPreviewCenterX : &m_TemplatePreviewCenterX;
-    int* centerYPtr = (previewSlot == 1) ? &m_AlignedPreviewCenterY : &m_TemplatePreviewCenterY;
-
-    EnsureTexture2D(*texPtr);
-    *sizePtr = cropSizePixels;
-    *centerXPtr = cropCenterX;
-    *centerYPtr = cropCenterY;
+    PreviewEngine& preview = (previewSlot == 1) ? m_AlignedPreview : m_TemplatePreview;
     try {
-        *namePtr = std::filesystem::path(filepath).filename().string();
+        preview.SetName(std::filesystem::path(filepath).filename().string());
     } catch (...) {
-        *namePtr = filepath;
-    }
-
-    const int w = m_ImageLoader->GetWidth();
-    const int h = m_ImageLoader->GetHeight();
-    if (w <= 0 || h <= 0) return;
-
-    const int half = cropSizePixels / 2;
-    const int xStart = cropCenterX - half;
-    const int yStart = cropCenterY - half;
-
-    const bool isFits = m_ImageLoader->IsFits();
-    std::vector<unsigned char> rgba(static_cast<std::size_t>(cropSizePixels) * cropSizePixels * 4);
-
-    // For FITS, do a local contrast stretch so deep bit-depth data looks like a normal image.
-    float stretchLow = 0.0f;
-    float stretchHigh = 1.0f;
-    std::vector<float> grayVals;
-    if (isFits) {
-        grayVals.reserve(static_cast<std::size_t>(cropSizePixels) * cropSizePixels);
-        for (int j = 0; j < cropSizePixels; j++) {
-            for (int i = 0; i < cropSizePixels; i++) {
-                const int x = std::clamp(xStart + i, 0, w - 1);
-                const int y = std::clamp(yStart + j, 0, h - 1);
-                grayVals.push_back(m_ImageLoader->GetNormalizedPixelValue(x, y));
-            }
-        }
-        auto quantile = [&](float q) -> float {
-            if (grayVals.empty()) return 0.0f;
-            const std::size_t n = grayVals.size();
-            const std::size_t idx = static_cast<std::size_t>(std::clamp(q, 0.0f, 1.0f) * float(n - 1));
-            std::vector<float> tmp = grayVals;
-            std::nth_element(tmp.begin(), tmp.begin() + idx, tmp.end());
-            return tmp[idx];
-        };
-        stretchLow = quantile(0.01f);
-        stretchHigh = quantile(0.99f);
-        if (stretchHigh - stretchLow < 1e-6f) {
-            stretchLow = 0.0f;
-            stretchHigh = 1.0f;
-        }
-    }
-
-    for (int j = 0; j < cropSizePixels; j++) {
-        for (int i = 0; i < cropSizePixels; i++) {
-            const int x = std::clamp(xStart + i, 0, w - 1);
-            const int y = std::clamp(yStart + j, 0, h - 1);
-
-            glm::vec3 out(0.0f);
-            if (isFits) {
-                // Contrast stretch to [0,1], then apply a mild gamma to lift shadows.
-                const float v = m_ImageLoader->GetNormalizedPixelValue(x, y);
-                float t = (v - stretchLow) / (stretchHigh - stretchLow);
-                t = std::clamp(t, 0.0f, 1.0f);
-                // Gamma-like curve (sqrt) to make dim structures more visible.
-                t = std::sqrt(t);
-                out = glm::vec3(t, t, t);
-            } else {
-                // Standard images are already in display range.
-                out = m_ImageLoader->GetPixelColor(x, y);
-            }
-
-            const std::size_t idx = (static_cast<std::size_t>(j) * cropSizePixels + i) * 4;
-            rgba[idx + 0] = static_cast<unsigned char>(std::clamp(out.r, 0.0f, 1.0f) * 255.0f);
-            rgba[idx + 1] = static_cast<unsigned char>(std::clamp(out.g, 0.0f, 1.0f) * 255.0f);
-            rgba[idx + 2] = static_cast<unsigned char>(std::clamp(out.b, 0.0f, 1.0f) * 255.0f);
-            rgba[idx + 3] = 255;
-        }
+        preview.SetName(filepath);
     }
 
-    glBindTexture(GL_TEXTURE_2D, *texPtr);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cropSizePixels, cropSizePixels, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (m_ImageLoader->GetWidth() <= 0 || m_ImageLoader->GetHeight() <= 0) return;
+
+    if (prebuiltRGBA && prebuiltRGBA->size() == static_cast<std::size_t>(cropSizePixels) * cropSizePixels * 4) {
+        preview.Upload(*m_ImageLoader, prebuiltRGBA->data(), cropCenterX, cropCenterY, cropSizePixels, cropSizePixels);
+        return;
+    }
+    preview.Update(*m_ImageLoader, cropCenterX, cropCenterY, cropSizePixels);
 }
 
 void Application::RenderFitsRoiPreviewWindow() {
-    if (m_AlignedPreviewTex == 0 && m_TemplatePreviewTex == 0) return;
+    if (!m_AlignedPreview.HasTexture() && !m_TemplatePreview.HasTexture()) return;
 
     const int windowWidth = m_Window ? m_Window->GetWidth() : 0;
     const int windowHeight = m_Window ? m_Window->GetHeight() : 0;
@@ -502,30 +1118,48 @@ void Application::RenderFitsRoiPreviewWindow() {
         dl->AddLine(ImVec2(center.x, center.y + gap), ImVec2(center.x, center.y + len), col, thick);
     };
 
-    auto drawPreview = [&](int previewSlot, const char* label, unsigned int tex, const std::string& name) {
-        ImGui::Text("%s: %s", label, name.empty() ? "(none)" : name.c_str());
-        if (tex != 0) {
+    // Both crops follow a drag so aligned and template stay comparable.
+    auto recenterPreviews = [&](int centerX, int centerY) {
+        if (m_AlignedImage) m_AlignedPreview.Recenter(*m_AlignedImage, centerX, centerY);
+        if (m_TemplateImage) m_TemplatePreview.Recenter(*m_TemplateImage, centerX, centerY);
+    };
+
+    auto drawPreview = [&](int previewSlot, const char* label, PreviewEngine& preview) {
+        ImGui::Text("%s: %s", label, preview.GetName().empty() ? "(none)" : preview.GetName().c_str());
+        if (preview.HasTexture()) {
             // Keep aspect ratio correct (our preview textures are square crops).
-            ImGui::Image(reinterpret_cast<ImTextureID>(static_cast<intptr_t>(tex)), ImVec2(targetImageW, targetImageW));
+            const ImVec2 p0 = ImGui::GetCursorScreenPos();
+            const ImVec2 p1(p0.x + targetImageW, p0.y + targetImageW);
+            ImGui::InvisibleButton(label, ImVec2(targetImageW, targetImageW));
+            ImGui::GetWindowDrawList()->AddImage(
+                reinterpret_cast<ImTextureID>(static_cast<intptr_t>(preview.GetTexture())), p0, p1);
+
+            const int cropSize = std::max(1, preview.GetCropSize());
+            const int half = cropSize / 2;
+            const int xStart = preview.GetCenterX() - half;
+            const int yStart = preview.GetCenterY() - half;
+
+            // Drag -> re-crop around the moved center every frame.
+            if (ImGui::IsItemActivated()) {
+                m_PreviewDragMoved = false;
+                m_PreviewDragStartX = preview.GetCenterX();
+                m_PreviewDragStartY = preview.GetCenterY();
+            }
+            if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
+                const ImVec2 drag = ImGui::GetMouseDragDelta(ImGuiMouseButton_Left);
+                const float pixelsPerPoint = static_cast<float>(cropSize) / targetImageW;
+                m_PreviewDragMoved = true;
+                recenterPreviews(m_PreviewDragStartX - static_cast<int>(std::lround(drag.x * pixelsPerPoint)),
+                                 m_PreviewDragStartY - static_cast<int>(std::lround(drag.y * pixelsPerPoint)));
+            }
 
-            // Handle click -> update ROI center and request reload/center camera.
-            if (ImGui::IsItemClicked(ImGuiMouseButton_Left) && m_UIManager && m_UIManager->GetLabelDataBrowser()) {
+            // Click without dragging -> update ROI center and request reload/center camera.
+            if (ImGui::IsItemDeactivated() && !m_PreviewDragMoved && m_UIManager && m_UIManager->GetLabelDataBrowser()) {
                 LabelDataBrowser* lb = m_UIManager->GetLabelDataBrowser();
-                const ImVec2 p0 = ImGui::GetItemRectMin();
-                const ImVec2 p1 = ImGui::GetItemRectMax();
                 const ImVec2 mp = ImGui::GetIO().MousePos;
 
-                const float u = (p1.x > p0.x) ? (mp.x - p0.x) / (p1.x - p0.x) : 0.0f;
-                const float v = (p1.y > p0.y) ? (mp.y - p0.y) / (p1.y - p0.y) : 0.0f;
-
-                int cropSize = (previewSlot == 1) ? m_AlignedPreviewSize : m_TemplatePreviewSize;
-                int cropCenterX = (previewSlot == 1) ? m_AlignedPreviewCenterX : m_TemplatePreviewCenterX;
-                int cropCenterY = (previewSlot == 1) ? m_AlignedPreviewCenterY : m_TemplatePreviewCenterY;
-                cropSize = std::max(1, cropSize);
-
-                const int half = cropSize / 2;
-                const int xStart = cropCenterX - half;
-                const int yStart = cropCenterY - half;
+                const float u = (mp.x - p0.x) / targetImageW;
+                const float v = (mp.y - p0.y) / targetImageW;
 
                 const int clickX = xStart + static_cast<int>(std::clamp(u, 0.0f, 0.999999f) * cropSize);
                 const int clickY = yStart + static_cast<int>(std::clamp(v, 0.0f, 0.999999f) * cropSize);
@@ -545,27 +1179,15 @@ void Application::RenderFitsRoiPreviewWindow() {
             }
 
             // Draw crosshair overlay at last clicked pixel
-            {
-                const bool hasClick = (previewSlot == 1) ? m_HasAlignedPreviewClick : m_HasTemplatePreviewClick;
-                if (hasClick) {
-                    const int cropSize = (previewSlot == 1) ? m_AlignedPreviewSize : m_TemplatePreviewSize;
-                    const int cropCenterX = (previewSlot == 1) ? m_AlignedPreviewCenterX : m_TemplatePreviewCenterX;
-                    const int cropCenterY = (previewSlot == 1) ? m_AlignedPreviewCenterY : m_TemplatePreviewCenterY;
-                    const int clickX = (previewSlot == 1) ? m_AlignedPreviewClickX : m_TemplatePreviewClickX;
-                    const int clickY = (previewSlot == 1) ? m_AlignedPreviewClickY : m_TemplatePreviewClickY;
-
-                    const int half = std::max(1, cropSize) / 2;
-                    const int xStart = cropCenterX - half;
-                    const int yStart = cropCenterY - half;
-
-                    const float u = (static_cast<float>(clickX - xStart) + 0.5f) / static_cast<float>(std::max(1, cropSize));
-                    const float v = (static_cast<float>(clickY - yStart) + 0.5f) / static_cast<float>(std::max(1, cropSize));
-
-                    const ImVec2 p0 = ImGui::GetItemRectMin();
-                    const ImVec2 p1 = ImGui::GetItemRectMax();
-                    const ImVec2 center(p0.x + std::clamp(u, 0.0f, 1.0f) * (p1.x - p0.x),
-                                        p0.y + std::clamp(v, 0.0f, 1.0f) * (p1.y - p0.y));
-
+            const bool hasClick = (previewSlot == 1) ? m_HasAlignedPreviewClick : m_HasTemplatePreviewClick;
+            if (hasClick) {
+                const int clickX = (previewSlot == 1) ? m_AlignedPreviewClickX : m_TemplatePreviewClickX;
+                const int clickY = (previewSlot == 1) ? m_AlignedPreviewClickY : m_TemplatePreviewClickY;
+
+                const float u = (static_cast<float>(clickX - xStart) + 0.5f) / static_cast<float>(cropSize);
+                const float v = (static_cast<float>(clickY - yStart) + 0.5f) / static_cast<float>(cropSize);
+                if (u >= 0.0f && u <= 1.0f && v >= 0.0f && v <= 1.0f) {
+                    const ImVec2 center(p0.x + u * targetImageW, p0.y + v * targetImageW);
                     ImDrawList* dl = ImGui::GetWindowDrawList();
                     const ImU32 col = (previewSlot == 1)
                         ? IM_COL32(255, 69, 0, 255)   // aligned: OrangeRed
@@ -579,9 +1201,19 @@ void Application::RenderFitsRoiPreviewWindow() {
         }
     };
 
-    drawPreview(1, "aligned", m_AlignedPreviewTex, m_AlignedPreviewName);
+    drawPreview(1, "aligned", m_AlignedPreview);
     ImGui::Separator();
-    drawPreview(2, "template", m_TemplatePreviewTex, m_TemplatePreviewName);
+    drawPreview(2, "template", m_TemplatePreview);
+
+    if (m_Registration.valid) {
+        LabelDataBrowser* lb = m_UIManager ? m_UIManager->GetLabelDataBrowser() : nullptr;
+        const bool flagged = lb && lb->IsMisregistered(m_Registration);
+        ImGui::Separator();
+        ImGui::TextColored(flagged ? ImVec4(1.0f, 0.35f, 0.35f, 1.0f) : ImGui::GetStyleColorVec4(ImGuiCol_Text),
+                           "Shift %+.2f, %+.2f px  peak %.2f%s", m_Registration.dx, m_Registration.dy,
+                           m_Registration.peak, flagged ? "  (misregistered?)" : "");
+        ImGui::TextDisabled("phase correlation, %d px crop (FFT %d)", m_Registration.cropSize, m_Registration.fftSize);
+    }
 
     ImGui::End();
 }
@@ -600,8 +1232,7 @@ void Application::RemoveGeometryObject(std::shared_ptr<GeometryObject> object) {
 void Application::LoadImageAndGeneratePoints(const std::string& filepath) {
     // Normal image loading: keep previous behavior (skip if already loaded).
     LoadImageAndGeneratePointsInternal(filepath, /*replaceExisting*/ false, /*useRoi*/ false, 0, 0, 0,
-                                       /*useHighlight*/ false, 0, 0, 0, glm::vec4(0.0f), 1.0f,
-                                       /*previewSlot*/ 0);
+                                       /*highlights*/ {}, /*previewSlot*/ 0, /*previewSizePixels*/ 0);
 }
 
 void Application::LoadImageAndGeneratePointsInternal(const std::string& filepath,
@@ -610,13 +1241,9 @@ void Application::LoadImageAndGeneratePointsInternal(const std::string& filepath
                                                      int roiPixelX,
                                                      int roiPixelY,
                                                      int roiRadiusPixels,
-                                                     bool useHighlight,
-                                                     int highlightCenterX,
-                                                     int highlightCenterY,
-                                                     int highlightSizePixels,
-                                                     const glm::vec4& highlightColor,
-                                                     float highlightPointSizeScale,
-                                                     int previewSlot) {
+                                                     const std::vector<ImageLoader::PointHighlight>& highlights,
+                                                     int previewSlot,
+                                                     int previewSizePixels) {
     if (!replaceExisting) {
         // Check if already loaded
         if (m_ImagePointsMap.find(filepath) != m_ImagePointsMap.end()) {
@@ -630,53 +1257,95 @@ void Application::LoadImageAndGeneratePointsInternal(const std::string& filepath
         }
     }
 
-    if (!m_ImageLoader->LoadImage(filepath)) {
+    // This draw supersedes any redraw still waiting on a filter.
+    m_FilterPending.erase(std::remove_if(m_FilterPending.begin(), m_FilterPending.end(),
+                                         [&](const PointsLoad& load) { return load.path == filepath; }),
+                          m_FilterPending.end());
+
+    // A template resampled onto the aligned grid stands in for the file as loaded.
+    const bool reprojected = previewSlot == 2 && m_Reprojected.image && m_Reprojected.path == filepath;
+    if (reprojected) {
+        m_ImageLoader = m_Reprojected.image;
+    } else if (!LoadCurrentImage(filepath)) {
         std::cerr << "Failed to load image: " << filepath << std::endl;
         return;
     }
-
-    // Update preview texture using the freshly loaded image.
-    if (previewSlot == 1 || previewSlot == 2) {
-        // Use highlightSizePixels as crop size (i.e., "染色区域") and tint it.
-        // We keep a moderate alpha so the underlying content remains visible.
-        // Preview should be raw FITS brightness (no tint). Stretch is handled internally.
-        UpdatePreviewTextureFromCurrentImage(previewSlot, filepath, highlightCenterX, highlightCenterY, highlightSizePixels, highlightColor, 0.0f);
+    if (previewSlot == 1) {
+        m_AlignedImage = m_ImageLoader;
+    } else if (previewSlot == 2) {
+        m_TemplateImage = m_ImageLoader;
     }
 
     // Generate point cloud from image with original colors
     // Now: pixel(x,y) -> 3D(x,z), pixel value -> y height
-    const float scaleX = 0.1f;  // Scale for X (pixel X -> world X)
-    const float scaleY = 10.0f; // Scale for Y (pixel value -> world Y height)
-    const float scaleZ = 0.1f;  // Scale for Z (pixel Y -> world Z)
-
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec4> colors;
-    std::vector<glm::vec3> highlightPositions;
-    std::vector<glm::vec4> highlightColors;
-
-    // For highlight rendering, we split highlight points into a separate buffer so we can render them larger.
-    if (useHighlight) {
-        if (highlightPointSizeScale < 1.0f) highlightPointSizeScale = 1.0f;
-        if (highlightPointSizeScale > 20.0f) highlightPointSizeScale = 20.0f;
-
-        int effectiveRadius = roiRadiusPixels;
-        if (!useRoi) {
-            // Use a large ROI to cover the entire image, but still allow highlight split logic.
-            effectiveRadius = std::max(m_ImageLoader->GetWidth(), m_ImageLoader->GetHeight());
-        }
-
-        m_ImageLoader->GeneratePointCloudWithColorsROISplitHighlight(
-            positions, colors,
-            highlightPositions, highlightColors,
-            roiPixelX, roiPixelY, effectiveRadius,
-            highlightCenterX, highlightCenterY, highlightSizePixels, highlightColor,
-            scaleX, scaleY, scaleZ);
-    } else {
-        if (useRoi) {
-            m_ImageLoader->GeneratePointCloudWithColorsROI(positions, colors, roiPixelX, roiPixelY, roiRadiusPixels, scaleX, scaleY, scaleZ);
+    const float scaleX = kImageScaleX; // Scale for X (pixel X -> world X)
+    const float scaleY = kImageScaleY; // Scale for Y (pixel value -> world Y height)
+    const float scaleZ = kImageScaleZ; // Scale for Z (pixel Y -> world Z)
+
+    // Points and preview crop; a prefetched neighbour already has them prepared.
+    TargetPrefetcher::Job job;
+    job.path = filepath;
+    job.useRoi = useRoi;
+    job.roiX = roiPixelX;
+    job.roiY = roiPixelY;
+    job.roiRadius = roiRadiusPixels;
+    job.highlights = highlights;
+    job.previewSize = (previewSlot == 1 || previewSlot == 2) ? previewSizePixels : 0;
+    job.levels = m_LevelsPreset;
+    job.heightMode = m_HeightMode;
+    job.filter = m_ImageFilter;
+    job.scaleX = scaleX;
+    job.scaleY = scaleY;
+    job.scaleZ = scaleZ;
+    // Points (and the far-view surface) come from the filtered image; previews stay raw.
+    // The full frame is filtered on a worker: until it is ready only the ROI (plus the
+    // kernel radius) is filtered here, and without a ROI the image is drawn unfiltered
+    // and redrawn when the filtered frame lands.
+    std::shared_ptr<const ImageLoader> pointsImage = m_ImageLoader;
+    bool filterPending = false;
+    if (!m_ImageFilter.IsIdentity()) {
+        std::shared_ptr<const ImageLoader> filtered;
+        if (reprojected) {
+            if (m_Reprojected.filtered && m_Reprojected.filter == m_ImageFilter) filtered = m_Reprojected.filtered;
         } else {
-            m_ImageLoader->GeneratePointCloudWithColors(positions, colors, scaleX, scaleY, scaleZ);
+            filtered = m_Prefetcher->FindImage(filepath, m_ImageFilter);
+            if (!filtered) m_Prefetcher->RequestImage(filepath, m_ImageFilter);
         }
+        if (!filtered && useRoi && m_ImageLoader->IsFits()) {
+            const int r = std::max(0, roiRadiusPixels);
+            filtered = ImageFilter::Apply(*m_ImageLoader, m_ImageFilter, roiPixelX - r, roiPixelY - r,
+                                          roiPixelX + r, roiPixelY + r);
+        } else if (!filtered && reprojected) {
+            // Filter-only run on the reprojection worker.
+            ReprojectedTemplate request = m_Reprojected;
+            request.filter = m_ImageFilter;
+            if (m_ReprojectRun.valid()) {
+                m_ReprojectQueued = std::move(request);
+            } else {
+                StartReprojection(std::move(request));
+            }
+        } else if (!filtered && m_ImageLoader->IsFits()) {
+            filterPending = true;
+        }
+        if (filtered) pointsImage = std::move(filtered);
+    }
+    std::shared_ptr<const TargetPrefetcher::PreparedImage> prepared =
+        reprojected ? nullptr : m_Prefetcher->FindPrepared(job);
+    if (!prepared) {
+        auto generated = std::make_shared<TargetPrefetcher::PreparedImage>();
+        TargetPrefetcher::Prepare(*m_ImageLoader, *pointsImage, job, *generated);
+        prepared = std::move(generated);
+    }
+    const std::vector<glm::vec3>& positions = prepared->positions;
+    const std::vector<glm::vec4>& colors = prepared->colors;
+    const std::vector<std::uint8_t>& groups = prepared->groups;
+
+    // Update preview texture using the freshly loaded image.
+    if (previewSlot == 1 || previewSlot == 2) {
+        // Crop size follows the highlight size (i.e., "染色区域") around the ROI center.
+        // Preview should be raw FITS brightness (no tint). Stretch is handled internally.
+        UpdatePreviewTextureFromCurrentImage(previewSlot, filepath, roiPixelX, roiPixelY, previewSizePixels,
+                                             glm::vec4(0.0f), 0.0f, &prepared->previewRGBA);
     }
 
     std::cout << "Creating point cloud with " << positions.size() << " points..." << std::endl;
@@ -698,7 +1367,12 @@ void Application::LoadImageAndGeneratePointsInternal(const std::string& filepath
 
     auto pointCloud = std::make_shared<PointCloud>();
     pointCloud->SetPointData(positions, colors);
+    pointCloud->SetPointGroups(groups);
     pointCloud->SetPointSize(basePointSize);
+    for (const auto& highlight : highlights) {
+        pointCloud->SetGroupPointSizeScale(highlight.group, std::clamp(highlight.pointSizeScale, 1.0f, 20.0f));
+    }
+    pointCloud->SetChunkSize(kLodChunkPixels * scaleX);
     pointCloud->SetName("PointCloud_" + filepath);
     pointCloud->Initialize();
 
@@ -708,21 +1382,147 @@ void Application::LoadImageAndGeneratePointsInternal(const std::string& filepath
     std::vector<std::shared_ptr<GeometryObject>> imageObjects;
     imageObjects.push_back(pointCloud);
 
-    if (useHighlight && !highlightPositions.empty()) {
-        auto highlightCloud = std::make_shared<PointCloud>();
-        highlightCloud->SetPointData(highlightPositions, highlightColors);
-        highlightCloud->SetPointSize(basePointSize * highlightPointSizeScale);
-        highlightCloud->SetName("PointCloud_" + filepath + "_highlight");
-        highlightCloud->Initialize();
-        AddGeometryObject(highlightCloud);
-        imageObjects.push_back(highlightCloud);
+    // Far-view stand-in covering the same pixel region as the points.
+    {
+        int x0 = 0;
+        int y0 = 0;
+        int x1 = m_ImageLoader->GetWidth() - 1;
+        int y1 = m_ImageLoader->GetHeight() - 1;
+        if (useRoi) {
+            const int r = std::max(0, roiRadiusPixels);
+            x0 = std::max(x0, roiPixelX - r);
+            x1 = std::min(x1, roiPixelX + r);
+            y0 = std::max(y0, roiPixelY - r);
+            y1 = std::min(y1, roiPixelY + r);
+        }
+        auto surface =
+            CreateImageSurfaceFromCurrentImage(filepath, *pointsImage, x0, y0, x1, y1, scaleX, scaleY, scaleZ);
+        if (surface) {
+            AddGeometryObject(surface);
+            imageObjects.push_back(surface);
+        }
     }
 
     m_ImagePointsMap[filepath] = imageObjects;
 
+    if (filterPending) {
+        PointsLoad load;
+        load.path = filepath;
+        load.useRoi = useRoi;
+        load.roiX = roiPixelX;
+        load.roiY = roiPixelY;
+        load.roiRadius = roiRadiusPixels;
+        load.highlights = highlights;
+        load.previewSlot = previewSlot;
+        load.previewSize = previewSizePixels;
+        load.filter = m_ImageFilter;
+        m_FilterPending.push_back(std::move(load));
+    }
+
     std::cout << "Point cloud created with " << positions.size() << " points (1 draw call)" << std::endl;
 }
 
+std::shared_ptr<ImageSurface> Application::CreateImageSurfaceFromCurrentImage(const std::string& filepath,
+                                                                              const ImageLoader& heights,
+                                                                              int x0, int y0, int x1, int y1,
+                                                                              float scaleX, float scaleY, float scaleZ) {
+    if (!m_ImageLoader || !m_ImageLoader->IsLoaded()) return nullptr;
+
+    const int regionW = x1 - x0 + 1;
+    const int regionH = y1 - y0 + 1;
+    if (regionW < 2 || regionH < 2) return nullptr;
+
+    // Low-res heightfield: one vertex every `step` pixels, always including the far edge.
+    const int step = std::max(1, (std::max(regionW, regionH) + kSurfaceMaxCells - 1) / kSurfaceMaxCells);
+    auto gridCount = [step](int extent) { return (extent - 1) / step + 1 + (((extent - 1) % step) != 0 ? 1 : 0); };
+    const int gridW = gridCount(regionW);
+    const int gridH = gridCount(regionH);
+
+    const float centerX = m_ImageLoader->GetWidth() * 0.5f;
+    const float centerZ = m_ImageLoader->GetHeight() * 0.5f;
+    const ImageLoader::FrameGrid& grid = heights.GetFrameGrid();
+    const int bin = std::max(1, grid.bin);
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    positions.reserve(static_cast<std::size_t>(gridW) * gridH);
+    texCoords.reserve(static_cast<std::size_t>(gridW) * gridH);
+    for (int j = 0; j < gridH; j++) {
+        const int py = std::min(y0 + j * step, y1);
+        for (int i = 0; i < gridW; i++) {
+            const int px = std::min(x0 + i * step, x1);
+            const int hx = std::clamp((px - grid.originX) / bin, 0, heights.GetWidth() - 1);
+            const int hy = std::clamp((py - grid.originY) / bin, 0, heights.GetHeight() - 1);
+            const float height = heights.GetHeightValue(hx, hy, m_HeightMode) * scaleY;
+            positions.emplace_back((px - centerX) * scaleX, height, (py - centerZ) * scaleZ);
+            texCoords.emplace_back((px - x0 + 0.5f) / regionW, (py - y0 + 0.5f) / regionH);
+        }
+    }
+
+    // Texture colors match the point colors (no preview stretch).
+    const int texW = std::min(regionW, kSurfaceMaxTextureSize);
+    const int texH = std::min(regionH, kSurfaceMaxTextureSize);
+    std::vector<unsigned char> rgba;
+    m_ImageLoader->BuildRegionRGBA(x0, y0, regionW, regionH, texW, texH, /*contrastStretch*/ false, rgba);
+    unsigned int texture = 0;
+    UploadTextureRGBA(texture, texW, texH, rgba);
+
+    auto surface = std::make_shared<ImageSurface>();
+    surface->SetGrid(gridW, gridH, positions, texCoords);
+    surface->SetChunkSize(kLodChunkPixels * scaleX);
+    surface->SetTexture(texture);
+    surface->SetName("Surface_" + filepath);
+    surface->Initialize();
+    return surface;
+}
+
+void Application::UpdateImageLayerLod() {
+    if (!m_Camera || !m_Window) return;
+
+    const int viewportHeight = std::max(1, m_Window->GetHeight());
+    const float focalPx = viewportHeight / (2.0f * std::tan(glm::radians(m_Camera->GetFOV()) * 0.5f));
+    const glm::vec3 eye = m_Camera->GetPosition();
+
+    for (auto& [path, objects] : m_ImagePointsMap) {
+        if (objects.empty()) continue;
+        auto* cloud = dynamic_cast<PointCloud*>(objects[0].get());
+        ImageSurface* surface = nullptr;
+        for (auto& object : objects) {
+            if (auto* s = dynamic_cast<ImageSurface*>(object.get())) surface = s;
+        }
+        if (!cloud || !surface) continue;
+
+        if (!m_ImageLodEnabled || !surface->IsVisible() || cloud->GetChunkSize() <= 0.0f) {
+            cloud->SetAllChunksVisible(true);
+            surface->SetAllChunksVisible(false);
+            continue;
+        }
+
+        // Screen-space size of one image pixel at the chunk's closest point to the camera.
+        const float pixelSpacing = cloud->GetChunkSize() / kLodChunkPixels;
+        std::unordered_set<std::int64_t> pointTiles;
+        const auto& chunks = cloud->GetChunks();
+        for (size_t i = 0; i < chunks.size(); i++) {
+            const auto& chunk = chunks[i];
+            const glm::vec3 closest(std::clamp(eye.x, chunk.boundsMin.x, chunk.boundsMax.x),
+                                    std::clamp(eye.y, chunk.boundsMin.y, chunk.boundsMax.y),
+                                    std::clamp(eye.z, chunk.boundsMin.z, chunk.boundsMax.z));
+            const float distance = std::max(glm::length(eye - closest), 1e-3f);
+            const float footprintPx = pixelSpacing * focalPx / distance;
+
+            const bool usePoints = footprintPx >= m_ImageLodThresholdPx;
+            cloud->SetChunkVisible(i, usePoints);
+            if (usePoints) pointTiles.insert(TileKey(chunk.tileX, chunk.tileZ));
+        }
+
+        const auto& surfaceChunks = surface->GetChunks();
+        for (size_t i = 0; i < surfaceChunks.size(); i++) {
+            const auto& chunk = surfaceChunks[i];
+            surface->SetChunkVisible(i, pointTiles.count(TileKey(chunk.tileX, chunk.tileZ)) == 0);
+        }
+    }
+}
+
 void Application::RemoveImagePoints(const std::string& filepath) {
     auto it = m_ImagePointsMap.find(filepath);
     if (it == m_ImagePointsMap.end()) {
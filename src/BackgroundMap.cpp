@@ -0,0 +1,224 @@
+#include "BackgroundMap.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+float Median(std::vector<float>& values) {
+    const std::size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + mid, values.end());
+    return values[mid];
+}
+
+void CatmullRomWeights(float t, float w[4]) {
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    w[0] = 0.5f * (-t3 + 2.0f * t2 - t);
+    w[1] = 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f);
+    w[2] = 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+    w[3] = 0.5f * (t3 - t2);
+}
+
+// Fill NaN cells (too few usable pixels) from their valid neighbours, growing inwards.
+void FillInvalidCells(std::vector<float>& mesh, int width, int height) {
+    std::vector<float> next;
+    for (bool changed = true; changed;) {
+        changed = false;
+        next = mesh;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                if (!std::isnan(mesh[static_cast<std::size_t>(y) * width + x])) continue;
+                double sum = 0.0;
+                int count = 0;
+                for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++) {
+                    for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++) {
+                        const float v = mesh[static_cast<std::size_t>(ny) * width + nx];
+                        if (std::isnan(v)) continue;
+                        sum += v;
+                        count++;
+                    }
+                }
+                if (count > 0) {
+                    next[static_cast<std::size_t>(y) * width + x] = static_cast<float>(sum / count);
+                    changed = true;
+                }
+            }
+        }
+        mesh.swap(next);
+    }
+    // No valid cell at all.
+    std::replace_if(mesh.begin(), mesh.end(), [](float v) { return std::isnan(v); }, 0.0f);
+}
+
+void MedianFilter(std::vector<float>& mesh, int width, int height, int filterSize) {
+    const int half = filterSize / 2;
+    if (half <= 0) return;
+    std::vector<float> filtered(mesh.size());
+    std::vector<float> window;
+    window.reserve(static_cast<std::size_t>(filterSize) * filterSize);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            window.clear();
+            for (int ny = std::max(y - half, 0); ny <= std::min(y + half, height - 1); ny++) {
+                for (int nx = std::max(x - half, 0); nx <= std::min(x + half, width - 1); nx++) {
+                    window.push_back(mesh[static_cast<std::size_t>(ny) * width + nx]);
+                }
+            }
+            filtered[static_cast<std::size_t>(y) * width + x] = Median(window);
+        }
+    }
+    mesh.swap(filtered);
+}
+} // namespace
+
+BackgroundMap::BackgroundMap()
+    : m_Width(0)
+    , m_Height(0)
+    , m_MeshWidth(0)
+    , m_MeshHeight(0)
+    , m_CellWidth(1.0f)
+    , m_CellHeight(1.0f)
+    , m_GlobalLevel(0.0f)
+    , m_GlobalRms(0.0f)
+{
+}
+
+void BackgroundMap::Build(const ImageLoader& image) {
+    Build(image, Params());
+}
+
+void BackgroundMap::Build(const ImageLoader& image, const Params& params) {
+    Clear();
+    if (!image.IsLoaded() || image.GetWidth() <= 0 || image.GetHeight() <= 0) return;
+
+    m_Width = image.GetWidth();
+    m_Height = image.GetHeight();
+    const int meshSize = std::max(params.meshSize, 8);
+    // Whole number of equal cells; edge cells do not end up as slivers.
+    m_MeshWidth = std::max(1, (m_Width + meshSize / 2) / meshSize);
+    m_MeshHeight = std::max(1, (m_Height + meshSize / 2) / meshSize);
+    m_CellWidth = static_cast<float>(m_Width) / m_MeshWidth;
+    m_CellHeight = static_cast<float>(m_Height) / m_MeshHeight;
+
+    const std::size_t cells = static_cast<std::size_t>(m_MeshWidth) * m_MeshHeight;
+    m_Level.assign(cells, 0.0f);
+    m_Rms.assign(cells, 0.0f);
+
+    ParallelForRanges(cells, 4, [&](std::size_t begin, std::size_t end, unsigned int) {
+        std::vector<float> values;
+        std::vector<float> row;
+        std::vector<std::uint8_t> blank;
+        for (std::size_t cell = begin; cell < end; cell++) {
+            const int cx = static_cast<int>(cell % m_MeshWidth);
+            const int cy = static_cast<int>(cell / m_MeshWidth);
+            const int x0 = cx * m_Width / m_MeshWidth;
+            const int x1 = (cx + 1) * m_Width / m_MeshWidth;
+            const int y0 = cy * m_Height / m_MeshHeight;
+            const int y1 = (cy + 1) * m_Height / m_MeshHeight;
+
+            values.clear();
+            row.resize(static_cast<std::size_t>(x1 - x0));
+            blank.resize(row.size());
+            for (int y = y0; y < y1; y++) {
+                image.GetNormalizedRow(y, x0, x1 - x0, row.data());
+                image.GetBlankRow(y, x0, x1 - x0, blank.data());
+                for (std::size_t i = 0; i < row.size(); i++) {
+                    if (!blank[i]) values.push_back(row[i]);
+                }
+            }
+            // Mostly blank cells are filled from their neighbours afterwards.
+            const std::size_t area = static_cast<std::size_t>(x1 - x0) * (y1 - y0);
+            if (values.empty() || values.size() * 2 < area) {
+                m_Level[cell] = std::numeric_limits<float>::quiet_NaN();
+                m_Rms[cell] = std::numeric_limits<float>::quiet_NaN();
+                continue;
+            }
+
+            // Clip around the median until no more pixels are rejected.
+            float median = 0.0f;
+            double mean = 0.0;
+            double sigma = 0.0;
+            for (int iteration = 0; iteration < params.maxIterations; iteration++) {
+                median = Median(values);
+                double sum = 0.0;
+                double sumSq = 0.0;
+                for (float v : values) {
+                    sum += v;
+                    sumSq += static_cast<double>(v) * v;
+                }
+                const double n = static_cast<double>(values.size());
+                mean = sum / n;
+                sigma = std::sqrt(std::max(0.0, sumSq / n - mean * mean));
+
+                const double limit = params.clipSigma * sigma;
+                const std::size_t before = values.size();
+                values.erase(std::remove_if(values.begin(), values.end(),
+                                            [&](float v) { return std::abs(v - median) > limit; }),
+                             values.end());
+                if (values.size() == before || values.size() < 3) break;
+            }
+
+            // Mode estimate, unless the distribution is too skewed (crowded field).
+            float level = median;
+            if (sigma > 0.0 && (mean - median) / sigma < 0.3) {
+                level = static_cast<float>(2.5 * median - 1.5 * mean);
+            }
+            m_Level[cell] = level;
+            m_Rms[cell] = static_cast<float>(sigma);
+        }
+    });
+
+    FillInvalidCells(m_Level, m_MeshWidth, m_MeshHeight);
+    FillInvalidCells(m_Rms, m_MeshWidth, m_MeshHeight);
+    MedianFilter(m_Level, m_MeshWidth, m_MeshHeight, params.filterSize);
+    MedianFilter(m_Rms, m_MeshWidth, m_MeshHeight, params.filterSize);
+
+    std::vector<float> scratch = m_Level;
+    m_GlobalLevel = Median(scratch);
+    scratch = m_Rms;
+    m_GlobalRms = Median(scratch);
+}
+
+void BackgroundMap::Clear() {
+    m_Width = 0;
+    m_Height = 0;
+    m_MeshWidth = 0;
+    m_MeshHeight = 0;
+    m_Level.clear();
+    m_Rms.clear();
+    m_GlobalLevel = 0.0f;
+    m_GlobalRms = 0.0f;
+}
+
+std::size_t BackgroundMap::GetMemoryBytes() const {
+    return (m_Level.capacity() + m_Rms.capacity()) * sizeof(float);
+}
+
+float BackgroundMap::Interpolate(const std::vector<float>& mesh, int x, int y) const {
+    if (mesh.empty()) return 0.0f;
+
+    // Position in cell units, cell centers at integers; flat beyond the outer centers.
+    const float gx = std::clamp((x + 0.5f) / m_CellWidth - 0.5f, 0.0f, static_cast<float>(m_MeshWidth - 1));
+    const float gy = std::clamp((y + 0.5f) / m_CellHeight - 0.5f, 0.0f, static_cast<float>(m_MeshHeight - 1));
+    const int ix = static_cast<int>(gx);
+    const int iy = static_cast<int>(gy);
+    float wx[4];
+    float wy[4];
+    CatmullRomWeights(gx - ix, wx);
+    CatmullRomWeights(gy - iy, wy);
+
+    int columns[4];
+    for (int k = 0; k < 4; k++) columns[k] = std::clamp(ix - 1 + k, 0, m_MeshWidth - 1);
+
+    float value = 0.0f;
+    for (int j = 0; j < 4; j++) {
+        const float* row = &mesh[static_cast<std::size_t>(std::clamp(iy - 1 + j, 0, m_MeshHeight - 1)) * m_MeshWidth];
+        value += wy[j] * (wx[0] * row[columns[0]] + wx[1] * row[columns[1]] + wx[2] * row[columns[2]] +
+                          wx[3] * row[columns[3]]);
+    }
+    return value;
+}
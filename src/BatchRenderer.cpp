@@ -0,0 +1,391 @@
+#include "BatchRenderer.h"
+#include "BoundedQueue.h"
+#include "Camera.h"
+#include "CpuPointRasterizer.h"
+#include "HeadlessContext.h"
+#include "ImageLoader.h"
+#include "ImageWriter.h"
+#include "ParallelFor.h"
+#include "Renderer.h"
+#include "Geometry/PointCloud.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Same pixel -> world mapping as Application::LoadImageAndGeneratePointsInternal.
+constexpr float kScaleX = 0.1f;
+constexpr float kScaleY = 10.0f;
+constexpr float kScaleZ = 0.1f;
+constexpr float kBasePointSize = 3.0f;
+constexpr float kFovDegrees = 45.0f;
+
+struct CameraPreset {
+    const char* name;
+    float yawDegrees;
+    float pitchDegrees;
+};
+
+// Looking down, three-quarter, and low side view of the ROI.
+const CameraPreset kCameraPresets[] = {
+    {"top", -90.0f, 89.0f},
+    {"oblique", 45.0f, 35.0f},
+    {"side", 90.0f, 10.0f},
+};
+
+const glm::vec4 kClearColor(0.95f, 0.95f, 0.95f, 1.0f); // Renderer::Clear default
+const glm::vec4 kAlignedHighlight(1.0f, 0.2706f, 0.0f, 1.0f);   // OrangeRed (#FF4500)
+const glm::vec4 kTemplateHighlight(0.5294f, 0.8078f, 0.9216f, 1.0f); // SkyBlue (#87CEEB)
+const glm::vec4 kOtherTargetHighlight(1.0f, 0.8431f, 0.0f, 1.0f); // Gold (#FFD700)
+
+std::string SanitizeFileComponent(const std::string& s) {
+    std::string out = s;
+    for (char& c : out) {
+        const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                        c == '-' || c == '_' || c == '.';
+        if (!ok) c = '_';
+    }
+    return out.empty() ? std::string("target") : out;
+}
+
+void SetupPresetCamera(Camera& camera, const glm::vec3& center, float roiWorldSize, const CameraPreset& preset) {
+    const float distance = (roiWorldSize * 0.5f) / std::tan(glm::radians(kFovDegrees * 0.5f)) * 1.3f;
+    const float yaw = glm::radians(preset.yawDegrees);
+    const float pitch = glm::radians(preset.pitchDegrees);
+    const glm::vec3 offset(std::cos(pitch) * std::cos(yaw), std::sin(pitch), std::cos(pitch) * std::sin(yaw));
+    camera.SetTarget(center);
+    camera.SetPosition(center + offset * distance);
+}
+} // namespace
+
+BatchRenderer::BatchRenderer(const BatchRenderOptions& options)
+    : m_Options(options)
+{
+}
+
+BatchRenderer::~BatchRenderer() = default;
+
+void BatchRenderer::CollectJobs(std::vector<PairJob>& jobs) const {
+    jobs.clear();
+
+    const fs::path root(m_Options.labelRoot);
+    std::vector<fs::path> txtFiles;
+    try {
+        for (const auto& entry : fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".txt") {
+                txtFiles.push_back(entry.path());
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to scan label root " << root << ": " << e.what() << std::endl;
+        return;
+    }
+    std::sort(txtFiles.begin(), txtFiles.end());
+
+    // FITS files next to the label txts are found through the shared index as well.
+    FileIndex& index = GetFitsFileIndex();
+    index.AddRoot(root);
+    index.WaitUntilReady();
+
+    for (const auto& txtPath : txtFiles) {
+        std::vector<TxtTargetRecord> targets;
+        std::string err;
+        if (!ParseTxtTargetFile(txtPath, targets, err)) {
+            std::cerr << "Skipping " << txtPath << ": " << err << std::endl;
+            continue;
+        }
+
+        std::string outSubdir;
+        try {
+            outSubdir = fs::relative(txtPath, root).replace_extension().generic_string();
+        } catch (...) {
+            outSubdir = txtPath.stem().string();
+        }
+
+        // Group this txt's targets by FITS pair, keeping first-seen order.
+        std::map<std::string, std::size_t> pairIndex;
+        for (const auto& rec : targets) {
+            if (!rec.hasPixelCenter) continue;
+
+            fs::path aligned;
+            fs::path templ;
+            if (!ResolveTxtTargetFitsPaths(rec, index, aligned, templ)) continue;
+
+            const std::string key = aligned.string() + "|" + templ.string();
+            auto it = pairIndex.find(key);
+            if (it == pairIndex.end()) {
+                it = pairIndex.emplace(key, jobs.size()).first;
+                PairJob job;
+                job.outSubdir = outSubdir;
+                job.alignedPath = aligned.string();
+                job.templatePath = templ.string();
+                jobs.push_back(std::move(job));
+            }
+            jobs[it->second].targets.push_back(rec);
+        }
+    }
+}
+
+void BatchRenderer::GenerateTarget(const TargetItem& item,
+                                   std::vector<RenderItem>& renderItems,
+                                   std::vector<EncodeJob>& crops) const {
+    const DecodedPair& pair = *item.pair;
+    const TxtTargetRecord& target = pair.job.targets[item.targetIndex];
+    const fs::path outBase = fs::path(m_Options.outDir) / pair.job.outSubdir / SanitizeFileComponent(target.index);
+
+    // Other targets of the same pair show up as a second highlight group.
+    std::vector<ImageLoader::PointHighlight> highlights;
+    ImageLoader::PointHighlight primary;
+    primary.centerX = target.pixelX;
+    primary.centerY = target.pixelY;
+    primary.sizePixels = m_Options.highlightSizePixels;
+    primary.group = 1;
+    highlights.push_back(primary);
+    for (std::size_t i = 0; i < pair.job.targets.size(); i++) {
+        if (i == item.targetIndex) continue;
+        ImageLoader::PointHighlight other;
+        other.centerX = pair.job.targets[i].pixelX;
+        other.centerY = pair.job.targets[i].pixelY;
+        other.sizePixels = m_Options.highlightSizePixels;
+        other.color = kOtherTargetHighlight;
+        other.group = 2;
+        highlights.push_back(other);
+    }
+
+    struct Side {
+        const char* name;
+        const ImageLoader* image;
+        glm::vec4 color;
+    };
+    const Side sides[] = {
+        {"aligned", pair.aligned.get(), kAlignedHighlight},
+        {"template", pair.templ.get(), kTemplateHighlight},
+    };
+
+    for (const Side& side : sides) {
+        if (!side.image || !side.image->IsLoaded()) continue;
+        const ImageLoader& image = *side.image;
+
+        highlights[0].color = side.color;
+
+        RenderItem render;
+        render.outPrefix = outBase.string() + "_" + side.name;
+        image.GeneratePointCloudWithColorsROIGroups(render.positions, render.colors, render.groups,
+                                                    target.pixelX, target.pixelY, m_Options.roiRadiusPixels,
+                                                    highlights, kScaleX, kScaleY, kScaleZ, m_Options.heightMode);
+        if (render.positions.empty()) continue;
+
+        const int cx = std::clamp(target.pixelX, 0, image.GetWidth() - 1);
+        const int cy = std::clamp(target.pixelY, 0, image.GetHeight() - 1);
+        render.center = glm::vec3((cx - image.GetWidth() * 0.5f) * kScaleX,
+                                  image.GetHeightValue(cx, cy, m_Options.heightMode) * kScaleY,
+                                  (cy - image.GetHeight() * 0.5f) * kScaleZ);
+        renderItems.push_back(std::move(render));
+
+        // 2D preview crop, same stretch as the interactive preview window.
+        const int crop = std::clamp(m_Options.previewSizePixels, 1, 300);
+        EncodeJob job;
+        job.path = outBase.string() + "_" + side.name + "_crop.png";
+        job.width = crop;
+        job.height = crop;
+        image.BuildRegionRGBA(target.pixelX - crop / 2, target.pixelY - crop / 2, crop, crop,
+                              crop, crop, /*contrastStretch*/ true, job.rgba);
+        crops.push_back(std::move(job));
+    }
+}
+
+bool BatchRenderer::RenderStage(BoundedQueue<RenderItem>& renderQueue, BoundedQueue<EncodeJob>& encodeQueue) {
+    const int width = m_Options.width;
+    const int height = m_Options.height;
+    const float roiWorldSize = (2.0f * m_Options.roiRadiusPixels + 1.0f) * kScaleX;
+
+    // The GL context lives on this thread; without one, fall back to the CPU rasterizer.
+    std::unique_ptr<HeadlessContext> context;
+    std::unique_ptr<Renderer> renderer;
+    if (!m_Options.useCpuRasterizer) {
+        context = std::make_unique<HeadlessContext>();
+        renderer = std::make_unique<Renderer>();
+        if (!context->Initialize(width, height) || !renderer->Initialize()) {
+            std::cerr << "Headless GL unavailable, using the CPU rasterizer" << std::endl;
+            renderer.reset();
+            context.reset();
+        }
+    }
+    CpuPointRasterizer rasterizer;
+    if (!context) rasterizer.Resize(width, height);
+
+    float groupSizes[PointCloud::kMaxPointGroups];
+    for (int i = 0; i < PointCloud::kMaxPointGroups; i++) groupSizes[i] = kBasePointSize;
+    groupSizes[1] = kBasePointSize * m_Options.highlightPointSizeScale;
+    groupSizes[2] = kBasePointSize * std::max(1.0f, m_Options.highlightPointSizeScale * 0.5f);
+
+    Camera camera(kFovDegrees, static_cast<float>(width) / static_cast<float>(height));
+
+    RenderItem item;
+    while (renderQueue.Pop(item)) {
+        std::unique_ptr<PointCloud> cloud;
+        if (context) {
+            cloud = std::make_unique<PointCloud>();
+            cloud->SetPointData(item.positions, item.colors);
+            cloud->SetPointGroups(item.groups);
+            cloud->SetPointSize(kBasePointSize);
+            for (int g = 1; g < PointCloud::kMaxPointGroups; g++) {
+                cloud->SetGroupPointSizeScale(g, groupSizes[g] / kBasePointSize);
+            }
+            cloud->Initialize();
+        }
+
+        for (const CameraPreset& preset : kCameraPresets) {
+            SetupPresetCamera(camera, item.center, roiWorldSize, preset);
+
+            EncodeJob job;
+            job.path = item.outPrefix + "_" + preset.name + ".png";
+            job.width = width;
+            job.height = height;
+            job.flipVertically = true; // both backends produce bottom-up rows
+
+            if (context) {
+                context->Bind();
+                renderer->Clear(kClearColor);
+                renderer->RenderPointCloud(cloud.get(), &camera);
+                context->ReadPixels(job.rgba);
+            } else {
+                rasterizer.Clear(kClearColor);
+                rasterizer.DrawPoints(item.positions, item.colors, item.groups, groupSizes,
+                                      glm::mat4(1.0f), camera.GetViewMatrix(), camera.GetProjectionMatrix());
+                job.rgba = rasterizer.GetColorBuffer();
+            }
+
+            if (!encodeQueue.Push(std::move(job))) return false;
+        }
+    }
+
+    if (renderer) renderer->Shutdown();
+    return true;
+}
+
+int BatchRenderer::Run() {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    if (m_Options.width <= 0 || m_Options.height <= 0) {
+        std::cerr << "Invalid snapshot size" << std::endl;
+        return -1;
+    }
+
+    std::vector<PairJob> jobs;
+    CollectJobs(jobs);
+    std::size_t totalTargets = 0;
+    for (const auto& job : jobs) totalTargets += job.targets.size();
+    if (jobs.empty()) {
+        std::cerr << "No targets with pixel centers found under " << m_Options.labelRoot << std::endl;
+        return -1;
+    }
+    std::cout << "Batch render: " << totalTargets << " targets in " << jobs.size() << " FITS pair(s)" << std::endl;
+
+    const unsigned int threads = (m_Options.threads > 0) ? static_cast<unsigned int>(m_Options.threads)
+                                                         : GetWorkerThreadCount();
+    const unsigned int generateWorkers = std::max(1u, threads);
+    const unsigned int encodeWorkers = std::max(1u, threads / 2);
+
+    // Queue capacities bound memory: only a couple of decoded pairs and a few frames per
+    // worker are alive at any time.
+    BoundedQueue<TargetItem> targetQueue(generateWorkers * 2);
+    BoundedQueue<RenderItem> renderQueue(4);
+    BoundedQueue<EncodeJob> encodeQueue(encodeWorkers * 4);
+
+    std::atomic<std::size_t> targetsDone{0};
+    std::atomic<std::size_t> filesWritten{0};
+    std::atomic<std::size_t> filesFailed{0};
+
+    // Decode: one pair at a time (FITS reads are serialized inside FitsLoader anyway).
+    std::thread decodeThread([&]() {
+        for (const PairJob& job : jobs) {
+            auto pair = std::make_shared<DecodedPair>();
+            pair->job = job;
+            pair->aligned = std::make_shared<ImageLoader>();
+            pair->templ = std::make_shared<ImageLoader>();
+            const bool alignedOk = fs::exists(job.alignedPath) && pair->aligned->LoadImage(job.alignedPath);
+            const bool templateOk = fs::exists(job.templatePath) && pair->templ->LoadImage(job.templatePath);
+            if (!alignedOk) std::cerr << "Aligned FITS not found: " << job.alignedPath << std::endl;
+            if (!templateOk) std::cerr << "Template FITS not found: " << job.templatePath << std::endl;
+            if (!alignedOk && !templateOk) {
+                targetsDone += job.targets.size();
+                continue;
+            }
+
+            try {
+                fs::create_directories(fs::path(m_Options.outDir) / job.outSubdir);
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to create output directory: " << e.what() << std::endl;
+            }
+
+            for (std::size_t i = 0; i < job.targets.size(); i++) {
+                if (!targetQueue.Push(TargetItem{pair, i})) return;
+            }
+        }
+        targetQueue.Close();
+    });
+
+    // Generate: ROI point clouds and preview crops, one target per worker at a time.
+    std::vector<std::thread> generateThreads;
+    for (unsigned int w = 0; w < generateWorkers; w++) {
+        generateThreads.emplace_back([&]() {
+            TargetItem item;
+            while (targetQueue.Pop(item)) {
+                std::vector<RenderItem> renderItems;
+                std::vector<EncodeJob> crops;
+                GenerateTarget(item, renderItems, crops);
+                item = TargetItem{};
+
+                for (auto& crop : crops) encodeQueue.Push(std::move(crop));
+                for (auto& render : renderItems) renderQueue.Push(std::move(render));
+
+                const std::size_t done = ++targetsDone;
+                if (done % 100 == 0) {
+                    std::cout << "  " << done << " / " << totalTargets << " targets" << std::endl;
+                }
+            }
+        });
+    }
+
+    std::thread renderThread([&]() {
+        if (!RenderStage(renderQueue, encodeQueue)) {
+            std::cerr << "Render stage stopped early" << std::endl;
+        }
+    });
+
+    std::vector<std::thread> encodeThreads;
+    for (unsigned int w = 0; w < encodeWorkers; w++) {
+        encodeThreads.emplace_back([&]() {
+            EncodeJob job;
+            while (encodeQueue.Pop(job)) {
+                if (ImageWriter::WritePngRGBA(job.path, job.width, job.height, job.rgba.data(), job.flipVertically)) {
+                    ++filesWritten;
+                } else {
+                    ++filesFailed;
+                }
+            }
+        });
+    }
+
+    decodeThread.join();
+    for (auto& t : generateThreads) t.join();
+    renderQueue.Close();
+    renderThread.join();
+    encodeQueue.Close();
+    for (auto& t : encodeThreads) t.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Batch render finished: " << targetsDone.load() << " targets, "
+              << filesWritten.load() << " PNG(s) written, " << filesFailed.load() << " failed, "
+              << seconds << " s (" << (seconds > 0.0 ? targetsDone.load() / seconds : 0.0) << " targets/s)" << std::endl;
+
+    return filesFailed.load() == 0 ? 0 : -1;
+}
@@ -0,0 +1,248 @@
+#include "CpuPointRasterizer.h"
+#include "Camera.h"
+#include "ParallelFor.h"
+#include "Geometry/PointCloud.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPU_RASTER_USE_SSE2 1
+#endif
+
+namespace {
+constexpr int kTileSize = 64;
+// Points are projected and binned in batches so memory stays bounded for huge clouds.
+constexpr std::size_t kBatchPoints = std::size_t(1) << 20;
+constexpr std::size_t kMinPointsPerWorker = 16384;
+
+std::uint8_t ToU8(float v) {
+    v = std::clamp(v, 0.0f, 1.0f);
+    return static_cast<std::uint8_t>(v * 255.0f + 0.5f);
+}
+
+// GL 3.3 core point sprite rule: a pixel is covered when its center lies in
+// [center - halfSize, center + halfSize).
+inline int FirstCoveredPixel(float center, float halfSize) {
+    return static_cast<int>(std::ceil(center - halfSize - 0.5f));
+}
+inline int LastCoveredPixel(float center, float halfSize) {
+    return static_cast<int>(std::ceil(center + halfSize - 0.5f)) - 1;
+}
+} // namespace
+
+CpuPointRasterizer::CpuPointRasterizer()
+    : m_Width(0)
+    , m_Height(0)
+    , m_TilesX(0)
+    , m_TilesY(0)
+{
+}
+
+void CpuPointRasterizer::Resize(int width, int height) {
+    m_Width = std::max(width, 0);
+    m_Height = std::max(height, 0);
+    m_TilesX = (m_Width + kTileSize - 1) / kTileSize;
+    m_TilesY = (m_Height + kTileSize - 1) / kTileSize;
+    m_Color.assign(static_cast<std::size_t>(m_Width) * m_Height * 4, 0);
+    m_Depth.assign(static_cast<std::size_t>(m_Width) * m_Height, 1.0f);
+}
+
+void CpuPointRasterizer::Clear(const glm::vec4& color) {
+    const std::uint8_t rgba[4] = {ToU8(color.r), ToU8(color.g), ToU8(color.b), ToU8(color.a)};
+    for (std::size_t i = 0; i < m_Color.size(); i += 4) {
+        m_Color[i + 0] = rgba[0];
+        m_Color[i + 1] = rgba[1];
+        m_Color[i + 2] = rgba[2];
+        m_Color[i + 3] = rgba[3];
+    }
+    std::fill(m_Depth.begin(), m_Depth.end(), 1.0f);
+}
+
+void CpuPointRasterizer::DrawPointCloud(const PointCloud& cloud, const Camera& camera) {
+    const std::vector<glm::vec3>& positions = cloud.GetPositions();
+    const std::vector<int>& order = cloud.GetDrawOrder();
+    float groupSizes[PointCloud::kMaxPointGroups];
+    if (order.size() != positions.size()) {
+        for (int i = 0; i < PointCloud::kMaxPointGroups; i++) {
+            groupSizes[i] = cloud.GetPointSize() * cloud.GetGroupPointSizeScale(i);
+        }
+        DrawPoints(positions, cloud.GetColors(), cloud.GetPointGroups(), groupSizes,
+                   cloud.GetModelMatrix(), camera.GetViewMatrix(), camera.GetProjectionMatrix());
+        return;
+    }
+    if (!cloud.BuildDrawRanges(m_DrawFirsts, m_DrawCounts, groupSizes)) return;
+
+    // Gather in vertex-slot order, so depth ties resolve like the GL draw.
+    const std::vector<glm::vec4>& colors = cloud.GetColors();
+    const std::vector<std::uint8_t>& groups = cloud.GetPointGroups();
+    m_DrawPositions.clear();
+    m_DrawColors.clear();
+    m_DrawGroups.clear();
+    for (std::size_t r = 0; r < m_DrawFirsts.size(); r++) {
+        for (int slot = m_DrawFirsts[r]; slot < m_DrawFirsts[r] + m_DrawCounts[r]; slot++) {
+            const int i = order[slot];
+            m_DrawPositions.push_back(positions[i]);
+            m_DrawColors.push_back(static_cast<std::size_t>(i) < colors.size() ? colors[i] : glm::vec4(1.0f));
+            m_DrawGroups.push_back(static_cast<std::size_t>(i) < groups.size() ? groups[i] : 0);
+        }
+    }
+    DrawPoints(m_DrawPositions, m_DrawColors, m_DrawGroups, groupSizes,
+               cloud.GetModelMatrix(), camera.GetViewMatrix(), camera.GetProjectionMatrix());
+}
+
+void CpuPointRasterizer::ProjectRange(std::size_t begin, std::size_t end,
+                                      const std::vector<glm::vec3>& positions,
+                                      const std::vector<glm::vec4>& colors,
+                                      const std::vector<std::uint8_t>& groups,
+                                      const float* groupSizes,
+                                      const glm::mat4& mvp,
+                                      std::vector<Splat>& out) const {
+    const float halfW = m_Width * 0.5f;
+    const float halfH = m_Height * 0.5f;
+
+    // Clip-space test and viewport transform for one point; cx..cw are clip coordinates.
+    auto emit = [&](std::size_t i, float cx, float cy, float cz, float cw) {
+        if (!(cw > 0.0f) || cx < -cw || cx > cw || cy < -cw || cy > cw || cz < -cw || cz > cw) return;
+        const float invW = 1.0f / cw;
+        Splat s;
+        s.x = cx * invW * halfW + halfW;
+        s.y = cy * invW * halfH + halfH;
+        s.depth = cz * invW * 0.5f + 0.5f;
+        const std::uint8_t group = (i < groups.size()) ? std::min<std::uint8_t>(groups[i], PointCloud::kMaxPointGroups - 1) : 0;
+        s.halfSize = std::max(groupSizes[group], 1.0f) * 0.5f;
+        const glm::vec4& c = (i < colors.size()) ? colors[i] : glm::vec4(1.0f);
+        s.rgba = static_cast<std::uint32_t>(ToU8(c.r)) |
+                 (static_cast<std::uint32_t>(ToU8(c.g)) << 8) |
+                 (static_cast<std::uint32_t>(ToU8(c.b)) << 16) |
+                 (static_cast<std::uint32_t>(ToU8(c.a)) << 24);
+        out.push_back(s);
+    };
+
+    std::size_t i = begin;
+#ifdef CPU_RASTER_USE_SSE2
+    // Four points at a time: clip = mvp * (x, y, z, 1), accumulated in the same order
+    // as the scalar tail so both paths give identical results.
+    const __m128 m00 = _mm_set1_ps(mvp[0][0]), m01 = _mm_set1_ps(mvp[0][1]), m02 = _mm_set1_ps(mvp[0][2]), m03 = _mm_set1_ps(mvp[0][3]);
+    const __m128 m10 = _mm_set1_ps(mvp[1][0]), m11 = _mm_set1_ps(mvp[1][1]), m12 = _mm_set1_ps(mvp[1][2]), m13 = _mm_set1_ps(mvp[1][3]);
+    const __m128 m20 = _mm_set1_ps(mvp[2][0]), m21 = _mm_set1_ps(mvp[2][1]), m22 = _mm_set1_ps(mvp[2][2]), m23 = _mm_set1_ps(mvp[2][3]);
+    const __m128 m30 = _mm_set1_ps(mvp[3][0]), m31 = _mm_set1_ps(mvp[3][1]), m32 = _mm_set1_ps(mvp[3][2]), m33 = _mm_set1_ps(mvp[3][3]);
+    alignas(16) float cx[4], cy[4], cz[4], cw[4];
+    for (; i + 4 <= end; i += 4) {
+        const glm::vec3& p0 = positions[i];
+        const glm::vec3& p1 = positions[i + 1];
+        const glm::vec3& p2 = positions[i + 2];
+        const glm::vec3& p3 = positions[i + 3];
+        const __m128 x = _mm_setr_ps(p0.x, p1.x, p2.x, p3.x);
+        const __m128 y = _mm_setr_ps(p0.y, p1.y, p2.y, p3.y);
+        const __m128 z = _mm_setr_ps(p0.z, p1.z, p2.z, p3.z);
+
+        _mm_store_ps(cx, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m10, y)), _mm_mul_ps(m20, z)), m30));
+        _mm_store_ps(cy, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m01, x), _mm_mul_ps(m11, y)), _mm_mul_ps(m21, z)), m31));
+        _mm_store_ps(cz, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m02, x), _mm_mul_ps(m12, y)), _mm_mul_ps(m22, z)), m32));
+        _mm_store_ps(cw, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m03, x), _mm_mul_ps(m13, y)), _mm_mul_ps(m23, z)), m33));
+
+        for (int lane = 0; lane < 4; lane++) {
+            emit(i + lane, cx[lane], cy[lane], cz[lane], cw[lane]);
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        const glm::vec3& p = positions[i];
+        const float x = ((mvp[0][0] * p.x + mvp[1][0] * p.y) + mvp[2][0] * p.z) + mvp[3][0];
+        const float y = ((mvp[0][1] * p.x + mvp[1][1] * p.y) + mvp[2][1] * p.z) + mvp[3][1];
+        const float z = ((mvp[0][2] * p.x + mvp[1][2] * p.y) + mvp[2][2] * p.z) + mvp[3][2];
+        const float w = ((mvp[0][3] * p.x + mvp[1][3] * p.y) + mvp[2][3] * p.z) + mvp[3][3];
+        emit(i, x, y, z, w);
+    }
+}
+
+void CpuPointRasterizer::DrawPoints(const std::vector<glm::vec3>& positions,
+                                    const std::vector<glm::vec4>& colors,
+                                    const std::vector<std::uint8_t>& groups,
+                                    const float* groupSizes,
+                                    const glm::mat4& model,
+                                    const glm::mat4& view,
+                                    const glm::mat4& projection) {
+    if (m_Width <= 0 || m_Height <= 0 || positions.empty() || !groupSizes) return;
+
+    const glm::mat4 mvp = projection * view * model;
+    const std::size_t workers = GetWorkerThreadCount();
+    const int tileCount = m_TilesX * m_TilesY;
+
+    std::vector<std::vector<Splat>> splatsPerWorker(workers);
+    std::vector<std::vector<std::vector<std::uint32_t>>> binsPerWorker(
+        workers, std::vector<std::vector<std::uint32_t>>(tileCount));
+
+    for (std::size_t batchBegin = 0; batchBegin < positions.size(); batchBegin += kBatchPoints) {
+        const std::size_t batchEnd = std::min(positions.size(), batchBegin + kBatchPoints);
+
+        // Stage 1: project this batch and bin splats by the tiles they touch. Worker ranges
+        // are contiguous and ascending, so walking workers in order keeps submission order.
+        for (auto& splats : splatsPerWorker) splats.clear();
+        for (auto& bins : binsPerWorker) {
+            for (auto& bin : bins) bin.clear();
+        }
+
+        ParallelForRanges(batchEnd - batchBegin, kMinPointsPerWorker,
+                          [&](std::size_t begin, std::size_t end, unsigned int worker) {
+            auto& splats = splatsPerWorker[worker];
+            auto& bins = binsPerWorker[worker];
+            ProjectRange(batchBegin + begin, batchBegin + end, positions, colors, groups, groupSizes, mvp, splats);
+
+            for (std::size_t s = 0; s < splats.size(); s++) {
+                const Splat& splat = splats[s];
+                const int x0 = std::max(FirstCoveredPixel(splat.x, splat.halfSize), 0);
+                const int x1 = std::min(LastCoveredPixel(splat.x, splat.halfSize), m_Width - 1);
+                const int y0 = std::max(FirstCoveredPixel(splat.y, splat.halfSize), 0);
+                const int y1 = std::min(LastCoveredPixel(splat.y, splat.halfSize), m_Height - 1);
+                if (x0 > x1 || y0 > y1) continue;
+
+                for (int ty = y0 / kTileSize; ty <= y1 / kTileSize; ty++) {
+                    for (int tx = x0 / kTileSize; tx <= x1 / kTileSize; tx++) {
+                        bins[ty * m_TilesX + tx].push_back(static_cast<std::uint32_t>(s));
+                    }
+                }
+            }
+        });
+
+        // Stage 2: each tile owns its pixels, so tiles rasterize without locking.
+        ParallelForEach(static_cast<std::size_t>(tileCount), [&](std::size_t tile) {
+            RasterizeTile(static_cast<int>(tile), splatsPerWorker, binsPerWorker);
+        });
+    }
+}
+
+void CpuPointRasterizer::RasterizeTile(int tileIndex,
+                                       const std::vector<std::vector<Splat>>& splatsPerWorker,
+                                       const std::vector<std::vector<std::vector<std::uint32_t>>>& binsPerWorker) {
+    const int tileX0 = (tileIndex % m_TilesX) * kTileSize;
+    const int tileY0 = (tileIndex / m_TilesX) * kTileSize;
+    const int tileX1 = std::min(tileX0 + kTileSize, m_Width) - 1;
+    const int tileY1 = std::min(tileY0 + kTileSize, m_Height) - 1;
+
+    for (std::size_t worker = 0; worker < binsPerWorker.size(); worker++) {
+        const auto& splats = splatsPerWorker[worker];
+        for (std::uint32_t s : binsPerWorker[worker][tileIndex]) {
+            const Splat& splat = splats[s];
+            const int x0 = std::max(FirstCoveredPixel(splat.x, splat.halfSize), tileX0);
+            const int x1 = std::min(LastCoveredPixel(splat.x, splat.halfSize), tileX1);
+            const int y0 = std::max(FirstCoveredPixel(splat.y, splat.halfSize), tileY0);
+            const int y1 = std::min(LastCoveredPixel(splat.y, splat.halfSize), tileY1);
+
+            for (int y = y0; y <= y1; y++) {
+                const std::size_t row = static_cast<std::size_t>(y) * m_Width;
+                for (int x = x0; x <= x1; x++) {
+                    const std::size_t idx = row + x;
+                    if (!(splat.depth < m_Depth[idx])) continue;
+                    m_Depth[idx] = splat.depth;
+                    unsigned char* dst = &m_Color[idx * 4];
+                    dst[0] = static_cast<unsigned char>(splat.rgba & 0xFF);
+                    dst[1] = static_cast<unsigned char>((splat.rgba >> 8) & 0xFF);
+                    dst[2] = static_cast<unsigned char>((splat.rgba >> 16) & 0xFF);
+                    dst[3] = static_cast<unsigned char>((splat.rgba >> 24) & 0xFF);
+                }
+            }
+        }
+    }
+}
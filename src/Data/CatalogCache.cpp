@@ -0,0 +1,326 @@
+#include "Data/CatalogCache.h"
+
+#include "Data/MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr char kMagic[8] = {'G', 'G', 'C', 'A', 'T', 'L', 'G', '\0'};
+
+std::uint64_t HashPath(const std::string& s) {
+    // FNV-1a, 64 bit.
+    std::uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+class Writer {
+public:
+    explicit Writer(std::ofstream& out) : m_Out(out), m_Offset(0) {}
+
+    template <typename T>
+    void Pod(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        Bytes(&value, sizeof(T));
+    }
+
+    void String(const std::string& s) {
+        Pod(static_cast<std::uint32_t>(s.size()));
+        Bytes(s.data(), s.size());
+    }
+
+    // Count, then the elements starting on an 8-byte boundary.
+    template <typename T>
+    void Column(const std::vector<T>& values) {
+        Pod(static_cast<std::uint64_t>(values.size()));
+        Align();
+        Bytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void Pool(const StringPool& pool) {
+        Pod(static_cast<std::uint32_t>(pool.Size()));
+        for (std::size_t i = 0; i < pool.Size(); i++) String(pool.Get(static_cast<std::uint32_t>(i)));
+    }
+
+private:
+    void Bytes(const void* data, std::size_t size) {
+        m_Out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        m_Offset += size;
+    }
+
+    void Align() {
+        static const char zeros[8] = {};
+        const std::size_t pad = (8 - m_Offset % 8) % 8;
+        Bytes(zeros, pad);
+    }
+
+    std::ofstream& m_Out;
+    std::size_t m_Offset;
+};
+
+// Bounds-checked reader over the mapped file; any overrun sets the failed flag.
+class Reader {
+public:
+    Reader(const char* data, std::size_t size) : m_Data(data), m_Size(size), m_Offset(0), m_Failed(false) {}
+
+    bool Failed() const { return m_Failed; }
+
+    template <typename T>
+    T Pod() {
+        T value{};
+        if (Take(sizeof(T))) std::memcpy(&value, m_Data + m_Offset - sizeof(T), sizeof(T));
+        return value;
+    }
+
+    std::string String() {
+        const std::uint32_t size = Pod<std::uint32_t>();
+        if (!Take(size)) return std::string();
+        return std::string(m_Data + m_Offset - size, size);
+    }
+
+    template <typename T>
+    void Column(std::vector<T>& values) {
+        const std::uint64_t count = Pod<std::uint64_t>();
+        Take((8 - m_Offset % 8) % 8);
+        if (m_Failed || count > (m_Size - m_Offset) / sizeof(T)) {
+            m_Failed = true;
+            return;
+        }
+        values.resize(static_cast<std::size_t>(count));
+        std::memcpy(values.data(), m_Data + m_Offset, values.size() * sizeof(T));
+        m_Offset += values.size() * sizeof(T);
+    }
+
+    // A duplicate string would shift every later id, so it marks the pool as corrupt.
+    void Pool(StringPool& pool) {
+        const std::uint32_t count = Pod<std::uint32_t>();
+        for (std::uint32_t i = 0; i < count && !m_Failed; i++) {
+            if (pool.Intern(String()) != i) m_Failed = true;
+        }
+    }
+
+private:
+    bool Take(std::size_t bytes) {
+        if (m_Failed || bytes > m_Size - m_Offset) {
+            m_Failed = true;
+            return false;
+        }
+        m_Offset += bytes;
+        return true;
+    }
+
+    const char* m_Data;
+    std::size_t m_Size;
+    std::size_t m_Offset;
+    bool m_Failed;
+};
+} // namespace
+
+fs::path CatalogCache::GetCachePath(const fs::path& root) {
+    std::error_code ec;
+    fs::path absolute = fs::absolute(root, ec);
+    if (ec) absolute = root;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin",
+                  static_cast<unsigned long long>(HashPath(absolute.lexically_normal().generic_string())));
+    return fs::current_path(ec) / "catalog_cache" / name;
+}
+
+bool CatalogCache::Save(const TargetCatalog& catalog, const fs::path& file, std::string& outError) {
+    std::error_code ec;
+    fs::create_directories(file.parent_path(), ec);
+
+    fs::path tempFile = file;
+    tempFile += ".tmp";
+    {
+        std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            outError = "cannot write " + tempFile.string();
+            return false;
+        }
+        Writer w(out);
+        out.write(kMagic, sizeof(kMagic));
+        w.Pod(kVersion);
+        w.Pod(std::uint32_t{0});
+        w.String(catalog.m_Root.generic_string());
+
+        w.Pod(static_cast<std::uint32_t>(catalog.m_SourceFiles.size()));
+        for (const auto& source : catalog.m_SourceFiles) {
+            w.String(source.relativePath);
+            w.Pod(static_cast<std::uint8_t>(source.label));
+            w.Pod(source.firstRow);
+            w.Pod(source.rowCount);
+            w.Pod(static_cast<std::uint64_t>(source.size));
+            w.Pod(static_cast<std::int64_t>(source.writeTime.time_since_epoch().count()));
+        }
+
+        w.Pod(static_cast<std::uint32_t>(catalog.m_Directories.size()));
+        for (const auto& dir : catalog.m_Directories) {
+            w.String(dir.relativePath);
+            w.Pod(static_cast<std::uint32_t>(dir.entries.size()));
+            for (const auto& entry : dir.entries) {
+                w.String(entry.name);
+                w.Pod(static_cast<std::uint8_t>(entry.isDirectory ? 1 : 0));
+                w.Pod(static_cast<std::uint64_t>(entry.size));
+            }
+        }
+
+        w.Pool(catalog.m_Paths);
+        w.Pool(catalog.m_Names);
+
+        w.Column(catalog.m_SourceFile);
+        w.Column(catalog.m_Label);
+        w.Column(catalog.m_Flags);
+        w.Column(catalog.m_IndexId);
+        w.Column(catalog.m_FileDirId);
+        w.Column(catalog.m_AlignedId);
+        w.Column(catalog.m_TemplateId);
+        w.Column(catalog.m_PixelX);
+        w.Column(catalog.m_PixelY);
+        w.Column(catalog.m_Ra);
+        w.Column(catalog.m_Dec);
+        w.Column(catalog.m_Epoch);
+
+        out.flush();
+        if (!out) {
+            outError = "write failed: " + tempFile.string();
+            return false;
+        }
+    }
+
+    fs::rename(tempFile, file, ec);
+    if (ec) {
+        outError = ec.message();
+        fs::remove(tempFile, ec);
+        return false;
+    }
+    return true;
+}
+
+bool CatalogCache::Load(const fs::path& file, const fs::path& root, TargetCatalog& catalog, std::string& outError) {
+    MappedFile mapping;
+    if (!mapping.Open(file, outError)) return false;
+    if (mapping.GetSize() < sizeof(kMagic) || std::memcmp(mapping.GetData(), kMagic, sizeof(kMagic)) != 0) {
+        outError = "not a catalog cache";
+        return false;
+    }
+
+    Reader r(mapping.GetData() + sizeof(kMagic), mapping.GetSize() - sizeof(kMagic));
+    const std::uint32_t version = r.Pod<std::uint32_t>();
+    r.Pod<std::uint32_t>();
+    if (version != kVersion) {
+        outError = "cache version " + std::to_string(version) + ", expected " + std::to_string(kVersion);
+        return false;
+    }
+
+    std::error_code ec;
+    fs::path absoluteRoot = fs::absolute(root, ec);
+    if (ec) absoluteRoot = root;
+    if (r.String() != absoluteRoot.generic_string()) {
+        outError = "cache belongs to another root";
+        return false;
+    }
+
+    TargetCatalog loaded;
+    loaded.m_Root = absoluteRoot;
+
+    const std::uint32_t sourceCount = r.Pod<std::uint32_t>();
+    for (std::uint32_t i = 0; i < sourceCount && !r.Failed(); i++) {
+        TargetCatalog::SourceFile source;
+        source.relativePath = r.String();
+        source.path = absoluteRoot / fs::path(source.relativePath);
+        source.label = static_cast<TargetCatalog::Label>(r.Pod<std::uint8_t>());
+        source.firstRow = r.Pod<std::uint32_t>();
+        source.rowCount = r.Pod<std::uint32_t>();
+        source.size = r.Pod<std::uint64_t>();
+        source.writeTime = fs::file_time_type(fs::file_time_type::duration(r.Pod<std::int64_t>()));
+        loaded.m_SourceFiles.push_back(std::move(source));
+    }
+
+    const std::uint32_t dirCount = r.Pod<std::uint32_t>();
+    for (std::uint32_t i = 0; i < dirCount && !r.Failed(); i++) {
+        TargetCatalog::DirectoryListing listing;
+        listing.relativePath = r.String();
+        const std::uint32_t entryCount = r.Pod<std::uint32_t>();
+        for (std::uint32_t j = 0; j < entryCount && !r.Failed(); j++) {
+            TargetCatalog::DirectoryEntry entry;
+            entry.name = r.String();
+            entry.isDirectory = r.Pod<std::uint8_t>() != 0;
+            entry.size = r.Pod<std::uint64_t>();
+            listing.entries.push_back(std::move(entry));
+        }
+        loaded.m_Directories.push_back(std::move(listing));
+    }
+
+    r.Pool(loaded.m_Paths);
+    r.Pool(loaded.m_Names);
+
+    r.Column(loaded.m_SourceFile);
+    r.Column(loaded.m_Label);
+    r.Column(loaded.m_Flags);
+    r.Column(loaded.m_IndexId);
+    r.Column(loaded.m_FileDirId);
+    r.Column(loaded.m_AlignedId);
+    r.Column(loaded.m_TemplateId);
+    r.Column(loaded.m_PixelX);
+    r.Column(loaded.m_PixelY);
+    r.Column(loaded.m_Ra);
+    r.Column(loaded.m_Dec);
+    r.Column(loaded.m_Epoch);
+
+    if (r.Failed()) {
+        outError = "truncated catalog cache";
+        return false;
+    }
+    const std::size_t rows = loaded.m_SourceFile.size();
+    if (loaded.m_Label.size() != rows || loaded.m_Flags.size() != rows || loaded.m_IndexId.size() != rows ||
+        loaded.m_FileDirId.size() != rows || loaded.m_AlignedId.size() != rows ||
+        loaded.m_TemplateId.size() != rows || loaded.m_PixelX.size() != rows || loaded.m_PixelY.size() != rows ||
+        loaded.m_Ra.size() != rows || loaded.m_Dec.size() != rows || loaded.m_Epoch.size() != rows) {
+        outError = "inconsistent catalog cache columns";
+        return false;
+    }
+
+    // Ids and row ranges index straight into the pools and columns, so a corrupt or
+    // stale cache must not get past here; the caller then rescans the root.
+    const std::size_t sourceFiles = loaded.m_SourceFiles.size();
+    const std::size_t paths = loaded.m_Paths.Size();
+    const std::size_t names = loaded.m_Names.Size();
+    const auto maxLabel = static_cast<std::uint8_t>(TargetCatalog::Label::Bad);
+    for (std::size_t s = 0; s < sourceFiles; s++) {
+        const auto& source = loaded.m_SourceFiles[s];
+        if (static_cast<std::uint8_t>(source.label) > maxLabel ||
+            static_cast<std::uint64_t>(source.firstRow) + source.rowCount > rows) {
+            outError = "catalog cache source file out of range";
+            return false;
+        }
+        for (std::uint32_t row = source.firstRow; row < source.firstRow + source.rowCount; row++) {
+            if (loaded.m_SourceFile[row] != s) {
+                outError = "catalog cache rows do not match their source file";
+                return false;
+            }
+        }
+    }
+    for (std::size_t row = 0; row < rows; row++) {
+        if (loaded.m_SourceFile[row] >= sourceFiles || loaded.m_Label[row] > maxLabel ||
+            loaded.m_FileDirId[row] >= paths || loaded.m_IndexId[row] >= names ||
+            loaded.m_AlignedId[row] >= names || loaded.m_TemplateId[row] >= names) {
+            outError = "catalog cache id out of range";
+            return false;
+        }
+    }
+
+    loaded.FinalizeLoad();
+    catalog = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,331 @@
+#include "Data/DirectoryScanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+// Publish a partial listing every this many entries.
+constexpr std::size_t kPublishBatch = 256;
+// Worker wake-up interval for notifications when no scan is queued.
+constexpr auto kPollInterval = std::chrono::milliseconds(100);
+#ifndef __linux__
+// Without inotify, directory modification times are compared this often.
+constexpr auto kMtimePollInterval = std::chrono::seconds(2);
+#endif
+
+DirectoryScanner::Entry MakeEntry(const fs::directory_entry& de) {
+    DirectoryScanner::Entry entry;
+    std::error_code ec;
+    entry.name = de.path().filename().string();
+    entry.isDirectory = de.is_directory(ec);
+    if (!entry.isDirectory) {
+        entry.size = de.file_size(ec);
+        if (ec) entry.size = 0;
+    }
+    return entry;
+}
+} // namespace
+
+DirectoryScanner::DirectoryScanner()
+    : m_Stop(false)
+    , m_Scanning(false)
+    , m_Generation(0)
+    , m_ChangeGeneration(0)
+    , m_NotifyFd(-1)
+{
+#ifdef __linux__
+    m_NotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    m_Worker = std::thread(&DirectoryScanner::WorkerLoop, this);
+}
+
+DirectoryScanner::~DirectoryScanner() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Cv.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+#ifdef __linux__
+    if (m_NotifyFd >= 0) close(m_NotifyFd);
+#endif
+}
+
+bool DirectoryScanner::GetListing(const fs::path& dir, std::vector<Entry>& outEntries) {
+    outEntries.clear();
+    const std::string key = dir.string();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Listings.find(key);
+    if (it == m_Listings.end()) {
+        m_Listings.emplace(key, Listing());
+        m_Pending.push_back(key);
+        m_Scanning = true;
+        m_Cv.notify_all();
+        return false;
+    }
+
+    // The map is name-ordered; emit directories first.
+    outEntries.reserve(it->second.entries.size());
+    for (const auto& [name, entry] : it->second.entries) {
+        if (entry.isDirectory) outEntries.push_back(entry);
+    }
+    for (const auto& [name, entry] : it->second.entries) {
+        if (!entry.isDirectory) outEntries.push_back(entry);
+    }
+    return it->second.complete;
+}
+
+void DirectoryScanner::Rescan(const fs::path& dir) {
+    const std::string key = dir.string();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Listings.emplace(key, Listing());
+    if (std::find(m_Pending.begin(), m_Pending.end(), key) == m_Pending.end()) {
+        m_Pending.push_back(key);
+    }
+    m_Scanning = true;
+    m_Cv.notify_all();
+}
+
+void DirectoryScanner::Clear() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+#ifdef __linux__
+    for (const auto& [watch, dir] : m_WatchDirs) inotify_rm_watch(m_NotifyFd, watch);
+#endif
+    m_WatchDirs.clear();
+    m_Listings.clear();
+    m_Pending.clear();
+    m_Generation++;
+}
+
+void DirectoryScanner::Retain(const std::vector<fs::path>& keep) {
+    std::unordered_set<std::string> keepKeys;
+    for (const auto& dir : keep) keepKeys.insert(dir.string());
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto it = m_Listings.begin(); it != m_Listings.end();) {
+        if (keepKeys.count(it->first) > 0) {
+            ++it;
+            continue;
+        }
+#ifdef __linux__
+        if (it->second.watch >= 0) {
+            inotify_rm_watch(m_NotifyFd, it->second.watch);
+            m_WatchDirs.erase(it->second.watch);
+        }
+#endif
+        it = m_Listings.erase(it);
+    }
+    m_Pending.erase(std::remove_if(m_Pending.begin(), m_Pending.end(),
+                                   [&](const std::string& dir) { return keepKeys.count(dir) == 0; }),
+                    m_Pending.end());
+}
+
+void DirectoryScanner::WorkerLoop() {
+#ifndef __linux__
+    auto lastMtimePoll = std::chrono::steady_clock::now();
+#endif
+    while (true) {
+        std::string dir;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Cv.wait_for(lock, kPollInterval, [this]() { return !m_Pending.empty() || m_Stop.load(); });
+            if (m_Stop) break;
+            if (!m_Pending.empty()) {
+                dir = std::move(m_Pending.front());
+                m_Pending.pop_front();
+            } else {
+                m_Scanning = false;
+            }
+        }
+
+        if (!dir.empty()) ScanDirectory(dir);
+
+#ifdef __linux__
+        PollChanges();
+#else
+        if (std::chrono::steady_clock::now() - lastMtimePoll >= kMtimePollInterval) {
+            lastMtimePoll = std::chrono::steady_clock::now();
+            PollChanges();
+        }
+#endif
+    }
+}
+
+void DirectoryScanner::ScanDirectory(const std::string& dir) {
+    std::error_code ec;
+    const fs::file_time_type writeTime = fs::last_write_time(dir, ec);
+
+    // Watch before listing so nothing created during the scan is missed.
+    bool firstScan = true;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Listings.find(dir);
+        if (it == m_Listings.end()) return; // cleared meanwhile
+        firstScan = !it->second.complete;
+        if (firstScan) it->second.entries.clear();
+        it->second.writeTime = writeTime;
+#ifdef __linux__
+        if (it->second.watch < 0 && m_NotifyFd >= 0) {
+            const int watch = inotify_add_watch(m_NotifyFd, dir.c_str(),
+                                                IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE |
+                                                    IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+            if (watch >= 0) {
+                it->second.watch = watch;
+                m_WatchDirs[watch] = dir;
+            }
+        }
+#endif
+    }
+
+    // A first scan is published in batches; a rescan keeps the old listing visible and
+    // swaps the new one in at the end.
+    std::map<std::string, Entry> rescanned;
+    std::vector<Entry> batch;
+    batch.reserve(kPublishBatch);
+    auto publish = [&](bool complete) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Listings.find(dir);
+        if (it == m_Listings.end()) return false;
+        if (firstScan) {
+            for (auto& entry : batch) {
+                std::string name = entry.name;
+                it->second.entries[std::move(name)] = std::move(entry);
+            }
+        } else if (complete) {
+            it->second.entries = std::move(rescanned);
+        }
+        it->second.complete = complete;
+        m_Generation++;
+        return true;
+    };
+
+    fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    if (!ec) {
+        for (const fs::directory_iterator end; it != end; it.increment(ec)) {
+            if (ec || m_Stop) break;
+            Entry entry = MakeEntry(*it);
+            if (!firstScan) {
+                std::string name = entry.name;
+                rescanned[std::move(name)] = std::move(entry);
+                continue;
+            }
+            batch.push_back(std::move(entry));
+            if (batch.size() >= kPublishBatch) {
+                if (!publish(false)) return;
+                batch.clear();
+            }
+        }
+    }
+    publish(true);
+}
+
+void DirectoryScanner::PollChanges() {
+#ifdef __linux__
+    if (m_NotifyFd < 0) return;
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true) {
+        const ssize_t length = read(m_NotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost; re-list everything that is known.
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                for (const auto& [dir, listing] : m_Listings) {
+                    if (std::find(m_Pending.begin(), m_Pending.end(), dir) == m_Pending.end()) m_Pending.push_back(dir);
+                }
+                m_Scanning = true;
+                m_ChangeGeneration++;
+                continue;
+            }
+
+            std::string dir;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                auto it = m_WatchDirs.find(event->wd);
+                if (it == m_WatchDirs.end()) continue;
+                dir = it->second;
+            }
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                DropListing(dir);
+            } else if (event->len > 0) {
+                const bool removed = (event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0;
+                UpdateEntry(dir, event->name, removed);
+            }
+        }
+    }
+#else
+    std::vector<std::pair<std::string, fs::file_time_type>> known;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (const auto& [dir, listing] : m_Listings) {
+            if (listing.complete) known.emplace_back(dir, listing.writeTime);
+        }
+    }
+    for (const auto& [dir, writeTime] : known) {
+        std::error_code ec;
+        const auto current = fs::last_write_time(dir, ec);
+        if (!ec && current == writeTime) continue;
+        if (ec) {
+            DropListing(dir);
+        } else {
+            Rescan(dir);
+        }
+        m_ChangeGeneration++;
+    }
+#endif
+}
+
+void DirectoryScanner::UpdateEntry(const std::string& dir, const std::string& name, bool removed) {
+    const fs::path path = fs::path(dir) / name;
+    Entry entry;
+    if (!removed) {
+        std::error_code ec;
+        const fs::directory_entry de(path, ec);
+        if (ec || !de.exists(ec)) {
+            removed = true;
+        } else {
+            entry = MakeEntry(de);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Listings.find(dir);
+    if (it == m_Listings.end()) return;
+    if (removed) {
+        it->second.entries.erase(name);
+    } else {
+        it->second.entries[name] = std::move(entry);
+    }
+    m_Generation++;
+    if (it->second.complete) m_ChangeGeneration++;
+}
+
+void DirectoryScanner::DropListing(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Listings.find(dir);
+    if (it == m_Listings.end()) return;
+#ifdef __linux__
+    if (it->second.watch >= 0) {
+        inotify_rm_watch(m_NotifyFd, it->second.watch);
+        m_WatchDirs.erase(it->second.watch);
+    }
+#endif
+    m_Listings.erase(it);
+    m_Generation++;
+    m_ChangeGeneration++;
+}
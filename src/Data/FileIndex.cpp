@@ -0,0 +1,410 @@
+#include "Data/FileIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Wait this long between refreshes triggered by lookup misses.
+constexpr auto kMissRefreshInterval = std::chrono::seconds(5);
+
+// '\' -> '/', no trailing separator.
+std::string NormalizeSeparators(const std::string& path) {
+    std::string out = path;
+    std::replace(out.begin(), out.end(), '\\', '/');
+    while (out.size() > 1 && out.back() == '/') out.pop_back();
+    return out;
+}
+
+std::string ToLower(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+std::string Trim(const std::string& s) {
+    const auto begin = s.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return std::string();
+    const auto end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+} // namespace
+
+FileIndex::FileIndex()
+    : m_RootsGeneration(0)
+    , m_ScanRequested(false)
+    , m_ResetRequested(false)
+    , m_StopWorker(false)
+    , m_Ready(false)
+    , m_FileCount(0)
+{
+}
+
+FileIndex::~FileIndex() {
+    {
+        std::lock_guard<std::mutex> lock(m_WorkerMutex);
+        m_StopWorker = true;
+    }
+    m_WorkerCv.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+}
+
+void FileIndex::StartWorker() {
+    // Caller holds m_WorkerMutex.
+    if (!m_Worker.joinable()) {
+        m_Worker = std::thread(&FileIndex::WorkerLoop, this);
+    }
+}
+
+void FileIndex::SetRoots(const std::vector<fs::path>& roots) {
+    std::lock_guard<std::mutex> lock(m_WorkerMutex);
+    m_Roots = roots;
+    m_ResetRequested = true;
+    m_RootsGeneration++;
+    m_Ready = false;
+    m_ScanRequested = true;
+    StartWorker();
+    m_WorkerCv.notify_all();
+}
+
+void FileIndex::AddRoot(const fs::path& root) {
+    std::lock_guard<std::mutex> lock(m_WorkerMutex);
+    if (std::find(m_Roots.begin(), m_Roots.end(), root) != m_Roots.end()) return;
+    m_Roots.push_back(root);
+    m_RootsGeneration++;
+    m_Ready = false;
+    m_ScanRequested = true;
+    StartWorker();
+    m_WorkerCv.notify_all();
+}
+
+void FileIndex::RequestRefresh() {
+    std::lock_guard<std::mutex> lock(m_WorkerMutex);
+    m_ScanRequested = true;
+    StartWorker();
+    m_WorkerCv.notify_all();
+}
+
+bool FileIndex::WaitUntilReady(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_WorkerMutex);
+    m_ReadyCv.wait_for(lock, timeout, [this]() { return m_Ready.load() || m_StopWorker.load(); });
+    return m_Ready.load();
+}
+
+void FileIndex::WorkerLoop() {
+    while (true) {
+        std::vector<fs::path> roots;
+        unsigned int generation = 0;
+        bool reset = false;
+        {
+            std::unique_lock<std::mutex> lock(m_WorkerMutex);
+            m_WorkerCv.wait(lock, [this]() { return m_ScanRequested || m_StopWorker.load(); });
+            if (m_StopWorker) break;
+            m_ScanRequested = false;
+            reset = m_ResetRequested;
+            m_ResetRequested = false;
+            roots = m_Roots;
+            generation = m_RootsGeneration;
+        }
+
+        if (reset) {
+            std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+            m_Directories.clear();
+            m_FilesByName.clear();
+            m_FileCount = 0;
+        }
+
+        const auto startTime = std::chrono::steady_clock::now();
+        ScanPass(roots);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        {
+            std::lock_guard<std::mutex> lock(m_WorkerMutex);
+            // Roots added while scanning are picked up by the next pass.
+            if (generation == m_RootsGeneration && !m_StopWorker) {
+                if (!m_Ready) {
+                    std::cout << "File index: " << GetFileCount() << " files in " << GetDirectoryCount()
+                              << " directories (" << seconds << " s)" << std::endl;
+                }
+                m_Ready = true;
+            }
+        }
+        m_ReadyCv.notify_all();
+    }
+    m_ReadyCv.notify_all();
+}
+
+void FileIndex::ScanPass(const std::vector<fs::path>& roots) {
+    // Re-list directories that changed since the last pass, then cover new roots.
+    RefreshKnownDirectories();
+
+    for (int i = 0; i < static_cast<int>(roots.size()); i++) {
+        if (m_StopWorker) return;
+        fs::path root;
+        try {
+            if (!fs::is_directory(roots[i])) continue;
+            root = fs::weakly_canonical(roots[i]);
+        } catch (...) {
+            continue;
+        }
+        ScanDirectoryTree(root, i);
+    }
+}
+
+void FileIndex::RefreshKnownDirectories() {
+    std::vector<std::pair<fs::path, fs::file_time_type>> known;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+        known.reserve(m_Directories.size());
+        for (const auto& [dir, state] : m_Directories) known.emplace_back(dir, state.writeTime);
+    }
+
+    for (const auto& [dir, writeTime] : known) {
+        if (m_StopWorker) return;
+
+        std::error_code ec;
+        const auto currentTime = fs::last_write_time(dir, ec);
+        if (ec) {
+            RemoveDirectoryTree(dir);
+            continue;
+        }
+        if (currentTime == writeTime) continue;
+
+        DirectoryState updated;
+        {
+            std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+            auto it = m_Directories.find(dir);
+            if (it == m_Directories.end()) continue; // removed with a parent
+            updated.rootIndex = it->second.rootIndex;
+        }
+        if (!ListDirectory(dir, updated.rootIndex, updated)) {
+            RemoveDirectoryTree(dir);
+            continue;
+        }
+
+        const int rootIndex = updated.rootIndex;
+        std::vector<fs::path> removedSubdirs;
+        std::vector<fs::path> addedSubdirs;
+        {
+            std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+            auto it = m_Directories.find(dir);
+            if (it == m_Directories.end()) continue;
+            for (const auto& sub : it->second.subdirectories) {
+                if (std::find(updated.subdirectories.begin(), updated.subdirectories.end(), sub) == updated.subdirectories.end()) {
+                    removedSubdirs.push_back(sub);
+                }
+            }
+            for (const auto& sub : updated.subdirectories) {
+                if (m_Directories.find(sub) == m_Directories.end()) addedSubdirs.push_back(sub);
+            }
+            UnindexDirectory(dir, it->second);
+            IndexDirectory(dir, updated);
+            it->second = std::move(updated);
+        }
+
+        for (const auto& sub : removedSubdirs) RemoveDirectoryTree(sub);
+        for (const auto& sub : addedSubdirs) ScanDirectoryTree(sub, rootIndex);
+    }
+}
+
+bool FileIndex::ListDirectory(const fs::path& dir, int rootIndex, DirectoryState& outState) const {
+    outState = DirectoryState();
+    outState.rootIndex = rootIndex;
+
+    std::error_code ec;
+    outState.writeTime = fs::last_write_time(dir, ec);
+    if (ec) return false;
+
+    fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    if (ec) return false;
+    for (const fs::directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) break;
+        const fs::directory_entry& entry = *it;
+        std::error_code entryEc;
+        // Do not follow directory symlinks, like recursive_directory_iterator by default.
+        if (entry.is_directory(entryEc) && !entry.is_symlink(entryEc)) {
+            outState.subdirectories.push_back(entry.path());
+        } else if (entry.is_regular_file(entryEc)) {
+            outState.files.push_back(entry.path().filename().string());
+        }
+    }
+    return true;
+}
+
+void FileIndex::ScanDirectoryTree(const fs::path& dir, int rootIndex) {
+    std::vector<fs::path> pending{dir};
+    while (!pending.empty()) {
+        if (m_StopWorker) return;
+
+        const fs::path current = std::move(pending.back());
+        pending.pop_back();
+
+        {
+            // Already covered (overlapping roots, or an earlier root with higher priority).
+            std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+            if (m_Directories.find(current) != m_Directories.end()) continue;
+        }
+
+        DirectoryState state;
+        if (!ListDirectory(current, rootIndex, state)) continue;
+        pending.insert(pending.end(), state.subdirectories.begin(), state.subdirectories.end());
+
+        std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+        if (m_Directories.find(current) != m_Directories.end()) continue;
+        IndexDirectory(current, state);
+        m_Directories.emplace(current, std::move(state));
+    }
+}
+
+void FileIndex::RemoveDirectoryTree(const fs::path& dir) {
+    std::unique_lock<std::shared_mutex> lock(m_IndexMutex);
+    std::vector<fs::path> pending{dir};
+    while (!pending.empty()) {
+        const fs::path current = std::move(pending.back());
+        pending.pop_back();
+        auto it = m_Directories.find(current);
+        if (it == m_Directories.end()) continue;
+        pending.insert(pending.end(), it->second.subdirectories.begin(), it->second.subdirectories.end());
+        UnindexDirectory(current, it->second);
+        m_Directories.erase(it);
+    }
+}
+
+void FileIndex::IndexDirectory(const fs::path& dir, const DirectoryState& state) {
+    // Caller holds m_IndexMutex exclusively.
+    for (const auto& name : state.files) {
+        auto& entries = m_FilesByName[name];
+        IndexedFile file{dir / name, state.rootIndex};
+        // Keep the highest-priority root first so Find() is a single probe.
+        auto pos = std::find_if(entries.begin(), entries.end(),
+                                [&](const IndexedFile& e) { return e.rootIndex > file.rootIndex; });
+        entries.insert(pos, std::move(file));
+        m_FileCount++;
+    }
+}
+
+void FileIndex::UnindexDirectory(const fs::path& dir, const DirectoryState& state) {
+    // Caller holds m_IndexMutex exclusively.
+    for (const auto& name : state.files) {
+        auto it = m_FilesByName.find(name);
+        if (it == m_FilesByName.end()) continue;
+        const fs::path full = dir / name;
+        auto& entries = it->second;
+        auto pos = std::find_if(entries.begin(), entries.end(), [&](const IndexedFile& e) { return e.path == full; });
+        if (pos != entries.end()) {
+            entries.erase(pos);
+            m_FileCount--;
+        }
+        if (entries.empty()) m_FilesByName.erase(it);
+    }
+}
+
+bool FileIndex::Find(const std::string& filename, fs::path& outPath) {
+    if (filename.empty()) return false;
+
+    auto probe = [&]() {
+        std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+        auto it = m_FilesByName.find(filename);
+        if (it == m_FilesByName.end() || it->second.empty()) return false;
+        outPath = it->second.front().path;
+        return true;
+    };
+
+    if (probe()) return true;
+    if (!IsReady()) return false; // the first build will pick it up
+
+    {
+        std::lock_guard<std::mutex> lock(m_WorkerMutex);
+        const auto now = std::chrono::steady_clock::now();
+        if (now - m_LastMissRefresh < kMissRefreshInterval) return false;
+        m_LastMissRefresh = now;
+        m_ScanRequested = true;
+        StartWorker();
+    }
+    m_WorkerCv.notify_all();
+    return false;
+}
+
+std::size_t FileIndex::GetFileCount() const {
+    std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+    return m_FileCount;
+}
+
+std::size_t FileIndex::GetDirectoryCount() const {
+    std::shared_lock<std::shared_mutex> lock(m_IndexMutex);
+    return m_Directories.size();
+}
+
+void FileIndex::AddPrefixRemap(const std::string& from, const std::string& to) {
+    const std::string normalizedFrom = ToLower(NormalizeSeparators(Trim(from)));
+    const std::string trimmedTo = Trim(to);
+    if (normalizedFrom.empty() || trimmedTo.empty()) return;
+
+    std::lock_guard<std::mutex> lock(m_RemapMutex);
+    m_PrefixRemaps.emplace_back(normalizedFrom, trimmedTo);
+    // Longest prefix first, so more specific rules win.
+    std::stable_sort(m_PrefixRemaps.begin(), m_PrefixRemaps.end(),
+                     [](const auto& a, const auto& b) { return a.first.size() > b.first.size(); });
+}
+
+void FileIndex::ClearPrefixRemaps() {
+    std::lock_guard<std::mutex> lock(m_RemapMutex);
+    m_PrefixRemaps.clear();
+}
+
+bool FileIndex::LoadPrefixRemapFile(const fs::path& file) {
+    std::ifstream in(file);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        const std::string trimmed = Trim(line);
+        if (trimmed.empty() || trimmed[0] == '#') continue;
+        const auto eq = trimmed.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Ignoring path remap rule without '=' at " << file << ":" << lineNumber << std::endl;
+            continue;
+        }
+        AddPrefixRemap(trimmed.substr(0, eq), trimmed.substr(eq + 1));
+    }
+    return true;
+}
+
+void FileIndex::AddPrefixRemapList(const std::string& rules) {
+    std::size_t start = 0;
+    while (start <= rules.size()) {
+        const auto end = rules.find(';', start);
+        const std::string rule = rules.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        const auto eq = rule.find('=');
+        if (eq != std::string::npos) AddPrefixRemap(rule.substr(0, eq), rule.substr(eq + 1));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+}
+
+bool FileIndex::ApplyPrefixRemap(const std::string& path, fs::path& outPath) const {
+    const std::string normalized = NormalizeSeparators(path);
+    const std::string lowered = ToLower(normalized);
+
+    std::lock_guard<std::mutex> lock(m_RemapMutex);
+    for (const auto& [from, to] : m_PrefixRemaps) {
+        if (lowered.compare(0, from.size(), from) != 0) continue;
+        // Match whole components only: "E:/fix_data" must not match "E:/fix_data2".
+        if (lowered.size() > from.size() && lowered[from.size()] != '/' && from.back() != '/') continue;
+
+        std::string rest = normalized.substr(from.size());
+        while (!rest.empty() && rest.front() == '/') rest.erase(rest.begin());
+        outPath = rest.empty() ? fs::path(to) : fs::path(to) / fs::path(rest);
+        return true;
+    }
+    return false;
+}
+
+std::string FileIndex::FilenameOf(const std::string& path) {
+    const auto pos = path.find_last_of("/\\");
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
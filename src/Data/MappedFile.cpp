@@ -0,0 +1,128 @@
+#include "Data/MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : m_Data(nullptr)
+    , m_Size(0)
+    , m_Open(false)
+#ifdef _WIN32
+    , m_FileHandle(nullptr)
+    , m_MappingHandle(nullptr)
+#else
+    , m_Fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::filesystem::path& path, std::string& outError) {
+    Close();
+
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        outError = "无法打开文件";
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        outError = "无法获取文件大小";
+        return false;
+    }
+
+    m_FileHandle = file;
+    m_Size = static_cast<std::size_t>(size.QuadPart);
+    m_Open = true;
+    if (m_Size == 0) return true; // empty files cannot be mapped
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        Close();
+        outError = "无法映射文件";
+        return false;
+    }
+    m_MappingHandle = mapping;
+
+    m_Data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_Data) {
+        Close();
+        outError = "无法映射文件";
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_Data) UnmapViewOfFile(m_Data);
+    if (m_MappingHandle) CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+    if (m_FileHandle) CloseHandle(static_cast<HANDLE>(m_FileHandle));
+    m_Data = nullptr;
+    m_MappingHandle = nullptr;
+    m_FileHandle = nullptr;
+    m_Size = 0;
+    m_Open = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& path, std::string& outError) {
+    Close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        outError = "无法打开文件";
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        outError = "无法获取文件大小";
+        return false;
+    }
+
+    m_Fd = fd;
+    m_Size = static_cast<std::size_t>(st.st_size);
+    m_Open = true;
+    if (m_Size == 0) return true; // empty files cannot be mapped
+
+    void* data = ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        Close();
+        outError = "无法映射文件";
+        return false;
+    }
+    // Parsers walk the file front to back.
+    ::madvise(data, m_Size, MADV_SEQUENTIAL);
+    m_Data = static_cast<const char*>(data);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_Data) ::munmap(const_cast<char*>(m_Data), m_Size);
+    if (m_Fd >= 0) ::close(m_Fd);
+    m_Data = nullptr;
+    m_Fd = -1;
+    m_Size = 0;
+    m_Open = false;
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "Data/SkyIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr std::uint32_t kLeafSize = 16;
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr double kRadToArcsec = 180.0 / kPi * 3600.0;
+// Node bounds are floats; pad the pruning tests by more than their rounding error.
+constexpr double kBoundsEpsilon = 1e-6;
+
+void ToUnitVector(double raDeg, double decDeg, double out[3]) {
+    const double ra = raDeg * kDegToRad;
+    const double dec = decDeg * kDegToRad;
+    out[0] = std::cos(dec) * std::cos(ra);
+    out[1] = std::cos(dec) * std::sin(ra);
+    out[2] = std::sin(dec);
+}
+
+double NormalizeRa(double raDeg) {
+    double ra = std::fmod(raDeg, 360.0);
+    if (ra < 0.0) ra += 360.0;
+    return ra;
+}
+} // namespace
+
+SkyIndex::SkyIndex() = default;
+
+void SkyIndex::Clear() {
+    m_Points.clear();
+    m_Nodes.clear();
+}
+
+void SkyIndex::Build(const std::vector<Entry>& entries) {
+    Clear();
+    m_Points.reserve(entries.size());
+    for (const Entry& e : entries) {
+        Point p;
+        ToUnitVector(e.ra, e.dec, p.v);
+        p.ra = NormalizeRa(e.ra);
+        p.dec = e.dec;
+        p.id = e.id;
+        m_Points.push_back(p);
+    }
+    if (m_Points.empty()) return;
+
+    m_Nodes.reserve(2 * (m_Points.size() / kLeafSize + 1));
+    BuildNode(0, static_cast<std::uint32_t>(m_Points.size()));
+}
+
+std::uint32_t SkyIndex::BuildNode(std::uint32_t begin, std::uint32_t end) {
+    Node node;
+    for (int axis = 0; axis < 3; axis++) {
+        double lo = m_Points[begin].v[axis];
+        double hi = lo;
+        for (std::uint32_t i = begin + 1; i < end; i++) {
+            lo = std::min(lo, m_Points[i].v[axis]);
+            hi = std::max(hi, m_Points[i].v[axis]);
+        }
+        node.boundsMin[axis] = static_cast<float>(lo);
+        node.boundsMax[axis] = static_cast<float>(hi);
+    }
+    node.begin = begin;
+    node.end = end;
+    node.left = 0;
+    node.right = 0;
+
+    const std::uint32_t index = static_cast<std::uint32_t>(m_Nodes.size());
+    m_Nodes.push_back(node);
+    if (end - begin <= kLeafSize) return index;
+
+    // Split at the median of the widest axis.
+    int axis = 0;
+    float widest = -1.0f;
+    for (int a = 0; a < 3; a++) {
+        const float extent = node.boundsMax[a] - node.boundsMin[a];
+        if (extent > widest) {
+            widest = extent;
+            axis = a;
+        }
+    }
+    const std::uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(m_Points.begin() + begin, m_Points.begin() + mid, m_Points.begin() + end,
+                     [axis](const Point& a, const Point& b) { return a.v[axis] < b.v[axis]; });
+
+    const std::uint32_t left = BuildNode(begin, mid);
+    const std::uint32_t right = BuildNode(mid, end);
+    m_Nodes[index].left = left;
+    m_Nodes[index].right = right;
+    return index;
+}
+
+void SkyIndex::QueryCone(double raDeg, double decDeg, double radiusArcsec, std::vector<Match>& outMatches) const {
+    outMatches.clear();
+    if (m_Nodes.empty() || radiusArcsec < 0.0) return;
+
+    double q[3];
+    ToUnitVector(raDeg, decDeg, q);
+    const double radius = std::min(radiusArcsec / kRadToArcsec, kPi);
+    const double chord = 2.0 * std::sin(radius * 0.5);
+    const double chord2 = chord * chord;
+    const double pruneChord = chord + kBoundsEpsilon;
+    const double prune2 = pruneChord * pruneChord;
+
+    std::uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_Nodes[stack[--top]];
+
+        double d2 = 0.0;
+        for (int a = 0; a < 3; a++) {
+            const double below = node.boundsMin[a] - q[a];
+            const double above = q[a] - node.boundsMax[a];
+            const double d = std::max(0.0, std::max(below, above));
+            d2 += d * d;
+        }
+        if (d2 > prune2) continue;
+
+        if (node.left == 0) {
+            for (std::uint32_t i = node.begin; i < node.end; i++) {
+                const Point& p = m_Points[i];
+                const double dx = p.v[0] - q[0];
+                const double dy = p.v[1] - q[1];
+                const double dz = p.v[2] - q[2];
+                const double pd2 = dx * dx + dy * dy + dz * dz;
+                if (pd2 <= chord2) {
+                    const double separation = 2.0 * std::asin(std::min(1.0, std::sqrt(pd2) * 0.5));
+                    outMatches.push_back(Match{p.id, separation * kRadToArcsec});
+                }
+            }
+        } else {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+
+    std::sort(outMatches.begin(), outMatches.end(),
+              [](const Match& a, const Match& b) { return a.separationArcsec < b.separationArcsec; });
+}
+
+void SkyIndex::QueryBox(double raMinDeg, double raMaxDeg, double decMinDeg, double decMaxDeg,
+                        std::vector<std::uint32_t>& outIds) const {
+    outIds.clear();
+    if (m_Nodes.empty() || decMinDeg > decMaxDeg) return;
+
+    if (raMaxDeg - raMinDeg >= 360.0) {
+        QueryBoxRange(0.0, 360.0, decMinDeg, decMaxDeg, outIds);
+        return;
+    }
+
+    // Split into RA ranges of at most 180 degrees so each is an intersection of two half-spaces.
+    const double lo = NormalizeRa(raMinDeg);
+    const double hi = NormalizeRa(raMaxDeg);
+    std::vector<std::pair<double, double>> ranges;
+    if (lo <= hi) {
+        ranges.emplace_back(lo, hi);
+    } else {
+        ranges.emplace_back(lo, 360.0);
+        ranges.emplace_back(0.0, hi);
+    }
+
+    for (const auto& [a, b] : ranges) {
+        if (b - a > 180.0) {
+            const double m = 0.5 * (a + b);
+            QueryBoxRange(a, m, decMinDeg, decMaxDeg, outIds);
+            QueryBoxRange(m, b, decMinDeg, decMaxDeg, outIds);
+        } else {
+            QueryBoxRange(a, b, decMinDeg, decMaxDeg, outIds);
+        }
+    }
+
+    // Split ranges share their edges.
+    if (ranges.size() > 1 || ranges[0].second - ranges[0].first > 180.0) {
+        std::sort(outIds.begin(), outIds.end());
+        outIds.erase(std::unique(outIds.begin(), outIds.end()), outIds.end());
+    }
+}
+
+void SkyIndex::QueryBoxRange(double raMinDeg, double raMaxDeg, double decMinDeg, double decMaxDeg,
+                             std::vector<std::uint32_t>& outIds) const {
+    const double zMin = std::sin(std::max(decMinDeg, -90.0) * kDegToRad);
+    const double zMax = std::sin(std::min(decMaxDeg, 90.0) * kDegToRad);
+
+    // Inside the RA range: nMin . p >= 0 and nMax . p <= 0 (valid for widths up to 180).
+    const bool fullCircle = (raMaxDeg - raMinDeg) >= 360.0;
+    const double nMin[2] = {-std::sin(raMinDeg * kDegToRad), std::cos(raMinDeg * kDegToRad)};
+    const double nMax[2] = {-std::sin(raMaxDeg * kDegToRad), std::cos(raMaxDeg * kDegToRad)};
+
+    std::uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_Nodes[stack[--top]];
+
+        if (node.boundsMax[2] < zMin - kBoundsEpsilon || node.boundsMin[2] > zMax + kBoundsEpsilon) continue;
+        if (!fullCircle) {
+            // Largest nMin . p and smallest nMax . p over the node box.
+            double maxDotMin = 0.0;
+            double minDotMax = 0.0;
+            for (int a = 0; a < 2; a++) {
+                maxDotMin += nMin[a] * (nMin[a] > 0.0 ? node.boundsMax[a] : node.boundsMin[a]);
+                minDotMax += nMax[a] * (nMax[a] > 0.0 ? node.boundsMin[a] : node.boundsMax[a]);
+            }
+            if (maxDotMin < -kBoundsEpsilon || minDotMax > kBoundsEpsilon) continue;
+        }
+
+        if (node.left == 0) {
+            for (std::uint32_t i = node.begin; i < node.end; i++) {
+                const Point& p = m_Points[i];
+                if (p.dec < decMinDeg || p.dec > decMaxDeg) continue;
+                if (!fullCircle && (p.ra < raMinDeg || p.ra > raMaxDeg)) continue;
+                outIds.push_back(p.id);
+            }
+        } else {
+            stack[top++] = node.left;
+            stack[top++] = node.right;
+        }
+    }
+}
+
+double SkyIndex::SeparationArcsec(double ra1Deg, double dec1Deg, double ra2Deg, double dec2Deg) {
+    const double dec1 = dec1Deg * kDegToRad;
+    const double dec2 = dec2Deg * kDegToRad;
+    const double sinDDec = std::sin((dec2 - dec1) * 0.5);
+    const double sinDRa = std::sin((ra2Deg - ra1Deg) * kDegToRad * 0.5);
+    const double h = sinDDec * sinDDec + std::cos(dec1) * std::cos(dec2) * sinDRa * sinDRa;
+    return 2.0 * std::asin(std::min(1.0, std::sqrt(h))) * kRadToArcsec;
+}
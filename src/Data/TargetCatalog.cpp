@@ -0,0 +1,462 @@
+#include "Data/TargetCatalog.h"
+#include "Data/MappedFile.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Files mapped and parsed at once; bounds open descriptors on very large trees.
+constexpr std::size_t kLoadBatchFiles = 256;
+
+std::string ToUpper(std::string s) {
+    for (char& c : s) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// One parsed txt; row views point into the mapping.
+struct ParsedFile {
+    MappedFile mapping;
+    std::vector<TxtTargetRowView> rows;
+    TxtParseReport report;
+    bool ok{false};
+};
+} // namespace
+
+TargetCatalog::TargetCatalog() = default;
+
+void TargetCatalog::Clear() {
+    m_Root.clear();
+    m_Directories.clear();
+    m_DirectoryLookup.clear();
+    m_SourceFileLookup.clear();
+    m_SourceFiles.clear();
+    m_Paths.Clear();
+    m_Names.Clear();
+    m_SourceFile.clear();
+    m_Label.clear();
+    m_Flags.clear();
+    m_IndexId.clear();
+    m_FileDirId.clear();
+    m_AlignedId.clear();
+    m_TemplateId.clear();
+    m_PixelX.clear();
+    m_PixelY.clear();
+    m_Ra.clear();
+    m_Dec.clear();
+    m_Epoch.clear();
+    m_SkyIndex.Clear();
+}
+
+const char* TargetCatalog::GetLabelName(Label label) {
+    switch (label) {
+        case Label::Good: return "GOOD";
+        case Label::Bad: return "BAD";
+        default: return "?";
+    }
+}
+
+TargetCatalog::Label TargetCatalog::DetectLabel(const std::string& headerLabel, const fs::path& txtPath) {
+    const std::string upper = ToUpper(headerLabel);
+    if (upper == "GOOD") return Label::Good;
+    if (upper == "BAD") return Label::Bad;
+
+    const std::string name = ToUpper(txtPath.filename().string());
+    if (name.rfind("GOOD", 0) == 0) return Label::Good;
+    if (name.rfind("BAD", 0) == 0) return Label::Bad;
+    return Label::Unknown;
+}
+
+std::uint64_t TargetCatalog::ParseEpoch(std::string_view time) {
+    // YYYYMMDD_hhmmss (separator optional).
+    std::uint64_t value = 0;
+    int digits = 0;
+    for (char c : time) {
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + static_cast<std::uint64_t>(c - '0');
+            digits++;
+        } else if (c != '_' && c != '-' && c != 'T') {
+            return 0;
+        }
+    }
+    if (digits == 8) return value * 1000000ull;
+    return digits == 14 ? value : 0;
+}
+
+bool TargetCatalog::LoadFromRoot(const fs::path& root, std::string& outError) {
+    return UpdateFromRoot(root, nullptr, outError);
+}
+
+bool TargetCatalog::UpdateFromRoot(const fs::path& root, const TargetCatalog* previous,
+                                   std::string& outError, UpdateStats* outStats) {
+    Clear();
+    outError.clear();
+    UpdateStats stats;
+
+    std::error_code ec;
+    m_Root = fs::absolute(root, ec);
+    if (ec) m_Root = root;
+
+    // Walk once: directory listings for the browser tree, and the txt files with size/mtime.
+    struct TxtFile {
+        fs::path path;
+        std::uintmax_t size;
+        fs::file_time_type writeTime;
+    };
+    std::vector<TxtFile> txtFiles;
+    std::vector<fs::path> pending{m_Root};
+    while (!pending.empty()) {
+        const fs::path dir = std::move(pending.back());
+        pending.pop_back();
+
+        DirectoryListing listing;
+        listing.relativePath = RelativeKey(dir);
+        fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+        if (ec) {
+            if (dir == m_Root) {
+                outError = ec.message();
+                return false;
+            }
+            continue;
+        }
+        for (const fs::directory_iterator end; it != end; it.increment(ec)) {
+            if (ec) break;
+            std::error_code entryEc;
+            DirectoryEntry entry;
+            entry.name = it->path().filename().string();
+            entry.isDirectory = it->is_directory(entryEc);
+            if (entry.isDirectory) {
+                if (!it->is_symlink(entryEc)) pending.push_back(it->path());
+            } else {
+                entry.size = it->file_size(entryEc);
+                if (it->path().extension() == ".txt" && it->is_regular_file(entryEc)) {
+                    txtFiles.push_back(TxtFile{it->path(), entry.size, it->last_write_time(entryEc)});
+                }
+            }
+            listing.entries.push_back(std::move(entry));
+        }
+        std::sort(listing.entries.begin(), listing.entries.end(), [](const DirectoryEntry& a, const DirectoryEntry& b) {
+            if (a.isDirectory != b.isDirectory) return a.isDirectory > b.isDirectory;
+            return a.name < b.name;
+        });
+        m_Directories.push_back(std::move(listing));
+    }
+    std::sort(txtFiles.begin(), txtFiles.end(), [](const TxtFile& a, const TxtFile& b) { return a.path < b.path; });
+
+    // Unchanged files (same size and mtime) are copied from the previous catalog.
+    std::vector<int> reuse(txtFiles.size(), -1);
+    if (previous) {
+        std::size_t reusedRows = 0;
+        for (std::size_t i = 0; i < txtFiles.size(); i++) {
+            auto it = previous->m_SourceFileLookup.find(RelativeKey(txtFiles[i].path));
+            if (it == previous->m_SourceFileLookup.end()) continue;
+            const SourceFile& old = previous->m_SourceFiles[it->second];
+            if (old.size == txtFiles[i].size && old.writeTime == txtFiles[i].writeTime) {
+                reuse[i] = static_cast<int>(it->second);
+                reusedRows += old.rowCount;
+            }
+        }
+        ReserveRows(reusedRows);
+    }
+
+    for (std::size_t batchStart = 0; batchStart < txtFiles.size(); batchStart += kLoadBatchFiles) {
+        const std::size_t batchSize = std::min(kLoadBatchFiles, txtFiles.size() - batchStart);
+
+        // Map and parse in parallel; interning below is serial.
+        std::vector<ParsedFile> parsed(batchSize);
+        ParallelForEach(batchSize, [&](std::size_t i) {
+            if (reuse[batchStart + i] >= 0) return;
+            ParsedFile& file = parsed[i];
+            std::string err;
+            if (!file.mapping.Open(txtFiles[batchStart + i].path, err)) return;
+            file.ok = ParseTxtTargetRows(file.mapping.GetView(), file.rows, err, &file.report);
+        });
+
+        for (std::size_t i = 0; i < batchSize; i++) {
+            const TxtFile& txt = txtFiles[batchStart + i];
+            const int previousIndex = reuse[batchStart + i];
+            ParsedFile& file = parsed[i];
+            if (previousIndex < 0 && !file.ok) continue;
+
+            SourceFile source;
+            source.path = txt.path;
+            source.relativePath = RelativeKey(txt.path);
+            source.size = txt.size;
+            source.writeTime = txt.writeTime;
+            source.label = (previousIndex >= 0) ? previous->m_SourceFiles[previousIndex].label
+                                                : DetectLabel(file.report.label, txt.path);
+
+            const std::uint32_t sourceIndex = static_cast<std::uint32_t>(m_SourceFiles.size());
+            m_SourceFiles.push_back(std::move(source));
+            if (previousIndex >= 0) {
+                CopyFileRows(*previous, static_cast<std::uint32_t>(previousIndex), sourceIndex);
+                stats.reusedFiles++;
+            } else {
+                AppendFileRows(sourceIndex, m_SourceFiles.back().label, file.rows);
+                stats.parsedFiles++;
+            }
+        }
+    }
+
+    if (previous) {
+        stats.removedFiles = previous->m_SourceFiles.size() - stats.reusedFiles;
+    }
+    if (outStats) *outStats = stats;
+
+    FinalizeLoad();
+
+    std::cout << "Catalog: " << GetRowCount() << " targets from " << m_SourceFiles.size() << " txt files ("
+              << stats.parsedFiles << " parsed, " << stats.reusedFiles << " unchanged), "
+              << m_Paths.Size() << " distinct dirs, " << m_Names.Size() << " distinct names, "
+              << GetMemoryBytes() / 1024 << " KB" << std::endl;
+    return true;
+}
+
+void TargetCatalog::ReserveRows(std::size_t rowCount) {
+    const std::size_t newSize = m_SourceFile.size() + rowCount;
+    m_SourceFile.reserve(newSize);
+    m_Label.reserve(newSize);
+    m_Flags.reserve(newSize);
+    m_IndexId.reserve(newSize);
+    m_FileDirId.reserve(newSize);
+    m_AlignedId.reserve(newSize);
+    m_TemplateId.reserve(newSize);
+    m_PixelX.reserve(newSize);
+    m_PixelY.reserve(newSize);
+    m_Ra.reserve(newSize);
+    m_Dec.reserve(newSize);
+    m_Epoch.reserve(newSize);
+}
+
+void TargetCatalog::CopyFileRows(const TargetCatalog& previous, std::uint32_t previousSourceFile,
+                                 std::uint32_t sourceFile) {
+    const SourceFile& old = previous.m_SourceFiles[previousSourceFile];
+    SourceFile& source = m_SourceFiles[sourceFile];
+    source.firstRow = static_cast<std::uint32_t>(m_SourceFile.size());
+    source.rowCount = old.rowCount;
+
+    // Ids differ between catalogs; re-intern, reusing the last mapping for repeated ids.
+    std::uint32_t lastOldDir = StringPool::kInvalidId;
+    std::uint32_t lastNewDir = StringPool::kInvalidId;
+    auto mapName = [&](std::uint32_t oldId) { return m_Names.Intern(previous.m_Names.Get(oldId)); };
+
+    for (std::uint32_t r = old.firstRow; r < old.firstRow + old.rowCount; r++) {
+        if (previous.m_FileDirId[r] != lastOldDir) {
+            lastOldDir = previous.m_FileDirId[r];
+            lastNewDir = m_Paths.Intern(previous.m_Paths.Get(lastOldDir));
+        }
+        m_SourceFile.push_back(sourceFile);
+        m_Label.push_back(previous.m_Label[r]);
+        m_Flags.push_back(previous.m_Flags[r]);
+        m_IndexId.push_back(mapName(previous.m_IndexId[r]));
+        m_FileDirId.push_back(lastNewDir);
+        m_AlignedId.push_back(mapName(previous.m_AlignedId[r]));
+        m_TemplateId.push_back(mapName(previous.m_TemplateId[r]));
+        m_PixelX.push_back(previous.m_PixelX[r]);
+        m_PixelY.push_back(previous.m_PixelY[r]);
+        m_Ra.push_back(previous.m_Ra[r]);
+        m_Dec.push_back(previous.m_Dec[r]);
+        m_Epoch.push_back(previous.m_Epoch[r]);
+    }
+}
+
+void TargetCatalog::AppendFileRows(std::uint32_t sourceFile, Label label, const std::vector<TxtTargetRowView>& rows) {
+    SourceFile& source = m_SourceFiles[sourceFile];
+    source.firstRow = static_cast<std::uint32_t>(m_SourceFile.size());
+    source.rowCount = static_cast<std::uint32_t>(rows.size());
+
+    ReserveRows(rows.size());
+
+    // Consecutive rows usually share the directory and FITS pair; skip the hash lookups then.
+    std::string_view lastDir;
+    std::string_view lastAligned;
+    std::string_view lastTemplate;
+    std::uint32_t lastDirId = StringPool::kInvalidId;
+    std::uint32_t lastAlignedId = StringPool::kInvalidId;
+    std::uint32_t lastTemplateId = StringPool::kInvalidId;
+
+    for (const TxtTargetRowView& row : rows) {
+        if (lastDirId == StringPool::kInvalidId || row.fileDir != lastDir) {
+            lastDir = row.fileDir;
+            lastDirId = m_Paths.Intern(row.fileDir);
+        }
+        if (lastAlignedId == StringPool::kInvalidId || row.alignedFilename != lastAligned) {
+            lastAligned = row.alignedFilename;
+            lastAlignedId = m_Names.Intern(row.alignedFilename);
+        }
+        if (lastTemplateId == StringPool::kInvalidId || row.templateAlignedFilename != lastTemplate) {
+            lastTemplate = row.templateAlignedFilename;
+            lastTemplateId = m_Names.Intern(row.templateAlignedFilename);
+        }
+
+        std::uint8_t flags = 0;
+        if (row.hasPixelCenter) flags |= kHasPixelCenter;
+        if (row.hasRaDec) flags |= kHasRaDec;
+
+        m_SourceFile.push_back(sourceFile);
+        m_Label.push_back(static_cast<std::uint8_t>(label));
+        m_Flags.push_back(flags);
+        m_IndexId.push_back(m_Names.Intern(row.index));
+        m_FileDirId.push_back(lastDirId);
+        m_AlignedId.push_back(lastAlignedId);
+        m_TemplateId.push_back(lastTemplateId);
+        m_PixelX.push_back(row.pixelX);
+        m_PixelY.push_back(row.pixelY);
+        m_Ra.push_back(row.ra);
+        m_Dec.push_back(row.dec);
+        m_Epoch.push_back(ParseEpoch(row.time));
+    }
+}
+
+void TargetCatalog::FinalizeLoad() {
+    m_DirectoryLookup.clear();
+    for (std::size_t i = 0; i < m_Directories.size(); i++) {
+        m_DirectoryLookup.emplace(m_Directories[i].relativePath, static_cast<std::uint32_t>(i));
+    }
+    m_SourceFileLookup.clear();
+    for (std::size_t i = 0; i < m_SourceFiles.size(); i++) {
+        m_SourceFileLookup.emplace(m_SourceFiles[i].relativePath, static_cast<std::uint32_t>(i));
+    }
+
+    std::vector<SkyIndex::Entry> entries;
+    entries.reserve(GetRowCount());
+    for (std::size_t row = 0; row < GetRowCount(); row++) {
+        if (m_Flags[row] & kHasRaDec) {
+            entries.push_back(SkyIndex::Entry{m_Ra[row], m_Dec[row], static_cast<std::uint32_t>(row)});
+        }
+    }
+    m_SkyIndex.Build(entries);
+}
+
+std::string TargetCatalog::RelativeKey(const fs::path& path) const {
+    const fs::path relative = path.lexically_relative(m_Root);
+    const std::string key = relative.generic_string();
+    return (key == ".") ? std::string() : key;
+}
+
+const TargetCatalog::DirectoryListing* TargetCatalog::FindDirectory(const fs::path& dir) const {
+    auto it = m_DirectoryLookup.find(RelativeKey(dir));
+    return it != m_DirectoryLookup.end() ? &m_Directories[it->second] : nullptr;
+}
+
+int TargetCatalog::FindSourceFile(const fs::path& path) const {
+    auto it = m_SourceFileLookup.find(RelativeKey(path));
+    return it != m_SourceFileLookup.end() ? static_cast<int>(it->second) : -1;
+}
+
+std::uint32_t TargetCatalog::GetRowInSourceFile(std::size_t row) const {
+    return static_cast<std::uint32_t>(row) - m_SourceFiles[m_SourceFile[row]].firstRow;
+}
+
+std::size_t TargetCatalog::GetMemoryBytes() const {
+    const std::size_t perRow = sizeof(std::uint32_t) * 5 + sizeof(std::uint8_t) * 2 + sizeof(std::int32_t) * 2 +
+                               sizeof(double) * 2 + sizeof(std::uint64_t);
+    std::size_t bytes = GetRowCount() * perRow + m_Paths.GetMemoryBytes() + m_Names.GetMemoryBytes();
+    for (const auto& source : m_SourceFiles) {
+        bytes += sizeof(SourceFile) + source.path.native().size();
+    }
+    return bytes;
+}
+
+TxtTargetRecord TargetCatalog::GetRecord(std::size_t row) const {
+    TxtTargetRecord rec;
+    rec.index = GetIndex(row);
+    rec.fileDir = GetFileDir(row);
+    rec.alignedFilename = GetAlignedFilename(row);
+    rec.templateAlignedFilename = GetTemplateFilename(row);
+    rec.hasPixelCenter = HasPixelCenter(row);
+    rec.pixelX = m_PixelX[row];
+    rec.pixelY = m_PixelY[row];
+    rec.hasRaDec = HasRaDec(row);
+    rec.ra = m_Ra[row];
+    rec.dec = m_Dec[row];
+    return rec;
+}
+
+bool TargetCatalog::MatchesRow(const Query& query, std::size_t row) const {
+    switch (static_cast<Label>(m_Label[row])) {
+        case Label::Good: if (!query.good) return false; break;
+        case Label::Bad: if (!query.bad) return false; break;
+        default: if (!query.unknown) return false; break;
+    }
+
+    if (query.dateMin != 0 || query.dateMax != 0) {
+        const std::uint64_t date = m_Epoch[row] / 1000000ull;
+        if (date == 0) return false;
+        if (query.dateMin != 0 && date < query.dateMin) return false;
+        if (query.dateMax != 0 && date > query.dateMax) return false;
+    }
+
+    if (query.usePixelRegion) {
+        if (!(m_Flags[row] & kHasPixelCenter)) return false;
+        const int x = m_PixelX[row];
+        const int y = m_PixelY[row];
+        if (x < query.pixelXMin || x > query.pixelXMax || y < query.pixelYMin || y > query.pixelYMax) return false;
+    }
+
+    if (query.useRaDecRange) {
+        if (!(m_Flags[row] & kHasRaDec)) return false;
+        const double ra = m_Ra[row];
+        const double dec = m_Dec[row];
+        if (dec < query.decMin || dec > query.decMax) return false;
+        const bool raOk = (query.raMin <= query.raMax) ? (ra >= query.raMin && ra <= query.raMax)
+                                                      : (ra >= query.raMin || ra <= query.raMax);
+        if (!raOk) return false;
+    }
+    return true;
+}
+
+void TargetCatalog::RunQuery(const Query& query, std::vector<std::uint32_t>& outRows) const {
+    outRows.clear();
+
+    if (query.useRaDecRange && query.sourceFile < 0) {
+        std::vector<std::uint32_t> candidates;
+        m_SkyIndex.QueryBox(query.raMin, query.raMax, query.decMin, query.decMax, candidates);
+        for (std::uint32_t row : candidates) {
+            if (MatchesRow(query, row)) outRows.push_back(row);
+        }
+        std::sort(outRows.begin(), outRows.end());
+        return;
+    }
+
+    std::size_t begin = 0;
+    std::size_t end = GetRowCount();
+    if (query.sourceFile >= 0) {
+        if (query.sourceFile >= static_cast<int>(m_SourceFiles.size())) return;
+        const SourceFile& source = m_SourceFiles[query.sourceFile];
+        begin = source.firstRow;
+        end = source.firstRow + source.rowCount;
+    }
+
+    // Scan ranges in parallel, one result list per worker, concatenated in order.
+    std::vector<std::vector<std::uint32_t>> partial(GetWorkerThreadCount());
+    ParallelForRanges(end - begin, 1 << 16, [&](std::size_t rangeBegin, std::size_t rangeEnd, unsigned int worker) {
+        std::vector<std::uint32_t>& rows = partial[worker];
+        for (std::size_t i = begin + rangeBegin; i < begin + rangeEnd; i++) {
+            if (MatchesRow(query, i)) rows.push_back(static_cast<std::uint32_t>(i));
+        }
+    });
+
+    std::size_t total = 0;
+    for (const auto& rows : partial) total += rows.size();
+    outRows.reserve(total);
+    for (const auto& rows : partial) outRows.insert(outRows.end(), rows.begin(), rows.end());
+}
+
+void TargetCatalog::QueryCone(double raDeg, double decDeg, double radiusArcsec, const Query& filters,
+                              std::vector<SkyIndex::Match>& outMatches) const {
+    m_SkyIndex.QueryCone(raDeg, decDeg, radiusArcsec, outMatches);
+
+    // The cone replaces the RA/Dec box.
+    Query rowFilters = filters;
+    rowFilters.useRaDecRange = false;
+    outMatches.erase(std::remove_if(outMatches.begin(), outMatches.end(), [&](const SkyIndex::Match& m) {
+        if (rowFilters.sourceFile >= 0 && m_SourceFile[m.id] != static_cast<std::uint32_t>(rowFilters.sourceFile)) {
+            return true;
+        }
+        return !MatchesRow(rowFilters, m.id);
+    }), outMatches.end());
+}
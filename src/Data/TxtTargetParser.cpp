@@ -0,0 +1,447 @@
+#include "Data/TxtTargetParser.h"
+#include "Data/MappedFile.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Files at least this large are split into chunks parsed on worker threads.
+constexpr std::size_t kParallelParseMinBytes = 1 << 20;
+constexpr std::size_t kParseChunkMinBytes = 256 << 10;
+
+const char* const kExpectedFormat =
+    "index file_dir aligned_filename template_aligned_filename fits_center_ra fits_center_dec time pixel_x pixel_y ra dec";
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+std::string_view TrimView(std::string_view s) {
+    while (!s.empty() && IsSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && IsSpace(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+bool ParseInt(std::string_view token, int& out) {
+    if (!token.empty() && token.front() == '+') token.remove_prefix(1);
+    const auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), out);
+    return ec == std::errc() && end == token.data() + token.size();
+}
+
+bool ParseDouble(std::string_view token, double& out) {
+    if (!token.empty() && token.front() == '+') token.remove_prefix(1);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), out);
+    return ec == std::errc() && end == token.data() + token.size();
+#else
+    // Standard libraries without floating-point from_chars.
+    char buffer[64];
+    if (token.empty() || token.size() >= sizeof(buffer)) return false;
+    std::memcpy(buffer, token.data(), token.size());
+    buffer[token.size()] = '\0';
+    char* end = nullptr;
+    out = std::strtod(buffer, &end);
+    return end == buffer + token.size();
+#endif
+}
+
+// Split on spaces/tabs; returns the token count (may exceed maxTokens, extra tokens are not stored).
+std::size_t SplitTokens(std::string_view line, std::string_view* tokens, std::size_t maxTokens) {
+    std::size_t count = 0;
+    std::size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && IsSpace(line[i])) i++;
+        if (i >= line.size()) break;
+        const std::size_t start = i;
+        while (i < line.size() && !IsSpace(line[i])) i++;
+        if (count < maxTokens) tokens[count] = line.substr(start, i - start);
+        count++;
+    }
+    return count;
+}
+
+void AddIssue(TxtParseReport& report, std::size_t lineNumber, std::string message) {
+    if (report.issues.size() < TxtParseReport::kMaxIssues) {
+        report.issues.push_back(TxtParseIssue{lineNumber, std::move(message)});
+    }
+}
+
+// Leading '#'/blank lines. Returns the offset of the first data line.
+std::size_t ParseHeader(std::string_view text, TxtParseReport& report, std::size_t& outHeaderLines) {
+    std::size_t pos = 0;
+    outHeaderLines = 0;
+    while (pos < text.size()) {
+        const std::size_t eol = text.find('\n', pos);
+        const std::size_t lineEnd = (eol == std::string_view::npos) ? text.size() : eol;
+        const std::string_view line = TrimView(text.substr(pos, lineEnd - pos));
+        if (!line.empty() && line.front() != '#') break;
+
+        outHeaderLines++;
+        if (!line.empty()) {
+            const std::string_view body = TrimView(line.substr(1));
+            const std::size_t colon = body.find(':');
+            if (colon != std::string_view::npos) {
+                const std::string_view key = TrimView(body.substr(0, colon));
+                const std::string_view value = TrimView(body.substr(colon + 1));
+                if (key == "Label") {
+                    report.label.assign(value);
+                } else if (key == "Total Records") {
+                    int declared = 0;
+                    if (ParseInt(value, declared) && declared >= 0) {
+                        report.hasTotalRecords = true;
+                        report.declaredRecords = static_cast<std::size_t>(declared);
+                    } else {
+                        AddIssue(report, outHeaderLines, "Total Records 不是有效数字");
+                    }
+                } else if (key == "Format") {
+                    report.hasFormat = true;
+                    std::string_view expected[12];
+                    std::string_view actual[12];
+                    const std::size_t expectedCount = SplitTokens(kExpectedFormat, expected, 12);
+                    const std::size_t actualCount = SplitTokens(value, actual, 12);
+                    report.formatMatches = (expectedCount == actualCount) &&
+                                           std::equal(expected, expected + expectedCount, actual);
+                    if (!report.formatMatches) {
+                        AddIssue(report, outHeaderLines, "Format 列与预期不一致: " + std::string(value));
+                    }
+                }
+            }
+        }
+        pos = (eol == std::string_view::npos) ? text.size() : eol + 1;
+    }
+    return pos;
+}
+
+struct ChunkResult {
+    std::vector<TxtTargetRowView> rows;
+    TxtParseReport report; // issue line numbers are chunk-local until merged
+    std::size_t lineCount{0};
+};
+
+void ParseChunk(std::string_view chunk, ChunkResult& result) {
+    result.rows.reserve(chunk.size() / 160 + 1);
+
+    std::string problem;
+    std::size_t pos = 0;
+    while (pos < chunk.size()) {
+        const std::size_t eol = chunk.find('\n', pos);
+        const std::size_t lineEnd = (eol == std::string_view::npos) ? chunk.size() : eol;
+        const std::string_view line = TrimView(chunk.substr(pos, lineEnd - pos));
+        pos = (eol == std::string_view::npos) ? chunk.size() : eol + 1;
+        result.lineCount++;
+
+        if (line.empty() || line.front() == '#') continue;
+        result.report.dataLines++;
+
+        TxtTargetRowView row;
+        problem.clear();
+        const bool ok = ParseTxtTargetRow(line, row, &problem);
+        if (!problem.empty()) {
+            result.report.malformedLines++;
+            AddIssue(result.report, result.lineCount, problem);
+        }
+        if (ok) result.rows.push_back(row);
+    }
+}
+} // namespace
+
+bool ParseTxtTargetRow(std::string_view line, TxtTargetRowView& outRow, std::string* outProblem) {
+    outRow = TxtTargetRowView();
+
+    std::string_view tokens[11];
+    const std::size_t count = SplitTokens(line, tokens, 11);
+    if (count < 4) {
+        if (outProblem) *outProblem = "字段不足: 需要至少 4 列，实际 " + std::to_string(count) + " 列";
+        return false;
+    }
+
+    outRow.index = tokens[0];
+    outRow.fileDir = tokens[1];
+    outRow.alignedFilename = tokens[2];
+    outRow.templateAlignedFilename = tokens[3];
+
+    if (count == 4) return true;
+    if (count < 9) {
+        if (outProblem) *outProblem = "像素坐标列不完整";
+        return true;
+    }
+
+    double centerRa = 0.0;
+    double centerDec = 0.0;
+    int px = 0;
+    int py = 0;
+    if (!ParseDouble(tokens[4], centerRa) || !ParseDouble(tokens[5], centerDec) ||
+        !ParseInt(tokens[7], px) || !ParseInt(tokens[8], py)) {
+        if (outProblem) *outProblem = "中心坐标/像素坐标无法解析";
+        return true;
+    }
+    outRow.hasPixelCenter = true;
+    outRow.fitsCenterRa = centerRa;
+    outRow.fitsCenterDec = centerDec;
+    outRow.time = tokens[6];
+    outRow.pixelX = px;
+    outRow.pixelY = py;
+
+    if (count == 9) return true;
+    double ra = 0.0;
+    double dec = 0.0;
+    if (count < 11 || !ParseDouble(tokens[9], ra) || !ParseDouble(tokens[10], dec)) {
+        if (outProblem) *outProblem = "ra/dec 列不完整或无法解析";
+        return true;
+    }
+    outRow.hasRaDec = true;
+    outRow.ra = ra;
+    outRow.dec = dec;
+
+    if (count > 11 && outProblem) *outProblem = "多余的列: " + std::to_string(count) + " 列";
+    return true;
+}
+
+bool ParseTxtTargetRows(std::string_view text,
+                        std::vector<TxtTargetRowView>& outRows,
+                        std::string& outError,
+                        TxtParseReport* report) {
+    outRows.clear();
+    outError.clear();
+
+    TxtParseReport localReport;
+    TxtParseReport& rep = report ? *report : localReport;
+    rep = TxtParseReport();
+
+    std::size_t headerLines = 0;
+    const std::size_t bodyStart = ParseHeader(text, rep, headerLines);
+    const std::string_view body = text.substr(bodyStart);
+
+    // Chunk boundaries sit just after a newline so no line is split.
+    std::vector<std::string_view> chunks;
+    if (body.size() >= kParallelParseMinBytes) {
+        const std::size_t chunkCount = std::min<std::size_t>(GetWorkerThreadCount() * 2,
+                                                             body.size() / kParseChunkMinBytes);
+        std::size_t start = 0;
+        for (std::size_t k = 1; k < chunkCount && start < body.size(); k++) {
+            std::size_t cut = body.size() * k / chunkCount;
+            if (cut <= start) continue;
+            const std::size_t eol = body.find('\n', cut);
+            cut = (eol == std::string_view::npos) ? body.size() : eol + 1;
+            chunks.push_back(body.substr(start, cut - start));
+            start = cut;
+        }
+        if (start < body.size()) chunks.push_back(body.substr(start));
+    } else {
+        chunks.push_back(body);
+    }
+
+    std::vector<ChunkResult> results(chunks.size());
+    ParallelForEach(chunks.size(), [&](std::size_t i) { ParseChunk(chunks[i], results[i]); });
+
+    if (results.size() == 1) {
+        outRows = std::move(results[0].rows);
+    } else {
+        std::size_t total = 0;
+        for (const auto& r : results) total += r.rows.size();
+        outRows.reserve(total);
+        for (const auto& r : results) outRows.insert(outRows.end(), r.rows.begin(), r.rows.end());
+    }
+
+    std::size_t lineOffset = headerLines;
+    for (auto& r : results) {
+        rep.dataLines += r.report.dataLines;
+        rep.malformedLines += r.report.malformedLines;
+        for (auto& issue : r.report.issues) AddIssue(rep, issue.lineNumber + lineOffset, std::move(issue.message));
+        lineOffset += r.lineCount;
+    }
+
+    if (!rep.hasTotalRecords) AddIssue(rep, 0, "缺少 # Total Records 头");
+    if (!rep.hasFormat) AddIssue(rep, 0, "缺少 # Format 头");
+    if (rep.hasTotalRecords && rep.declaredRecords != outRows.size()) {
+        AddIssue(rep, 0, "Total Records 为 " + std::to_string(rep.declaredRecords) + "，实际解析 " +
+                             std::to_string(outRows.size()) + " 行");
+    }
+
+    if (outRows.empty()) {
+        outError = "txt 中未找到数据行";
+        return false;
+    }
+    return true;
+}
+
+bool ParseTxtTargetText(std::string_view text,
+                        std::vector<TxtTargetRecord>& outTargets,
+                        std::string& outError,
+                        TxtParseReport* report) {
+    outTargets.clear();
+
+    std::vector<TxtTargetRowView> rows;
+    if (!ParseTxtTargetRows(text, rows, outError, report)) return false;
+
+    outTargets.resize(rows.size());
+    ParallelForRanges(rows.size(), 16384, [&](std::size_t begin, std::size_t end, unsigned int) {
+        for (std::size_t i = begin; i < end; i++) {
+            const TxtTargetRowView& row = rows[i];
+            TxtTargetRecord& rec = outTargets[i];
+            rec.index.assign(row.index);
+            rec.fileDir.assign(row.fileDir);
+            rec.alignedFilename.assign(row.alignedFilename);
+            rec.templateAlignedFilename.assign(row.templateAlignedFilename);
+            rec.hasPixelCenter = row.hasPixelCenter;
+            rec.pixelX = row.pixelX;
+            rec.pixelY = row.pixelY;
+            rec.hasRaDec = row.hasRaDec;
+            rec.ra = row.ra;
+            rec.dec = row.dec;
+        }
+    });
+    return true;
+}
+
+bool ParseTxtTargetFile(const fs::path& txtPath,
+                        std::vector<TxtTargetRecord>& outTargets,
+                        std::string& outError,
+                        TxtParseReport* report) {
+    outTargets.clear();
+    outError.clear();
+
+    MappedFile file;
+    std::string mapError;
+    if (!file.Open(txtPath, mapError)) {
+        outError = "无法打开 txt";
+        return false;
+    }
+    return ParseTxtTargetText(file.GetView(), outTargets, outError, report);
+}
+
+bool ParseTxtTargetFileStream(const fs::path& txtPath,
+                              std::vector<TxtTargetRecord>& outTargets,
+                              std::string& outError) {
+    outTargets.clear();
+    outError.clear();
+
+    std::ifstream in(txtPath, std::ios::in);
+    if (!in.is_open()) {
+        outError = "无法打开 txt";
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        if (!line.empty() && line[0] == '#') continue;
+
+        // Expected (whitespace-separated):
+        // index file_dir aligned_filename template_aligned_filename fits_center_ra fits_center_dec time pixel_x pixel_y ra dec
+        std::istringstream iss(line);
+        TxtTargetRecord rec;
+        if (!(iss >> rec.index >> rec.fileDir >> rec.alignedFilename >> rec.templateAlignedFilename)) {
+            continue;
+        }
+
+        // Optional fields
+        double fits_center_ra = 0.0;
+        double fits_center_dec = 0.0;
+        std::string timeStr;
+        int px = 0, py = 0;
+        double ra = 0.0, dec = 0.0;
+        if ((iss >> fits_center_ra >> fits_center_dec >> timeStr >> px >> py)) {
+            rec.hasPixelCenter = true;
+            rec.pixelX = px;
+            rec.pixelY = py;
+            if ((iss >> ra >> dec)) {
+                rec.hasRaDec = true;
+                rec.ra = ra;
+                rec.dec = dec;
+            }
+        }
+
+        outTargets.push_back(std::move(rec));
+    }
+
+    if (outTargets.empty()) {
+        outError = "txt 中未找到数据行";
+        return false;
+    }
+    return true;
+}
+
+namespace {
+// Drive-letter and UNC paths are absolute wherever the txt is read.
+bool IsAbsoluteOnAnyPlatform(const std::string& path) {
+    if (path.size() >= 3 && std::isalpha(static_cast<unsigned char>(path[0])) && path[1] == ':' &&
+        (path[2] == '\\' || path[2] == '/')) {
+        return true;
+    }
+    if (path.size() >= 2 && path[0] == '\\' && path[1] == '\\') return true;
+    return fs::path(path).is_absolute();
+}
+
+std::string JoinRecordPath(const std::string& dir, const std::string& file) {
+    if (dir.empty() || IsAbsoluteOnAnyPlatform(file)) return file;
+    const char last = dir.back();
+    return (last == '/' || last == '\\') ? dir + file : dir + "/" + file;
+}
+
+fs::path ResolveMaybeMissingPath(const std::string& candidate, FileIndex& index, bool& indexPending) {
+    std::error_code ec;
+    if (!candidate.empty() && fs::exists(candidate, ec)) return candidate;
+
+    fs::path remapped;
+    if (index.ApplyPrefixRemap(candidate, remapped) && fs::exists(remapped, ec)) return remapped;
+
+    fs::path found;
+    if (index.Find(FileIndex::FilenameOf(candidate), found)) return found;
+    if (!index.IsReady()) indexPending = true;
+
+    return candidate; // fallback (may not exist)
+}
+} // namespace
+
+std::vector<fs::path> GetDefaultFitsSearchRoots() {
+    const fs::path cwd = fs::current_path();
+    return {
+        cwd,
+        cwd / "test-img",
+        cwd / "test-label-data",
+        cwd / ".." / ".." / ".." // if running from build/bin/<Config>
+    };
+}
+
+FileIndex& GetFitsFileIndex() {
+    static FileIndex index;
+    static std::once_flag configured;
+    std::call_once(configured, []() {
+        // Remap rules: path_remap.txt next to the working directory, then the environment.
+        const fs::path remapFile = fs::current_path() / "path_remap.txt";
+        if (fs::exists(remapFile) && index.LoadPrefixRemapFile(remapFile)) {
+            std::cout << "Loaded path remap rules from " << remapFile << std::endl;
+        }
+        if (const char* env = std::getenv("GEOGEBRA3D_PATH_REMAP")) {
+            index.AddPrefixRemapList(env);
+        }
+        index.SetRoots(GetDefaultFitsSearchRoots());
+    });
+    return index;
+}
+
+bool ResolveTxtTargetFitsPaths(const TxtTargetRecord& rec,
+                               FileIndex& index,
+                               fs::path& outAligned,
+                               fs::path& outTemplate,
+                               bool* outIndexPending) {
+    if (outIndexPending) *outIndexPending = false;
+    if (rec.alignedFilename.empty() || rec.templateAlignedFilename.empty()) return false;
+
+    bool pending = false;
+    outAligned = ResolveMaybeMissingPath(JoinRecordPath(rec.fileDir, rec.alignedFilename), index, pending);
+    outTemplate = ResolveMaybeMissingPath(JoinRecordPath(rec.fileDir, rec.templateAlignedFilename), index, pending);
+    if (outIndexPending) *outIndexPending = pending;
+    return true;
+}
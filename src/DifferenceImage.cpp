@@ -0,0 +1,288 @@
+#include "DifferenceImage.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DIFFERENCE_USE_SSE2 1
+#endif
+
+namespace {
+// out[i] = k0 + ka * a[i] + kt * t[i]
+void SubtractRow(const float* a, const float* t, float k0, float ka, float kt, float* out, int count) {
+    int i = 0;
+#ifdef DIFFERENCE_USE_SSE2
+    const __m128 vk0 = _mm_set1_ps(k0);
+    const __m128 vka = _mm_set1_ps(ka);
+    const __m128 vkt = _mm_set1_ps(kt);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 va = _mm_loadu_ps(a + i);
+        const __m128 vt = _mm_loadu_ps(t + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(vk0, _mm_mul_ps(vka, va)), _mm_mul_ps(vkt, vt)));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = (k0 + ka * a[i]) + kt * t[i];
+    }
+}
+} // namespace
+
+bool DifferenceImage::Params::operator==(const Params& other) const {
+    return matchScale == other.matchScale && sampleCount == other.sampleCount && clipSigma == other.clipSigma &&
+           maxIterations == other.maxIterations && colorSigma == other.colorSigma && maxTiles == other.maxTiles;
+}
+
+DifferenceImage::DifferenceImage()
+    : m_Width(0)
+    , m_Height(0)
+    , m_K0(0.0f)
+    , m_KAligned(1.0f)
+    , m_KTemplate(-1.0f)
+{
+}
+
+bool DifferenceImage::SetInputs(std::shared_ptr<const ImageLoader> aligned, std::shared_ptr<const ImageLoader> templ,
+                                const Params& params) {
+    // The colormap span and the cache cap do not change the tiles.
+    if (aligned == m_Aligned && templ == m_Template && params.matchScale == m_Params.matchScale &&
+        params.sampleCount == m_Params.sampleCount && params.clipSigma == m_Params.clipSigma &&
+        params.maxIterations == m_Params.maxIterations) {
+        m_Params = params;
+        return false;
+    }
+
+    Clear();
+    if (!aligned || !templ || !aligned->IsLoaded() || !templ->IsLoaded()) return true;
+    if (aligned->GetWidth() != templ->GetWidth() || aligned->GetHeight() != templ->GetHeight()) {
+        std::cerr << "Difference image: size mismatch " << aligned->GetWidth() << "x" << aligned->GetHeight()
+                  << " vs " << templ->GetWidth() << "x" << templ->GetHeight() << ", using the overlap" << std::endl;
+    }
+
+    m_Aligned = std::move(aligned);
+    m_Template = std::move(templ);
+    m_Params = params;
+    m_Width = std::min(m_Aligned->GetWidth(), m_Template->GetWidth());
+    m_Height = std::min(m_Aligned->GetHeight(), m_Template->GetHeight());
+    FitScale();
+    return true;
+}
+
+void DifferenceImage::Clear() {
+    m_Aligned.reset();
+    m_Template.reset();
+    m_Fit = Fit();
+    m_Width = 0;
+    m_Height = 0;
+    m_K0 = 0.0f;
+    m_KAligned = 1.0f;
+    m_KTemplate = -1.0f;
+    m_Tiles.clear();
+}
+
+std::size_t DifferenceImage::GetMemoryBytes() const {
+    return m_Tiles.size() * static_cast<std::size_t>(kTileSize) * kTileSize * sizeof(float);
+}
+
+void DifferenceImage::FitScale() {
+    double alignedMin = 0.0, alignedMax = 1.0, templateMin = 0.0, templateMax = 1.0;
+    m_Aligned->GetDataRange(alignedMin, alignedMax);
+    m_Template->GetDataRange(templateMin, templateMax);
+    const double alignedScale = alignedMax - alignedMin;
+    const double templateScale = templateMax - templateMin;
+
+    // Pairs (template, aligned) in data units on a regular grid.
+    int stride = 1;
+    while (static_cast<long long>(stride) * stride * std::max(m_Params.sampleCount, 1) <
+           static_cast<long long>(m_Width) * m_Height) {
+        stride++;
+    }
+    std::vector<double> t;
+    std::vector<double> a;
+    for (int y = stride / 2; y < m_Height; y += stride) {
+        for (int x = stride / 2; x < m_Width; x += stride) {
+            // Same blank test as the tiles.
+            if (m_Aligned->IsBlankPixel(x, y) || m_Template->IsBlankPixel(x, y)) continue;
+            const float av = m_Aligned->GetNormalizedPixelValue(x, y);
+            const float tv = m_Template->GetNormalizedPixelValue(x, y);
+            a.push_back(alignedMin + alignedScale * av);
+            t.push_back(templateMin + templateScale * tv);
+        }
+    }
+
+    // Fit on the kept pairs, clip residuals beyond clipSigma * rms, repeat until stable.
+    // Without flux matching only the scatter is estimated.
+    Fit fit;
+    std::vector<char> kept(a.size(), 1);
+    std::size_t keptCount = a.size();
+    for (int iteration = 0; iteration < std::max(m_Params.maxIterations, 1) && keptCount >= 3; iteration++) {
+        if (m_Params.matchScale) {
+            double n = 0.0, st = 0.0, sa = 0.0, stt = 0.0, sta = 0.0;
+            for (std::size_t i = 0; i < a.size(); i++) {
+                if (!kept[i]) continue;
+                n += 1.0;
+                st += t[i];
+                sa += a[i];
+                stt += t[i] * t[i];
+                sta += t[i] * a[i];
+            }
+            const double denom = n * stt - st * st;
+            if (denom > 0.0) {
+                fit.scale = (n * sta - st * sa) / denom;
+                fit.offset = (sa - fit.scale * st) / n;
+            }
+        }
+
+        double sum = 0.0, sumSq = 0.0;
+        for (std::size_t i = 0; i < a.size(); i++) {
+            if (!kept[i]) continue;
+            const double r = a[i] - (fit.offset + fit.scale * t[i]);
+            sum += r;
+            sumSq += r * r;
+        }
+        const double mean = sum / keptCount;
+        fit.rms = std::sqrt(std::max(0.0, sumSq / keptCount - mean * mean));
+
+        const double limit = m_Params.clipSigma * fit.rms;
+        std::size_t nextCount = 0;
+        for (std::size_t i = 0; i < a.size(); i++) {
+            const double r = a[i] - (fit.offset + fit.scale * t[i]) - mean;
+            kept[i] = std::abs(r) <= limit ? 1 : 0;
+            nextCount += kept[i];
+        }
+        if (nextCount == keptCount) break;
+        keptCount = nextCount;
+    }
+    fit.samples = static_cast<int>(keptCount);
+    fit.valid = keptCount >= 3;
+    m_Fit = fit;
+
+    // difference = (alignedMin + alignedScale * a) - (offset + scale * (templateMin + templateScale * t))
+    m_K0 = static_cast<float>(alignedMin - fit.offset - fit.scale * templateMin);
+    m_KAligned = static_cast<float>(alignedScale);
+    m_KTemplate = static_cast<float>(-fit.scale * templateScale);
+
+    std::cout << "Difference fit: aligned = " << fit.offset << " + " << fit.scale << " * template, rms " << fit.rms
+              << " (" << fit.samples << " of " << a.size() << " samples)" << std::endl;
+}
+
+void DifferenceImage::ComputeTile(int tileX, int tileY, std::vector<float>& out) const {
+    out.assign(static_cast<std::size_t>(kTileSize) * kTileSize, std::numeric_limits<float>::quiet_NaN());
+    const int x0 = tileX * kTileSize;
+    const int y0 = tileY * kTileSize;
+    const int width = std::min(kTileSize, m_Width - x0);
+    const int height = std::min(kTileSize, m_Height - y0);
+    if (width <= 0 || height <= 0) return;
+
+    float alignedRow[kTileSize];
+    float templateRow[kTileSize];
+    std::uint8_t alignedBlank[kTileSize];
+    std::uint8_t templateBlank[kTileSize];
+    const bool blanks = m_Aligned->HasBlankPixels() || m_Template->HasBlankPixels();
+    for (int j = 0; j < height; j++) {
+        float* target = out.data() + static_cast<std::size_t>(j) * kTileSize;
+        m_Aligned->GetNormalizedRow(y0 + j, x0, width, alignedRow);
+        m_Template->GetNormalizedRow(y0 + j, x0, width, templateRow);
+        SubtractRow(alignedRow, templateRow, m_K0, m_KAligned, m_KTemplate, target, width);
+        if (!blanks) continue;
+        // No difference where either input has no data.
+        m_Aligned->GetBlankRow(y0 + j, x0, width, alignedBlank);
+        m_Template->GetBlankRow(y0 + j, x0, width, templateBlank);
+        for (int i = 0; i < width; i++) {
+            if (alignedBlank[i] | templateBlank[i]) target[i] = std::numeric_limits<float>::quiet_NaN();
+        }
+    }
+}
+
+int DifferenceImage::Update(int x0, int y0, int x1, int y1) {
+    if (!HasInputs()) return 0;
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_Width - 1);
+    y1 = std::min(y1, m_Height - 1);
+    if (x0 > x1 || y0 > y1) return 0;
+
+    const int tx0 = x0 / kTileSize;
+    const int ty0 = y0 / kTileSize;
+    const int tx1 = x1 / kTileSize;
+    const int ty1 = y1 / kTileSize;
+    std::vector<std::pair<int, int>> missing;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            if (m_Tiles.find(TileKey(tx, ty)) == m_Tiles.end()) missing.emplace_back(tx, ty);
+        }
+    }
+    if (missing.empty()) return 0;
+
+    // Over the cap: keep only the tiles of this region.
+    if (m_Tiles.size() + missing.size() > m_Params.maxTiles) {
+        for (auto it = m_Tiles.begin(); it != m_Tiles.end();) {
+            const int tx = static_cast<int>(static_cast<std::uint32_t>(it->first));
+            const int ty = static_cast<int>(it->first >> 32);
+            if (tx < tx0 || tx > tx1 || ty < ty0 || ty > ty1) {
+                it = m_Tiles.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    std::vector<std::vector<float>> computed(missing.size());
+    ParallelForEach(missing.size(), [&](std::size_t i) {
+        ComputeTile(missing[i].first, missing[i].second, computed[i]);
+    });
+    for (std::size_t i = 0; i < missing.size(); i++) {
+        m_Tiles[TileKey(missing[i].first, missing[i].second)] = std::move(computed[i]);
+    }
+    return static_cast<int>(missing.size());
+}
+
+float DifferenceImage::GetValue(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_Width || y >= m_Height) return std::numeric_limits<float>::quiet_NaN();
+    const auto it = m_Tiles.find(TileKey(x / kTileSize, y / kTileSize));
+    if (it == m_Tiles.end()) return std::numeric_limits<float>::quiet_NaN();
+    return it->second[static_cast<std::size_t>(y % kTileSize) * kTileSize + (x % kTileSize)];
+}
+
+glm::vec4 DifferenceImage::DivergingColor(float t) {
+    // Cool-warm: blue -> light gray -> red.
+    const glm::vec3 negative(0.23f, 0.30f, 0.75f);
+    const glm::vec3 middle(0.87f, 0.87f, 0.87f);
+    const glm::vec3 positive(0.71f, 0.02f, 0.15f);
+    t = std::clamp(t, -1.0f, 1.0f);
+    const glm::vec3 rgb = (t < 0.0f) ? middle + (negative - middle) * (-t) : middle + (positive - middle) * t;
+    return glm::vec4(rgb, 1.0f);
+}
+
+void DifferenceImage::GeneratePointCloud(int x0, int y0, int x1, int y1, float scaleX, float scaleY, float scaleZ,
+                                         std::vector<glm::vec3>& positions, std::vector<glm::vec4>& colors) const {
+    positions.clear();
+    colors.clear();
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_Width - 1);
+    y1 = std::min(y1, m_Height - 1);
+    if (!HasInputs() || x0 > x1 || y0 > y1) return;
+
+    const std::size_t count = static_cast<std::size_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+    positions.reserve(count);
+    colors.reserve(count);
+
+    const float span = static_cast<float>(m_Params.colorSigma * m_Fit.rms);
+    const float invSpan = span > 0.0f ? 1.0f / span : 0.0f;
+    const float centerX = m_Width * 0.5f;
+    const float centerZ = m_Height * 0.5f;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            const float d = GetValue(x, y);
+            if (!std::isfinite(d)) continue;  // blank
+            const float t = std::clamp(d * invSpan, -1.0f, 1.0f);
+            positions.emplace_back((x - centerX) * scaleX, t * 0.5f * scaleY, (y - centerZ) * scaleZ);
+            colors.push_back(DivergingColor(t));
+        }
+    }
+}
@@ -0,0 +1,143 @@
+#include "Fft.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace {
+constexpr double kTwoPi = 6.283185307179586476925286766559;
+
+template <typename T>
+std::shared_ptr<const T> GetCached(int size) {
+    static std::mutex mutex;
+    static std::map<int, std::shared_ptr<const T>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = cache[size];
+    if (!entry) entry = std::make_shared<const T>(size);
+    return entry;
+}
+} // namespace
+
+FftPlan::FftPlan(int size)
+    : m_Size(size)
+{
+    int bits = 0;
+    while ((1 << bits) < size) bits++;
+    for (int i = 0; i < size; i++) {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) reversed |= 1 << (bits - 1 - b);
+        }
+        if (i < reversed) m_Swaps.emplace_back(i, reversed);
+    }
+
+    m_Twiddles.resize(static_cast<std::size_t>(size / 2));
+    for (int k = 0; k < size / 2; k++) {
+        const double angle = -kTwoPi * k / size;
+        m_Twiddles[k] = std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+}
+
+void FftPlan::Transform(std::complex<float>* data, bool inverse) const {
+    for (const auto& swap : m_Swaps) std::swap(data[swap.first], data[swap.second]);
+
+    for (int length = 2; length <= m_Size; length <<= 1) {
+        const int half = length / 2;
+        const int step = m_Size / length;
+        for (int start = 0; start < m_Size; start += length) {
+            for (int k = 0; k < half; k++) {
+                const std::complex<float> w = inverse ? std::conj(m_Twiddles[k * step]) : m_Twiddles[k * step];
+                const std::complex<float> odd = data[start + k + half] * w;
+                data[start + k + half] = data[start + k] - odd;
+                data[start + k] += odd;
+            }
+        }
+    }
+}
+
+std::shared_ptr<const FftPlan> FftPlan::Get(int size) {
+    return GetCached<FftPlan>(size);
+}
+
+int FftPlan::NextPowerOfTwo(int n) {
+    int size = 1;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+RealFft2D::RealFft2D(int size)
+    : m_Size(size)
+    , m_RowPlan(FftPlan::Get(size / 2))
+    , m_ColumnPlan(FftPlan::Get(size))
+{
+    m_RowTwiddles.resize(static_cast<std::size_t>(size / 2 + 1));
+    for (int k = 0; k <= size / 2; k++) {
+        const double angle = -kTwoPi * k / size;
+        m_RowTwiddles[k] = std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+}
+
+std::shared_ptr<const RealFft2D> RealFft2D::Get(int size) {
+    return GetCached<RealFft2D>(size);
+}
+
+void RealFft2D::Forward(const float* image, std::complex<float>* spectrum) const {
+    const int half = m_Size / 2;
+    const int width = GetSpectrumWidth();
+    std::vector<std::complex<float>> packed(static_cast<std::size_t>(half));
+
+    for (int y = 0; y < m_Size; y++) {
+        const float* row = image + static_cast<std::size_t>(y) * m_Size;
+        for (int j = 0; j < half; j++) packed[j] = std::complex<float>(row[2 * j], row[2 * j + 1]);
+        m_RowPlan->Transform(packed.data(), false);
+
+        // Split the packed spectrum into the even and odd sample spectra and combine.
+        std::complex<float>* out = spectrum + static_cast<std::size_t>(y) * width;
+        for (int k = 0; k <= half; k++) {
+            const std::complex<float> z = packed[k % half];
+            const std::complex<float> zc = std::conj(packed[(half - k) % half]);
+            const std::complex<float> even = 0.5f * (z + zc);
+            const std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (z - zc);
+            out[k] = even + m_RowTwiddles[k] * odd;
+        }
+    }
+
+    TransformColumns(spectrum, false);
+}
+
+void RealFft2D::Inverse(std::complex<float>* spectrum, float* image) const {
+    const int half = m_Size / 2;
+    const int width = GetSpectrumWidth();
+    TransformColumns(spectrum, true);
+
+    // Column pass scales by size, packed row pass by size / 2.
+    const float scale = 1.0f / (static_cast<float>(m_Size) * static_cast<float>(half));
+    std::vector<std::complex<float>> packed(static_cast<std::size_t>(half));
+    for (int y = 0; y < m_Size; y++) {
+        const std::complex<float>* in = spectrum + static_cast<std::size_t>(y) * width;
+        for (int k = 0; k < half; k++) {
+            const std::complex<float> x = in[k];
+            const std::complex<float> xc = std::conj(in[half - k]);
+            const std::complex<float> even = 0.5f * (x + xc);
+            const std::complex<float> odd = 0.5f * (x - xc) * std::conj(m_RowTwiddles[k]);
+            packed[k] = even + std::complex<float>(0.0f, 1.0f) * odd;
+        }
+        m_RowPlan->Transform(packed.data(), true);
+
+        float* row = image + static_cast<std::size_t>(y) * m_Size;
+        for (int j = 0; j < half; j++) {
+            row[2 * j] = packed[j].real() * scale;
+            row[2 * j + 1] = packed[j].imag() * scale;
+        }
+    }
+}
+
+void RealFft2D::TransformColumns(std::complex<float>* spectrum, bool inverse) const {
+    const int width = GetSpectrumWidth();
+    std::vector<std::complex<float>> column(static_cast<std::size_t>(m_Size));
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < m_Size; y++) column[y] = spectrum[static_cast<std::size_t>(y) * width + x];
+        m_ColumnPlan->Transform(column.data(), inverse);
+        for (int y = 0; y < m_Size; y++) spectrum[static_cast<std::size_t>(y) * width + x] = column[y];
+    }
+}
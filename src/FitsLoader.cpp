@@ -1,9 +1,17 @@
 #include "FitsLoader.h"
+#include "ZScale.h"
 #include <fitsio.h>
 #include <iostream>
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <mutex>
+
+namespace {
+// cfitsio is built without thread support (USE_PTHREADS OFF), so file access from
+// worker threads must not overlap.
+std::mutex g_CfitsioMutex;
+} // namespace
 
 FitsLoader::FitsLoader()
     : m_Width(0)
@@ -11,6 +19,8 @@ FitsLoader::FitsLoader()
     , m_BitDepth(0)
     , m_MinValue(0.0f)
     , m_MaxValue(1.0f)
+    , m_ZScaleLow(0.0f)
+    , m_ZScaleHigh(1.0f)
 {
 }
 
@@ -18,15 +28,26 @@ FitsLoader::~FitsLoader() {
     Unload();
 }
 
+std::mutex& FitsLoader::GetCfitsioMutex() {
+    return g_CfitsioMutex;
+}
+
 void FitsLoader::Unload() {
     m_Data.clear();
+    m_Blank.clear();
     m_Width = 0;
     m_Height = 0;
     m_BitDepth = 0;
+    m_ZScaleLow = 0.0f;
+    m_ZScaleHigh = 1.0f;
+    m_Wcs = Wcs();
 }
 
 bool FitsLoader::LoadFits(const std::string& filepath) {
     Unload();
+
+    // Held for the fits_* calls only; normalization and ZScale run unlocked.
+    std::unique_lock<std::mutex> lock(g_CfitsioMutex);
     
     fitsfile* fptr = nullptr;
     int status = 0;
@@ -91,7 +112,8 @@ bool FitsLoader::LoadFits(const std::string& filepath) {
     m_Data.resize(numPixels);
     
     long fpixel[2] = {1, 1};  // Start from first pixel
-    float nullval = 0.0f;
+    // Integer BLANK pixels come back as NaN, like undefined floating-point ones.
+    float nullval = std::numeric_limits<float>::quiet_NaN();
     int anynull = 0;
     
     if (fits_read_pix(fptr, TFLOAT, fpixel, numPixels, &nullval, 
@@ -103,8 +125,29 @@ bool FitsLoader::LoadFits(const std::string& filepath) {
         return false;
     }
     
+    // Header cards for the WCS; a missing or unsupported WCS is not an error.
+    int keyCount = 0;
+    std::vector<std::string> cards;
+    const bool haveHeader = fits_get_hdrspace(fptr, &keyCount, nullptr, &status) == 0;
+    if (haveHeader) {
+        cards.reserve(static_cast<std::size_t>(keyCount));
+        char card[FLEN_CARD];
+        for (int key = 1; key <= keyCount; key++) {
+            if (fits_read_record(fptr, key, card, &status)) break;
+            cards.emplace_back(card);
+        }
+    }
+    status = 0;
+
     // Close FITS file
     fits_close_file(fptr, &status);
+    lock.unlock();
+
+    if (haveHeader) {
+        std::string message;
+        m_Wcs.Parse(cards, message);
+        std::cout << "  WCS: " << message << std::endl;
+    }
     
     // Find min and max values for normalization
     m_MinValue = std::numeric_limits<float>::max();
@@ -125,16 +168,55 @@ bool FitsLoader::LoadFits(const std::string& filepath) {
         for (float& val : m_Data) {
             if (std::isfinite(val)) {
                 val = (val - m_MinValue) / range;
-            } else {
-                val = 0.0f;
             }
         }
     }
-    
+    MarkBlankPixels();
+    
+    // Display limits that ignore hot pixels and other outliers.
+    ZScale::Compute(0, 0, m_Width - 1, m_Height - 1,
+                    [this](int x, int y) {
+                        return IsBlank(x, y) ? std::numeric_limits<float>::quiet_NaN()
+                                             : m_Data[static_cast<std::size_t>(y) * m_Width + x];
+                    },
+                    ZScale::Params(), m_ZScaleLow, m_ZScaleHigh);
+    std::cout << "  ZScale: [" << m_MinValue + m_ZScaleLow * range << ", " << m_MinValue + m_ZScaleHigh * range
+              << "]" << std::endl;
+
     std::cout << "FITS file loaded successfully" << std::endl;
     return true;
 }
 
+bool FitsLoader::LoadNormalized(std::vector<float> data, int width, int height, const FitsLoader& like,
+                                const Wcs& wcs) {
+    Unload();
+    if (width <= 0 || height <= 0 || data.size() != static_cast<std::size_t>(width) * height) {
+        std::cerr << "Normalized data does not match " << width << "x" << height << std::endl;
+        return false;
+    }
+    m_Data = std::move(data);
+    m_Width = width;
+    m_Height = height;
+    m_BitDepth = like.m_BitDepth;
+    m_MinValue = like.m_MinValue;
+    m_MaxValue = like.m_MaxValue;
+    m_ZScaleLow = like.m_ZScaleLow;
+    m_ZScaleHigh = like.m_ZScaleHigh;
+    m_Wcs = wcs;
+    MarkBlankPixels();
+    return true;
+}
+
+void FitsLoader::MarkBlankPixels() {
+    m_Blank.clear();
+    for (std::size_t i = 0; i < m_Data.size(); i++) {
+        if (std::isfinite(m_Data[i])) continue;
+        if (m_Blank.empty()) m_Blank.assign(m_Data.size(), 0);
+        m_Blank[i] = 1;
+        m_Data[i] = 0.0f;
+    }
+}
+
 float FitsLoader::GetNormalizedPixelValue(int x, int y) const {
     if (!IsLoaded() || x < 0 || x >= m_Width || y < 0 || y >= m_Height) {
         return 0.0f;
@@ -144,6 +226,27 @@ float FitsLoader::GetNormalizedPixelValue(int x, int y) const {
     return m_Data[index];
 }
 
+const float* FitsLoader::GetRow(int y) const {
+    if (!IsLoaded() || y < 0 || y >= m_Height) {
+        return nullptr;
+    }
+    return m_Data.data() + static_cast<std::size_t>(y) * m_Width;
+}
+
+bool FitsLoader::IsBlank(int x, int y) const {
+    if (m_Blank.empty() || x < 0 || x >= m_Width || y < 0 || y >= m_Height) {
+        return false;
+    }
+    return m_Blank[static_cast<std::size_t>(y) * m_Width + x] != 0;
+}
+
+const std::uint8_t* FitsLoader::GetBlankRow(int y) const {
+    if (m_Blank.empty() || y < 0 || y >= m_Height) {
+        return nullptr;
+    }
+    return m_Blank.data() + static_cast<std::size_t>(y) * m_Width;
+}
+
 void FitsLoader::GetPixelColor(int x, int y, float& r, float& g, float& b) const {
     float gray = GetNormalizedPixelValue(x, y);
     r = g = b = gray;
@@ -0,0 +1,318 @@
+#include "FrameStacker.h"
+#include "FitsLoader.h"
+#include "ParallelFor.h"
+
+#include <fitsio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+namespace {
+constexpr int kSkySampleRows = 32;   // rows read per frame to estimate its sky level
+constexpr int kSkySampleStep = 4;    // every n-th pixel of those rows
+constexpr std::size_t kMinPixelsPerWorker = 4096;
+
+std::string StatusText(int status) {
+    char text[FLEN_STATUS];
+    fits_get_errstatus(status, text);
+    return text;
+}
+
+// Structural keywords that cfitsio writes itself for the output image.
+bool IsStructuralCard(const std::string& card) {
+    std::string key = card.substr(0, std::min<std::size_t>(card.size(), 8));
+    key.erase(key.find_last_not_of(' ') + 1);
+    static const char* const kSkipped[] = {"SIMPLE", "XTENSION", "BITPIX",  "EXTEND",   "PCOUNT",  "GCOUNT",
+                                           "BZERO",  "BSCALE",   "BLANK",   "DATAMIN",  "DATAMAX", "CHECKSUM",
+                                           "DATASUM", "NCOMBINE", "END"};
+    if (key.empty() || key.compare(0, 5, "NAXIS") == 0) return true;
+    return std::find_if(std::begin(kSkipped), std::end(kSkipped), [&](const char* k) { return key == k; }) !=
+           std::end(kSkipped);
+}
+
+// Median of values[0, count); reorders them.
+float Median(float* values, int count) {
+    const int mid = count / 2;
+    std::nth_element(values, values + mid, values + count);
+    if (count % 2 == 1) return values[mid];
+    return 0.5f * (values[mid] + *std::max_element(values, values + mid));
+}
+
+// Mean of the values left after iteratively rejecting those further than clipSigma from
+// the median. Sigma is estimated from the median absolute deviation: with a handful of
+// frames a single cosmic ray inflates the plain standard deviation past its own
+// residual. Reorders values; scratch holds count floats.
+float SigmaClippedMean(float* values, float* scratch, int count, float clipSigma, int maxIterations) {
+    for (int iteration = 0; iteration < maxIterations && count > 2; iteration++) {
+        const float center = Median(values, count);
+        for (int i = 0; i < count; i++) scratch[i] = std::abs(values[i] - center);
+        const float sigma = 1.4826f * Median(scratch, count);
+        if (sigma <= 0.0f) break;
+        const float limit = clipSigma * sigma;
+        const int kept = static_cast<int>(
+            std::remove_if(values, values + count, [&](float v) { return std::abs(v - center) > limit; }) - values);
+        if (kept == count) break;
+        count = kept;
+    }
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += values[i];
+    return static_cast<float>(sum / count);
+}
+} // namespace
+
+const char* FrameStacker::GetMethodName(Method method) {
+    return method == Method::SigmaClip ? "sigma-clip" : "median";
+}
+
+FrameStacker::FrameStacker()
+    : m_Cancelled(false)
+    , m_StripsDone(0)
+    , m_StripCount(0)
+{
+}
+
+FrameStacker::~FrameStacker() {
+    Cancel();
+    Wait();
+}
+
+FrameStacker::Result FrameStacker::Run(const std::vector<std::string>& inputs, const std::string& output,
+                                       const Params& params) {
+    const auto start = std::chrono::steady_clock::now();
+    Result result;
+    result.frames = static_cast<int>(inputs.size());
+    m_StripsDone = 0;
+    m_StripCount = 0;
+    auto fail = [&](const std::string& message) {
+        result.message = message;
+        std::cerr << "Stacking failed: " << message << std::endl;
+        return result;
+    };
+    if (inputs.size() < 2) return fail("needs at least two frames");
+    if (output.empty()) return fail("no output path");
+
+    std::mutex& cfitsio = FitsLoader::GetCfitsioMutex();
+    std::vector<fitsfile*> files(inputs.size(), nullptr);
+    fitsfile* out = nullptr;
+    bool keepOutput = false;
+    // Closes everything on every exit path; a failed output is deleted.
+    struct Closer {
+        std::function<void()> close;
+        ~Closer() { close(); }
+    } closer{[&]() {
+        std::lock_guard<std::mutex> lock(cfitsio);
+        int status = 0;
+        for (fitsfile* file : files) {
+            if (file) fits_close_file(file, &status);
+            status = 0;
+        }
+        if (out) keepOutput ? fits_close_file(out, &status) : fits_delete_file(out, &status);
+    }};
+
+    // Open every frame and check that they share one pixel grid.
+    std::vector<std::string> cards;
+    long naxes[2] = {0, 0};
+    {
+        std::lock_guard<std::mutex> lock(cfitsio);
+        for (std::size_t f = 0; f < inputs.size(); f++) {
+            int status = 0;
+            int naxis = 0;
+            long size[2] = {0, 0};
+            if (fits_open_file(&files[f], inputs[f].c_str(), READONLY, &status) ||
+                fits_get_img_dim(files[f], &naxis, &status) || naxis != 2 ||
+                fits_get_img_size(files[f], 2, size, &status)) {
+                return fail(inputs[f] + ": " + (status ? StatusText(status) : "not a 2D image"));
+            }
+            if (f == 0) {
+                naxes[0] = size[0];
+                naxes[1] = size[1];
+                int keyCount = 0;
+                if (fits_get_hdrspace(files[f], &keyCount, nullptr, &status) == 0) {
+                    char card[FLEN_CARD];
+                    for (int key = 1; key <= keyCount; key++) {
+                        if (fits_read_record(files[f], key, card, &status)) break;
+                        if (!IsStructuralCard(card)) cards.emplace_back(card);
+                    }
+                }
+            } else if (size[0] != naxes[0] || size[1] != naxes[1]) {
+                return fail(inputs[f] + " is " + std::to_string(size[0]) + "x" + std::to_string(size[1]) +
+                            ", expected " + std::to_string(naxes[0]) + "x" + std::to_string(naxes[1]) +
+                            " (frames must be registered onto one grid)");
+            }
+        }
+    }
+    const int width = static_cast<int>(naxes[0]);
+    const int height = static_cast<int>(naxes[1]);
+    const int frames = static_cast<int>(files.size());
+    result.width = width;
+    result.height = height;
+    if (width <= 0 || height <= 0) return fail("empty image");
+
+    // Blank pixels come back as NaN and are left out of the combine.
+    const float blank = std::numeric_limits<float>::quiet_NaN();
+    auto readRows = [&](int f, int y0, int rows, float* destination) {
+        std::lock_guard<std::mutex> lock(cfitsio);
+        long first[2] = {1, static_cast<long>(y0) + 1};
+        float nullValue = blank;
+        int anyNull = 0;
+        int status = 0;
+        fits_read_pix(files[f], TFLOAT, first, static_cast<long long>(rows) * width, &nullValue, destination,
+                      &anyNull, &status);
+        return status;
+    };
+
+    // Sky offsets from a few rows per frame, so epochs taken through different sky
+    // brightness do not bias the combine.
+    std::vector<float> offsets(files.size(), 0.0f);
+    if (params.matchBackground) {
+        std::vector<float> row(static_cast<std::size_t>(width));
+        std::vector<float> samples;
+        for (int f = 0; f < frames; f++) {
+            samples.clear();
+            for (int i = 0; i < kSkySampleRows; i++) {
+                const int y = std::min(static_cast<int>((i + 0.5) * height / kSkySampleRows), height - 1);
+                if (const int status = readRows(f, y, 1, row.data())) return fail(inputs[f] + ": " + StatusText(status));
+                for (int x = 0; x < width; x += kSkySampleStep) {
+                    if (std::isfinite(row[x])) samples.push_back(row[x]);
+                }
+            }
+            offsets[f] = samples.empty() ? 0.0f : Median(samples.data(), static_cast<int>(samples.size()));
+        }
+        for (int f = frames - 1; f >= 0; f--) offsets[f] = offsets[0] - offsets[f];
+    }
+
+    // Two input strips (one being combined, one being read) plus the combined rows.
+    const std::size_t rowBytes = static_cast<std::size_t>(width) * sizeof(float) * (2 * frames + 1);
+    const int stripRows = static_cast<int>(std::clamp<std::size_t>(params.memoryBudgetBytes / rowBytes, 1, height));
+    const int stripCount = (height + stripRows - 1) / stripRows;
+    const std::size_t stripPixels = static_cast<std::size_t>(stripRows) * width;
+    result.stripRows = stripRows;
+    result.bufferBytes = rowBytes * stripRows;
+    m_StripCount = stripCount;
+
+    {
+        std::lock_guard<std::mutex> lock(cfitsio);
+        int status = 0;
+        const std::string target = "!" + output; // '!' overwrites an existing file
+        if (fits_create_file(&out, target.c_str(), &status) ||
+            fits_create_img(out, FLOAT_IMG, 2, naxes, &status)) {
+            return fail(output + ": " + StatusText(status));
+        }
+        for (const std::string& card : cards) {
+            fits_write_record(out, card.c_str(), &status);
+        }
+        int combined = frames;
+        char method[FLEN_VALUE];
+        std::snprintf(method, sizeof(method), "%s", GetMethodName(params.method));
+        fits_update_key(out, TINT, "NCOMBINE", &combined, "number of frames stacked", &status);
+        fits_update_key(out, TSTRING, "COMBINE", method, "stacking method", &status);
+        for (const std::string& input : inputs) {
+            const std::string history = "stacked " + input.substr(input.find_last_of("/\\") + 1);
+            fits_write_history(out, history.c_str(), &status);
+        }
+        if (status) return fail(output + ": " + StatusText(status));
+    }
+
+    std::vector<float> buffers[2];
+    buffers[0].resize(stripPixels * frames);
+    buffers[1].resize(stripPixels * frames);
+    std::vector<float> combined(stripPixels);
+
+    // Returns an error message, empty on success.
+    auto readStrip = [&](int strip, std::vector<float>* buffer) -> std::string {
+        const int y0 = strip * stripRows;
+        const int rows = std::min(stripRows, height - y0);
+        for (int f = 0; f < frames; f++) {
+            if (const int status = readRows(f, y0, rows, buffer->data() + f * stripPixels)) {
+                return inputs[f] + ": " + StatusText(status);
+            }
+        }
+        return std::string();
+    };
+
+    std::future<std::string> pending = std::async(std::launch::async, readStrip, 0, &buffers[0]);
+    for (int strip = 0; strip < stripCount; strip++) {
+        const std::string error = pending.get();
+        if (!error.empty()) return fail(error);
+        if (m_Cancelled) return fail("cancelled");
+        if (strip + 1 < stripCount) {
+            pending = std::async(std::launch::async, readStrip, strip + 1, &buffers[(strip + 1) % 2]);
+        }
+
+        const int y0 = strip * stripRows;
+        const int rows = std::min(stripRows, height - y0);
+        const float* strips = buffers[strip % 2].data();
+        ParallelForRanges(static_cast<std::size_t>(rows) * width, kMinPixelsPerWorker,
+                          [&](std::size_t begin, std::size_t end, unsigned int) {
+            std::vector<float> values(static_cast<std::size_t>(frames));
+            std::vector<float> scratch(static_cast<std::size_t>(frames));
+            for (std::size_t i = begin; i < end; i++) {
+                int count = 0;
+                for (int f = 0; f < frames; f++) {
+                    const float v = strips[f * stripPixels + i];
+                    if (std::isfinite(v)) values[count++] = v + offsets[f];
+                }
+                if (count == 0) {
+                    combined[i] = blank;
+                } else if (params.method == Method::SigmaClip) {
+                    combined[i] = SigmaClippedMean(values.data(), scratch.data(), count, params.clipSigma, params.maxIterations);
+                } else {
+                    combined[i] = Median(values.data(), count);
+                }
+            }
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(cfitsio);
+            long first[2] = {1, static_cast<long>(y0) + 1};
+            int status = 0;
+            if (fits_write_pix(out, TFLOAT, first, static_cast<long long>(rows) * width, combined.data(), &status)) {
+                if (pending.valid()) pending.wait();
+                return fail(output + ": " + StatusText(status));
+            }
+        }
+        m_StripsDone++;
+    }
+
+    keepOutput = true;
+    result.ok = true;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.message = std::to_string(frames) + " frames, " + GetMethodName(params.method) + ", " +
+                     std::to_string(stripCount) + " strips of " + std::to_string(stripRows) + " rows";
+    std::cout << "Stacked " << output << ": " << result.message << ", "
+              << result.bufferBytes / (1024 * 1024) << " MB buffers, " << result.seconds << " s" << std::endl;
+    return result;
+}
+
+bool FrameStacker::Start(std::vector<std::string> inputs, std::string output, Params params) {
+    if (m_Run.valid()) return false;
+
+    m_Cancelled = false;
+    m_Result = Result();
+    m_Run = std::async(std::launch::async,
+                       [this, inputs = std::move(inputs), output = std::move(output), params]() {
+                           return Run(inputs, output, params);
+                       });
+    return true;
+}
+
+void FrameStacker::Cancel() {
+    m_Cancelled = true;
+}
+
+void FrameStacker::Wait() {
+    if (m_Run.valid()) m_Run.wait();
+}
+
+bool FrameStacker::Poll() {
+    if (!m_Run.valid() || m_Run.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+    m_Result = m_Run.get();
+    return true;
+}
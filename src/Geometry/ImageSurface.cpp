@@ -0,0 +1,163 @@
+#include "Geometry/ImageSurface.h"
+#include "Shader.h"
+#include <glad/glad.h>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+struct SurfaceVertex {
+    float x, y, z;
+    float u, v;
+};
+} // namespace
+
+ImageSurface::ImageSurface()
+    : GeometryObject(GeometryType::Surface)
+    , m_GridWidth(0)
+    , m_GridHeight(0)
+    , m_ChunkSize(0.0f)
+    , m_Texture(0)
+{
+}
+
+ImageSurface::~ImageSurface() {
+    if (m_Texture != 0) glDeleteTextures(1, &m_Texture);
+}
+
+void ImageSurface::SetGrid(int gridWidth, int gridHeight,
+                           const std::vector<glm::vec3>& positions,
+                           const std::vector<glm::vec2>& texCoords) {
+    m_GridWidth = gridWidth;
+    m_GridHeight = gridHeight;
+    m_Positions = positions;
+    m_TexCoords = texCoords;
+    m_TexCoords.resize(m_Positions.size(), glm::vec2(0.0f));
+}
+
+void ImageSurface::SetTexture(unsigned int texture) {
+    if (m_Texture != 0 && m_Texture != texture) glDeleteTextures(1, &m_Texture);
+    m_Texture = texture;
+}
+
+void ImageSurface::Initialize() {
+    m_Chunks.clear();
+    if (m_GridWidth < 2 || m_GridHeight < 2 ||
+        m_Positions.size() != static_cast<size_t>(m_GridWidth) * m_GridHeight) {
+        return;
+    }
+
+    std::vector<SurfaceVertex> vertices;
+    vertices.reserve(m_Positions.size());
+    for (size_t i = 0; i < m_Positions.size(); i++) {
+        const auto& p = m_Positions[i];
+        const auto& t = m_TexCoords[i];
+        vertices.push_back(SurfaceVertex{p.x, p.y, p.z, t.x, t.y});
+    }
+
+    // Bucket grid cells by the tile containing the cell center, then lay the
+    // index buffer out chunk by chunk so each tile is one contiguous range.
+    std::unordered_map<std::int64_t, int> lookup;
+    std::vector<std::vector<unsigned int>> chunkIndices;
+    for (int j = 0; j + 1 < m_GridHeight; j++) {
+        for (int i = 0; i + 1 < m_GridWidth; i++) {
+            const unsigned int i00 = static_cast<unsigned int>(j * m_GridWidth + i);
+            const unsigned int i10 = i00 + 1;
+            const unsigned int i01 = i00 + static_cast<unsigned int>(m_GridWidth);
+            const unsigned int i11 = i01 + 1;
+
+            const glm::vec3 center = (m_Positions[i00] + m_Positions[i11]) * 0.5f;
+            int tileX = 0;
+            int tileZ = 0;
+            if (m_ChunkSize > 0.0f) {
+                tileX = static_cast<int>(std::floor(center.x / m_ChunkSize));
+                tileZ = static_cast<int>(std::floor(center.z / m_ChunkSize));
+            }
+            const std::int64_t key = (static_cast<std::int64_t>(tileX) << 32) ^ static_cast<std::uint32_t>(tileZ);
+
+            auto it = lookup.find(key);
+            if (it == lookup.end()) {
+                it = lookup.emplace(key, static_cast<int>(m_Chunks.size())).first;
+                m_Chunks.push_back(Chunk{0, 0, tileX, tileZ, true});
+                chunkIndices.emplace_back();
+            }
+
+            auto& idx = chunkIndices[it->second];
+            idx.insert(idx.end(), {i00, i01, i10, i10, i01, i11});
+        }
+    }
+
+    std::vector<unsigned int> indices;
+    for (size_t c = 0; c < m_Chunks.size(); c++) {
+        m_Chunks[c].firstIndex = static_cast<int>(indices.size());
+        m_Chunks[c].indexCount = static_cast<int>(chunkIndices[c].size());
+        indices.insert(indices.end(), chunkIndices[c].begin(), chunkIndices[c].end());
+    }
+
+    if (m_VAO != 0) glDeleteVertexArrays(1, &m_VAO);
+    if (m_VBO != 0) glDeleteBuffers(1, &m_VBO);
+    if (m_EBO != 0) glDeleteBuffers(1, &m_EBO);
+
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+
+    glBindVertexArray(m_VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(SurfaceVertex), vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    // Position attribute (location = 0)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SurfaceVertex), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Texture coordinate attribute (location = 1)
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SurfaceVertex), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+
+    m_VertexCount = static_cast<unsigned int>(vertices.size());
+    m_IndexCount = static_cast<unsigned int>(indices.size());
+
+    std::cout << "ImageSurface initialized with " << m_GridWidth << "x" << m_GridHeight
+              << " vertices in " << m_Chunks.size() << " chunk(s)" << std::endl;
+}
+
+void ImageSurface::SetChunkVisible(size_t index, bool visible) {
+    if (index >= m_Chunks.size()) return;
+    m_Chunks[index].visible = visible;
+}
+
+void ImageSurface::SetAllChunksVisible(bool visible) {
+    for (auto& chunk : m_Chunks) {
+        chunk.visible = visible;
+    }
+}
+
+void ImageSurface::Render(Shader* shader) {
+    if (m_IndexCount == 0 || m_Texture == 0) return;
+
+    m_DrawCounts.clear();
+    m_DrawOffsets.clear();
+    for (const auto& chunk : m_Chunks) {
+        if (!chunk.visible || chunk.indexCount == 0) continue;
+        m_DrawCounts.push_back(chunk.indexCount);
+        m_DrawOffsets.push_back(reinterpret_cast<const void*>(static_cast<std::uintptr_t>(chunk.firstIndex) * sizeof(unsigned int)));
+    }
+    if (m_DrawCounts.empty()) return;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_Texture);
+    if (shader) shader->SetInt("imageTexture", 0);
+
+    glBindVertexArray(m_VAO);
+    glMultiDrawElements(GL_TRIANGLES, m_DrawCounts.data(), GL_UNSIGNED_INT, m_DrawOffsets.data(),
+                        static_cast<GLsizei>(m_DrawCounts.size()));
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
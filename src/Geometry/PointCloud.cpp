@@ -2,27 +2,138 @@
 #include "Shader.h"
 #include <glad/glad.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <random>
+#include <unordered_map>
 
 namespace {
 struct PackedVertex {
     float x, y, z;
     std::uint8_t r, g, b, a;
+    std::uint8_t group;
+    std::uint8_t pad[3];
 };
 
 static std::uint8_t ToU8(float v) {
     v = std::clamp(v, 0.0f, 1.0f);
     return static_cast<std::uint8_t>(v * 255.0f + 0.5f);
 }
+
+static PackedVertex PackVertex(const glm::vec3& p, const glm::vec4& c, std::uint8_t group) {
+    return PackedVertex{
+        p.x, p.y, p.z,
+        ToU8(c.r), ToU8(c.g), ToU8(c.b), ToU8(c.a),
+        group, {0, 0, 0},
+    };
+}
+
+// Upload order of the points: pinned points (group > 0) first, ordered by group, then
+// the rest grouped by XZ tile (chunkSize <= 0 means a single chunk). Inside each chunk the
+// order is a fixed pseudo-random shuffle, so drawing only the first part of a chunk
+// (see SetDrawBudget) thins it evenly instead of cutting off rows. order[slot] is the
+// index of the point stored at that vertex slot.
+static void BuildDrawOrder(const std::vector<glm::vec3>& positions,
+                           const std::vector<std::uint8_t>& groups,
+                           float chunkSize,
+                           std::vector<int>& order,
+                           std::vector<PointCloud::Chunk>& chunks,
+                           int& pinnedCount) {
+    order.clear();
+    chunks.clear();
+    pinnedCount = 0;
+    if (positions.empty()) return;
+
+    auto groupOf = [&](size_t i) -> std::uint8_t {
+        if (i >= groups.size()) return 0;
+        return std::min<std::uint8_t>(groups[i], PointCloud::kMaxPointGroups - 1);
+    };
+
+    std::vector<int> chunkOf(positions.size(), -1);
+    std::unordered_map<std::int64_t, int> lookup;
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        if (groupOf(i) != 0) {
+            pinnedCount++;
+            continue;
+        }
+        const auto& p = positions[i];
+        int tileX = 0;
+        int tileZ = 0;
+        if (chunkSize > 0.0f) {
+            tileX = static_cast<int>(std::floor(p.x / chunkSize));
+            tileZ = static_cast<int>(std::floor(p.z / chunkSize));
+        }
+        const std::int64_t key = (static_cast<std::int64_t>(tileX) << 32) ^ static_cast<std::uint32_t>(tileZ);
+
+        auto it = lookup.find(key);
+        if (it == lookup.end()) {
+            it = lookup.emplace(key, static_cast<int>(chunks.size())).first;
+            chunks.push_back(PointCloud::Chunk{0, 0, tileX, tileZ, p, p, true});
+        }
+
+        PointCloud::Chunk& chunk = chunks[it->second];
+        chunk.count++;
+        chunk.boundsMin = glm::min(chunk.boundsMin, p);
+        chunk.boundsMax = glm::max(chunk.boundsMax, p);
+        chunkOf[i] = it->second;
+    }
+
+    std::vector<int> cursor(chunks.size());
+    int first = pinnedCount;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        chunks[c].first = first;
+        cursor[c] = first;
+        first += chunks[c].count;
+    }
+
+    order.resize(positions.size());
+    int pinnedCursor = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        const int slot = (groupOf(i) != 0) ? pinnedCursor++ : cursor[chunkOf[i]]++;
+        order[slot] = static_cast<int>(i);
+    }
+    std::stable_sort(order.begin(), order.begin() + pinnedCount,
+                     [&](int a, int b) { return groupOf(a) < groupOf(b); });
+
+    std::mt19937 rng(0x5eed1234u);
+    for (const auto& chunk : chunks) {
+        std::shuffle(order.begin() + chunk.first, order.begin() + chunk.first + chunk.count, rng);
+    }
+}
+
+static void PackVertices(const std::vector<glm::vec3>& positions,
+                         const std::vector<glm::vec4>& colors,
+                         const std::vector<std::uint8_t>& groups,
+                         const std::vector<int>& order,
+                         std::vector<PackedVertex>& vertices) {
+    vertices.resize(order.size());
+    for (size_t slot = 0; slot < order.size(); slot++) {
+        const int i = order[slot];
+        const std::uint8_t group = (static_cast<size_t>(i) < groups.size())
+            ? std::min<std::uint8_t>(groups[i], PointCloud::kMaxPointGroups - 1) : 0;
+        vertices[slot] = PackVertex(positions[i], colors[i], group);
+    }
+}
+
+// Thinned clouds get larger points so surface coverage stays roughly constant.
+constexpr float kMaxBudgetPointSizeScale = 3.0f;
 } // namespace
 
 PointCloud::PointCloud()
     : GeometryObject(GeometryType::Point)
     , m_PointSize(5.0f)
     , m_PointCount(0)
+    , m_DrawBudget(-1)
     , m_NeedsUpdate(false)
+    , m_PinnedCount(0)
+    , m_ChunkSize(0.0f)
+    , m_ActivePointCount(0)
 {
+    for (int i = 0; i < kMaxPointGroups; i++) {
+        m_GroupPointSizeScale[i] = 1.0f;
+    }
 }
 
 PointCloud::~PointCloud() {
@@ -36,20 +147,11 @@ void PointCloud::Initialize() {
     // Create interleaved vertex data:
     // position: 3 * float (12B)
     // color:    4 * uint8 normalized (4B)
-    // Total ~16B/point (vs previous 28B/point with vec4 floats)
+    // group:    1 * uint8 + 3B padding (4B)
+    // Total 20B/point (vs previous 28B/point with vec4 floats)
+    PrepareChunks();
     std::vector<PackedVertex> vertices;
-    vertices.reserve(m_Positions.size());
-
-    for (size_t i = 0; i < m_Positions.size(); i++) {
-        const auto& p = m_Positions[i];
-        const auto& c = m_Colors[i];
-        vertices.push_back(PackedVertex{
-            p.x, p.y, p.z,
-            ToU8(c.r), ToU8(c.g), ToU8(c.b), ToU8(c.a),
-        });
-    }
-
-    m_PointCount = static_cast<int>(m_Positions.size());
+    PackVertices(m_Positions, m_Colors, m_Groups, m_DrawOrder, vertices);
 
     // Clean up old buffers if they exist
     if (m_VAO != 0) glDeleteVertexArrays(1, &m_VAO);
@@ -71,12 +173,17 @@ void PointCloud::Initialize() {
     glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
+    // Point group attribute (location = 2), integer
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(PackedVertex), (void*)(3 * sizeof(float) + 4));
+    glEnableVertexAttribArray(2);
+
     glBindVertexArray(0);
 
     m_VertexCount = m_PointCount;
     m_NeedsUpdate = false;
 
-    std::cout << "PointCloud initialized with " << m_PointCount << " points" << std::endl;
+    std::cout << "PointCloud initialized with " << m_PointCount << " points in "
+              << m_Chunks.size() << " chunk(s), " << m_PinnedCount << " pinned" << std::endl;
 }
 
 void PointCloud::Update(float deltaTime) {
@@ -85,14 +192,100 @@ void PointCloud::Update(float deltaTime) {
     }
 }
 
+void PointCloud::PrepareChunks() {
+    BuildDrawOrder(m_Positions, m_Groups, m_ChunkSize, m_DrawOrder, m_Chunks, m_PinnedCount);
+    m_PointCount = static_cast<int>(m_Positions.size());
+    m_ActivePointCount = m_PointCount - m_PinnedCount;
+}
+
+int PointCloud::GetDrawCount() const {
+    if (m_DrawBudget < 0) return m_ActivePointCount;
+    return std::clamp(m_DrawBudget, 0, m_ActivePointCount);
+}
+
+void PointCloud::SetChunkVisible(size_t index, bool visible) {
+    if (index >= m_Chunks.size()) return;
+    Chunk& chunk = m_Chunks[index];
+    if (chunk.visible == visible) return;
+    chunk.visible = visible;
+    m_ActivePointCount += visible ? chunk.count : -chunk.count;
+}
+
+void PointCloud::SetAllChunksVisible(bool visible) {
+    for (size_t i = 0; i < m_Chunks.size(); i++) {
+        SetChunkVisible(i, visible);
+    }
+}
+
+void PointCloud::SetPointGroups(const std::vector<std::uint8_t>& groups) {
+    m_Groups = groups;
+    m_NeedsUpdate = true;
+}
+
+void PointCloud::SetGroupPointSizeScale(int group, float scale) {
+    if (group <= 0 || group >= kMaxPointGroups) return;
+    m_GroupPointSizeScale[group] = scale;
+}
+
+float PointCloud::GetGroupPointSizeScale(int group) const {
+    if (group < 0 || group >= kMaxPointGroups) return 1.0f;
+    return m_GroupPointSizeScale[group];
+}
+
+bool PointCloud::BuildDrawRanges(std::vector<int>& firsts, std::vector<int>& counts, float* groupSizes) const {
+    firsts.clear();
+    counts.clear();
+    const int drawCount = GetDrawCount();
+    if (drawCount == 0 && m_PinnedCount == 0) return false;
+
+    // Pinned points are one range at the front; every visible chunk draws the same
+    // leading fraction of its (shuffled) points.
+    const double fraction = (m_ActivePointCount > 0)
+        ? static_cast<double>(drawCount) / static_cast<double>(m_ActivePointCount)
+        : 1.0;
+    if (m_PinnedCount > 0) {
+        firsts.push_back(0);
+        counts.push_back(m_PinnedCount);
+    }
+    for (const auto& chunk : m_Chunks) {
+        if (drawCount == 0) break;
+        if (!chunk.visible || chunk.count == 0) continue;
+        int count = chunk.count;
+        if (fraction < 1.0) {
+            count = std::clamp(static_cast<int>(std::ceil(chunk.count * fraction)), 1, chunk.count);
+        }
+        firsts.push_back(chunk.first);
+        counts.push_back(count);
+    }
+    if (firsts.empty()) return false;
+
+    // Per-group sizes; the shader picks one per vertex, so all groups go out in one draw.
+    groupSizes[0] = m_PointSize;
+    if (fraction < 1.0) {
+        const float coverage = static_cast<float>(std::sqrt(1.0 / fraction));
+        groupSizes[0] *= std::min(coverage, kMaxBudgetPointSizeScale);
+    }
+    for (int i = 1; i < kMaxPointGroups; i++) {
+        groupSizes[i] = m_PointSize * m_GroupPointSizeScale[i];
+    }
+    return true;
+}
+
 void PointCloud::Render(Shader* shader) {
-    if (m_PointCount == 0) return;
+    float groupSizes[kMaxPointGroups];
+    if (!BuildDrawRanges(m_DrawFirsts, m_DrawCounts, groupSizes)) return;
 
-    glPointSize(m_PointSize);
+    // Without the shader the per-group uniform is never set; draw at the base size instead.
+    if (shader) {
+        shader->SetFloatArray("groupPointSize", groupSizes, kMaxPointGroups);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+    } else {
+        glPointSize(groupSizes[0]);
+    }
     glBindVertexArray(m_VAO);
-    glDrawArrays(GL_POINTS, 0, m_PointCount);
+    glMultiDrawArrays(GL_POINTS, m_DrawFirsts.data(), m_DrawCounts.data(), static_cast<GLsizei>(m_DrawFirsts.size()));
     glBindVertexArray(0);
-    glPointSize(1.0f);
+    if (shader) glDisable(GL_PROGRAM_POINT_SIZE);
 }
 
 void PointCloud::SetPointData(const std::vector<glm::vec3>& positions, 
@@ -114,19 +307,9 @@ void PointCloud::UpdateBuffers() {
     }
 
     // Update existing buffer data
+    PrepareChunks();
     std::vector<PackedVertex> vertices;
-    vertices.reserve(m_Positions.size());
-
-    for (size_t i = 0; i < m_Positions.size(); i++) {
-        const auto& p = m_Positions[i];
-        const auto& c = m_Colors[i];
-        vertices.push_back(PackedVertex{
-            p.x, p.y, p.z,
-            ToU8(c.r), ToU8(c.g), ToU8(c.b), ToU8(c.a),
-        });
-    }
-
-    m_PointCount = static_cast<int>(m_Positions.size());
+    PackVertices(m_Positions, m_Colors, m_Groups, m_DrawOrder, vertices);
 
     if (m_VBO != 0) {
         glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
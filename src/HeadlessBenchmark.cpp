@@ -0,0 +1,229 @@
+#include "HeadlessBenchmark.h"
+#include "HeadlessContext.h"
+#include "CpuPointRasterizer.h"
+#include "Renderer.h"
+#include "Camera.h"
+#include "ImageLoader.h"
+#include "Geometry/PointCloud.h"
+#include "Data/TxtTargetParser.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+int RunHeadlessBenchmark(const std::string& imagePath, int frames, int width, int height) {
+    frames = std::max(frames, 1);
+
+    HeadlessContext context;
+    if (!context.Initialize(width, height)) {
+        return -1;
+    }
+
+    Renderer renderer;
+    if (!renderer.Initialize()) {
+        std::cerr << "Failed to initialize renderer" << std::endl;
+        return -1;
+    }
+
+    ImageLoader imageLoader;
+    if (!imageLoader.LoadImage(imagePath)) {
+        std::cerr << "Failed to load image: " << imagePath << std::endl;
+        return -1;
+    }
+
+    // Same pixel -> world mapping as Application::LoadImageAndGeneratePointsInternal.
+    const float scaleX = 0.1f;
+    const float scaleY = 10.0f;
+    const float scaleZ = 0.1f;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec4> colors;
+    imageLoader.GeneratePointCloudWithColors(positions, colors, scaleX, scaleY, scaleZ);
+
+    PointCloud cloud;
+    cloud.SetPointData(positions, colors);
+    cloud.SetPointSize(3.0f);
+    cloud.Initialize();
+
+    const float imageWidth = imageLoader.GetWidth() * scaleX;
+    const float imageDepth = imageLoader.GetHeight() * scaleZ;
+    Camera camera(45.0f, context.GetAspectRatio());
+    camera.FrameView(std::sqrt(imageWidth * imageWidth + imageDepth * imageDepth));
+
+    std::vector<double> frameMs;
+    frameMs.reserve(frames);
+    for (int i = 0; i < frames; i++) {
+        // Orbit so every frame sees a different view, like an interactive session.
+        camera.Orbit(360.0f / frames, 0.0f);
+
+        const auto start = std::chrono::steady_clock::now();
+        renderer.BeginFrame();
+        context.Bind();
+        renderer.Clear();
+        renderer.RenderPointCloud(&cloud, &camera);
+        renderer.EndFrame();
+        glFinish();
+        const auto end = std::chrono::steady_clock::now();
+
+        frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : frameMs) total += ms;
+    auto percentile = [&](double q) {
+        const std::size_t idx = static_cast<std::size_t>(q * (sorted.size() - 1));
+        return sorted[idx];
+    };
+
+    std::cout << "Headless benchmark: " << imagePath << " (" << cloud.GetPointCount() << " points, "
+              << width << "x" << height << ", " << context.GetBackendName() << ")" << std::endl;
+    std::cout << "frames=" << frames
+              << " mean_ms=" << total / frameMs.size()
+              << " p50_ms=" << percentile(0.5)
+              << " p95_ms=" << percentile(0.95)
+              << " max_ms=" << sorted.back() << std::endl;
+
+    // One more frame through both backends, compared pixel for pixel. The FBO is not
+    // multisampled, so the only expected differences are depth ties and rounding.
+    const glm::vec4 clearColor(0.95f, 0.95f, 0.95f, 1.0f);
+    std::vector<unsigned char> glPixels;
+    context.Bind();
+    renderer.Clear(clearColor);
+    renderer.RenderPointCloud(&cloud, &camera);
+    context.ReadPixels(glPixels);
+
+    CpuPointRasterizer rasterizer;
+    rasterizer.Resize(width, height);
+    const auto cpuStart = std::chrono::steady_clock::now();
+    rasterizer.Clear(clearColor);
+    rasterizer.DrawPointCloud(cloud, camera);
+    const double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - cpuStart).count();
+    const std::vector<unsigned char>& cpuPixels = rasterizer.GetColorBuffer();
+
+    std::size_t mismatched = 0;
+    int maxDiff = 0;
+    const std::size_t pixelCount = std::min(glPixels.size(), cpuPixels.size()) / 4;
+    for (std::size_t p = 0; p < pixelCount; p++) {
+        int diff = 0;
+        for (int c = 0; c < 3; c++) {
+            diff = std::max(diff, std::abs(static_cast<int>(glPixels[p * 4 + c]) - static_cast<int>(cpuPixels[p * 4 + c])));
+        }
+        if (diff > 1) mismatched++;
+        maxDiff = std::max(maxDiff, diff);
+    }
+    std::cout << "cpu_raster_ms=" << cpuMs
+              << " mismatched_pixels=" << mismatched << "/" << pixelCount
+              << " (" << (pixelCount > 0 ? 100.0 * mismatched / pixelCount : 0.0) << "%)"
+              << " max_channel_diff=" << maxDiff << std::endl;
+
+    renderer.Shutdown();
+    return 0;
+}
+
+namespace {
+bool SameRecords(const std::vector<TxtTargetRecord>& a, const std::vector<TxtTargetRecord>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        const TxtTargetRecord& x = a[i];
+        const TxtTargetRecord& y = b[i];
+        if (x.index != y.index || x.fileDir != y.fileDir || x.alignedFilename != y.alignedFilename ||
+            x.templateAlignedFilename != y.templateAlignedFilename || x.hasPixelCenter != y.hasPixelCenter ||
+            x.pixelX != y.pixelX || x.pixelY != y.pixelY || x.hasRaDec != y.hasRaDec ||
+            std::abs(x.ra - y.ra) > 1e-9 || std::abs(x.dec - y.dec) > 1e-9) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Header of the source file with Total Records updated, then its data rows repeated.
+bool WriteReplicatedTxt(const std::string& sourcePath, std::size_t rows, const std::filesystem::path& outPath) {
+    std::ifstream in(sourcePath);
+    if (!in.is_open()) return false;
+
+    std::vector<std::string> header;
+    std::vector<std::string> data;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            if (data.empty()) header.push_back(line);
+        } else {
+            data.push_back(line);
+        }
+    }
+    if (data.empty()) return false;
+
+    std::ofstream out(outPath, std::ios::binary);
+    if (!out.is_open()) return false;
+    for (const auto& h : header) {
+        if (h.rfind("# Total Records:", 0) == 0) out << "# Total Records: " << rows << "\n";
+        else out << h << "\n";
+    }
+    for (std::size_t i = 0; i < rows; i++) out << data[i % data.size()] << "\n";
+    return static_cast<bool>(out);
+}
+} // namespace
+
+int RunTxtParseBenchmark(const std::string& txtPath, int iterations, std::size_t replicateRows) {
+    iterations = std::max(iterations, 1);
+
+    std::filesystem::path path(txtPath);
+    std::filesystem::path tempPath;
+    if (replicateRows > 0) {
+        tempPath = std::filesystem::temp_directory_path() / "geogebra3d_txt_parse_bench.txt";
+        if (!WriteReplicatedTxt(txtPath, replicateRows, tempPath)) {
+            std::cerr << "Failed to build replicated txt from " << txtPath << std::endl;
+            return -1;
+        }
+        path = tempPath;
+    }
+
+    std::error_code ec;
+    const auto fileBytes = std::filesystem::file_size(path, ec);
+    if (ec) {
+        std::cerr << "Cannot read " << path << std::endl;
+        return -1;
+    }
+
+    auto timeParser = [&](auto&& parse, std::vector<TxtTargetRecord>& records) {
+        std::vector<double> ms;
+        for (int i = 0; i < iterations; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            parse(records);
+            ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(ms.begin(), ms.end());
+        return ms[ms.size() / 2];
+    };
+
+    std::string err;
+    std::vector<TxtTargetRecord> streamRecords;
+    std::vector<TxtTargetRecord> mappedRecords;
+    TxtParseReport report;
+    const double streamMs = timeParser([&](std::vector<TxtTargetRecord>& out) {
+        ParseTxtTargetFileStream(path, out, err);
+    }, streamRecords);
+    const double mappedMs = timeParser([&](std::vector<TxtTargetRecord>& out) {
+        ParseTxtTargetFile(path, out, err, &report);
+    }, mappedRecords);
+
+    const double mb = fileBytes / (1024.0 * 1024.0);
+    std::cout << "Txt parse benchmark: " << path << " (" << mb << " MB, " << mappedRecords.size()
+              << " records, median of " << iterations << ")" << std::endl;
+    std::cout << "stream_ms=" << streamMs << " (" << (streamMs > 0.0 ? mb / (streamMs / 1000.0) : 0.0) << " MB/s)"
+              << " mapped_ms=" << mappedMs << " (" << (mappedMs > 0.0 ? mb / (mappedMs / 1000.0) : 0.0) << " MB/s)"
+              << " speedup=" << (mappedMs > 0.0 ? streamMs / mappedMs : 0.0) << "x" << std::endl;
+    std::cout << "malformed_lines=" << report.malformedLines << " issues=" << report.issues.size() << std::endl;
+
+    const bool same = SameRecords(streamRecords, mappedRecords);
+    if (!same) std::cerr << "Parsers disagree on " << path << std::endl;
+
+    if (!tempPath.empty()) std::filesystem::remove(tempPath, ec);
+    return same ? 0 : -1;
+}
@@ -0,0 +1,260 @@
+#include "HeadlessContext.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+
+#ifdef GEOGEBRA3D_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext()
+    : m_Width(0)
+    , m_Height(0)
+    , m_BackendName("")
+    , m_EglDisplay(nullptr)
+    , m_EglContext(nullptr)
+    , m_GlfwWindow(nullptr)
+    , m_Framebuffer(0)
+    , m_ColorBuffer(0)
+    , m_DepthBuffer(0)
+{
+}
+
+HeadlessContext::~HeadlessContext() {
+    Shutdown();
+}
+
+bool HeadlessContext::Initialize(int width, int height) {
+    m_Width = width;
+    m_Height = height;
+
+    if (CreateEglContext()) {
+        m_BackendName = "egl-surfaceless";
+    } else if (CreateGlfwContext()) {
+        m_BackendName = "glfw-hidden";
+    } else {
+        std::cerr << "Failed to create a headless OpenGL context" << std::endl;
+        return false;
+    }
+
+    std::cout << "Headless OpenGL (" << m_BackendName << "): " << glGetString(GL_VERSION)
+              << " / " << glGetString(GL_RENDERER) << std::endl;
+
+    if (!CreateFramebuffer()) {
+        Shutdown();
+        return false;
+    }
+
+    // Same fixed state as Window::Initialize, minus multisampling so readbacks are exact.
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    Bind();
+    return true;
+}
+
+bool HeadlessContext::CreateEglContext() {
+#ifdef GEOGEBRA3D_HAS_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // Prefer the surfaceless platform: it needs no X server, GBM device or pbuffer.
+    // Older eglext.h headers lack the token; those builds use the default display only.
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+#endif
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        std::cerr << "EGL: no display available" << std::endl;
+        return false;
+    }
+
+    EGLint major = 0;
+    EGLint minor = 0;
+    if (!eglInitialize(display, &major, &minor)) {
+        std::cerr << "EGL: eglInitialize failed" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    // Surfaceless contexts may have no matching config; EGL_KHR_no_config_context covers that.
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0) {
+        config = nullptr;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL: desktop OpenGL API not supported" << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "EGL: failed to create an OpenGL 3.3 core context" << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "EGL: surfaceless eglMakeCurrent failed" << std::endl;
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD (EGL)" << std::endl;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+
+    m_EglDisplay = display;
+    m_EglContext = context;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool HeadlessContext::CreateGlfwContext() {
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    m_GlfwWindow = glfwCreateWindow(16, 16, "GeoGebra 3D (headless)", nullptr, nullptr);
+    if (!m_GlfwWindow) {
+        std::cerr << "Failed to create hidden GLFW window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(m_GlfwWindow);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwDestroyWindow(m_GlfwWindow);
+        m_GlfwWindow = nullptr;
+        glfwTerminate();
+        return false;
+    }
+    return true;
+}
+
+bool HeadlessContext::CreateFramebuffer() {
+    DestroyFramebuffer();
+    if (m_Width <= 0 || m_Height <= 0) return false;
+
+    glGenFramebuffers(1, &m_Framebuffer);
+    glGenRenderbuffers(1, &m_ColorBuffer);
+    glGenRenderbuffers(1, &m_DepthBuffer);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, m_ColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_Width, m_Height);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_DepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_Width, m_Height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_DepthBuffer);
+
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer incomplete (status 0x" << std::hex << status << std::dec << ")" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        DestroyFramebuffer();
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::DestroyFramebuffer() {
+    if (m_Framebuffer != 0) {
+        glDeleteFramebuffers(1, &m_Framebuffer);
+        m_Framebuffer = 0;
+    }
+    if (m_ColorBuffer != 0) {
+        glDeleteRenderbuffers(1, &m_ColorBuffer);
+        m_ColorBuffer = 0;
+    }
+    if (m_DepthBuffer != 0) {
+        glDeleteRenderbuffers(1, &m_DepthBuffer);
+        m_DepthBuffer = 0;
+    }
+}
+
+bool HeadlessContext::Resize(int width, int height) {
+    if (width == m_Width && height == m_Height && m_Framebuffer != 0) return true;
+    m_Width = width;
+    m_Height = height;
+    if (!CreateFramebuffer()) return false;
+    Bind();
+    return true;
+}
+
+void HeadlessContext::Bind() {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+    glViewport(0, 0, m_Width, m_Height);
+}
+
+void HeadlessContext::ReadPixels(std::vector<unsigned char>& rgba) {
+    rgba.resize(static_cast<std::size_t>(m_Width) * m_Height * 4);
+    if (rgba.empty()) return;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Framebuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+}
+
+void HeadlessContext::Shutdown() {
+    if (m_EglContext == nullptr && m_GlfwWindow == nullptr) return;
+
+    DestroyFramebuffer();
+
+#ifdef GEOGEBRA3D_HAS_EGL
+    if (m_EglContext != nullptr) {
+        eglMakeCurrent(m_EglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(m_EglDisplay, m_EglContext);
+        eglTerminate(m_EglDisplay);
+        m_EglContext = nullptr;
+        m_EglDisplay = nullptr;
+    }
+#endif
+
+    if (m_GlfwWindow != nullptr) {
+        glfwDestroyWindow(m_GlfwWindow);
+        m_GlfwWindow = nullptr;
+        glfwTerminate();
+    }
+}
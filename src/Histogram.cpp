@@ -0,0 +1,217 @@
+#include "Histogram.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool Histogram::LevelsPreset::operator==(const LevelsPreset& other) const {
+    return mode == other.mode && lowPercent == other.lowPercent && highPercent == other.highPercent &&
+           sigmaLow == other.sigmaLow && sigmaHigh == other.sigmaHigh && fromRoi == other.fromRoi;
+}
+
+Histogram::Histogram(int binCount)
+    : m_Bins(static_cast<std::size_t>(std::max(binCount, 1)), 0)
+    , m_Count(0)
+    , m_BinLow(0.0f)
+    , m_BinHigh(1.0f)
+    , m_Min(0.0f)
+    , m_Max(1.0f)
+    , m_Mean(0.0)
+    , m_Stddev(0.0)
+    , m_Offset(0.0)
+    , m_Scale(1.0)
+{
+}
+
+void Histogram::Build(const ImageLoader& image) {
+    Count(image, 0, 0, image.GetWidth() - 1, image.GetHeight() - 1, /*fitRange*/ false);
+}
+
+void Histogram::BuildRegion(const ImageLoader& image, int x0, int y0, int x1, int y1) {
+    Count(image, x0, y0, x1, y1, /*fitRange*/ true);
+}
+
+void Histogram::Count(const ImageLoader& image, int x0, int y0, int x1, int y1, bool fitRange) {
+    Clear();
+    if (!image.IsLoaded()) return;
+
+    double minValue = 0.0;
+    double maxValue = 1.0;
+    image.GetDataRange(minValue, maxValue);
+    m_Offset = minValue;
+    m_Scale = maxValue - minValue;
+
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, image.GetWidth() - 1);
+    y1 = std::min(y1, image.GetHeight() - 1);
+    if (x0 > x1 || y0 > y1) return;
+
+    struct Partial {
+        std::uint64_t count{0};
+        double sum{0.0};
+        double sumSq{0.0};
+        float min{1.0f};
+        float max{0.0f};
+    };
+
+    const int width = x1 - x0 + 1;
+    const std::size_t rows = static_cast<std::size_t>(y1 - y0 + 1);
+    const unsigned int workers = GetWorkerThreadCount();
+    std::vector<Partial> partials(workers);
+    // Blank pixels (no data, e.g. outside a reprojection's coverage) are not counted.
+    const bool blanks = image.HasBlankPixels();
+
+    // Pass 1 (regions only): the value range the bins will span.
+    if (fitRange) {
+        ParallelForRanges(rows, 16, [&](std::size_t begin, std::size_t end, unsigned int worker) {
+            std::vector<float> row(static_cast<std::size_t>(width));
+            std::vector<std::uint8_t> blank(blanks ? row.size() : 0);
+            Partial local;
+            for (std::size_t r = begin; r < end; r++) {
+                image.GetNormalizedRow(y0 + static_cast<int>(r), x0, width, row.data());
+                if (blanks) image.GetBlankRow(y0 + static_cast<int>(r), x0, width, blank.data());
+                for (int i = 0; i < width; i++) {
+                    if (blanks && blank[i]) continue;
+                    const float v = std::clamp(row[i], 0.0f, 1.0f);
+                    local.min = std::min(local.min, v);
+                    local.max = std::max(local.max, v);
+                }
+            }
+            partials[worker] = local;
+        });
+        m_BinLow = 1.0f;
+        m_BinHigh = 0.0f;
+        for (const Partial& partial : partials) {
+            m_BinLow = std::min(m_BinLow, partial.min);
+            m_BinHigh = std::max(m_BinHigh, partial.max);
+        }
+        if (m_BinHigh - m_BinLow < 1e-6f) {
+            // Flat region: any span works, keep the value inside it.
+            m_BinLow = std::max(0.0f, m_BinLow - 0.5e-6f);
+            m_BinHigh = m_BinLow + 1e-6f;
+        }
+        std::fill(partials.begin(), partials.end(), Partial());
+    }
+
+    const std::size_t binCount = m_Bins.size();
+    m_WorkerBins.assign(binCount * workers, 0);
+
+    const float binLow = m_BinLow;
+    const float binScale = static_cast<float>(binCount / (static_cast<double>(m_BinHigh) - m_BinLow));
+    ParallelForRanges(rows, 16, [&](std::size_t begin, std::size_t end, unsigned int worker) {
+        std::uint32_t* bins = &m_WorkerBins[static_cast<std::size_t>(worker) * binCount];
+        std::vector<float> row(static_cast<std::size_t>(width));
+        std::vector<std::uint8_t> blank(blanks ? row.size() : 0);
+        // Accumulate locally; neighbouring partials share cache lines.
+        Partial local;
+        for (std::size_t r = begin; r < end; r++) {
+            image.GetNormalizedRow(y0 + static_cast<int>(r), x0, width, row.data());
+            if (blanks) image.GetBlankRow(y0 + static_cast<int>(r), x0, width, blank.data());
+            for (int i = 0; i < width; i++) {
+                if (blanks && blank[i]) continue;
+                const float v = std::clamp(row[i], 0.0f, 1.0f);
+                const float scaled = std::max(0.0f, (v - binLow) * binScale);
+                const std::size_t b = std::min(static_cast<std::size_t>(scaled), binCount - 1);
+                bins[b]++;
+                local.sum += v;
+                local.sumSq += static_cast<double>(v) * v;
+                local.min = std::min(local.min, v);
+                local.max = std::max(local.max, v);
+                local.count++;
+            }
+        }
+        partials[worker] = local;
+    });
+
+    // Merge the per-thread bins and partial sums.
+    for (unsigned int w = 0; w < workers; w++) {
+        const std::uint32_t* bins = &m_WorkerBins[static_cast<std::size_t>(w) * binCount];
+        for (std::size_t b = 0; b < binCount; b++) {
+            m_Bins[b] += bins[b];
+        }
+    }
+    double sum = 0.0;
+    double sumSq = 0.0;
+    m_Min = 1.0f;
+    m_Max = 0.0f;
+    for (const Partial& partial : partials) {
+        if (partial.count == 0) continue;
+        m_Count += partial.count;
+        sum += partial.sum;
+        sumSq += partial.sumSq;
+        m_Min = std::min(m_Min, partial.min);
+        m_Max = std::max(m_Max, partial.max);
+    }
+
+    if (m_Count == 0) {
+        Clear(); // every pixel blank
+        return;
+    }
+    const double n = static_cast<double>(m_Count);
+    m_Mean = sum / n;
+    m_Stddev = std::sqrt(std::max(0.0, sumSq / n - m_Mean * m_Mean));
+}
+
+void Histogram::Clear() {
+    std::fill(m_Bins.begin(), m_Bins.end(), 0);
+    m_Count = 0;
+    m_BinLow = 0.0f;
+    m_BinHigh = 1.0f;
+    m_Min = 0.0f;
+    m_Max = 1.0f;
+    m_Mean = 0.0;
+    m_Stddev = 0.0;
+}
+
+float Histogram::GetPercentile(float q) const {
+    if (m_Count == 0) return 0.0f;
+
+    const double rank = std::clamp(static_cast<double>(q), 0.0, 1.0) * static_cast<double>(m_Count);
+    const double binWidth = (static_cast<double>(m_BinHigh) - m_BinLow) / static_cast<double>(m_Bins.size());
+    std::uint64_t below = 0;
+    for (std::size_t b = 0; b < m_Bins.size(); b++) {
+        const std::uint32_t count = m_Bins[b];
+        if (count > 0 && rank <= static_cast<double>(below + count)) {
+            const double within = (rank - static_cast<double>(below)) / count;
+            const float value = static_cast<float>(m_BinLow + (static_cast<double>(b) + within) * binWidth);
+            return std::clamp(value, m_Min, m_Max);
+        }
+        below += count;
+    }
+    return m_Max;
+}
+
+void Histogram::ComputeLevels(const LevelsPreset& preset, float& outLow, float& outHigh) const {
+    outLow = m_Min;
+    outHigh = m_Max;
+    if (m_Count == 0) {
+        outLow = 0.0f;
+        outHigh = 1.0f;
+        return;
+    }
+
+    switch (preset.mode) {
+    case LevelsPreset::Mode::MinMax:
+    case LevelsPreset::Mode::ZScale:
+        break;
+    case LevelsPreset::Mode::Percentile:
+        outLow = GetPercentile(preset.lowPercent / 100.0f);
+        outHigh = GetPercentile(preset.highPercent / 100.0f);
+        break;
+    case LevelsPreset::Mode::MeanSigma:
+        outLow = std::max(m_Min, static_cast<float>(m_Mean - preset.sigmaLow * m_Stddev));
+        outHigh = std::min(m_Max, static_cast<float>(m_Mean + preset.sigmaHigh * m_Stddev));
+        break;
+    }
+
+    if (outHigh - outLow < 1e-6f) {
+        outLow = m_Min;
+        outHigh = m_Max;
+    }
+    if (outHigh - outLow < 1e-6f) {
+        outLow = 0.0f;
+        outHigh = 1.0f;
+    }
+}
@@ -0,0 +1,346 @@
+#include "ImageFilter.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+#include "Wcs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int kStripRows = 32;   // rows per parallel job
+constexpr int kBlock = 64;       // pixels per vectorized block of a row
+constexpr int kMaxMedianSize = 5;
+
+struct Comparator {
+    int low;
+    int high;
+};
+
+// Batcher odd-even merge sort for count inputs, pruned to the comparators that affect
+// the median (index count / 2). Inputs past count act as +inf and never move, so
+// comparators touching them are dropped.
+std::vector<Comparator> BuildMedianNetwork(int count) {
+    int padded = 1;
+    while (padded < count) padded <<= 1;
+    std::vector<Comparator> network;
+    for (int p = 1; p < padded; p <<= 1) {
+        for (int k = p; k >= 1; k >>= 1) {
+            for (int j = k % p; j + k < padded; j += 2 * k) {
+                for (int i = 0; i < std::min(k, padded - j - k); i++) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < count) {
+                        network.push_back({i + j, i + j + k});
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<bool> needed(static_cast<std::size_t>(count), false);
+    needed[count / 2] = true;
+    std::vector<Comparator> pruned;
+    for (auto it = network.rbegin(); it != network.rend(); ++it) {
+        if (!needed[it->low] && !needed[it->high]) continue;
+        needed[it->low] = needed[it->high] = true;
+        pruned.push_back(*it);
+    }
+    std::reverse(pruned.begin(), pruned.end());
+    return pruned;
+}
+
+const std::vector<Comparator>& MedianNetwork(int size) {
+    static const std::vector<Comparator> network3 = BuildMedianNetwork(9);
+    static const std::vector<Comparator> network5 = BuildMedianNetwork(25);
+    return size == 3 ? network3 : network5;
+}
+
+// size x size median with edge replication. Each block of a row gathers its
+// size^2 neighbours into lanes, then runs the network with min/max across the block.
+// With blanks, NaN (blank) taps are left out: half of them become -inf and the rest
+// +inf, so the network's middle element is the median of the valid taps (NaN if none).
+void MedianFilter(const std::vector<float>& in, std::vector<float>& out, int width, int height, int size,
+                  bool blanks) {
+    const int radius = size / 2;
+    const int taps = size * size;
+    const std::vector<Comparator>& network = MedianNetwork(size);
+    const int strips = (height + kStripRows - 1) / kStripRows;
+    ParallelForEach(static_cast<std::size_t>(strips), [&](std::size_t strip) {
+        float lanes[kMaxMedianSize * kMaxMedianSize][kBlock];
+        const int y0 = static_cast<int>(strip) * kStripRows;
+        const int y1 = std::min(y0 + kStripRows, height);
+        for (int y = y0; y < y1; y++) {
+            for (int xb = 0; xb < width; xb += kBlock) {
+                const int n = std::min(kBlock, width - xb);
+                int tap = 0;
+                for (int dy = -radius; dy <= radius; dy++) {
+                    const float* row = &in[static_cast<std::size_t>(std::clamp(y + dy, 0, height - 1)) * width];
+                    for (int dx = -radius; dx <= radius; dx++, tap++) {
+                        float* lane = lanes[tap];
+                        if (xb + dx >= 0 && xb + dx + kBlock <= width) {
+                            std::copy(row + xb + dx, row + xb + dx + kBlock, lane);
+                        } else {
+                            for (int i = 0; i < kBlock; i++) lane[i] = row[std::clamp(xb + i + dx, 0, width - 1)];
+                        }
+                    }
+                }
+                if (blanks) {
+                    for (int i = 0; i < n; i++) {
+                        int blankTaps = 0;
+                        for (int t = 0; t < taps; t++) blankTaps += std::isnan(lanes[t][i]) ? 1 : 0;
+                        if (blankTaps == 0) continue;
+                        int low = blankTaps / 2;
+                        for (int t = 0; t < taps; t++) {
+                            if (!std::isnan(lanes[t][i])) continue;
+                            lanes[t][i] = low-- > 0 ? -std::numeric_limits<float>::infinity()
+                                                    : std::numeric_limits<float>::infinity();
+                        }
+                    }
+                }
+                for (const Comparator& c : network) {
+                    float* a = lanes[c.low];
+                    float* b = lanes[c.high];
+                    for (int i = 0; i < kBlock; i++) {
+                        const float lo = std::min(a[i], b[i]);
+                        const float hi = std::max(a[i], b[i]);
+                        a[i] = lo;
+                        b[i] = hi;
+                    }
+                }
+                float* target = &out[static_cast<std::size_t>(y) * width + xb];
+                std::copy(lanes[taps / 2], lanes[taps / 2] + n, target);
+                if (blanks) {
+                    // Lanes with no valid tap sorted +inf to the middle.
+                    for (int i = 0; i < n; i++) {
+                        if (std::isinf(target[i])) target[i] = std::numeric_limits<float>::quiet_NaN();
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Separable Gaussian with edge replication: per strip, the rows it needs (plus the
+// kernel radius above and below) are blurred horizontally into a scratch buffer, then
+// combined vertically. With blanks, NaN (blank) taps get zero weight: the valid values
+// and their weights are blurred alike and divided, so blanks do not pull towards 0.
+void GaussianFilter(const std::vector<float>& in, std::vector<float>& out, int width, int height, float sigma,
+                    bool blanks) {
+    const int radius = std::max(1, static_cast<int>(std::ceil(3.0f * sigma)));
+    std::vector<float> weights(static_cast<std::size_t>(2 * radius + 1));
+    double sum = 0.0;
+    for (int k = -radius; k <= radius; k++) {
+        weights[k + radius] = static_cast<float>(std::exp(-0.5 * k * k / (static_cast<double>(sigma) * sigma)));
+        sum += weights[k + radius];
+    }
+    for (float& w : weights) w = static_cast<float>(w / sum);
+
+    const int strips = (height + kStripRows - 1) / kStripRows;
+    ParallelForEach(static_cast<std::size_t>(strips), [&](std::size_t strip) {
+        const int y0 = static_cast<int>(strip) * kStripRows;
+        const int y1 = std::min(y0 + kStripRows, height);
+        const int rows = y1 - y0 + 2 * radius;
+        std::vector<float> padded(static_cast<std::size_t>(width) + 2 * radius);
+        std::vector<float> paddedValid(blanks ? padded.size() : 0);
+        std::vector<float> blurred(static_cast<std::size_t>(rows) * width, 0.0f);
+        std::vector<float> blurredValid(blanks ? blurred.size() : 0, 0.0f);
+
+        for (int r = 0; r < rows; r++) {
+            const float* row = &in[static_cast<std::size_t>(std::clamp(y0 - radius + r, 0, height - 1)) * width];
+            std::fill(padded.begin(), padded.begin() + radius, row[0]);
+            std::copy(row, row + width, padded.begin() + radius);
+            std::fill(padded.begin() + radius + width, padded.end(), row[width - 1]);
+            if (blanks) {
+                for (std::size_t i = 0; i < padded.size(); i++) {
+                    const bool valid = !std::isnan(padded[i]);
+                    paddedValid[i] = valid ? 1.0f : 0.0f;
+                    if (!valid) padded[i] = 0.0f;
+                }
+            }
+            float* target = &blurred[static_cast<std::size_t>(r) * width];
+            for (int k = 0; k <= 2 * radius; k++) {
+                const float w = weights[k];
+                const float* source = padded.data() + k;
+                for (int x = 0; x < width; x++) target[x] += w * source[x];
+            }
+            if (blanks) {
+                float* targetValid = &blurredValid[static_cast<std::size_t>(r) * width];
+                for (int k = 0; k <= 2 * radius; k++) {
+                    const float w = weights[k];
+                    const float* source = paddedValid.data() + k;
+                    for (int x = 0; x < width; x++) targetValid[x] += w * source[x];
+                }
+            }
+        }
+
+        std::vector<float> weightSum(blanks ? static_cast<std::size_t>(width) : 0);
+        for (int y = y0; y < y1; y++) {
+            float* target = &out[static_cast<std::size_t>(y) * width];
+            std::fill(target, target + width, 0.0f);
+            for (int k = 0; k <= 2 * radius; k++) {
+                const float w = weights[k];
+                const float* source = &blurred[static_cast<std::size_t>(y - y0 + k) * width];
+                for (int x = 0; x < width; x++) target[x] += w * source[x];
+            }
+            if (!blanks) continue;
+            std::fill(weightSum.begin(), weightSum.end(), 0.0f);
+            for (int k = 0; k <= 2 * radius; k++) {
+                const float w = weights[k];
+                const float* source = &blurredValid[static_cast<std::size_t>(y - y0 + k) * width];
+                for (int x = 0; x < width; x++) weightSum[x] += w * source[x];
+            }
+            for (int x = 0; x < width; x++) {
+                target[x] = weightSum[x] > 1e-6f ? target[x] / weightSum[x] : std::numeric_limits<float>::quiet_NaN();
+            }
+        }
+    });
+}
+
+// Mean of factor x factor blocks of in (row stride `stride`); a partial block at the
+// right / bottom edge is dropped.
+void BinFilter(const float* in, std::size_t stride, std::vector<float>& out, int factor, int binnedWidth,
+               int binnedHeight) {
+    const float scale = 1.0f / static_cast<float>(factor * factor);
+    const int width = binnedWidth * factor;
+    ParallelForRanges(static_cast<std::size_t>(binnedHeight), kStripRows / factor + 1,
+                      [&](std::size_t begin, std::size_t end, unsigned int) {
+        std::vector<float> columnSums(static_cast<std::size_t>(width));
+        for (std::size_t by = begin; by < end; by++) {
+            std::fill(columnSums.begin(), columnSums.end(), 0.0f);
+            for (int dy = 0; dy < factor; dy++) {
+                const float* row = in + (by * factor + dy) * stride;
+                for (int x = 0; x < width; x++) columnSums[x] += row[x];
+            }
+            float* target = &out[by * binnedWidth];
+            for (int bx = 0; bx < binnedWidth; bx++) {
+                float value = 0.0f;
+                for (int dx = 0; dx < factor; dx++) value += columnSums[static_cast<std::size_t>(bx) * factor + dx];
+                target[bx] = value * scale;
+            }
+        }
+    });
+}
+} // namespace
+
+std::string ImageFilter::Params::GetKey() const {
+    char key[64];
+    const int sigmaTenths = GetSigmaTenths(gaussianSigma);
+    std::snprintf(key, sizeof(key), "m%d,g%d.%d,b%d", medianSize >= 3 ? medianSize : 0, sigmaTenths / 10,
+                  sigmaTenths % 10, std::max(binFactor, 1));
+    return key;
+}
+
+std::shared_ptr<ImageLoader> ImageFilter::Apply(const ImageLoader& source, const Params& params) {
+    return Apply(source, params, 0, 0, source.GetWidth() - 1, source.GetHeight() - 1);
+}
+
+std::shared_ptr<ImageLoader> ImageFilter::Apply(const ImageLoader& source, const Params& params, int x0, int y0,
+                                                int x1, int y1) {
+    if (!source.IsFits() || !source.IsLoaded()) {
+        std::cerr << "Image filters need a FITS image" << std::endl;
+        return nullptr;
+    }
+
+    const int width = source.GetWidth();
+    const int height = source.GetHeight();
+    const int factor = std::clamp(params.binFactor, 1, std::min(width, height));
+    const int binnedWidth = width / factor;
+    const int binnedHeight = height / factor;
+
+    // The region in whole output pixels, then in source pixels.
+    const int bx0 = std::clamp(x0 / factor, 0, binnedWidth - 1);
+    const int by0 = std::clamp(y0 / factor, 0, binnedHeight - 1);
+    const int bx1 = std::clamp(x1 / factor, bx0, binnedWidth - 1);
+    const int by1 = std::clamp(y1 / factor, by0, binnedHeight - 1);
+    const int outWidth = bx1 - bx0 + 1;
+    const int outHeight = by1 - by0 + 1;
+    const int rx0 = bx0 * factor;
+    const int ry0 = by0 * factor;
+
+    // Kernels read this far around the region; inside the frame it is filtered too so the
+    // region matches the whole-frame result (edges are replicated at the frame border).
+    const float sigma = Params::QuantizeSigma(params.gaussianSigma);
+    const int medianSize = params.medianSize >= 5 ? 5 : (params.medianSize >= 3 ? 3 : 0);
+    const int halo = medianSize / 2 + (sigma > 0.0f ? std::max(1, static_cast<int>(std::ceil(3.0f * sigma))) : 0);
+    const int ex0 = std::max(0, rx0 - halo);
+    const int ey0 = std::max(0, ry0 - halo);
+    const int ex1 = std::min(width - 1, rx0 + outWidth * factor - 1 + halo);
+    const int ey1 = std::min(height - 1, ry0 + outHeight * factor - 1 + halo);
+    const int extentWidth = ex1 - ex0 + 1;
+    const int extentHeight = ey1 - ey0 + 1;
+
+    const bool blanks = source.HasBlankPixels();
+    std::vector<float> data(static_cast<std::size_t>(extentWidth) * extentHeight);
+    ParallelForRanges(static_cast<std::size_t>(extentHeight), kStripRows,
+                      [&](std::size_t begin, std::size_t end, unsigned int) {
+        std::vector<std::uint8_t> blank(blanks ? static_cast<std::size_t>(extentWidth) : 0);
+        for (std::size_t y = begin; y < end; y++) {
+            float* row = &data[y * extentWidth];
+            source.GetNormalizedRow(ey0 + static_cast<int>(y), ex0, extentWidth, row);
+            if (!blanks) continue;
+            // Blank pixels read as 0; NaN keeps them out of the kernels.
+            source.GetBlankRow(ey0 + static_cast<int>(y), ex0, extentWidth, blank.data());
+            for (int x = 0; x < extentWidth; x++) {
+                if (blank[x]) row[x] = std::numeric_limits<float>::quiet_NaN();
+            }
+        }
+    });
+    std::vector<float> scratch(data.size());
+
+    if (medianSize > 0) {
+        MedianFilter(data, scratch, extentWidth, extentHeight, medianSize, blanks);
+        std::swap(data, scratch);
+    }
+    if (sigma > 0.0f) {
+        GaussianFilter(data, scratch, extentWidth, extentHeight, sigma, blanks);
+        std::swap(data, scratch);
+    }
+
+    // Cut the region out of the halo and bin it.
+    const float* region = &data[static_cast<std::size_t>(ry0 - ey0) * extentWidth + (rx0 - ex0)];
+    if (factor > 1 || outWidth != extentWidth || outHeight != extentHeight) {
+        scratch.assign(static_cast<std::size_t>(outWidth) * outHeight, 0.0f);
+        BinFilter(region, static_cast<std::size_t>(extentWidth), scratch, factor, outWidth, outHeight);
+        std::swap(data, scratch);
+    }
+    scratch = std::vector<float>();
+
+    // Blank source pixels stay blank; a binned pixel is blank if any pixel of its block is.
+    if (blanks) {
+        ParallelForRanges(static_cast<std::size_t>(outHeight), kStripRows, [&](std::size_t begin, std::size_t end,
+                                                                              unsigned int) {
+            std::vector<std::uint8_t> blank(static_cast<std::size_t>(outWidth) * factor);
+            for (std::size_t y = begin; y < end; y++) {
+                float* target = &data[y * outWidth];
+                for (int dy = 0; dy < factor; dy++) {
+                    source.GetBlankRow(ry0 + static_cast<int>(y) * factor + dy, rx0, outWidth * factor, blank.data());
+                    for (int x = 0; x < outWidth; x++) {
+                        for (int dx = 0; dx < factor; dx++) {
+                            if (blank[static_cast<std::size_t>(x) * factor + dx]) {
+                                target[x] = std::numeric_limits<float>::quiet_NaN();
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    const Wcs* wcs = source.GetWcs();
+    auto result = std::make_shared<ImageLoader>();
+    if (!result->LoadResampled(source, std::move(data), outWidth, outHeight,
+                               wcs ? wcs->Cropped(rx0, ry0).Binned(factor) : Wcs())) {
+        return nullptr;
+    }
+    const ImageLoader::FrameGrid& sourceGrid = source.GetFrameGrid();
+    ImageLoader::FrameGrid grid;
+    grid.originX = sourceGrid.originX + rx0 * sourceGrid.bin;
+    grid.originY = sourceGrid.originY + ry0 * sourceGrid.bin;
+    grid.bin = sourceGrid.bin * factor;
+    result->SetFrameGrid(grid);
+    return result;
+}
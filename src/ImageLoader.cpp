@@ -1,10 +1,12 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "ImageLoader.h"
 #include "FitsLoader.h"
+#include "ZScale.h"
 #include <stb_image.h>
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 ImageLoader::ImageLoader()
     : m_Data(nullptr)
@@ -12,6 +14,10 @@ ImageLoader::ImageLoader()
     , m_Height(0)
     , m_Channels(0)
     , m_FitsLoader(nullptr)
+    , m_ZScaleLow(0.0f)
+    , m_ZScaleHigh(1.0f)
+    , m_DisplayScale(1.0f)
+    , m_RegionZScaleNext(0)
 {
 }
 
@@ -47,6 +53,14 @@ bool ImageLoader::LoadStandardImage(const std::string& filepath) {
     std::cout << "  Size: " << m_Width << "x" << m_Height << std::endl;
     std::cout << "  Channels: " << m_Channels << std::endl;
 
+    ZScale::Compute(0, 0, m_Width - 1, m_Height - 1,
+                    [this](int x, int y) { return GetNormalizedPixelValue(x, y); },
+                    ZScale::Params(), m_ZScaleLow, m_ZScaleHigh);
+    UpdateDisplayScale();
+
+    m_Integral.Build(*this);
+    m_Histogram.Build(*this);
+    m_Background.Build(*this);
     return true;
 }
 
@@ -60,11 +74,40 @@ bool ImageLoader::LoadFitsImage(const std::string& filepath) {
         return false;
     }
 
+    FinishFitsLoad();
+    return true;
+}
+
+bool ImageLoader::LoadResampled(const ImageLoader& like, std::vector<float> normalized, int width, int height,
+                                const Wcs& wcs) {
+    UnloadImage();
+    if (!like.m_FitsLoader) return false;
+
+    m_FitsLoader = std::make_unique<FitsLoader>();
+    if (!m_FitsLoader->LoadNormalized(std::move(normalized), width, height, *like.m_FitsLoader, wcs)) {
+        m_FitsLoader.reset();
+        return false;
+    }
+    FinishFitsLoad();
+    return true;
+}
+
+void ImageLoader::FinishFitsLoad() {
     m_Width = m_FitsLoader->GetWidth();
     m_Height = m_FitsLoader->GetHeight();
     m_Channels = 1;  // FITS is grayscale
+    m_ZScaleLow = m_FitsLoader->GetZScaleLow();
+    m_ZScaleHigh = m_FitsLoader->GetZScaleHigh();
+    UpdateDisplayScale();
 
-    return true;
+    m_Integral.Build(*this);
+    m_Histogram.Build(*this);
+    m_Background.Build(*this);
+}
+
+const Wcs* ImageLoader::GetWcs() const {
+    if (!m_FitsLoader || !m_FitsLoader->GetWcs().IsValid()) return nullptr;
+    return &m_FitsLoader->GetWcs();
 }
 
 void ImageLoader::UnloadImage() {
@@ -77,11 +120,124 @@ void ImageLoader::UnloadImage() {
         m_FitsLoader.reset();
     }
 
+    m_Integral.Clear();
+    m_Histogram.Clear();
+    m_Background.Clear();
+    m_ZScaleLow = 0.0f;
+    m_ZScaleHigh = 1.0f;
+    m_DisplayScale = 1.0f;
+    m_FrameGrid = FrameGrid();
+    {
+        std::lock_guard<std::mutex> lock(m_RegionZScaleMutex);
+        m_RegionZScaleCache.clear();
+        m_RegionZScaleNext = 0;
+    }
     m_Width = 0;
     m_Height = 0;
     m_Channels = 0;
 }
 
+void ImageLoader::GetDataRange(double& minValue, double& maxValue) const {
+    if (m_FitsLoader) {
+        minValue = m_FitsLoader->GetMinValue();
+        maxValue = m_FitsLoader->GetMaxValue();
+        return;
+    }
+    minValue = 0.0;
+    maxValue = 255.0;
+}
+
+void ImageLoader::UpdateDisplayScale() {
+    // A flat sample (e.g. an empty frame) falls back to the full range.
+    if (!(m_ZScaleHigh - m_ZScaleLow >= 1e-6f)) {
+        m_ZScaleLow = 0.0f;
+        m_ZScaleHigh = 1.0f;
+    }
+    m_DisplayScale = 1.0f / (m_ZScaleHigh - m_ZScaleLow);
+}
+
+void ImageLoader::GetZScale(float& low, float& high) const {
+    low = m_ZScaleLow;
+    high = m_ZScaleHigh;
+}
+
+void ImageLoader::GetRegionZScale(int x0, int y0, int x1, int y1, float& low, float& high) const {
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_Width - 1);
+    y1 = std::min(y1, m_Height - 1);
+    if (!IsLoaded() || x0 > x1 || y0 > y1) {
+        GetZScale(low, high);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_RegionZScaleMutex);
+        for (const RegionZScale& entry : m_RegionZScaleCache) {
+            if (entry.x0 == x0 && entry.y0 == y0 && entry.x1 == x1 && entry.y1 == y1) {
+                low = entry.low;
+                high = entry.high;
+                return;
+            }
+        }
+    }
+
+    // Computed outside the lock; two threads racing on the same region just both insert it.
+    auto sample = [this](int x, int y) {
+        return IsBlankPixel(x, y) ? std::numeric_limits<float>::quiet_NaN() : GetNormalizedPixelValue(x, y);
+    };
+    if (!ZScale::Compute(x0, y0, x1, y1, sample, ZScale::Params(), low, high) ||
+        !(high - low >= 1e-6f)) {
+        GetZScale(low, high);
+    }
+
+    std::lock_guard<std::mutex> lock(m_RegionZScaleMutex);
+    const RegionZScale entry{x0, y0, x1, y1, low, high};
+    if (m_RegionZScaleCache.size() < kRegionZScaleCacheSize) {
+        m_RegionZScaleCache.push_back(entry);
+    } else {
+        m_RegionZScaleCache[m_RegionZScaleNext] = entry;
+        m_RegionZScaleNext = (m_RegionZScaleNext + 1) % kRegionZScaleCacheSize;
+    }
+}
+
+float ImageLoader::ToDisplayValue(float normalized) const {
+    if (m_FitsLoader) {
+        return std::clamp((normalized - m_ZScaleLow) * m_DisplayScale, 0.0f, 1.0f);
+    }
+    return std::clamp(normalized, 0.0f, 1.0f);
+}
+
+float ImageLoader::GetDisplayValue(int x, int y) const {
+    if (m_FitsLoader) {
+        return ToDisplayValue(m_FitsLoader->GetNormalizedPixelValue(x, y));
+    }
+    return GetPixelValue(x, y) / 255.0f;
+}
+
+float ImageLoader::GetHeightValue(int x, int y, HeightMode mode) const {
+    if (mode == HeightMode::Display || m_Background.IsEmpty()) {
+        return GetDisplayValue(x, y);
+    }
+
+    const float value = GetNormalizedPixelValue(x, y);
+    const float background = m_Background.GetBackground(x, y);
+    const float level = m_Background.GetGlobalLevel();
+    if (mode == HeightMode::BackgroundNormalized) {
+        // Ratio in data units (normalized 0 is the data minimum, not zero).
+        double minValue = 0.0;
+        double maxValue = 1.0;
+        GetDataRange(minValue, maxValue);
+        const double scale = maxValue - minValue;
+        const double backgroundData = minValue + scale * background;
+        if (backgroundData > 0.0 && scale > 0.0) {
+            const double data = (minValue + scale * value) / backgroundData * (minValue + scale * level);
+            return ToDisplayValue(static_cast<float>((data - minValue) / scale));
+        }
+    }
+    return ToDisplayValue(value - background + level);
+}
+
 unsigned char ImageLoader::GetPixelValue(int x, int y) const {
     if (m_FitsLoader) {
         // FITS data
@@ -116,11 +272,59 @@ float ImageLoader::GetNormalizedPixelValue(int x, int y) const {
     return GetPixelValue(x, y) / 255.0f;
 }
 
+void ImageLoader::GetNormalizedRow(int y, int x0, int count, float* out) const {
+    if (count <= 0) return;
+    const int begin = std::clamp(x0, 0, m_Width);
+    const int end = std::clamp(x0 + count, begin, m_Width);
+    if (!IsLoaded() || y < 0 || y >= m_Height || begin >= end) {
+        std::fill(out, out + count, 0.0f);
+        return;
+    }
+    std::fill(out, out + (begin - x0), 0.0f);
+    std::fill(out + (end - x0), out + count, 0.0f);
+
+    float* dst = out + (begin - x0);
+    if (m_FitsLoader) {
+        const float* row = m_FitsLoader->GetRow(y);
+        std::copy(row + begin, row + end, dst);
+        return;
+    }
+    for (int x = begin; x < end; x++) {
+        *dst++ = GetPixelValue(x, y) / 255.0f;
+    }
+}
+
+bool ImageLoader::HasBlankPixels() const {
+    return m_FitsLoader && m_FitsLoader->HasBlankPixels();
+}
+
+bool ImageLoader::IsBlankPixel(int x, int y) const {
+    return m_FitsLoader && m_FitsLoader->IsBlank(x, y);
+}
+
+void ImageLoader::GetBlankRow(int y, int x0, int count, std::uint8_t* out) const {
+    if (count <= 0) return;
+    const int begin = std::clamp(x0, 0, m_Width);
+    const int end = std::clamp(x0 + count, begin, m_Width);
+    if (!IsLoaded() || y < 0 || y >= m_Height || begin >= end) {
+        std::fill(out, out + count, std::uint8_t{1});
+        return;
+    }
+    std::fill(out, out + (begin - x0), std::uint8_t{1});
+    std::fill(out + (end - x0), out + count, std::uint8_t{1});
+
+    const std::uint8_t* row = m_FitsLoader ? m_FitsLoader->GetBlankRow(y) : nullptr;
+    if (row) {
+        std::copy(row + begin, row + end, out + (begin - x0));
+    } else {
+        std::fill(out + (begin - x0), out + (end - x0), std::uint8_t{0});
+    }
+}
+
 glm::vec3 ImageLoader::GetPixelColor(int x, int y) const {
     if (m_FitsLoader) {
-        float r, g, b;
-        m_FitsLoader->GetPixelColor(x, y, r, g, b);
-        return glm::vec3(r, g, b);
+        const float gray = GetDisplayValue(x, y);
+        return glm::vec3(gray, gray, gray);
     }
 
     if (!m_Data || x < 0 || x >= m_Width || y < 0 || y >= m_Height) {
@@ -144,7 +348,8 @@ glm::vec3 ImageLoader::GetPixelColor(int x, int y) const {
     return glm::vec3(0.0f);
 }
 
-std::vector<glm::vec3> ImageLoader::GeneratePointCloud(float scaleX, float scaleY, float scaleZ) const {
+std::vector<glm::vec3> ImageLoader::GeneratePointCloud(float scaleX, float scaleY, float scaleZ,
+                                                       HeightMode heightMode) const {
     std::vector<glm::vec3> points;
 
     if (!IsLoaded()) {
@@ -159,7 +364,7 @@ std::vector<glm::vec3> ImageLoader::GeneratePointCloud(float scaleX, float scale
 
     for (int y = 0; y < m_Height; y++) {
         for (int x = 0; x < m_Width; x++) {
-            float pixelValue = GetNormalizedPixelValue(x, y);
+            float pixelValue = GetHeightValue(x, y, heightMode);
 
             // Create point: pixel(x,y) -> 3D(x,z), pixel value -> y height
             glm::vec3 point;
@@ -180,7 +385,8 @@ void ImageLoader::GeneratePointCloudWithColors(std::vector<glm::vec3>& positions
                                                std::vector<glm::vec4>& colors,
                                                float scaleX,
                                                float scaleY,
-                                               float scaleZ) const {
+                                               float scaleZ,
+                                               HeightMode heightMode) const {
     positions.clear();
     colors.clear();
 
@@ -198,7 +404,7 @@ void ImageLoader::GeneratePointCloudWithColors(std::vector<glm::vec3>& positions
     for (int y = 0; y < m_Height; y++) {
         for (int x = 0; x < m_Width; x++) {
             // Get grayscale value for height
-            float pixelValue = GetNormalizedPixelValue(x, y);
+            float pixelValue = GetHeightValue(x, y, heightMode);
 
             // Get original RGB color
             glm::vec3 rgb = GetPixelColor(x, y);
@@ -242,7 +448,8 @@ void ImageLoader::GeneratePointCloudWithColorsHighlight(std::vector<glm::vec3>&
                                                         const glm::vec4& highlightColor,
                                                         float scaleX,
                                                         float scaleY,
-                                                        float scaleZ) const {
+                                                        float scaleZ,
+                                                        HeightMode heightMode) const {
     positions.clear();
     colors.clear();
 
@@ -264,7 +471,7 @@ void ImageLoader::GeneratePointCloudWithColorsHighlight(std::vector<glm::vec3>&
     for (int y = 0; y < m_Height; y++) {
         for (int x = 0; x < m_Width; x++) {
             // Get grayscale value for height
-            const float pixelValue = GetNormalizedPixelValue(x, y);
+            const float pixelValue = GetHeightValue(x, y, heightMode);
 
             // Base color
             glm::vec3 rgb = GetPixelColor(x, y);
@@ -296,7 +503,8 @@ void ImageLoader::GeneratePointCloudWithColorsROI(std::vector<glm::vec3>& positi
                                                   int radiusPixels,
                                                   float scaleX,
                                                   float scaleY,
-                                                  float scaleZ) const {
+                                                  float scaleZ,
+                                                  HeightMode heightMode) const {
     positions.clear();
     colors.clear();
 
@@ -332,7 +540,7 @@ void ImageLoader::GeneratePointCloudWithColorsROI(std::vector<glm::vec3>& positi
     for (int y = y0; y <= y1; y++) {
         for (int x = x0; x <= x1; x++) {
             // Get grayscale value for height
-            const float pixelValue = GetNormalizedPixelValue(x, y);
+            const float pixelValue = GetHeightValue(x, y, heightMode);
 
             // Get original RGB color
             const glm::vec3 rgb = GetPixelColor(x, y);
@@ -364,7 +572,8 @@ void ImageLoader::GeneratePointCloudWithColorsROIHighlight(std::vector<glm::vec3
                                                            const glm::vec4& highlightColor,
                                                            float scaleX,
                                                            float scaleY,
-                                                           float scaleZ) const {
+                                                           float scaleZ,
+                                                           HeightMode heightMode) const {
     positions.clear();
     colors.clear();
 
@@ -404,7 +613,7 @@ void ImageLoader::GeneratePointCloudWithColorsROIHighlight(std::vector<glm::vec3
     for (int y = y0; y <= y1; y++) {
         for (int x = x0; x <= x1; x++) {
             // Get grayscale value for height
-            const float pixelValue = GetNormalizedPixelValue(x, y);
+            const float pixelValue = GetHeightValue(x, y, heightMode);
 
             // Base color
             const glm::vec3 rgb = GetPixelColor(x, y);
@@ -430,24 +639,20 @@ void ImageLoader::GeneratePointCloudWithColorsROIHighlight(std::vector<glm::vec3
               << " radius=" << radiusPixels << ", highlight size=" << highlightSizePixels << ")" << std::endl;
 }
 
-void ImageLoader::GeneratePointCloudWithColorsROISplitHighlight(std::vector<glm::vec3>& positions,
-                                                                std::vector<glm::vec4>& colors,
-                                                                std::vector<glm::vec3>& highlightPositions,
-                                                                std::vector<glm::vec4>& highlightColors,
-                                                                int pixelX,
-                                                                int pixelY,
-                                                                int radiusPixels,
-                                                                int highlightCenterX,
-                                                                int highlightCenterY,
-                                                                int highlightSizePixels,
-                                                                const glm::vec4& highlightColor,
-                                                                float scaleX,
-                                                                float scaleY,
-                                                                float scaleZ) const {
+void ImageLoader::GeneratePointCloudWithColorsROIGroups(std::vector<glm::vec3>& positions,
+                                                        std::vector<glm::vec4>& colors,
+                                                        std::vector<std::uint8_t>& groups,
+                                                        int pixelX,
+                                                        int pixelY,
+                                                        int radiusPixels,
+                                                        const std::vector<PointHighlight>& highlights,
+                                                        float scaleX,
+                                                        float scaleY,
+                                                        float scaleZ,
+                                                        HeightMode heightMode) const {
     positions.clear();
     colors.clear();
-    highlightPositions.clear();
-    highlightColors.clear();
+    groups.clear();
 
     if (!IsLoaded()) {
         return;
@@ -469,47 +674,194 @@ void ImageLoader::GeneratePointCloudWithColorsROISplitHighlight(std::vector<glm:
         return;
     }
 
-    int hx0, hx1, hy0, hy1;
-    HighlightBounds(highlightCenterX, highlightSizePixels, hx0, hx1);
-    HighlightBounds(highlightCenterY, highlightSizePixels, hy0, hy1);
+    // Only highlights overlapping the ROI matter; each is bucketed under the ROI rows it
+    // covers, so a row paints just its own rects instead of testing all per pixel.
+    struct HighlightRect {
+        int hx0, hx1, hy0, hy1;
+        const PointHighlight* highlight;
+    };
+    std::vector<HighlightRect> rects;
+    for (const auto& h : highlights) {
+        HighlightRect r{0, 0, 0, 0, &h};
+        HighlightBounds(h.centerX, h.sizePixels, r.hx0, r.hx1);
+        HighlightBounds(h.centerY, h.sizePixels, r.hy0, r.hy1);
+        if (r.hx1 < x0 || r.hx0 > x1 || r.hy1 < y0 || r.hy0 > y1) continue;
+        rects.push_back(r);
+    }
+    std::vector<std::vector<int>> rowRects(static_cast<std::size_t>(y1 - y0 + 1));
+    for (int i = 0; i < static_cast<int>(rects.size()); i++) {
+        for (int y = std::max(rects[i].hy0, y0); y <= std::min(rects[i].hy1, y1); y++) {
+            rowRects[y - y0].push_back(i);
+        }
+    }
+    std::vector<const PointHighlight*> rowHits(static_cast<std::size_t>(x1 - x0 + 1), nullptr);
 
     const std::size_t approxCount =
         static_cast<std::size_t>(x1 - x0 + 1) * static_cast<std::size_t>(y1 - y0 + 1);
     positions.reserve(approxCount);
     colors.reserve(approxCount);
-
-    const std::size_t approxHighlight =
-        static_cast<std::size_t>(std::min(highlightSizePixels, x1 - x0 + 1)) *
-        static_cast<std::size_t>(std::min(highlightSizePixels, y1 - y0 + 1));
-    highlightPositions.reserve(approxHighlight);
-    highlightColors.reserve(approxHighlight);
+    groups.reserve(approxCount);
 
     // Keep the same world-space centering as full image, so ROI aligns with the original image coordinates.
     const float centerX = m_Width * 0.5f;
     const float centerZ = m_Height * 0.5f;
 
+    std::size_t highlightCount = 0;
     for (int y = y0; y <= y1; y++) {
+        // Painted last to first, so the first highlight containing a pixel wins.
+        const std::vector<int>& active = rowRects[y - y0];
+        if (!active.empty()) {
+            std::fill(rowHits.begin(), rowHits.end(), nullptr);
+            for (auto it = active.rbegin(); it != active.rend(); ++it) {
+                const HighlightRect& r = rects[*it];
+                const int hx0 = std::max(r.hx0, x0);
+                const int hx1 = std::min(r.hx1, x1);
+                if (hx0 <= hx1) std::fill(rowHits.begin() + (hx0 - x0), rowHits.begin() + (hx1 - x0 + 1), r.highlight);
+            }
+        }
         for (int x = x0; x <= x1; x++) {
-            const float pixelValue = GetNormalizedPixelValue(x, y);
-            const glm::vec3 rgb = GetPixelColor(x, y);
+            const float pixelValue = GetHeightValue(x, y, heightMode);
 
             glm::vec3 point;
             point.x = (x - centerX) * scaleX;
             point.y = pixelValue * scaleY;
             point.z = (y - centerZ) * scaleZ;
 
-            if (IsInRangeInclusive(x, hx0, hx1) && IsInRangeInclusive(y, hy0, hy1)) {
-                highlightPositions.push_back(point);
-                highlightColors.push_back(highlightColor);
+            const PointHighlight* hit = active.empty() ? nullptr : rowHits[x - x0];
+
+            positions.push_back(point);
+            if (hit) {
+                colors.push_back(hit->color);
+                groups.push_back(hit->group);
+                highlightCount++;
             } else {
-                positions.push_back(point);
-                colors.push_back(glm::vec4(rgb, 1.0f));
+                colors.push_back(glm::vec4(GetPixelColor(x, y), 1.0f));
+                groups.push_back(0);
             }
         }
     }
 
     std::cout << "Generated ROI point cloud with " << positions.size()
-              << " points + highlight " << highlightPositions.size()
-              << " points (pixel center=" << pixelX << "," << pixelY
-              << " radius=" << radiusPixels << ", highlight size=" << highlightSizePixels << ")" << std::endl;
+              << " points (" << highlightCount << " highlighted in " << rects.size()
+              << " region(s), pixel center=" << pixelX << "," << pixelY
+              << " radius=" << radiusPixels << ")" << std::endl;
+}
+
+namespace {
+constexpr std::size_t kStretchHistogramBins = 4096;
+
+// Value at rank floor(q * (n - 1)) of the sorted values, read from a histogram over
+// [lo, hi] and interpolated inside the bin.
+float HistogramQuantile(const std::vector<std::uint32_t>& histogram, std::size_t n, float lo, float hi, float q) {
+    const std::size_t rank = static_cast<std::size_t>(std::clamp(q, 0.0f, 1.0f) * float(n - 1));
+    const float binWidth = (hi - lo) / static_cast<float>(histogram.size());
+    std::size_t below = 0;
+    for (std::size_t b = 0; b < histogram.size(); b++) {
+        const std::size_t count = histogram[b];
+        if (rank < below + count) {
+            const float within = (static_cast<float>(rank - below) + 0.5f) / static_cast<float>(count);
+            return lo + (static_cast<float>(b) + within) * binWidth;
+        }
+        below += count;
+    }
+    return hi;
+}
+} // namespace
+
+void ImageLoader::BuildRegionRGBA(int srcX, int srcY, int srcW, int srcH,
+                                  int outW, int outH,
+                                  bool contrastStretch,
+                                  std::vector<unsigned char>& rgba) const {
+    rgba.resize(static_cast<std::size_t>(std::max(outW, 0)) * std::max(outH, 0) * 4);
+    RegionScratch scratch;
+    BuildRegionRGBA(srcX, srcY, srcW, srcH, outW, outH, contrastStretch, rgba.data(), scratch);
+}
+
+void ImageLoader::BuildRegionRGBA(int srcX, int srcY, int srcW, int srcH,
+                                  int outW, int outH,
+                                  bool contrastStretch,
+                                  unsigned char* rgba,
+                                  RegionScratch& scratch,
+                                  float levelLow,
+                                  float levelHigh) const {
+    if (outW <= 0 || outH <= 0) return;
+    const std::size_t outPixels = static_cast<std::size_t>(outW) * outH;
+    if (!IsLoaded() || m_Width <= 0 || m_Height <= 0 || srcW <= 0 || srcH <= 0) {
+        std::fill(rgba, rgba + outPixels * 4, static_cast<unsigned char>(0));
+        return;
+    }
+
+    // Nearest sample at output pixel centers; for outW == srcW this is exactly srcX + i.
+    scratch.columns.resize(static_cast<std::size_t>(outW));
+    for (int i = 0; i < outW; i++) {
+        const long long x = srcX + (2LL * i + 1) * srcW / (2LL * outW);
+        scratch.columns[i] = std::clamp(static_cast<int>(x), 0, m_Width - 1);
+    }
+    auto sampleY = [&](int j) {
+        const long long y = srcY + (2LL * j + 1) * srcH / (2LL * outH);
+        return std::clamp(static_cast<int>(y), 0, m_Height - 1);
+    };
+
+    // Standard images are already in display range.
+    if (!contrastStretch || !IsFits()) {
+        for (int j = 0; j < outH; j++) {
+            const int y = sampleY(j);
+            unsigned char* row = rgba + static_cast<std::size_t>(j) * outW * 4;
+            for (int i = 0; i < outW; i++) {
+                const glm::vec3 out = GetPixelColor(scratch.columns[i], y);
+                row[i * 4 + 0] = static_cast<unsigned char>(std::clamp(out.r, 0.0f, 1.0f) * 255.0f);
+                row[i * 4 + 1] = static_cast<unsigned char>(std::clamp(out.g, 0.0f, 1.0f) * 255.0f);
+                row[i * 4 + 2] = static_cast<unsigned char>(std::clamp(out.b, 0.0f, 1.0f) * 255.0f);
+                row[i * 4 + 3] = 255;
+            }
+        }
+        return;
+    }
+
+    // For FITS, do a local contrast stretch so deep bit-depth data looks like a normal image.
+    // Sample once; without explicit levels take the 1%/99% points from a single histogram pass.
+    scratch.values.resize(outPixels);
+    float lo = 1.0f;
+    float hi = 0.0f;
+    for (int j = 0; j < outH; j++) {
+        const int y = sampleY(j);
+        float* row = scratch.values.data() + static_cast<std::size_t>(j) * outW;
+        for (int i = 0; i < outW; i++) {
+            const float v = GetNormalizedPixelValue(scratch.columns[i], y);
+            row[i] = v;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    }
+
+    float stretchLow = 0.0f;
+    float stretchHigh = 1.0f;
+    if (levelHigh > levelLow) {
+        stretchLow = levelLow;
+        stretchHigh = levelHigh;
+    } else if (hi - lo >= 1e-6f) {
+        scratch.histogram.assign(kStretchHistogramBins, 0);
+        const float binScale = static_cast<float>(kStretchHistogramBins) / (hi - lo);
+        for (float v : scratch.values) {
+            const std::size_t b = static_cast<std::size_t>((v - lo) * binScale);
+            scratch.histogram[std::min(b, kStretchHistogramBins - 1)]++;
+        }
+        stretchLow = HistogramQuantile(scratch.histogram, outPixels, lo, hi, 0.01f);
+        stretchHigh = HistogramQuantile(scratch.histogram, outPixels, lo, hi, 0.99f);
+        if (stretchHigh - stretchLow < 1e-6f) {
+            stretchLow = 0.0f;
+            stretchHigh = 1.0f;
+        }
+    }
+
+    const float invRange = 1.0f / (stretchHigh - stretchLow);
+    for (std::size_t p = 0; p < outPixels; p++) {
+        // Contrast stretch to [0,1], then a sqrt curve to make dim structures more visible.
+        const float t = std::sqrt(std::clamp((scratch.values[p] - stretchLow) * invRange, 0.0f, 1.0f));
+        const unsigned char g = static_cast<unsigned char>(t * 255.0f);
+        rgba[p * 4 + 0] = g;
+        rgba[p * 4 + 1] = g;
+        rgba[p * 4 + 2] = g;
+        rgba[p * 4 + 3] = 255;
+    }
 }
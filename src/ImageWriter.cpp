@@ -0,0 +1,249 @@
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+namespace {
+std::uint32_t Crc32(const unsigned char* data, std::size_t size, std::uint32_t crc = 0) {
+    // Built once; function-local statics are initialized thread-safely.
+    static const std::vector<std::uint32_t> table = []() {
+        std::vector<std::uint32_t> t(256);
+        for (std::uint32_t n = 0; n < 256; n++) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+std::uint32_t Adler32(const std::vector<unsigned char>& data) {
+    std::uint32_t a = 1;
+    std::uint32_t b = 0;
+    for (unsigned char v : data) {
+        a = (a + v) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    return (b << 16) | a;
+}
+
+// LSB-first bit packer for deflate.
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<unsigned char>& out) : m_Out(out), m_Bits(0), m_Count(0) {}
+
+    void Write(std::uint32_t value, int bitCount) {
+        m_Bits |= static_cast<std::uint64_t>(value) << m_Count;
+        m_Count += bitCount;
+        while (m_Count >= 8) {
+            m_Out.push_back(static_cast<unsigned char>(m_Bits & 0xFF));
+            m_Bits >>= 8;
+            m_Count -= 8;
+        }
+    }
+
+    // Huffman codes are defined MSB-first, so they go out bit-reversed.
+    void WriteCode(std::uint32_t code, int length) {
+        std::uint32_t reversed = 0;
+        for (int i = 0; i < length; i++) {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        Write(reversed, length);
+    }
+
+    void Flush() {
+        if (m_Count > 0) {
+            m_Out.push_back(static_cast<unsigned char>(m_Bits & 0xFF));
+            m_Bits = 0;
+            m_Count = 0;
+        }
+    }
+
+private:
+    std::vector<unsigned char>& m_Out;
+    std::uint64_t m_Bits;
+    int m_Count;
+};
+
+const int kLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                             35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const int kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                              3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const int kDistBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                           257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const int kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+void WriteLiteralLengthCode(BitWriter& bits, int symbol) {
+    if (symbol < 144) bits.WriteCode(0x30 + symbol, 8);
+    else if (symbol < 256) bits.WriteCode(0x190 + (symbol - 144), 9);
+    else if (symbol < 280) bits.WriteCode(symbol - 256, 7);
+    else bits.WriteCode(0xC0 + (symbol - 280), 8);
+}
+
+void WriteMatch(BitWriter& bits, int length, int distance) {
+    int li = 28;
+    while (kLengthBase[li] > length) li--;
+    WriteLiteralLengthCode(bits, 257 + li);
+    if (kLengthExtra[li] > 0) bits.Write(length - kLengthBase[li], kLengthExtra[li]);
+
+    int di = 29;
+    while (kDistBase[di] > distance) di--;
+    bits.WriteCode(di, 5);
+    if (kDistExtra[di] > 0) bits.Write(distance - kDistBase[di], kDistExtra[di]);
+}
+
+// zlib stream: one fixed-Huffman block with greedy LZ77 matching (one candidate per hash).
+std::vector<unsigned char> ZlibCompress(const std::vector<unsigned char>& data) {
+    constexpr int kWindow = 32768;
+    constexpr int kMinMatch = 3;
+    constexpr int kMaxMatch = 258;
+    constexpr int kHashBits = 15;
+
+    std::vector<unsigned char> out;
+    out.reserve(data.size() / 4 + 64);
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    BitWriter bits(out);
+    bits.Write(1, 1); // BFINAL
+    bits.Write(1, 2); // BTYPE = fixed Huffman
+
+    std::vector<int> head(1 << kHashBits, -1);
+    auto hashAt = [&](std::size_t i) {
+        const std::uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+        return (v * 2654435761u) >> (32 - kHashBits);
+    };
+
+    const std::size_t n = data.size();
+    std::size_t i = 0;
+    while (i < n) {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (i + kMinMatch <= n) {
+            const std::uint32_t h = hashAt(i);
+            const int candidate = head[h];
+            head[h] = static_cast<int>(i);
+            if (candidate >= 0 && static_cast<int>(i) - candidate <= kWindow) {
+                const std::size_t maxLength = std::min<std::size_t>(kMaxMatch, n - i);
+                std::size_t length = 0;
+                while (length < maxLength && data[candidate + length] == data[i + length]) length++;
+                if (length >= static_cast<std::size_t>(kMinMatch)) {
+                    bestLength = static_cast<int>(length);
+                    bestDistance = static_cast<int>(i) - candidate;
+                }
+            }
+        }
+
+        if (bestLength > 0) {
+            WriteMatch(bits, bestLength, bestDistance);
+            // Keep the hash table warm inside the match so later repeats are found.
+            for (std::size_t k = i + 1; k < i + bestLength && k + kMinMatch <= n; k++) {
+                head[hashAt(k)] = static_cast<int>(k);
+            }
+            i += bestLength;
+        } else {
+            WriteLiteralLengthCode(bits, data[i]);
+            i++;
+        }
+    }
+    WriteLiteralLengthCode(bits, 256); // end of block
+    bits.Flush();
+
+    const std::uint32_t adler = Adler32(data);
+    out.push_back(static_cast<unsigned char>(adler >> 24));
+    out.push_back(static_cast<unsigned char>(adler >> 16));
+    out.push_back(static_cast<unsigned char>(adler >> 8));
+    out.push_back(static_cast<unsigned char>(adler));
+    return out;
+}
+
+void AppendU32(std::vector<unsigned char>& out, std::uint32_t v) {
+    out.push_back(static_cast<unsigned char>(v >> 24));
+    out.push_back(static_cast<unsigned char>(v >> 16));
+    out.push_back(static_cast<unsigned char>(v >> 8));
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+void AppendChunk(std::vector<unsigned char>& out, const char type[4], const std::vector<unsigned char>& payload) {
+    AppendU32(out, static_cast<std::uint32_t>(payload.size()));
+    const std::size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), payload.begin(), payload.end());
+    AppendU32(out, Crc32(out.data() + typeStart, out.size() - typeStart));
+}
+} // namespace
+
+std::vector<unsigned char> ImageWriter::EncodePngRGBA(int width, int height,
+                                                      const unsigned char* rgba, bool flipVertically) {
+    if (width <= 0 || height <= 0 || !rgba) return {};
+
+    // Filter each row with Sub or Up, whichever has the smaller absolute sum.
+    const std::size_t stride = static_cast<std::size_t>(width) * 4;
+    std::vector<unsigned char> filtered;
+    filtered.reserve((stride + 1) * height);
+    std::vector<unsigned char> sub(stride);
+    std::vector<unsigned char> up(stride);
+    for (int y = 0; y < height; y++) {
+        const int srcRow = flipVertically ? (height - 1 - y) : y;
+        const unsigned char* row = rgba + static_cast<std::size_t>(srcRow) * stride;
+        const int prevSrcRow = flipVertically ? (srcRow + 1) : (srcRow - 1);
+        const unsigned char* prev = (y > 0) ? rgba + static_cast<std::size_t>(prevSrcRow) * stride : nullptr;
+
+        long subCost = 0;
+        long upCost = 0;
+        for (std::size_t i = 0; i < stride; i++) {
+            sub[i] = static_cast<unsigned char>(row[i] - (i >= 4 ? row[i - 4] : 0));
+            up[i] = static_cast<unsigned char>(row[i] - (prev ? prev[i] : 0));
+            subCost += std::abs(static_cast<int>(static_cast<signed char>(sub[i])));
+            upCost += std::abs(static_cast<int>(static_cast<signed char>(up[i])));
+        }
+
+        const bool useUp = prev && upCost < subCost;
+        filtered.push_back(useUp ? 2 : 1);
+        const std::vector<unsigned char>& chosen = useUp ? up : sub;
+        filtered.insert(filtered.end(), chosen.begin(), chosen.end());
+    }
+
+    std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::vector<unsigned char> header;
+    AppendU32(header, static_cast<std::uint32_t>(width));
+    AppendU32(header, static_cast<std::uint32_t>(height));
+    header.push_back(8); // bit depth
+    header.push_back(6); // RGBA
+    header.push_back(0); // deflate
+    header.push_back(0); // adaptive filtering
+    header.push_back(0); // no interlace
+    AppendChunk(png, "IHDR", header);
+    AppendChunk(png, "IDAT", ZlibCompress(filtered));
+    AppendChunk(png, "IEND", {});
+    return png;
+}
+
+bool ImageWriter::WritePngRGBA(const std::string& filepath, int width, int height,
+                               const unsigned char* rgba, bool flipVertically) {
+    const std::vector<unsigned char> png = EncodePngRGBA(width, height, rgba, flipVertically);
+    if (png.empty()) {
+        std::cerr << "Invalid image for PNG: " << filepath << std::endl;
+        return false;
+    }
+
+    std::ofstream out(filepath, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open for writing: " << filepath << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,174 @@
+#include "IntegralImage.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+IntegralImage::IntegralImage()
+    : m_Width(0)
+    , m_Height(0)
+    , m_Offset(0.0)
+    , m_Scale(1.0)
+{
+}
+
+void IntegralImage::Build(const ImageLoader& image) {
+    Clear();
+    if (!image.IsLoaded() || image.GetWidth() <= 0 || image.GetHeight() <= 0) return;
+
+    m_Width = image.GetWidth();
+    m_Height = image.GetHeight();
+    double minValue = 0.0;
+    double maxValue = 1.0;
+    image.GetDataRange(minValue, maxValue);
+    m_Offset = minValue;
+    m_Scale = maxValue - minValue;
+
+    const std::size_t stride = static_cast<std::size_t>(m_Width) + 1;
+    m_Sum.assign(stride * (static_cast<std::size_t>(m_Height) + 1), 0.0);
+    m_SumSq.assign(m_Sum.size(), 0.0);
+    const bool hasBlank = image.HasBlankPixels();
+    if (hasBlank) m_Count.assign(m_Sum.size(), 0);
+
+    // Row prefix sums, rows in parallel.
+    ParallelForRanges(static_cast<std::size_t>(m_Height), 64, [&](std::size_t begin, std::size_t end, unsigned int) {
+        std::vector<float> values(static_cast<std::size_t>(m_Width));
+        std::vector<std::uint8_t> blank(hasBlank ? values.size() : 0);
+        for (std::size_t y = begin; y < end; y++) {
+            image.GetNormalizedRow(static_cast<int>(y), 0, m_Width, values.data());
+            if (hasBlank) image.GetBlankRow(static_cast<int>(y), 0, m_Width, blank.data());
+            double* sumRow = &m_Sum[(y + 1) * stride];
+            double* sqRow = &m_SumSq[(y + 1) * stride];
+            double sum = 0.0;
+            double sumSq = 0.0;
+            std::uint32_t count = 0;
+            for (int x = 0; x < m_Width; x++) {
+                if (!hasBlank || !blank[x]) {
+                    const double v = values[x];
+                    sum += v;
+                    sumSq += v * v;
+                    count++;
+                }
+                sumRow[x + 1] = sum;
+                sqRow[x + 1] = sumSq;
+                if (hasBlank) m_Count[(y + 1) * stride + x + 1] = count;
+            }
+        }
+    });
+
+    // Then accumulate down the columns, column bands in parallel.
+    ParallelForRanges(stride, 256, [&](std::size_t begin, std::size_t end, unsigned int) {
+        for (int y = 1; y <= m_Height; y++) {
+            const std::size_t row = static_cast<std::size_t>(y) * stride;
+            const std::size_t above = row - stride;
+            for (std::size_t x = begin; x < end; x++) {
+                m_Sum[row + x] += m_Sum[above + x];
+                m_SumSq[row + x] += m_SumSq[above + x];
+                if (hasBlank) m_Count[row + x] += m_Count[above + x];
+            }
+        }
+    });
+}
+
+void IntegralImage::Clear() {
+    m_Width = 0;
+    m_Height = 0;
+    m_Sum.clear();
+    m_Sum.shrink_to_fit();
+    m_SumSq.clear();
+    m_SumSq.shrink_to_fit();
+    m_Count.clear();
+    m_Count.shrink_to_fit();
+    m_Offset = 0.0;
+    m_Scale = 1.0;
+}
+
+std::size_t IntegralImage::GetMemoryBytes() const {
+    return (m_Sum.capacity() + m_SumSq.capacity()) * sizeof(double) + m_Count.capacity() * sizeof(std::uint32_t);
+}
+
+void IntegralImage::SumRect(int x0, int y0, int x1, int y1, std::size_t& count, double& sum, double& sumSq) const {
+    count = 0;
+    sum = 0.0;
+    sumSq = 0.0;
+    if (IsEmpty()) return;
+
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, m_Width - 1);
+    y1 = std::min(y1, m_Height - 1);
+    if (x0 > x1 || y0 > y1) return;
+
+    const std::size_t stride = static_cast<std::size_t>(m_Width) + 1;
+    const std::size_t top = static_cast<std::size_t>(y0) * stride;
+    const std::size_t bottom = (static_cast<std::size_t>(y1) + 1) * stride;
+    const std::size_t left = static_cast<std::size_t>(x0);
+    const std::size_t right = static_cast<std::size_t>(x1) + 1;
+
+    if (m_Count.empty()) {
+        count = static_cast<std::size_t>(x1 - x0 + 1) * static_cast<std::size_t>(y1 - y0 + 1);
+    } else {
+        count = m_Count[bottom + right] - m_Count[top + right] - m_Count[bottom + left] + m_Count[top + left];
+    }
+    sum = m_Sum[bottom + right] - m_Sum[top + right] - m_Sum[bottom + left] + m_Sum[top + left];
+    sumSq = m_SumSq[bottom + right] - m_SumSq[top + right] - m_SumSq[bottom + left] + m_SumSq[top + left];
+}
+
+IntegralImage::Stats IntegralImage::MakeStats(std::size_t count, double sum, double sumSq) const {
+    Stats stats;
+    stats.count = count;
+    if (count == 0) return stats;
+
+    const double n = static_cast<double>(count);
+    const double mean = sum / n;
+    // Rounding can leave a tiny negative variance for flat regions.
+    const double variance = std::max(0.0, sumSq / n - mean * mean);
+    stats.mean = m_Offset + m_Scale * mean;
+    stats.sum = m_Offset * n + m_Scale * sum;
+    stats.stddev = std::abs(m_Scale) * std::sqrt(variance);
+    return stats;
+}
+
+IntegralImage::Stats IntegralImage::GetRectStats(int x0, int y0, int x1, int y1) const {
+    std::size_t count = 0;
+    double sum = 0.0;
+    double sumSq = 0.0;
+    SumRect(x0, y0, x1, y1, count, sum, sumSq);
+    return MakeStats(count, sum, sumSq);
+}
+
+IntegralImage::Stats IntegralImage::GetSquareStats(int cx, int cy, int halfSize) const {
+    halfSize = std::max(halfSize, 0);
+    return GetRectStats(cx - halfSize, cy - halfSize, cx + halfSize, cy + halfSize);
+}
+
+IntegralImage::Snr IntegralImage::GetSnr(int cx, int cy, int apertureHalfSize, int backgroundHalfSize) const {
+    Snr result;
+    apertureHalfSize = std::max(apertureHalfSize, 0);
+    backgroundHalfSize = std::max(backgroundHalfSize, apertureHalfSize + 1);
+
+    std::size_t apCount = 0;
+    double apSum = 0.0;
+    double apSumSq = 0.0;
+    SumRect(cx - apertureHalfSize, cy - apertureHalfSize, cx + apertureHalfSize, cy + apertureHalfSize,
+            apCount, apSum, apSumSq);
+
+    std::size_t outerCount = 0;
+    double outerSum = 0.0;
+    double outerSumSq = 0.0;
+    SumRect(cx - backgroundHalfSize, cy - backgroundHalfSize, cx + backgroundHalfSize, cy + backgroundHalfSize,
+            outerCount, outerSum, outerSumSq);
+
+    result.aperture = MakeStats(apCount, apSum, apSumSq);
+    // The aperture lies inside the outer square, so the annulus is a plain difference.
+    result.background = MakeStats(outerCount - apCount, outerSum - apSum, outerSumSq - apSumSq);
+    if (result.aperture.count == 0 || result.background.count < 2) return result;
+
+    const double n = static_cast<double>(result.aperture.count);
+    result.signal = result.aperture.sum - n * result.background.mean;
+    const double noise = result.background.stddev * std::sqrt(n);
+    result.snr = noise > 0.0 ? result.signal / noise : 0.0;
+    result.valid = noise > 0.0;
+    return result;
+}
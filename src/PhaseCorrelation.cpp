@@ -0,0 +1,241 @@
+#include "PhaseCorrelation.h"
+#include "Fft.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+namespace {
+constexpr double kTwoPi = 6.283185307179586476925286766559;
+// Gaussian taper on the whitened spectrum (cycles per pixel). Whitening alone lifts the
+// noisy high frequencies and leaves a one-pixel spike that a parabola cannot place.
+constexpr double kSpectrumSigma = 0.1;
+
+// Mean-subtracted, Hann-windowed crop in the top-left corner of a zeroed size x size
+// buffer. Blank pixels (no data) are left out of the mean and set to 0 after the
+// subtraction, so they add nothing. False if the crop is flat or blank.
+bool FillWindowedCrop(const ImageLoader& image, int x0, int y0, int crop, int size, const std::vector<float>& window,
+                      std::vector<float>& out, std::vector<std::uint8_t>& blank) {
+    out.assign(static_cast<std::size_t>(size) * size, 0.0f);
+    blank.resize(static_cast<std::size_t>(crop) * crop);
+    double sum = 0.0;
+    std::size_t count = 0;
+    for (int y = 0; y < crop; y++) {
+        float* row = &out[static_cast<std::size_t>(y) * size];
+        std::uint8_t* rowBlank = &blank[static_cast<std::size_t>(y) * crop];
+        image.GetNormalizedRow(y0 + y, x0, crop, row);
+        image.GetBlankRow(y0 + y, x0, crop, rowBlank);
+        for (int x = 0; x < crop; x++) {
+            if (!rowBlank[x]) {
+                sum += row[x];
+                count++;
+            }
+        }
+    }
+    if (count == 0) return false;
+
+    const float mean = static_cast<float>(sum / static_cast<double>(count));
+    double power = 0.0;
+    for (int y = 0; y < crop; y++) {
+        float* row = &out[static_cast<std::size_t>(y) * size];
+        const std::uint8_t* rowBlank = &blank[static_cast<std::size_t>(y) * crop];
+        for (int x = 0; x < crop; x++) {
+            const float v = rowBlank[x] ? 0.0f : row[x] - mean;
+            row[x] = v * window[y] * window[x];
+            power += static_cast<double>(row[x]) * row[x];
+        }
+    }
+    return power > 0.0;
+}
+
+// Vertex of the parabola through (-1, a), (0, b), (1, c), within half a pixel.
+float ParabolicOffset(float a, float b, float c) {
+    const float denominator = a - 2.0f * b + c;
+    if (denominator >= 0.0f) return 0.0f; // not a maximum
+    return std::clamp(0.5f * (a - c) / denominator, -0.5f, 0.5f);
+}
+} // namespace
+
+PhaseCorrelation::Result PhaseCorrelation::Measure(const ImageLoader& aligned, const ImageLoader& templ, int centerX,
+                                                   int centerY, int cropSize) {
+    Result result;
+    result.centerX = centerX;
+    result.centerY = centerY;
+    result.cropSize = std::clamp(cropSize, kMinCrop, kMaxCrop);
+    if (!aligned.IsLoaded() || !templ.IsLoaded()) return result;
+
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    if (!GetCropRect(std::min(aligned.GetWidth(), templ.GetWidth()), std::min(aligned.GetHeight(), templ.GetHeight()),
+                     centerX, centerY, result.cropSize, x0, y0, x1, y1)) {
+        return result;
+    }
+    const int crop = x1 - x0 + 1;
+    const int size = std::max(FftPlan::NextPowerOfTwo(crop), 16);
+    result.fftSize = size;
+
+    std::vector<float> window(static_cast<std::size_t>(crop));
+    for (int i = 0; i < crop; i++) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(kTwoPi * (i + 0.5) / crop));
+    }
+
+    std::vector<float> alignedCrop;
+    std::vector<float> templateCrop;
+    std::vector<std::uint8_t> blank;
+    if (!FillWindowedCrop(aligned, x0, y0, crop, size, window, alignedCrop, blank)) return result;
+    if (!FillWindowedCrop(templ, x0, y0, crop, size, window, templateCrop, blank)) return result;
+
+    const std::shared_ptr<const RealFft2D> fft = RealFft2D::Get(size);
+    std::vector<std::complex<float>> alignedSpectrum(fft->GetSpectrumCount());
+    std::vector<std::complex<float>> templateSpectrum(fft->GetSpectrumCount());
+    fft->Forward(alignedCrop.data(), alignedSpectrum.data());
+    fft->Forward(templateCrop.data(), templateSpectrum.data());
+
+    // Separable taper over signed frequencies; its sum is the peak of a perfect match.
+    std::vector<float> taper(static_cast<std::size_t>(size));
+    double taperSum = 0.0;
+    for (int k = 0; k < size; k++) {
+        const double f = static_cast<double>(k > size / 2 ? k - size : k) / size;
+        taper[k] = static_cast<float>(std::exp(-f * f / (2.0 * kSpectrumSigma * kSpectrumSigma)));
+        taperSum += taper[k];
+    }
+    const float peakScale = static_cast<float>(static_cast<double>(size) * size / (taperSum * taperSum));
+
+    // Normalized cross-power spectrum: unit magnitude, phase = the shift.
+    const int width = fft->GetSpectrumWidth();
+    for (std::size_t i = 0; i < alignedSpectrum.size(); i++) {
+        const std::complex<float> cross = alignedSpectrum[i] * std::conj(templateSpectrum[i]);
+        const float magnitude = std::abs(cross);
+        const float weight = taper[i % width] * taper[i / width];
+        alignedSpectrum[i] = magnitude > 1e-20f ? cross * (weight / magnitude) : std::complex<float>(0.0f, 0.0f);
+    }
+    std::vector<float>& surface = alignedCrop; // reuse
+    fft->Inverse(alignedSpectrum.data(), surface.data());
+
+    const auto best = std::max_element(surface.begin(), surface.end());
+    const int peakIndex = static_cast<int>(best - surface.begin());
+    const int px = peakIndex % size;
+    const int py = peakIndex / size;
+    auto at = [&](int x, int y) {
+        return surface[static_cast<std::size_t>((y + size) % size) * size + static_cast<std::size_t>((x + size) % size)];
+    };
+
+    // Peaks past the middle are negative shifts (the surface is circular).
+    const float peak = *best;
+    float dx = static_cast<float>(px > size / 2 ? px - size : px);
+    float dy = static_cast<float>(py > size / 2 ? py - size : py);
+    dx += ParabolicOffset(at(px - 1, py), peak, at(px + 1, py));
+    dy += ParabolicOffset(at(px, py - 1), peak, at(px, py + 1));
+
+    result.valid = true;
+    result.dx = dx;
+    result.dy = dy;
+    result.peak = peak * peakScale;
+    return result;
+}
+
+bool PhaseCorrelation::GetCropRect(int width, int height, int centerX, int centerY, int cropSize, int& x0, int& y0,
+                                   int& x1, int& y1) {
+    // Near the frame edge the crop is shifted inside the frame (and shrunk if the frame is
+    // smaller), so it measures pixels rather than the zero padding outside.
+    const int crop = std::min({std::clamp(cropSize, kMinCrop, kMaxCrop), width, height});
+    if (crop < kMinCrop) return false;
+    x0 = std::clamp(centerX - crop / 2, 0, width - crop);
+    y0 = std::clamp(centerY - crop / 2, 0, height - crop);
+    x1 = x0 + crop - 1;
+    y1 = y0 + crop - 1;
+    return true;
+}
+
+RegistrationBatch::RegistrationBatch()
+    : m_Cancelled(false)
+    , m_Done(0)
+    , m_Total(0)
+{
+}
+
+RegistrationBatch::~RegistrationBatch() {
+    Cancel();
+    Wait();
+}
+
+bool RegistrationBatch::Start(std::vector<Target> targets, int cropSize, ImageSource source, bool reproject,
+                              Reprojector::Params reprojectParams) {
+    if (m_Run.valid() || !source) return false;
+
+    m_Cancelled = false;
+    m_Done = 0;
+    m_Total = targets.size();
+    m_Results.clear();
+
+    m_Run = std::async(std::launch::async, [this, targets = std::move(targets), cropSize, source = std::move(source),
+                                            reproject, reprojectParams]() -> std::vector<Entry> {
+        std::vector<Entry> entries(targets.size());
+        std::map<std::pair<std::string, std::string>, std::vector<std::size_t>> pairs;
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            entries[i].target = targets[i];
+            pairs[{targets[i].alignedPath, targets[i].templatePath}].push_back(i);
+        }
+
+        for (const auto& pair : pairs) {
+            if (m_Cancelled) break;
+            const std::shared_ptr<const ImageLoader> aligned = source(pair.first.first);
+            std::shared_ptr<const ImageLoader> templ = aligned ? source(pair.first.second) : nullptr;
+            const std::vector<std::size_t>& members = pair.second;
+            const char* error = !aligned ? "aligned not loaded" : !templ ? "template not loaded" : nullptr;
+            if (!error && reproject) {
+                // One resampling over the bounding box of the pair's crops.
+                int x0 = aligned->GetWidth(), y0 = aligned->GetHeight(), x1 = -1, y1 = -1;
+                for (std::size_t i : members) {
+                    int cx0 = 0, cy0 = 0, cx1 = 0, cy1 = 0;
+                    if (!PhaseCorrelation::GetCropRect(aligned->GetWidth(), aligned->GetHeight(), targets[i].pixelX,
+                                                       targets[i].pixelY, cropSize, cx0, cy0, cx1, cy1)) {
+                        continue;
+                    }
+                    x0 = std::min(x0, cx0);
+                    y0 = std::min(y0, cy0);
+                    x1 = std::max(x1, cx1);
+                    y1 = std::max(y1, cy1);
+                }
+                templ = Reprojector::Reproject(*templ, *aligned, x0, y0, x1, y1, reprojectParams);
+                if (!templ) error = "template not reprojected";
+            }
+            if (error) {
+                for (std::size_t i : members) {
+                    entries[i].error = error;
+                }
+                m_Done += members.size();
+                continue;
+            }
+
+            ParallelForEach(members.size(), [&](std::size_t k) {
+                if (m_Cancelled) return;
+                Entry& entry = entries[members[k]];
+                entry.result = PhaseCorrelation::Measure(*aligned, *templ, entry.target.pixelX, entry.target.pixelY,
+                                                         cropSize);
+                m_Done++;
+            });
+        }
+        return entries;
+    });
+    return true;
+}
+
+void RegistrationBatch::Cancel() {
+    m_Cancelled = true;
+}
+
+void RegistrationBatch::Wait() {
+    if (m_Run.valid()) m_Run.wait();
+}
+
+bool RegistrationBatch::Poll() {
+    if (!m_Run.valid() || m_Run.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+    m_Results = m_Run.get();
+    return true;
+}
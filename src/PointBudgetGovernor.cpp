@@ -0,0 +1,156 @@
+#include "PointBudgetGovernor.h"
+#include "Geometry/PointCloud.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+// Clouds this small (e.g. highlight patches) are always drawn in full.
+constexpr std::int64_t kAlwaysFullPointCount = 65536;
+} // namespace
+
+PointBudgetGovernor::PointBudgetGovernor()
+    : m_WriteIndex(0)
+    , m_QueryActive(false)
+    , m_Enabled(true)
+    , m_TargetFrameMs(16.0f)
+    , m_LastGpuFrameMs(0.0f)
+    , m_PointBudget(32 * 1000 * 1000)
+    , m_MinPointBudget(250 * 1000)
+    , m_MaxPointBudget(32 * 1000 * 1000)
+    , m_LastTotalPoints(0)
+    , m_LastDrawnPoints(0)
+{
+    for (int i = 0; i < kQueryCount; i++) {
+        m_Queries[i] = 0;
+        m_QueryPending[i] = false;
+    }
+}
+
+PointBudgetGovernor::~PointBudgetGovernor() {
+    Shutdown();
+}
+
+bool PointBudgetGovernor::Initialize() {
+    glGenQueries(kQueryCount, m_Queries);
+    for (int i = 0; i < kQueryCount; i++) {
+        m_QueryPending[i] = false;
+    }
+    m_WriteIndex = 0;
+    m_QueryActive = false;
+    return true;
+}
+
+void PointBudgetGovernor::Shutdown() {
+    if (m_Queries[0] != 0) {
+        glDeleteQueries(kQueryCount, m_Queries);
+        for (int i = 0; i < kQueryCount; i++) {
+            m_Queries[i] = 0;
+            m_QueryPending[i] = false;
+        }
+    }
+    m_QueryActive = false;
+}
+
+void PointBudgetGovernor::BeginFrame() {
+    if (m_Queries[0] == 0) return;
+
+    ReadFinishedQueries();
+
+    // GPU is more than kQueryCount frames behind: skip measuring this frame rather than stall.
+    if (m_QueryPending[m_WriteIndex]) {
+        m_QueryActive = false;
+        return;
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, m_Queries[m_WriteIndex]);
+    m_QueryActive = true;
+}
+
+void PointBudgetGovernor::EndFrame() {
+    if (!m_QueryActive) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_QueryPending[m_WriteIndex] = true;
+    m_WriteIndex = (m_WriteIndex + 1) % kQueryCount;
+    m_QueryActive = false;
+}
+
+void PointBudgetGovernor::ReadFinishedQueries() {
+    // Oldest pending query first, so results are applied in submission order.
+    for (int n = 0; n < kQueryCount; n++) {
+        const int i = (m_WriteIndex + n) % kQueryCount;
+        if (!m_QueryPending[i]) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(m_Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(m_Queries[i], GL_QUERY_RESULT, &elapsedNs);
+        m_QueryPending[i] = false;
+
+        m_LastGpuFrameMs = static_cast<float>(static_cast<double>(elapsedNs) / 1.0e6);
+        AdjustBudget(m_LastGpuFrameMs);
+    }
+}
+
+void PointBudgetGovernor::AdjustBudget(float gpuFrameMs) {
+    if (!m_Enabled || gpuFrameMs <= 0.0f) return;
+
+    if (gpuFrameMs > m_TargetFrameMs) {
+        // Over target: shrink relative to what was actually drawn, so a huge unused budget
+        // does not take several frames to bite.
+        const float factor = std::clamp(m_TargetFrameMs / gpuFrameMs * 0.95f, 0.5f, 0.95f);
+        const std::int64_t base = std::min(m_PointBudget, std::max<std::int64_t>(m_LastDrawnPoints, m_MinPointBudget));
+        m_PointBudget = static_cast<std::int64_t>(static_cast<double>(base) * factor);
+    } else if (gpuFrameMs < m_TargetFrameMs * 0.75f && m_LastTotalPoints > m_LastDrawnPoints) {
+        // Comfortably under target while clouds are being thinned: grow back slowly.
+        m_PointBudget = static_cast<std::int64_t>(static_cast<double>(m_PointBudget) * 1.1);
+    }
+
+    m_PointBudget = std::clamp(m_PointBudget, m_MinPointBudget, m_MaxPointBudget);
+}
+
+void PointBudgetGovernor::Distribute(const std::vector<PointCloud*>& visibleClouds) {
+    std::int64_t total = 0;
+    std::int64_t smallTotal = 0;
+    std::int64_t pinnedTotal = 0;
+    for (PointCloud* cloud : visibleClouds) {
+        const std::int64_t count = cloud->GetActivePointCount();
+        total += count;
+        if (count <= kAlwaysFullPointCount) smallTotal += count;
+        pinnedTotal += cloud->GetPinnedPointCount();
+    }
+    // Pinned points are always drawn; they come out of the budget first.
+    total += pinnedTotal;
+    smallTotal += pinnedTotal;
+    m_LastTotalPoints = total;
+
+    if (!m_Enabled || total <= m_PointBudget) {
+        for (PointCloud* cloud : visibleClouds) {
+            cloud->SetDrawBudget(-1);
+        }
+        m_LastDrawnPoints = total;
+        return;
+    }
+
+    // Small clouds and pinned points are reserved first; large clouds share the rest at a common density.
+    const std::int64_t largeTotal = total - smallTotal;
+    const std::int64_t remaining = std::max<std::int64_t>(m_PointBudget - smallTotal, 0);
+    const double ratio = (largeTotal > 0) ? std::min(1.0, static_cast<double>(remaining) / static_cast<double>(largeTotal)) : 1.0;
+
+    std::int64_t drawn = pinnedTotal;
+    for (PointCloud* cloud : visibleClouds) {
+        const std::int64_t count = cloud->GetActivePointCount();
+        if (count <= kAlwaysFullPointCount) {
+            cloud->SetDrawBudget(-1);
+            drawn += count;
+            continue;
+        }
+        const int budget = static_cast<int>(std::max<std::int64_t>(1, static_cast<std::int64_t>(count * ratio)));
+        cloud->SetDrawBudget(budget);
+        drawn += budget;
+    }
+    m_LastDrawnPoints = drawn;
+}
@@ -0,0 +1,155 @@
+#include "PreviewEngine.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+
+PreviewEngine::PreviewEngine()
+    : m_Texture(0)
+    , m_Pbo(0)
+    , m_TextureSize(0)
+    , m_Mapped(false)
+    , m_CenterX(0)
+    , m_CenterY(0)
+    , m_CropSize(0)
+    , m_OutputSize(0)
+    , m_LevelLow(0.0f)
+    , m_LevelHigh(1.0f)
+{
+}
+
+PreviewEngine::~PreviewEngine() {
+    // GL objects are freed in Release(), while the context is still current.
+}
+
+void PreviewEngine::Update(const ImageLoader& image, int centerX, int centerY, int cropSize, int outputSize) {
+    m_CropSize = std::max(cropSize, 1);
+    m_OutputSize = std::clamp(outputSize > 0 ? outputSize : m_CropSize, 1, kMaxSize);
+    m_CenterX = centerX;
+    m_CenterY = centerY;
+
+    ComputeLevels(image, m_LevelsPreset, centerX, centerY, m_CropSize, m_RoiHistogram, m_LevelLow, m_LevelHigh);
+
+    const int half = m_CropSize / 2;
+    unsigned char* pixels = BeginUpload(m_OutputSize);
+    image.BuildRegionRGBA(centerX - half, centerY - half, m_CropSize, m_CropSize, m_OutputSize, m_OutputSize,
+                          /*contrastStretch*/ true, pixels, m_Scratch, m_LevelLow, m_LevelHigh);
+    EndUpload();
+}
+
+void PreviewEngine::Recenter(const ImageLoader& image, int centerX, int centerY) {
+    if (m_CropSize <= 0 || (centerX == m_CenterX && centerY == m_CenterY)) return;
+    Update(image, centerX, centerY, m_CropSize, m_OutputSize);
+}
+
+void PreviewEngine::Refresh(const ImageLoader& image) {
+    if (m_CropSize <= 0) return;
+    Update(image, m_CenterX, m_CenterY, m_CropSize, m_OutputSize);
+}
+
+void PreviewEngine::Upload(const ImageLoader& image, const unsigned char* rgba, int centerX, int centerY, int cropSize,
+                           int outputSize) {
+    m_CropSize = std::max(cropSize, 1);
+    m_OutputSize = std::clamp(outputSize > 0 ? outputSize : m_CropSize, 1, kMaxSize);
+    m_CenterX = centerX;
+    m_CenterY = centerY;
+    // Only for the histogram view; the pixels already carry these levels.
+    ComputeLevels(image, m_LevelsPreset, centerX, centerY, m_CropSize, m_RoiHistogram, m_LevelLow, m_LevelHigh);
+
+    unsigned char* pixels = BeginUpload(m_OutputSize);
+    std::memcpy(pixels, rgba, static_cast<std::size_t>(m_OutputSize) * m_OutputSize * 4);
+    EndUpload();
+}
+
+void PreviewEngine::ComputeLevels(const ImageLoader& image, const Histogram::LevelsPreset& preset, int centerX,
+                                  int centerY, int cropSize, Histogram& roiScratch, float& outLow, float& outHigh) {
+    const bool zscale = preset.mode == Histogram::LevelsPreset::Mode::ZScale;
+    if (!preset.fromRoi) {
+        if (zscale) {
+            image.GetZScale(outLow, outHigh);
+        } else {
+            image.GetHistogram().ComputeLevels(preset, outLow, outHigh);
+        }
+        return;
+    }
+    const int x0 = centerX - cropSize / 2;
+    const int y0 = centerY - cropSize / 2;
+    // The crop histogram is still built for the levels view.
+    roiScratch.BuildRegion(image, x0, y0, x0 + cropSize - 1, y0 + cropSize - 1);
+    if (zscale) {
+        image.GetRegionZScale(x0, y0, x0 + cropSize - 1, y0 + cropSize - 1, outLow, outHigh);
+    } else {
+        roiScratch.ComputeLevels(preset, outLow, outHigh);
+    }
+}
+
+void PreviewEngine::Release() {
+    if (m_Texture != 0) {
+        glDeleteTextures(1, &m_Texture);
+        m_Texture = 0;
+    }
+    if (m_Pbo != 0) {
+        glDeleteBuffers(1, &m_Pbo);
+        m_Pbo = 0;
+    }
+    m_TextureSize = 0;
+    m_CropSize = 0;
+    m_OutputSize = 0;
+    m_Name.clear();
+    m_Fallback.clear();
+    m_Fallback.shrink_to_fit();
+}
+
+unsigned char* PreviewEngine::BeginUpload(int outputSize) {
+    if (m_Texture == 0) {
+        glGenTextures(1, &m_Texture);
+        glBindTexture(GL_TEXTURE_2D, m_Texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (m_TextureSize != outputSize) {
+        // Storage only; pixels arrive through glTexSubImage2D.
+        glBindTexture(GL_TEXTURE_2D, m_Texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, outputSize, outputSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_TextureSize = outputSize;
+    }
+
+    const std::size_t bytes = static_cast<std::size_t>(outputSize) * outputSize * 4;
+    if (m_Pbo == 0) {
+        glGenBuffers(1, &m_Pbo);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Pbo);
+    // Orphan the previous contents so mapping never waits for an upload still in flight.
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        m_Mapped = true;
+        return static_cast<unsigned char*>(mapped);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_Mapped = false;
+    m_Fallback.resize(bytes);
+    return m_Fallback.data();
+}
+
+void PreviewEngine::EndUpload() {
+    glBindTexture(GL_TEXTURE_2D, m_Texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (m_Mapped) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        // With a PBO bound the data argument is an offset into it.
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_TextureSize, m_TextureSize, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        m_Mapped = false;
+    } else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_TextureSize, m_TextureSize, GL_RGBA, GL_UNSIGNED_BYTE,
+                        m_Fallback.data());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -2,6 +2,7 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "GeometryObject.h"
+#include "PointBudgetGovernor.h"
 #include <glad/glad.h>
 #include <iostream>
 
@@ -33,6 +34,9 @@ bool Renderer::Initialize() {
 
     glBindVertexArray(0);
 
+    m_PointBudget = std::make_unique<PointBudgetGovernor>();
+    m_PointBudget->Initialize();
+
     std::cout << "Renderer initialized" << std::endl;
     return true;
 }
@@ -47,9 +51,11 @@ void Renderer::Shutdown() {
         m_LineVBO = 0;
     }
 
+    m_PointBudget.reset();
     m_DefaultShader.reset();
     m_LineShader.reset();
     m_PointCloudShader.reset();
+    m_SurfaceShader.reset();
 }
 
 void Renderer::SetupShaders() {
@@ -149,15 +155,18 @@ void Renderer::SetupShaders() {
         #version 330 core
         layout (location = 0) in vec3 aPos;
         layout (location = 1) in vec4 aColor;
+        layout (location = 2) in uint aGroup;
 
         uniform mat4 model;
         uniform mat4 view;
         uniform mat4 projection;
+        uniform float groupPointSize[8];
 
         out vec4 vColor;
 
         void main() {
             gl_Position = projection * view * model * vec4(aPos, 1.0);
+            gl_PointSize = groupPointSize[min(aGroup, 7u)];
             vColor = aColor;
         }
     )";
@@ -174,14 +183,49 @@ void Renderer::SetupShaders() {
 
     m_PointCloudShader->LoadFromSource(pointCloudVertexShader, pointCloudFragmentShader);
 
+    // Textured heightfield shader (far-view stand-in for image point clouds)
+    m_SurfaceShader = std::make_unique<Shader>();
+    std::string surfaceVertexShader = R"(
+        #version 330 core
+        layout (location = 0) in vec3 aPos;
+        layout (location = 1) in vec2 aTexCoord;
+
+        uniform mat4 model;
+        uniform mat4 view;
+        uniform mat4 projection;
+
+        out vec2 vTexCoord;
+
+        void main() {
+            gl_Position = projection * view * model * vec4(aPos, 1.0);
+            vTexCoord = aTexCoord;
+        }
+    )";
+
+    std::string surfaceFragmentShader = R"(
+        #version 330 core
+        in vec2 vTexCoord;
+        out vec4 FragColor;
+
+        uniform sampler2D imageTexture;
+
+        void main() {
+            FragColor = vec4(texture(imageTexture, vTexCoord).rgb, 1.0);
+        }
+    )";
+
+    m_SurfaceShader->LoadFromSource(surfaceVertexShader, surfaceFragmentShader);
+
     // Grid shader uses the same shader as line shader
     // We'll use m_LineShader directly for grid rendering
 }
 
 void Renderer::BeginFrame() {
+    if (m_PointBudget) m_PointBudget->BeginFrame();
 }
 
 void Renderer::EndFrame() {
+    if (m_PointBudget) m_PointBudget->EndFrame();
 }
 
 void Renderer::Clear(const glm::vec4& color) {
@@ -218,6 +262,17 @@ void Renderer::RenderPointCloud(GeometryObject* object, Camera* camera) {
     object->Render(m_PointCloudShader.get());
 }
 
+void Renderer::RenderSurface(GeometryObject* object, Camera* camera) {
+    if (!object || !object->IsVisible()) return;
+
+    m_SurfaceShader->Use();
+    m_SurfaceShader->SetMat4("model", object->GetModelMatrix());
+    m_SurfaceShader->SetMat4("view", camera->GetViewMatrix());
+    m_SurfaceShader->SetMat4("projection", camera->GetProjectionMatrix());
+
+    object->Render(m_SurfaceShader.get());
+}
+
 void Renderer::RenderLine(const glm::vec3& start, const glm::vec3& end, const glm::vec4& color, Camera* camera) {
     float vertices[] = {
         start.x, start.y, start.z, color.r, color.g, color.b,
@@ -0,0 +1,196 @@
+#include "Reprojector.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+#include "Wcs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace {
+constexpr int kLanczosA = 3;
+constexpr int kLanczosSamples = 1024; // table entries per pixel
+constexpr double kPi = 3.14159265358979323846;
+
+// Lanczos-3 kernel sampled on [0, 3); sin() per tap would dominate the resampling.
+const std::vector<float>& LanczosTable() {
+    static const std::vector<float> table = [] {
+        std::vector<float> values(static_cast<std::size_t>(kLanczosA) * kLanczosSamples + 1, 0.0f);
+        values[0] = 1.0f;
+        for (std::size_t i = 1; i + 1 < values.size(); i++) {
+            const double x = static_cast<double>(i) / kLanczosSamples;
+            values[i] = static_cast<float>(kLanczosA * std::sin(kPi * x) * std::sin(kPi * x / kLanczosA) /
+                                           (kPi * kPi * x * x));
+        }
+        return values;
+    }();
+    return table;
+}
+
+// With blanks, blank taps get zero weight and the rest are renormalized, so neither a
+// NaN region nor the edge of the footprint pulls its neighbours towards 0.
+float SampleBilinear(const ImageLoader& image, bool blanks, float x, float y) {
+    const int w = image.GetWidth();
+    const int h = image.GetHeight();
+    const int ix = static_cast<int>(std::floor(x));
+    const int iy = static_cast<int>(std::floor(y));
+    const float fx = x - ix;
+    const float fy = y - iy;
+    const int xs[2] = {std::clamp(ix, 0, w - 1), std::clamp(ix + 1, 0, w - 1)};
+    const int ys[2] = {std::clamp(iy, 0, h - 1), std::clamp(iy + 1, 0, h - 1)};
+    const float wx[2] = {1.0f - fx, fx};
+    const float wy[2] = {1.0f - fy, fy};
+    float value = 0.0f;
+    float weightSum = 0.0f;
+    for (int j = 0; j < 2; j++) {
+        for (int k = 0; k < 2; k++) {
+            if (blanks && image.IsBlankPixel(xs[k], ys[j])) continue;
+            const float weight = wx[k] * wy[j];
+            value += weight * image.GetNormalizedPixelValue(xs[k], ys[j]);
+            weightSum += weight;
+        }
+    }
+    return weightSum > 0.0f ? value / weightSum : std::numeric_limits<float>::quiet_NaN();
+}
+
+float SampleLanczos(const ImageLoader& image, bool blanks, const std::vector<float>& table, float x, float y) {
+    const int w = image.GetWidth();
+    const int h = image.GetHeight();
+    const int ix = static_cast<int>(std::floor(x));
+    const int iy = static_cast<int>(std::floor(y));
+    const float fx = x - ix;
+    const float fy = y - iy;
+
+    float wx[2 * kLanczosA];
+    float wy[2 * kLanczosA];
+    int columns[2 * kLanczosA];
+    float sumX = 0.0f;
+    float sumY = 0.0f;
+    for (int k = 0; k < 2 * kLanczosA; k++) {
+        const int offset = k - kLanczosA + 1; // -2 .. 3
+        const float dx = std::abs(fx - offset);
+        const float dy = std::abs(fy - offset);
+        wx[k] = dx < kLanczosA ? table[static_cast<std::size_t>(dx * kLanczosSamples)] : 0.0f;
+        wy[k] = dy < kLanczosA ? table[static_cast<std::size_t>(dy * kLanczosSamples)] : 0.0f;
+        sumX += wx[k];
+        sumY += wy[k];
+        columns[k] = std::clamp(ix + offset, 0, w - 1);
+    }
+
+    float value = 0.0f;
+    float weightSum = 0.0f;
+    for (int j = 0; j < 2 * kLanczosA; j++) {
+        if (wy[j] == 0.0f) continue;
+        const int row = std::clamp(iy + j - kLanczosA + 1, 0, h - 1);
+        float rowValue = 0.0f;
+        float rowWeight = 0.0f;
+        for (int k = 0; k < 2 * kLanczosA; k++) {
+            if (blanks && image.IsBlankPixel(columns[k], row)) continue;
+            rowValue += wx[k] * image.GetNormalizedPixelValue(columns[k], row);
+            rowWeight += wx[k];
+        }
+        value += wy[j] * rowValue;
+        weightSum += wy[j] * rowWeight;
+    }
+    // Weights are renormalized so flat regions stay flat. The kernel's negative lobes can
+    // leave little weight next to blanks; fall back to bilinear there.
+    if (blanks && weightSum < 0.25f * sumX * sumY) return SampleBilinear(image, blanks, x, y);
+    return value / weightSum;
+}
+} // namespace
+
+std::shared_ptr<ImageLoader> Reprojector::Reproject(const ImageLoader& source, const ImageLoader& target, int x0,
+                                                    int y0, int x1, int y1, const Params& params) {
+    const Wcs* sourceWcs = source.GetWcs();
+    const Wcs* targetWcs = target.GetWcs();
+    if (!source.IsFits() || !sourceWcs || !targetWcs) {
+        std::cerr << "Reprojection needs FITS images with a WCS on both sides" << std::endl;
+        return nullptr;
+    }
+
+    const int width = target.GetWidth();
+    const int height = target.GetHeight();
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width - 1);
+    y1 = std::min(y1, height - 1);
+    // NaN marks blank pixels (see FitsLoader::LoadNormalized), so pixels without coverage
+    // stay distinct from data that clamps to 0.
+    std::vector<float> data(static_cast<std::size_t>(width) * height, std::numeric_limits<float>::quiet_NaN());
+
+    if (x0 <= x1 && y0 <= y1) {
+        const int tile = std::max(params.tileSize, 8);
+        const int step = std::clamp(params.gridStep, 1, tile);
+        const int tilesX = (x1 - x0 + tile) / tile;
+        const int tilesY = (y1 - y0 + tile) / tile;
+        const float sourceMaxX = source.GetWidth() - 0.5f;
+        const float sourceMaxY = source.GetHeight() - 0.5f;
+        const std::vector<float>& lanczos = LanczosTable();
+        const bool sourceBlanks = source.HasBlankPixels();
+
+        ParallelForEach(static_cast<std::size_t>(tilesX) * tilesY, [&](std::size_t index) {
+            const int tx0 = x0 + static_cast<int>(index % tilesX) * tile;
+            const int ty0 = y0 + static_cast<int>(index / tilesX) * tile;
+            const int tx1 = std::min(tx0 + tile - 1, x1);
+            const int ty1 = std::min(ty0 + tile - 1, y1);
+
+            // Exact source positions on the grid nodes (the last node sits on the tile edge).
+            const int nodesX = (tx1 - tx0 + step - 1) / step + 1;
+            const int nodesY = (ty1 - ty0 + step - 1) / step + 1;
+            auto nodeX = [&](int i) { return std::min(tx0 + i * step, tx1); };
+            auto nodeY = [&](int j) { return std::min(ty0 + j * step, ty1); };
+            std::vector<float> mapX(static_cast<std::size_t>(nodesX) * nodesY);
+            std::vector<float> mapY(mapX.size());
+            for (int j = 0; j < nodesY; j++) {
+                for (int i = 0; i < nodesX; i++) {
+                    double ra = 0.0, dec = 0.0, sx = 0.0, sy = 0.0;
+                    const bool ok = targetWcs->PixelToWorld(nodeX(i), nodeY(j), ra, dec) &&
+                                    sourceWcs->WorldToPixel(ra, dec, sx, sy);
+                    const std::size_t node = static_cast<std::size_t>(j) * nodesX + i;
+                    mapX[node] = ok ? static_cast<float>(sx) : std::numeric_limits<float>::quiet_NaN();
+                    mapY[node] = ok ? static_cast<float>(sy) : std::numeric_limits<float>::quiet_NaN();
+                }
+            }
+
+            for (int y = ty0; y <= ty1; y++) {
+                const int j = std::min((y - ty0) / step, std::max(nodesY - 2, 0));
+                const int j1 = std::min(j + 1, nodesY - 1);
+                const int span = nodeY(j1) - nodeY(j);
+                const float v = span > 0 ? static_cast<float>(y - nodeY(j)) / span : 0.0f;
+                float* out = &data[static_cast<std::size_t>(y) * width];
+                for (int x = tx0; x <= tx1; x++) {
+                    const int i = std::min((x - tx0) / step, std::max(nodesX - 2, 0));
+                    const int i1 = std::min(i + 1, nodesX - 1);
+                    const int spanX = nodeX(i1) - nodeX(i);
+                    const float u = spanX > 0 ? static_cast<float>(x - nodeX(i)) / spanX : 0.0f;
+                    auto lerp = [&](const std::vector<float>& map) {
+                        const float top = map[static_cast<std::size_t>(j) * nodesX + i] * (1.0f - u) +
+                                          map[static_cast<std::size_t>(j) * nodesX + i1] * u;
+                        const float bottom = map[static_cast<std::size_t>(j1) * nodesX + i] * (1.0f - u) +
+                                             map[static_cast<std::size_t>(j1) * nodesX + i1] * u;
+                        return top * (1.0f - v) + bottom * v;
+                    };
+                    const float sx = lerp(mapX);
+                    const float sy = lerp(mapY);
+                    // NaN (unmapped node) fails these comparisons too.
+                    if (!(sx >= -0.5f && sx <= sourceMaxX && sy >= -0.5f && sy <= sourceMaxY)) continue;
+                    if (sourceBlanks && source.IsBlankPixel(static_cast<int>(std::lround(sx)),
+                                                            static_cast<int>(std::lround(sy)))) {
+                        continue;
+                    }
+
+                    const float value = params.interpolation == Interpolation::Lanczos3
+                                            ? SampleLanczos(source, sourceBlanks, lanczos, sx, sy)
+                                            : SampleBilinear(source, sourceBlanks, sx, sy);
+                    if (!std::isnan(value)) out[x] = std::clamp(value, 0.0f, 1.0f);
+                }
+            }
+        });
+    }
+
+    auto result = std::make_shared<ImageLoader>();
+    if (!result->LoadResampled(source, std::move(data), width, height, *targetWcs)) return nullptr;
+    return result;
+}
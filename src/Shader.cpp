@@ -142,6 +142,10 @@ void Shader::SetFloat(const std::string& name, float value) const {
     glUniform1f(GetUniformLocation(name), value);
 }
 
+void Shader::SetFloatArray(const std::string& name, const float* values, int count) const {
+    glUniform1fv(GetUniformLocation(name), count, values);
+}
+
 void Shader::SetVec2(const std::string& name, const glm::vec2& value) const {
     glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value));
 }
@@ -0,0 +1,186 @@
+#include "SourceDetector.h"
+#include "ImageLoader.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+int FindRoot(std::vector<int>& parent, int label) {
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+    return label;
+}
+
+void Unite(std::vector<int>& parent, int a, int b) {
+    a = FindRoot(parent, a);
+    b = FindRoot(parent, b);
+    if (a == b) return;
+    // Keep the smaller label as root so the second pass is order-independent.
+    if (a < b) {
+        parent[b] = a;
+    } else {
+        parent[a] = b;
+    }
+}
+
+struct Component {
+    double sumW{0.0};
+    double sumWX{0.0};
+    double sumWY{0.0};
+    float peak{0.0f};
+    int area{0};
+    int x0{0}, y0{0}, x1{0}, y1{0};
+};
+} // namespace
+
+void SourceDetector::DetectRegion(const ImageLoader& image, int x0, int y0, int x1, int y1, const Params& params,
+                                  std::vector<Source>& out) {
+    const BackgroundMap& background = image.GetBackgroundMap();
+    if (!image.IsLoaded() || background.IsEmpty()) return;
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, image.GetWidth() - 1);
+    y1 = std::min(y1, image.GetHeight() - 1);
+    if (x0 > x1 || y0 > y1) return;
+
+    const int width = x1 - x0 + 1;
+    const int height = y1 - y0 + 1;
+    const std::size_t pixels = static_cast<std::size_t>(width) * height;
+
+    // Background-subtracted values, negative below the detection threshold.
+    std::vector<float> signal(pixels);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const int px = x0 + x;
+            const int py = y0 + y;
+            const float v = image.GetNormalizedPixelValue(px, py) - background.GetBackground(px, py);
+            const float threshold = params.thresholdSigma * background.GetRms(px, py);
+            signal[static_cast<std::size_t>(y) * width + x] = (std::isfinite(v) && v > threshold) ? v : -1.0f;
+        }
+    }
+
+    // First pass: provisional labels from the already visited neighbours (W, NW, N, NE).
+    std::vector<int> labels(pixels, 0);
+    std::vector<int> parent(1, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const std::size_t i = static_cast<std::size_t>(y) * width + x;
+            if (signal[i] < 0.0f) continue;
+
+            int label = 0;
+            auto visit = [&](int nx, int ny) {
+                if (nx < 0 || nx >= width || ny < 0) return;
+                const int neighbour = labels[static_cast<std::size_t>(ny) * width + nx];
+                if (neighbour == 0) return;
+                if (label == 0) {
+                    label = neighbour;
+                } else if (neighbour != label) {
+                    Unite(parent, label, neighbour);
+                }
+            };
+            visit(x - 1, y);
+            visit(x - 1, y - 1);
+            visit(x, y - 1);
+            visit(x + 1, y - 1);
+            if (label == 0) {
+                label = static_cast<int>(parent.size());
+                parent.push_back(label);
+            }
+            labels[i] = label;
+        }
+    }
+
+    // Second pass: accumulate moments per root label.
+    std::vector<int> componentOf(parent.size(), -1);
+    std::vector<Component> components;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const std::size_t i = static_cast<std::size_t>(y) * width + x;
+            if (labels[i] == 0) continue;
+            const int root = FindRoot(parent, labels[i]);
+            if (componentOf[root] < 0) {
+                componentOf[root] = static_cast<int>(components.size());
+                Component c;
+                c.x0 = c.x1 = x0 + x;
+                c.y0 = c.y1 = y0 + y;
+                components.push_back(c);
+            }
+            Component& c = components[componentOf[root]];
+            const float w = signal[i];
+            c.sumW += w;
+            c.sumWX += static_cast<double>(w) * (x0 + x);
+            c.sumWY += static_cast<double>(w) * (y0 + y);
+            c.peak = std::max(c.peak, w);
+            c.area++;
+            c.x0 = std::min(c.x0, x0 + x);
+            c.x1 = std::max(c.x1, x0 + x);
+            c.y1 = y0 + y;
+        }
+    }
+
+    for (const Component& c : components) {
+        if (c.area < params.minArea || c.sumW <= 0.0) continue;
+        Source source;
+        source.x = static_cast<float>(c.sumWX / c.sumW);
+        source.y = static_cast<float>(c.sumWY / c.sumW);
+        source.flux = c.sumW;
+        source.peak = c.peak;
+        source.area = c.area;
+        source.x0 = c.x0;
+        source.y0 = c.y0;
+        source.x1 = c.x1;
+        source.y1 = c.y1;
+        out.push_back(source);
+    }
+}
+
+void SourceDetector::DetectAll(const ImageLoader& image, const Params& params, std::vector<Source>& out) {
+    out.clear();
+    if (!image.IsLoaded()) return;
+
+    const int tile = std::max(params.tileSize, 32);
+    const int margin = std::max(params.tileMargin, 0);
+    const int tilesX = (image.GetWidth() + tile - 1) / tile;
+    const int tilesY = (image.GetHeight() + tile - 1) / tile;
+    std::vector<std::vector<Source>> perTile(static_cast<std::size_t>(tilesX) * tilesY);
+
+    ParallelForEach(perTile.size(), [&](std::size_t index) {
+        const int tx0 = static_cast<int>(index % tilesX) * tile;
+        const int ty0 = static_cast<int>(index / tilesX) * tile;
+        const int tx1 = tx0 + tile;
+        const int ty1 = ty0 + tile;
+        std::vector<Source> found;
+        DetectRegion(image, tx0 - margin, ty0 - margin, tx1 - 1 + margin, ty1 - 1 + margin, params, found);
+
+        // Each source belongs to the tile its centroid falls into.
+        std::vector<Source>& kept = perTile[index];
+        for (const Source& source : found) {
+            const int cx = static_cast<int>(std::floor(source.x + 0.5f));
+            const int cy = static_cast<int>(std::floor(source.y + 0.5f));
+            if (cx >= tx0 && cx < tx1 && cy >= ty0 && cy < ty1) kept.push_back(source);
+        }
+    });
+
+    for (const auto& sources : perTile) {
+        out.insert(out.end(), sources.begin(), sources.end());
+    }
+    std::sort(out.begin(), out.end(), [](const Source& a, const Source& b) { return a.flux > b.flux; });
+}
+
+int SourceDetector::FindNearest(const std::vector<Source>& sources, float x, float y, float maxDistance) {
+    int best = -1;
+    float bestDistanceSq = maxDistance * maxDistance;
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        const float dx = sources[i].x - x;
+        const float dy = sources[i].y - y;
+        const float distanceSq = dx * dx + dy * dy;
+        if (distanceSq <= bestDistanceSq) {
+            bestDistanceSq = distanceSq;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
@@ -0,0 +1,416 @@
+#include "TargetPrefetcher.h"
+
+#include "Data/TxtTargetParser.h"
+#include "PreviewEngine.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+std::size_t ImageBytes(const ImageLoader& image) {
+    // FITS pixels are kept as normalized floats, other images as 8-bit channels; both
+    // carry summed-area tables.
+    const std::size_t pixels = static_cast<std::size_t>(std::max(0, image.GetWidth())) * std::max(0, image.GetHeight());
+    const std::size_t data = image.IsFits() ? pixels * sizeof(float) : pixels * std::max(1, image.GetChannels());
+    return data + image.GetIntegralImage().GetMemoryBytes() + image.GetBackgroundMap().GetMemoryBytes();
+}
+
+std::size_t PreparedBytes(const TargetPrefetcher::PreparedImage& prepared) {
+    return prepared.positions.capacity() * sizeof(glm::vec3) + prepared.colors.capacity() * sizeof(glm::vec4) +
+           prepared.groups.capacity() + prepared.previewRGBA.capacity();
+}
+} // namespace
+
+TargetPrefetcher::TargetPrefetcher(std::size_t memoryCapBytes)
+    : m_Bytes(0)
+    , m_Generation(0)
+    , m_MemoryCap(memoryCapBytes)
+    , m_Hits(0)
+    , m_Misses(0)
+    , m_Stop(false)
+{
+    m_Worker = std::thread(&TargetPrefetcher::WorkerLoop, this);
+}
+
+TargetPrefetcher::~TargetPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+        m_Pending.clear();
+        m_Requested.clear();
+    }
+    m_WorkCv.notify_all();
+    m_LoadCv.notify_all();
+    if (m_Worker.joinable()) m_Worker.join();
+}
+
+std::string TargetPrefetcher::ImageKey(const std::string& path, const ImageFilter::Params& filter) {
+    return filter.IsIdentity() ? "img|" + path : "flt|" + filter.GetKey() + "|" + path;
+}
+
+std::string TargetPrefetcher::PreparedKey(const Job& job) {
+    std::ostringstream oss;
+    oss << "pts|" << job.path << '|' << job.useRoi << ',' << job.roiX << ',' << job.roiY << ',' << job.roiRadius << ','
+        << job.previewSize << ',' << job.scaleX << ',' << job.scaleY << ',' << job.scaleZ << ",h"
+        << int(job.heightMode);
+    if (!job.filter.IsIdentity()) oss << ",f" << job.filter.GetKey();
+    if (job.previewSize > 0) {
+        const Histogram::LevelsPreset& levels = job.levels;
+        oss << "|lv" << int(levels.mode) << ',' << levels.lowPercent << ',' << levels.highPercent << ','
+            << levels.sigmaLow << ',' << levels.sigmaHigh << ',' << levels.fromRoi;
+    }
+    for (const auto& h : job.highlights) {
+        oss << '|' << h.centerX << ',' << h.centerY << ',' << h.sizePixels << ',' << int(h.group) << ',' << h.color.r
+            << ',' << h.color.g << ',' << h.color.b << ',' << h.color.a;
+    }
+    return oss.str();
+}
+
+void TargetPrefetcher::Prefetch(std::vector<TargetJob> targets, std::vector<std::string> txtFiles) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Generation++;
+    m_Pending.clear();
+    for (auto& target : targets) {
+        WorkItem item;
+        item.kind = WorkItem::Kind::Target;
+        item.target = std::move(target);
+        m_Pending.push_back(std::move(item));
+    }
+    for (auto& txt : txtFiles) {
+        WorkItem item;
+        item.kind = WorkItem::Kind::Txt;
+        item.txtPath = std::move(txt);
+        m_Pending.push_back(std::move(item));
+    }
+    m_WorkCv.notify_all();
+}
+
+void TargetPrefetcher::CancelAll() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Generation++;
+    m_Pending.clear();
+}
+
+void TargetPrefetcher::SetMemoryCapBytes(std::size_t bytes) {
+    m_MemoryCap = bytes;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    while (m_Bytes > m_MemoryCap.load() && !m_Lru.empty()) {
+        auto it = m_Cache.find(m_Lru.back());
+        m_Bytes -= it->second.bytes;
+        m_Cache.erase(it);
+        m_Lru.pop_back();
+    }
+}
+
+std::size_t TargetPrefetcher::GetMemoryBytes() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Bytes;
+}
+
+std::size_t TargetPrefetcher::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Pending.size();
+}
+
+void TargetPrefetcher::TouchLocked(CacheEntry& entry, std::uint64_t generation) {
+    m_Lru.splice(m_Lru.begin(), m_Lru, entry.lru);
+    entry.generation = std::max(entry.generation, generation);
+}
+
+bool TargetPrefetcher::InsertLocked(const std::string& key, CacheEntry entry) {
+    auto existing = m_Cache.find(key);
+    if (existing != m_Cache.end()) {
+        m_Bytes -= existing->second.bytes;
+        m_Lru.erase(existing->second.lru);
+        m_Cache.erase(existing);
+    }
+
+    m_Lru.push_front(key);
+    entry.lru = m_Lru.begin();
+    m_Bytes += entry.bytes;
+    const std::uint64_t generation = entry.generation;
+    m_Cache.emplace(key, std::move(entry));
+
+    // Evict least recently used entries: pass 0 only those of older requests, pass 1
+    // anything except the new entry (at the front).
+    const std::size_t cap = m_MemoryCap.load();
+    bool withinCap = true;
+    for (int pass = 0; pass < 2 && m_Bytes > cap; pass++) {
+        auto it = m_Lru.end();
+        while (m_Bytes > cap) {
+            --it;
+            if (it == m_Lru.begin()) break;
+            auto entryIt = m_Cache.find(*it);
+            const bool current = entryIt->second.generation >= generation;
+            if (pass == 0 && current) continue;
+            if (current) withinCap = false;
+            m_Bytes -= entryIt->second.bytes;
+            m_Cache.erase(entryIt);
+            it = m_Lru.erase(it);
+        }
+    }
+    return withinCap;
+}
+
+std::shared_ptr<const ImageLoader> TargetPrefetcher::LoadImageCached(const std::string& path,
+                                                                    const ImageFilter::Params& filter,
+                                                                    std::uint64_t generation) {
+    const std::string key = ImageKey(path, filter);
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        // Another thread producing the same image: wait for its result instead.
+        m_LoadCv.wait(lock, [&]() {
+            return m_Stop.load() || std::find(m_Loading.begin(), m_Loading.end(), key) == m_Loading.end();
+        });
+        auto it = m_Cache.find(key);
+        if (it != m_Cache.end()) {
+            TouchLocked(it->second, generation);
+            return it->second.image;
+        }
+        if (m_Stop) return nullptr;
+        m_Loading.push_back(key);
+    }
+
+    std::shared_ptr<const ImageLoader> image;
+    if (filter.IsIdentity()) {
+        auto decoded = std::make_shared<ImageLoader>();
+        if (fs::exists(fs::path(path)) && decoded->LoadImage(path)) image = std::move(decoded);
+    } else if (std::shared_ptr<const ImageLoader> source = LoadImageCached(path, ImageFilter::Params(), generation)) {
+        // Non-FITS images stay unfiltered (cached under the filter key so we do not retry).
+        std::shared_ptr<const ImageLoader> filtered = ImageFilter::Apply(*source, filter);
+        image = filtered ? filtered : source;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Loading.erase(std::find(m_Loading.begin(), m_Loading.end(), key));
+        if (image) {
+            CacheEntry entry;
+            entry.image = image;
+            entry.bytes = ImageBytes(*image);
+            entry.generation = generation;
+            InsertLocked(key, std::move(entry));
+        }
+    }
+    m_LoadCv.notify_all();
+    return image;
+}
+
+std::shared_ptr<const ImageLoader> TargetPrefetcher::GetImage(const std::string& path,
+                                                              const ImageFilter::Params& filter) {
+    std::uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        generation = m_Generation;
+        auto it = m_Cache.find(ImageKey(path, filter));
+        if (it != m_Cache.end()) {
+            TouchLocked(it->second, generation);
+            m_Hits++;
+            return it->second.image;
+        }
+    }
+    m_Misses++;
+    return LoadImageCached(path, filter, generation);
+}
+
+std::shared_ptr<const ImageLoader> TargetPrefetcher::FindImage(const std::string& path,
+                                                               const ImageFilter::Params& filter) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Cache.find(ImageKey(path, filter));
+    if (it == m_Cache.end()) return nullptr;
+    TouchLocked(it->second, m_Generation);
+    return it->second.image;
+}
+
+void TargetPrefetcher::RequestImage(const std::string& path, const ImageFilter::Params& filter) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const ImageRequest& request : m_Requested) {
+        if (request.path == path && request.filter == filter) return;
+    }
+    m_Requested.push_back({path, filter});
+    m_WorkCv.notify_all();
+}
+
+std::shared_ptr<const TargetPrefetcher::PreparedImage> TargetPrefetcher::FindPrepared(const Job& job) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Cache.find(PreparedKey(job));
+    if (it == m_Cache.end()) return nullptr;
+    TouchLocked(it->second, m_Generation);
+    return it->second.prepared;
+}
+
+void TargetPrefetcher::Prepare(const ImageLoader& image, const ImageLoader& points, const Job& job,
+                               PreparedImage& out) {
+    out.positions.clear();
+    out.colors.clear();
+    out.groups.clear();
+    out.previewRGBA.clear();
+
+    // Job pixel coordinates onto the (possibly binned or cropped) grid the points come from.
+    const ImageLoader::FrameGrid& grid = points.GetFrameGrid();
+    const int bin = std::max(1, grid.bin);
+    const int roiX = (job.roiX - grid.originX) / bin;
+    const int roiY = (job.roiY - grid.originY) / bin;
+    const int roiRadius = (job.roiRadius + bin - 1) / bin;
+    std::vector<ImageLoader::PointHighlight> highlights = job.highlights;
+    for (auto& h : highlights) {
+        h.centerX = (h.centerX - grid.originX) / bin;
+        h.centerY = (h.centerY - grid.originY) / bin;
+        h.sizePixels = std::max(1, h.sizePixels / bin);
+    }
+    const float scaleX = job.scaleX * bin;
+    const float scaleZ = job.scaleZ * bin;
+
+    // Highlighted pixels get their own point group so they render larger in the same draw.
+    if (!highlights.empty()) {
+        int effectiveRadius = roiRadius;
+        int centerX = roiX;
+        int centerY = roiY;
+        if (!job.useRoi) {
+            // Use a ROI covering the entire image, but still tag highlight groups.
+            effectiveRadius = std::max(points.GetWidth(), points.GetHeight());
+            centerX = points.GetWidth() / 2;
+            centerY = points.GetHeight() / 2;
+        }
+        points.GeneratePointCloudWithColorsROIGroups(out.positions, out.colors, out.groups, centerX, centerY,
+                                                     effectiveRadius, highlights, scaleX, job.scaleY, scaleZ,
+                                                     job.heightMode);
+    } else if (job.useRoi) {
+        points.GeneratePointCloudWithColorsROI(out.positions, out.colors, roiX, roiY, roiRadius, scaleX, job.scaleY,
+                                               scaleZ, job.heightMode);
+    } else {
+        points.GeneratePointCloudWithColors(out.positions, out.colors, scaleX, job.scaleY, scaleZ, job.heightMode);
+    }
+
+    if (bin > 1 || grid.originX != 0 || grid.originY != 0) {
+        // The generator centers on the grid's own size; grid pixel x sits at image pixel
+        // originX + x * bin + (bin - 1) / 2.
+        const float shiftX =
+            (grid.originX + (bin - 1) * 0.5f - image.GetWidth() * 0.5f + points.GetWidth() * bin * 0.5f) * job.scaleX;
+        const float shiftZ =
+            (grid.originY + (bin - 1) * 0.5f - image.GetHeight() * 0.5f + points.GetHeight() * bin * 0.5f) *
+            job.scaleZ;
+        for (glm::vec3& p : out.positions) {
+            p.x += shiftX;
+            p.z += shiftZ;
+        }
+    }
+
+    if (job.previewSize > 0) {
+        const int size = std::clamp(job.previewSize, 1, PreviewEngine::kMaxSize);
+        const int half = size / 2;
+        Histogram roiHistogram;
+        float levelLow = 0.0f;
+        float levelHigh = 1.0f;
+        PreviewEngine::ComputeLevels(image, job.levels, job.roiX, job.roiY, size, roiHistogram, levelLow, levelHigh);
+        ImageLoader::RegionScratch scratch;
+        out.previewRGBA.resize(static_cast<std::size_t>(size) * size * 4);
+        image.BuildRegionRGBA(job.roiX - half, job.roiY - half, size, size, size, size, /*contrastStretch*/ true,
+                              out.previewRGBA.data(), scratch, levelLow, levelHigh);
+    }
+}
+
+void TargetPrefetcher::WorkerLoop() {
+    while (true) {
+        WorkItem item;
+        ImageRequest request;
+        bool requested = false;
+        std::uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkCv.wait(lock,
+                          [this]() { return !m_Requested.empty() || !m_Pending.empty() || m_Stop.load(); });
+            if (m_Stop) break;
+            if (!m_Requested.empty()) {
+                request = std::move(m_Requested.front());
+                m_Requested.pop_front();
+                requested = true;
+            } else {
+                item = std::move(m_Pending.front());
+                m_Pending.pop_front();
+            }
+            generation = m_Generation;
+        }
+
+        if (requested) {
+            LoadImageCached(request.path, request.filter, generation);
+            continue;
+        }
+
+        if (item.kind == WorkItem::Kind::Txt) {
+            std::vector<TxtTargetRecord> records;
+            std::string err;
+            if (!ParseTxtTargetFile(item.txtPath, records, err) || records.empty()) continue;
+            fs::path alignedPath;
+            fs::path templatePath;
+            if (!ResolveTxtTargetFitsPaths(records.front(), GetFitsFileIndex(), alignedPath, templatePath)) continue;
+            for (const fs::path& path : {alignedPath, templatePath}) {
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    if (generation != m_Generation) break; // user moved on
+                }
+                LoadImageCached(path.string(), ImageFilter::Params(), generation);
+            }
+            continue;
+        }
+
+        // Paths are resolved here, off the UI thread. A target whose file the index has not
+        // reached yet is skipped; the prefetch of the next selection asks again.
+        TargetJob& target = item.target;
+        fs::path alignedPath;
+        fs::path templatePath;
+        bool indexPending = false;
+        if (!ResolveTxtTargetFitsPaths(target.record, GetFitsFileIndex(), alignedPath, templatePath, &indexPending) ||
+            indexPending) {
+            continue;
+        }
+        target.aligned.path = alignedPath.string();
+        target.templ.path = templatePath.string();
+        for (const Job* job : {&target.aligned, &target.templ}) {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (generation != m_Generation) break; // user moved on
+            }
+            PrepareJob(*job, generation);
+        }
+    }
+}
+
+void TargetPrefetcher::PrepareJob(const Job& job, std::uint64_t generation) {
+    const std::string key = PreparedKey(job);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Cache.find(key);
+        if (it != m_Cache.end()) {
+            TouchLocked(it->second, generation);
+            return;
+        }
+    }
+
+    std::shared_ptr<const ImageLoader> image = LoadImageCached(job.path, ImageFilter::Params(), generation);
+    if (!image) return;
+    std::shared_ptr<const ImageLoader> points =
+        job.filter.IsIdentity() ? image : LoadImageCached(job.path, job.filter, generation);
+    if (!points) return;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (generation != m_Generation) return;
+    }
+
+    auto prepared = std::make_shared<PreparedImage>();
+    Prepare(*image, *points, job, *prepared);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    CacheEntry entry;
+    entry.prepared = prepared;
+    entry.bytes = PreparedBytes(*prepared);
+    entry.generation = generation;
+    if (!InsertLocked(key, std::move(entry)) && generation == m_Generation) {
+        // The cap is full with data for this request; the rest would only evict it.
+        m_Pending.clear();
+    }
+}
@@ -12,6 +12,11 @@ FileBrowser::FileBrowser()
     , m_SelectedFile("")
     , m_HasNewSelection(false)
     , m_FirstRender(true)
+    , m_ScannerGeneration(0)
+    , m_ScannedPath("")
+    , m_ListingComplete(false)
+    , m_SortColumn(1)
+    , m_SortAscending(true)
     , m_SelectedIndex(-1)
     , m_HasNewCheck(false)
     , m_HasNewUncheck(false)
@@ -39,37 +44,42 @@ void FileBrowser::SetDefaultFile(const std::string& filename) {
 }
 
 void FileBrowser::RefreshDirectory() {
-    m_Files.clear();
-    m_SelectedIndex = -1;
+    // Keep check marks and the selection across incremental updates of the same folder.
+    std::vector<std::string> checked;
+    for (const auto& file : m_Files) {
+        if (file.isChecked) checked.push_back(file.path);
+    }
 
-    if (!fs::exists(m_CurrentPath) || !fs::is_directory(m_CurrentPath)) {
-        return;
+    // Only the shown folder keeps its listing and watch.
+    if (m_CurrentPath != m_ScannedPath) {
+        m_Scanner.Retain({fs::path(m_CurrentPath)});
+        m_ScannedPath = m_CurrentPath;
     }
 
-    try {
-        for (const auto& entry : fs::directory_iterator(m_CurrentPath)) {
-            FileEntry fileEntry;
-            fileEntry.name = entry.path().filename().string();
-            fileEntry.path = entry.path().string();
-            fileEntry.isDirectory = entry.is_directory();
-            fileEntry.size = fileEntry.isDirectory ? 0 : fs::file_size(entry.path());
-            fileEntry.isChecked = false;
+    m_ScannerGeneration = m_Scanner.GetGeneration();
+    std::vector<DirectoryScanner::Entry> entries;
+    m_ListingComplete = m_Scanner.GetListing(fs::path(m_CurrentPath), entries);
 
-            m_Files.push_back(fileEntry);
+    m_Files.clear();
+    m_SelectedIndex = -1;
+    m_Files.reserve(entries.size());
+    for (auto& entry : entries) {
+        FileEntry fileEntry;
+        fileEntry.path = (fs::path(m_CurrentPath) / entry.name).string();
+        fileEntry.name = std::move(entry.name);
+        fileEntry.isDirectory = entry.isDirectory;
+        fileEntry.size = static_cast<size_t>(entry.size);
+        fileEntry.isChecked = std::find(checked.begin(), checked.end(), fileEntry.path) != checked.end();
+        if (!fileEntry.isDirectory && fileEntry.path == m_SelectedFile) {
+            m_SelectedIndex = static_cast<int>(m_Files.size());
         }
+        m_Files.push_back(std::move(fileEntry));
+    }
 
-        std::sort(m_Files.begin(), m_Files.end(), [](const FileEntry& a, const FileEntry& b) {
-            if (a.isDirectory != b.isDirectory) {
-                return a.isDirectory > b.isDirectory;
-            }
-            return a.name < b.name;
-        });
-
-        // Don't auto-select any file on startup
-        m_FirstRender = false;
+    SortFiles();
 
-    } catch (const std::exception& e) {
-    }
+    // Don't auto-select any file on startup
+    m_FirstRender = false;
 }
 
 void FileBrowser::Render() {
@@ -92,6 +102,7 @@ void FileBrowser::Render() {
         
         ImGui::SameLine();
         if (ImGui::Button("Refresh")) {
+            m_Scanner.Rescan(fs::path(m_CurrentPath));
             RefreshDirectory();
         }
         
@@ -100,6 +111,15 @@ void FileBrowser::Render() {
             SetDefaultPath(m_DefaultPath);
         }
         
+        // Scan progress and file system changes arrive from the scanner thread.
+        if (m_Scanner.GetGeneration() != m_ScannerGeneration) {
+            RefreshDirectory();
+        }
+        if (!m_ListingComplete) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("Scanning... (%zu)", m_Files.size());
+        }
+
         ImGui::Separator();
         
         RenderFileList();
@@ -126,81 +146,130 @@ void FileBrowser::Render() {
     ImGui::End();
 }
 
+void FileBrowser::SortFiles() {
+    m_SortedIndices.resize(m_Files.size());
+    for (size_t i = 0; i < m_Files.size(); i++) {
+        m_SortedIndices[i] = static_cast<int>(i);
+    }
+
+    const int column = m_SortColumn;
+    const bool ascending = m_SortAscending;
+    std::stable_sort(m_SortedIndices.begin(), m_SortedIndices.end(), [&](int ia, int ib) {
+        const FileEntry& a = m_Files[ia];
+        const FileEntry& b = m_Files[ib];
+        if (a.isDirectory != b.isDirectory) {
+            // Folders first, unless sorting by type descending.
+            return (column == 2 && !ascending) ? a.isDirectory < b.isDirectory : a.isDirectory > b.isDirectory;
+        }
+        if (column == 3 && a.size != b.size) {
+            return ascending ? a.size < b.size : a.size > b.size;
+        }
+        return ascending ? a.name < b.name : a.name > b.name;
+    });
+}
+
 void FileBrowser::RenderFileList() {
-    ImGui::BeginChild("FileList", ImVec2(0, -40), true);
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                  ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable;
+    if (!ImGui::BeginTable("FileTable", 4, flags, ImVec2(0, -40))) {
+        return;
+    }
 
-    ImGui::Columns(4, "FileColumns");
-    ImGui::Separator();
-    ImGui::Text("Show"); ImGui::NextColumn();
-    ImGui::Text("Name"); ImGui::NextColumn();
-    ImGui::Text("Type"); ImGui::NextColumn();
-    ImGui::Text("Size"); ImGui::NextColumn();
-    ImGui::Separator();
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Show", ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthFixed, 40.0f, 0);
+    ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_WidthStretch, 0.0f, 1);
+    ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_WidthFixed, 60.0f, 2);
+    ImGui::TableSetupColumn("Size", ImGuiTableColumnFlags_WidthFixed, 90.0f, 3);
+    ImGui::TableHeadersRow();
 
-    for (size_t i = 0; i < m_Files.size(); i++) {
-        auto& file = m_Files[i];
-
-        bool isSelected = (m_SelectedIndex == static_cast<int>(i));
-
-        // Checkbox column (only for files, not directories)
-        if (!file.isDirectory) {
-            ImGui::PushID(static_cast<int>(i));
-            bool wasChecked = file.isChecked;
-            if (ImGui::Checkbox("##check", &file.isChecked)) {
-                if (file.isChecked && !wasChecked) {
-                    // Newly checked
-                    m_HasNewCheck = true;
-                    m_NewCheckedFile = file.path;
-                } else if (!file.isChecked && wasChecked) {
-                    // Newly unchecked
-                    m_HasNewUncheck = true;
-                    m_NewUncheckedFile = file.path;
+    if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
+        if (specs->SpecsDirty && specs->SpecsCount > 0) {
+            m_SortColumn = static_cast<int>(specs->Specs[0].ColumnUserID);
+            m_SortAscending = (specs->Specs[0].SortDirection != ImGuiSortDirection_Descending);
+            SortFiles();
+        }
+        specs->SpecsDirty = false;
+    }
+
+    // Only the visible rows are submitted.
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(m_SortedIndices.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            const int i = m_SortedIndices[row];
+            auto& file = m_Files[i];
+            const bool isSelected = (m_SelectedIndex == i);
+
+            ImGui::TableNextRow();
+            ImGui::PushID(i);
+
+            // Checkbox column (only for files, not directories)
+            ImGui::TableNextColumn();
+            if (!file.isDirectory) {
+                bool wasChecked = file.isChecked;
+                if (ImGui::Checkbox("##check", &file.isChecked)) {
+                    if (file.isChecked && !wasChecked) {
+                        // Newly checked
+                        m_HasNewCheck = true;
+                        m_NewCheckedFile = file.path;
+                    } else if (!file.isChecked && wasChecked) {
+                        // Newly unchecked
+                        m_HasNewUncheck = true;
+                        m_NewUncheckedFile = file.path;
+                    }
                 }
             }
-            ImGui::PopID();
-        }
-        ImGui::NextColumn();
 
-        // Name column
-        if (file.isDirectory) {
-            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.0f, 1.0f));
-        }
+            // Name column
+            ImGui::TableNextColumn();
+            if (file.isDirectory) {
+                ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.0f, 1.0f));
+            }
+
+            bool openDirectory = false;
+            if (ImGui::Selectable(file.name.c_str(), isSelected,
+                                  ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowItemOverlap)) {
+                if (file.isDirectory) {
+                    openDirectory = true;
+                } else {
+                    m_SelectedIndex = i;
+                    m_SelectedFile = file.path;
+                    m_HasNewSelection = true;
+                }
+            }
 
-        if (ImGui::Selectable(file.name.c_str(), isSelected, ImGuiSelectableFlags_SpanAllColumns)) {
             if (file.isDirectory) {
-                m_CurrentPath = file.path;
-                RefreshDirectory();
-            } else {
-                m_SelectedIndex = static_cast<int>(i);
-                m_SelectedFile = file.path;
-                m_HasNewSelection = true;
+                ImGui::PopStyleColor();
             }
-        }
 
-        if (file.isDirectory) {
-            ImGui::PopStyleColor();
-        }
+            // Type column
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", file.isDirectory ? "Folder" : "File");
 
-        ImGui::NextColumn();
+            // Size column
+            ImGui::TableNextColumn();
+            if (!file.isDirectory) {
+                if (file.size < 1024) {
+                    ImGui::Text("%zu B", file.size);
+                } else if (file.size < 1024 * 1024) {
+                    ImGui::Text("%.2f KB", file.size / 1024.0);
+                } else {
+                    ImGui::Text("%.2f MB", file.size / (1024.0 * 1024.0));
+                }
+            }
 
-        // Type column
-        ImGui::Text("%s", file.isDirectory ? "Folder" : "File");
-        ImGui::NextColumn();
+            ImGui::PopID();
 
-        // Size column
-        if (!file.isDirectory) {
-            if (file.size < 1024) {
-                ImGui::Text("%zu B", file.size);
-            } else if (file.size < 1024 * 1024) {
-                ImGui::Text("%.2f KB", file.size / 1024.0);
-            } else {
-                ImGui::Text("%.2f MB", file.size / (1024.0 * 1024.0));
+            // Refreshing replaces m_Files, so leave the loop first.
+            if (openDirectory) {
+                m_CurrentPath = file.path;
+                RefreshDirectory();
+                clipper.End();
+                ImGui::EndTable();
+                return;
             }
         }
-        ImGui::NextColumn();
     }
-    
-    ImGui::Columns(1);
-    ImGui::EndChild();
-}
 
+    ImGui::EndTable();
+}
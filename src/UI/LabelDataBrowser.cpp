@@ -1,9 +1,16 @@
 #include "UI/LabelDataBrowser.h"
 
+#include "Data/CatalogCache.h"
+
 #include <imgui.h>
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
 #include <fstream>
+#include <iostream>
 #include <sstream>
 #include <utility>
 #include <vector>
@@ -55,11 +62,49 @@ LabelDataBrowser::LabelDataBrowser()
     , m_ActivePixelY(0)
     , m_TxtTargets()
     , m_SelectedTxtTargetIndex(-1)
+    , m_PendingTxtTargetIndex(-1)
+    , m_PendingTxtTargetReload(false)
+    , m_TxtTargetSortColumn(-1)
+    , m_TxtTargetSortAscending(true)
+    , m_TxtTargetOrderDirty(true)
     , m_RoiEnabled(true)
     , m_RoiRadius(200)
     , m_HighlightSizePixels(10)
     , m_HighlightPointSizeScale(4.0f)
-    , m_RequestCenterCameraOnRoi(false) {
+    , m_PreviewCropPixels(0)
+    , m_HeightMode(ImageLoader::HeightMode::Display)
+    , m_DifferenceEnabled(false)
+    , m_ReprojectEnabled(false)
+    , m_ReprojectInterpolation(Reprojector::Interpolation::Lanczos3)
+    , m_HighlightOtherTargets(false)
+    , m_RequestCenterCameraOnRoi(false)
+    , m_SourceRequest(SourceRequest::None)
+    , m_SnapRadius(5)
+    , m_SourceDetectionRunning(false)
+    , m_RegistrationRequest(RegistrationRequest::None)
+    , m_RegistrationCropPixels(128)
+    , m_RegistrationMaxShift(1.0f)
+    , m_RegistrationMinPeak(0.3f)
+    , m_RegistrationRunning(false)
+    , m_RegistrationOnlyFlagged(false)
+    , m_StackMemoryMB(256)
+    , m_PrefetchEnabled(true)
+    , m_PrefetchCount(2)
+    , m_PrefetchMemoryMB(1024)
+    , m_CatalogAutoStarted(false)
+    , m_CatalogLabelFilter(0)
+    , m_CatalogConeEnabled(false)
+    , m_ConeRa(0.0)
+    , m_ConeDec(0.0)
+    , m_ConeRadiusArcsec(30.0)
+    , m_CatalogQueryMs(0.0)
+    , m_CatalogQueryDirty(false)
+    , m_CatalogSortColumn(-1)
+    , m_CatalogSortAscending(true)
+    , m_ScannerGeneration(0)
+    , m_ScannerChangeGeneration(0)
+    , m_CatalogRefreshPending(false)
+    , m_TreeRowsDirty(true) {
     ResolveRootPath();
 }
 
@@ -84,7 +129,16 @@ void LabelDataBrowser::ResolveRootPath() {
         m_ResolvedRootPath = m_RootPath;
     }
     // Root resolution may change the absolute path; clear cached directory entries.
+    m_DirectoryScanner.Clear();
     m_DirectoryCache.clear();
+    if (m_Catalog && m_Catalog->GetRoot() != fs::path(m_ResolvedRootPath)) {
+        m_Catalog.reset();
+        m_CatalogResults.clear();
+        m_CatalogOrder.clear();
+        m_CatalogSeparations.clear();
+        m_CatalogMessage.clear();
+    }
+    m_CatalogAutoStarted = false;
 }
 
 const std::vector<LabelDataBrowser::CachedEntry>& LabelDataBrowser::GetDirectoryEntriesCached(const fs::path& dir) {
@@ -94,119 +148,30 @@ const std::vector<LabelDataBrowser::CachedEntry>& LabelDataBrowser::GetDirectory
         return it->second;
     }
 
+    std::vector<DirectoryScanner::Entry> scanned;
+    const bool complete = m_DirectoryScanner.GetListing(dir, scanned);
+
     std::vector<CachedEntry> entries;
-    try {
-        for (const auto& entry : fs::directory_iterator(dir)) {
-            CachedEntry e;
-            e.path = entry.path();
-            e.name = e.path.filename().string();
-            e.isDirectory = entry.is_directory();
-            if (!e.isDirectory) {
-                try {
-                    e.size = fs::file_size(e.path);
-                } catch (...) {
-                    e.size = 0;
-                }
-            } else {
-                e.size = 0;
-            }
-            entries.push_back(std::move(e));
+    // Until the scan finishes, prefer the catalog's listing (from the last walk) over a
+    // partial one.
+    const TargetCatalog::DirectoryListing* listing = m_Catalog ? m_Catalog->FindDirectory(dir) : nullptr;
+    if (!complete && listing) {
+        entries.reserve(listing->entries.size());
+        for (const auto& entry : listing->entries) {
+            entries.push_back(CachedEntry{dir / entry.name, entry.name, entry.isDirectory, entry.size});
+        }
+    } else {
+        entries.reserve(scanned.size());
+        for (auto& entry : scanned) {
+            fs::path path = dir / entry.name;
+            entries.push_back(CachedEntry{std::move(path), std::move(entry.name), entry.isDirectory, entry.size});
         }
-    } catch (...) {
-        // Cache empty list on error so we don't retry every frame.
     }
 
-    std::sort(entries.begin(), entries.end(), [](const CachedEntry& a, const CachedEntry& b) {
-        if (a.isDirectory != b.isDirectory) return a.isDirectory > b.isDirectory;
-        return a.name < b.name;
-    });
-
     auto [insIt, _] = m_DirectoryCache.emplace(key, std::move(entries));
     return insIt->second;
 }
 
-static bool ParseAllTargetsFromTxt(const fs::path& txtPath,
-                                  std::vector<LabelDataBrowser::TxtTargetRecord>& outTargets,
-                                  std::string& outError) {
-    outTargets.clear();
-    outError.clear();
-
-    std::ifstream in(txtPath, std::ios::in);
-    if (!in.is_open()) {
-        outError = "无法打开 txt";
-        return false;
-    }
-
-    std::string line;
-    while (std::getline(in, line)) {
-        if (line.empty()) continue;
-        if (!line.empty() && line[0] == '#') continue;
-
-        // Expected (whitespace-separated):
-        // index file_dir aligned_filename template_aligned_filename fits_center_ra fits_center_dec time pixel_x pixel_y ra dec
-        std::istringstream iss(line);
-        LabelDataBrowser::TxtTargetRecord rec;
-        if (!(iss >> rec.index >> rec.fileDir >> rec.alignedFilename >> rec.templateAlignedFilename)) {
-            continue;
-        }
-
-        // Optional fields
-        double fits_center_ra = 0.0;
-        double fits_center_dec = 0.0;
-        std::string timeStr;
-        int px = 0, py = 0;
-        double ra = 0.0, dec = 0.0;
-        if ((iss >> fits_center_ra >> fits_center_dec >> timeStr >> px >> py)) {
-            rec.hasPixelCenter = true;
-            rec.pixelX = px;
-            rec.pixelY = py;
-            if ((iss >> ra >> dec)) {
-                rec.hasRaDec = true;
-                rec.ra = ra;
-                rec.dec = dec;
-            }
-        }
-
-        outTargets.push_back(std::move(rec));
-    }
-
-    if (outTargets.empty()) {
-        outError = "txt 中未找到数据行";
-        return false;
-    }
-    return true;
-}
-
-static bool TryFindFileByNameUnder(const fs::path& root, const std::string& filename, fs::path& outPath) {
-    try {
-        if (!fs::exists(root) || !fs::is_directory(root)) return false;
-        for (const auto& entry : fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied)) {
-            if (!entry.is_regular_file()) continue;
-            if (entry.path().filename().string() == filename) {
-                outPath = entry.path();
-                return true;
-            }
-        }
-    } catch (...) {
-        return false;
-    }
-    return false;
-}
-
-static fs::path ResolveMaybeMissingPath(const fs::path& candidate, const std::vector<fs::path>& searchRoots) {
-    if (!candidate.empty() && fs::exists(candidate)) return candidate;
-
-    const std::string filename = candidate.filename().string();
-    if (filename.empty()) return candidate;
-
-    for (const auto& root : searchRoots) {
-        fs::path found;
-        if (TryFindFileByNameUnder(root, filename, found)) return found;
-    }
-
-    return candidate; // fallback (may not exist)
-}
-
 void LabelDataBrowser::TryParseFitsPairFromTxtSelection(const fs::path& txtPath) {
     m_HasNewFitsPair = false;
     m_NewAlignedFitsPath.clear();
@@ -220,10 +185,14 @@ void LabelDataBrowser::TryParseFitsPairFromTxtSelection(const fs::path& txtPath)
     m_ActivePixelX = 0;
     m_ActivePixelY = 0;
     m_TxtTargets.clear();
+    m_TxtParseReport = TxtParseReport();
     m_SelectedTxtTargetIndex = -1;
+    m_PendingTxtTargetIndex = -1;
+    m_TxtTargetOrderDirty = true;
+    m_RegistrationResults.clear();
 
     std::string err;
-    if (!ParseAllTargetsFromTxt(txtPath, m_TxtTargets, err)) {
+    if (!ParseTxtTargetFile(txtPath, m_TxtTargets, err, &m_TxtParseReport)) {
         m_LastParseMessage = "解析失败: " + err;
         return;
     }
@@ -233,6 +202,16 @@ void LabelDataBrowser::TryParseFitsPairFromTxtSelection(const fs::path& txtPath)
     SelectTxtTargetIndex(0, /*triggerReload*/ true);
 }
 
+int LabelDataBrowser::GetPreviewCropPixels() const {
+    if (m_PreviewCropPixels > 0) return m_PreviewCropPixels;
+    return std::clamp(m_HighlightSizePixels, 1, 300);
+}
+
+void LabelDataBrowser::SetRoiStatistics(int slot, const RoiStatistics& stats) {
+    if (slot < 0 || slot > 1) return;
+    m_RoiStatistics[slot] = stats;
+}
+
 void LabelDataBrowser::SetActivePixelCenter(int pixelX, int pixelY) {
     m_HasActivePixelCenter = true;
     m_ActivePixelX = pixelX;
@@ -245,39 +224,108 @@ void LabelDataBrowser::SetActivePixelCenter(int pixelX, int pixelY) {
     }
 }
 
+void LabelDataBrowser::GetOtherTargetPixelCenters(std::vector<std::pair<int, int>>& centers) const {
+    GetOtherTargetPixelCenters(m_SelectedTxtTargetIndex, centers);
+}
+
+void LabelDataBrowser::GetOtherTargetPixelCenters(int index, std::vector<std::pair<int, int>>& centers) const {
+    centers.clear();
+    if (index < 0 || index >= static_cast<int>(m_TxtTargets.size())) return;
+
+    const auto& selected = m_TxtTargets[index];
+    for (int i = 0; i < static_cast<int>(m_TxtTargets.size()); i++) {
+        if (i == index) continue;
+        const auto& rec = m_TxtTargets[i];
+        if (!rec.hasPixelCenter) continue;
+        if (rec.fileDir != selected.fileDir || rec.alignedFilename != selected.alignedFilename) continue;
+        centers.emplace_back(rec.pixelX, rec.pixelY);
+    }
+}
+
+void LabelDataBrowser::GetPrefetchTargets(std::vector<PrefetchTarget>& targets, std::vector<std::string>& siblingTxtFiles) {
+    targets.clear();
+    siblingTxtFiles.clear();
+    if (!m_PrefetchEnabled || m_PrefetchCount <= 0) return;
+
+    // Targets of the current txt, next before previous.
+    if (m_SelectedTxtTargetIndex >= 0) {
+        for (int d = 1; d <= m_PrefetchCount; d++) {
+            for (int index : {m_SelectedTxtTargetIndex + d, m_SelectedTxtTargetIndex - d}) {
+                if (index < 0 || index >= static_cast<int>(m_TxtTargets.size())) continue;
+                const auto& rec = m_TxtTargets[index];
+                if (rec.alignedFilename.empty() || rec.templateAlignedFilename.empty()) continue;
+
+                PrefetchTarget target;
+                target.record = rec;
+                if (m_HighlightOtherTargets) GetOtherTargetPixelCenters(index, target.otherCenters);
+                targets.push_back(std::move(target));
+            }
+        }
+    }
+
+    // Sibling epoch folders (e.g. 20250628_190147, _191828, ...) next to the txt's folder.
+    // The catalog's walk lists every folder under the root; the tree's scanner only keeps
+    // the expanded ones, so it is the fallback while the catalog loads.
+    if (m_NewFitsSourceTxtPath.empty()) return;
+    const fs::path epochDir = fs::path(m_NewFitsSourceTxtPath).parent_path();
+    const fs::path parentDir = epochDir.parent_path();
+    auto listEntries = [this](const fs::path& dir, bool directories, std::vector<std::string>& names) {
+        names.clear();
+        if (const TargetCatalog::DirectoryListing* listing = m_Catalog ? m_Catalog->FindDirectory(dir) : nullptr) {
+            for (const auto& entry : listing->entries) {
+                if (entry.isDirectory == directories) names.push_back(entry.name);
+            }
+            return;
+        }
+        std::vector<DirectoryScanner::Entry> scanned;
+        m_DirectoryScanner.GetListing(dir, scanned); // may still be partial; fine for a hint
+        for (const auto& entry : scanned) {
+            if (entry.isDirectory == directories) names.push_back(entry.name);
+        }
+    };
+    std::vector<std::string> siblingDirs;
+    listEntries(parentDir, /*directories*/ true, siblingDirs);
+    const auto self = std::find(siblingDirs.begin(), siblingDirs.end(), epochDir.filename().string());
+    if (self == siblingDirs.end()) return;
+    const int selfIndex = static_cast<int>(self - siblingDirs.begin());
+
+    std::vector<std::string> files;
+    for (int d = 1; d <= m_PrefetchCount; d++) {
+        for (int index : {selfIndex + d, selfIndex - d}) {
+            if (index < 0 || index >= static_cast<int>(siblingDirs.size())) continue;
+            const fs::path dir = parentDir / siblingDirs[index];
+            listEntries(dir, /*directories*/ false, files);
+            for (const auto& name : files) {
+                if (fs::path(name).extension() == ".txt") siblingTxtFiles.push_back((dir / name).string());
+            }
+        }
+    }
+}
+
 void LabelDataBrowser::SelectTxtTargetIndex(int idx, bool triggerReload) {
     if (idx < 0 || idx >= static_cast<int>(m_TxtTargets.size())) return;
     m_SelectedTxtTargetIndex = idx;
+    m_PendingTxtTargetIndex = -1;
 
     const auto& rec = m_TxtTargets[idx];
 
-    // Resolve file paths for this record
+    // Resolve file paths for this record. Also try common local roots
+    // (useful if txt contains remote drive paths like E:\\...)
     fs::path alignedCandidate;
     fs::path templateCandidate;
-
-    try {
-        fs::path fileDirPath(rec.fileDir);
-        fs::path alignedPath(rec.alignedFilename);
-        fs::path templatePath(rec.templateAlignedFilename);
-
-        alignedCandidate = alignedPath.is_absolute() ? alignedPath : (fileDirPath / alignedPath);
-        templateCandidate = templatePath.is_absolute() ? templatePath : (fileDirPath / templatePath);
-    } catch (...) {
+    bool indexPending = false;
+    if (!ResolveTxtTargetFitsPaths(rec, GetFitsFileIndex(), alignedCandidate, templateCandidate, &indexPending)) {
         m_LastParseMessage = "解析成功，但路径拼接失败";
         return;
     }
-
-    // Try to resolve within common local roots (useful if txt contains remote drive paths like E:\\...)
-    const fs::path cwd = fs::current_path();
-    std::vector<fs::path> roots = {
-        cwd,
-        cwd / "test-img",
-        cwd / "test-label-data",
-        cwd / ".." / ".." / ".." // if running from build/bin/<Config>
-    };
-
-    alignedCandidate = ResolveMaybeMissingPath(alignedCandidate, roots);
-    templateCandidate = ResolveMaybeMissingPath(templateCandidate, roots);
+    if (indexPending) {
+        // 文件索引尚未建立完成，Render() 中每帧重试
+        m_PendingTxtTargetIndex = idx;
+        m_PendingTxtTargetReload = m_PendingTxtTargetReload || triggerReload;
+        m_LastParseMessage = "正在建立 FITS 文件索引，完成后自动加载...";
+        return;
+    }
+    m_PendingTxtTargetReload = false;
 
     m_NewAlignedFitsPath = alignedCandidate.string();
     m_NewTemplateFitsPath = templateCandidate.string();
@@ -339,15 +387,49 @@ void LabelDataBrowser::Render() {
     ImGui::Separator();
 
     if (ImGui::Button("Refresh")) {
-        // 目前是即时遍历，无缓存；Refresh 用于重新解析路径
+        // 重新解析路径，并在后台增量刷新目录/目标缓存
         ResolveRootPath();
         m_DirectoryCache.clear();
+        if (rootExists) StartCatalogLoad();
     }
     ImGui::SameLine();
     if (ImGui::Button("Default Root")) {
         SetRootPath("test-label-data");
     }
 
+    if (rootExists && !m_CatalogAutoStarted) {
+        m_CatalogAutoStarted = true;
+        StartCatalogLoad();
+    }
+    PollCatalogLoad();
+    PollStack();
+    if (m_PendingTxtTargetIndex >= 0 && GetFitsFileIndex().IsReady()) {
+        SelectTxtTargetIndex(m_PendingTxtTargetIndex, m_PendingTxtTargetReload);
+    }
+
+    // Pick up scan progress and on-disk changes from the scanner thread.
+    const std::uint64_t scannerGeneration = m_DirectoryScanner.GetGeneration();
+    if (scannerGeneration != m_ScannerGeneration) {
+        m_ScannerGeneration = scannerGeneration;
+        m_DirectoryCache.clear();
+    }
+    const std::uint64_t changeGeneration = m_DirectoryScanner.GetChangeGeneration();
+    const auto now = std::chrono::steady_clock::now();
+    if (changeGeneration != m_ScannerChangeGeneration) {
+        m_ScannerChangeGeneration = changeGeneration;
+        m_CatalogRefreshPending = true;
+        m_LastDiskChange = now;
+    }
+    // New exports arrive as bursts of files; refresh the catalog once they settle.
+    if (rootExists && m_CatalogRefreshPending && !m_CatalogLoad.valid() && now - m_LastDiskChange > std::chrono::seconds(2)) {
+        m_CatalogRefreshPending = false;
+        StartCatalogLoad();
+    }
+
+    if (rootExists && ImGui::CollapsingHeader("Catalog (all txt under root)")) {
+        RenderCatalogPanel();
+    }
+
     ImGui::Separator();
 
     // 左：目录树 右：选中项信息
@@ -356,8 +438,12 @@ void LabelDataBrowser::Render() {
     ImGui::BeginChild("LabelDataTree", ImVec2(0, 0), true);
     if (rootExists) {
         ImGui::TextUnformatted("Directory Tree");
+        if (m_DirectoryScanner.IsScanning()) {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(scanning...)");
+        }
         ImGui::Separator();
-        RenderDirectoryTree(fs::path(m_ResolvedRootPath));
+        RenderDirectoryTree();
     }
     ImGui::EndChild();
 
@@ -376,6 +462,20 @@ void LabelDataBrowser::Render() {
             if (!m_LastParseMessage.empty()) {
                 ImGui::Separator();
                 ImGui::Text("Parse: %s", m_LastParseMessage.c_str());
+                if (!m_TxtParseReport.issues.empty()) {
+                    ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "Warnings: %zu (malformed lines: %zu)",
+                                       m_TxtParseReport.issues.size(), m_TxtParseReport.malformedLines);
+                    if (ImGui::TreeNode("TxtParseIssues", "Show warnings")) {
+                        for (const auto& issue : m_TxtParseReport.issues) {
+                            if (issue.lineNumber > 0) {
+                                ImGui::BulletText("line %zu: %s", issue.lineNumber, issue.message.c_str());
+                            } else {
+                                ImGui::BulletText("%s", issue.message.c_str());
+                            }
+                        }
+                        ImGui::TreePop();
+                    }
+                }
                 if (!m_NewAlignedFitsPath.empty() || !m_NewTemplateFitsPath.empty()) {
                     ImGui::Text("Aligned FITS: %s", m_NewAlignedFitsPath.c_str());
                     ImGui::Text("Template FITS: %s", m_NewTemplateFitsPath.c_str());
@@ -387,45 +487,7 @@ void LabelDataBrowser::Render() {
                 ImGui::Separator();
                 ImGui::Text("Targets in txt: %d", static_cast<int>(m_TxtTargets.size()));
 
-                ImGui::BeginChild("TxtTargets", ImVec2(0, 160), true);
-                ImGui::Columns(5, "TxtTargetCols");
-                ImGui::TextUnformatted("idx"); ImGui::NextColumn();
-                ImGui::TextUnformatted("pixel_x"); ImGui::NextColumn();
-                ImGui::TextUnformatted("pixel_y"); ImGui::NextColumn();
-                ImGui::TextUnformatted("ra"); ImGui::NextColumn();
-                ImGui::TextUnformatted("dec"); ImGui::NextColumn();
-                ImGui::Separator();
-
-                for (int i = 0; i < static_cast<int>(m_TxtTargets.size()); i++) {
-                    const auto& rec = m_TxtTargets[i];
-                    const bool selected = (i == m_SelectedTxtTargetIndex);
-                    ImGui::PushID(i);
-
-                    if (ImGui::Selectable(rec.index.c_str(), selected, ImGuiSelectableFlags_SpanAllColumns)) {
-                        SelectTxtTargetIndex(i, /*triggerReload*/ true);
-                    }
-                    ImGui::NextColumn();
-
-                    ImGui::Text("%d", rec.pixelX); ImGui::NextColumn();
-                    ImGui::Text("%d", rec.pixelY); ImGui::NextColumn();
-                    if (rec.hasRaDec) {
-                        ImGui::Text("%.6f", rec.ra);
-                    } else {
-                        ImGui::TextUnformatted("-");
-                    }
-                    ImGui::NextColumn();
-                    if (rec.hasRaDec) {
-                        ImGui::Text("%.6f", rec.dec);
-                    } else {
-                        ImGui::TextUnformatted("-");
-                    }
-                    ImGui::NextColumn();
-
-                    ImGui::PopID();
-                }
-
-                ImGui::Columns(1);
-                ImGui::EndChild();
+                RenderTxtTargetTable();
 
                 if (m_HasActivePixelCenter) {
                     ImGui::Text("Active Center: (%d, %d)", m_ActivePixelX, m_ActivePixelY);
@@ -438,8 +500,21 @@ void LabelDataBrowser::Render() {
                 ImGui::Text("Pixel Center: (%d, %d)", m_PixelX, m_PixelY);
                 ImGui::Checkbox("Only show neighborhood points (ROI)", &m_RoiEnabled);
                 ImGui::SliderInt("ROI radius (pixels)", &m_RoiRadius, 50, 500);
+                const char* slotNames[2] = {"Aligned", "Template"};
+                for (int slot = 0; slot < 2; slot++) {
+                    const RoiStatistics& stats = m_RoiStatistics[slot];
+                    if (!stats.valid) continue;
+                    ImGui::Text("%s ROI: mean %.4g  std %.4g  (%zu px)", slotNames[slot], stats.roiMean,
+                                stats.roiStddev, stats.roiCount);
+                    if (stats.hasSnr) {
+                        ImGui::Text("%s highlight: mean %.4g  SNR %.1f", slotNames[slot], stats.apertureMean, stats.snr);
+                    }
+                }
                 ImGui::SliderInt("Highlight size (pixels)", &m_HighlightSizePixels, 1, 300);
                 ImGui::SliderFloat("Highlight point size (scale)", &m_HighlightPointSizeScale, 1.0f, 20.0f, "%.1fx");
+                ImGui::SliderInt("Preview crop (pixels)", &m_PreviewCropPixels, 0, 2048,
+                                 m_PreviewCropPixels == 0 ? "highlight size" : "%d");
+                ImGui::Checkbox("Highlight other targets in this txt", &m_HighlightOtherTargets);
                 if (ImGui::Button("Reload FITS with ROI")) {
                     // Trigger the event again with current ROI settings
                     if (!m_NewAlignedFitsPath.empty() || !m_NewTemplateFitsPath.empty()) {
@@ -450,6 +525,104 @@ void LabelDataBrowser::Render() {
                 if (ImGui::Button("Center view/rotate on ROI")) {
                     m_RequestCenterCameraOnRoi = true;
                 }
+                ImGui::SameLine();
+                if (ImGui::Button("Snap to nearest source")) {
+                    m_SourceRequest = SourceRequest::SnapToNearest;
+                }
+            }
+
+            const char* heightModes[] = {"Display (zscale)", "Background subtracted", "Background normalized"};
+            int heightMode = static_cast<int>(m_HeightMode);
+            if (ImGui::Combo("Point heights", &heightMode, heightModes, 3)) {
+                m_HeightMode = static_cast<ImageLoader::HeightMode>(heightMode);
+                if (!m_NewAlignedFitsPath.empty() || !m_NewTemplateFitsPath.empty()) {
+                    m_HasNewFitsPair = true;
+                }
+            }
+
+            if (ImGui::TreeNode("Point filters")) {
+                bool reloadFilter = false;
+                const char* medians[] = {"Off", "3x3", "5x5"};
+                int median = m_ImageFilter.medianSize >= 5 ? 2 : (m_ImageFilter.medianSize >= 3 ? 1 : 0);
+                if (ImGui::Combo("Median (hot pixels)", &median, medians, 3)) {
+                    m_ImageFilter.medianSize = median == 0 ? 0 : 2 * median + 1;
+                    reloadFilter = true;
+                }
+                float sigma = m_ImageFilter.gaussianSigma;
+                if (ImGui::SliderFloat("Gaussian sigma (0 = off)", &sigma, 0.0f, 5.0f, "%.1f")) {
+                    m_ImageFilter.gaussianSigma = ImageFilter::Params::QuantizeSigma(sigma);
+                }
+                reloadFilter |= ImGui::IsItemDeactivatedAfterEdit();
+                const char* bins[] = {"1x1", "2x2", "4x4"};
+                int bin = m_ImageFilter.binFactor >= 4 ? 2 : (m_ImageFilter.binFactor >= 2 ? 1 : 0);
+                if (ImGui::Combo("Binning", &bin, bins, 3)) {
+                    m_ImageFilter.binFactor = 1 << bin;
+                    reloadFilter = true;
+                }
+                ImGui::TextDisabled("Previews and measurements use the unfiltered images");
+                if (reloadFilter && (!m_NewAlignedFitsPath.empty() || !m_NewTemplateFitsPath.empty())) {
+                    m_HasNewFitsPair = true;
+                }
+                ImGui::TreePop();
+            }
+
+            bool reloadReprojection = ImGui::Checkbox("Reproject template onto aligned (WCS)", &m_ReprojectEnabled);
+            if (m_ReprojectEnabled) {
+                const char* interpolations[] = {"Bilinear", "Lanczos-3"};
+                int interpolation = static_cast<int>(m_ReprojectInterpolation);
+                if (ImGui::Combo("Interpolation", &interpolation, interpolations, 2)) {
+                    m_ReprojectInterpolation = static_cast<Reprojector::Interpolation>(interpolation);
+                    reloadReprojection = true;
+                }
+                if (!m_ReprojectStatus.empty()) {
+                    ImGui::TextDisabled("%s", m_ReprojectStatus.c_str());
+                }
+            }
+            if (reloadReprojection && (!m_NewAlignedFitsPath.empty() || !m_NewTemplateFitsPath.empty())) {
+                m_HasNewFitsPair = true;
+            }
+
+            bool reloadDifference = ImGui::Checkbox("Show difference (aligned - template)", &m_DifferenceEnabled);
+            if (m_DifferenceEnabled) {
+                reloadDifference |= ImGui::Checkbox("Match flux scale (robust fit)", &m_DifferenceParams.matchScale);
+                reloadDifference |= ImGui::SliderFloat("Difference span (sigma)", &m_DifferenceParams.colorSigma, 1.0f,
+                                                       50.0f, "%.1f");
+                if (!m_DifferenceStatus.empty()) {
+                    ImGui::TextDisabled("%s", m_DifferenceStatus.c_str());
+                }
+            }
+            if (reloadDifference && (!m_NewAlignedFitsPath.empty() || !m_NewTemplateFitsPath.empty())) {
+                m_HasNewFitsPair = true;
+            }
+
+            if (ImGui::TreeNode("Levels")) {
+                RenderLevelsControls();
+                ImGui::TreePop();
+            }
+
+            if (ImGui::TreeNode("Sources")) {
+                RenderSourceControls();
+                ImGui::TreePop();
+            }
+
+            if (ImGui::TreeNode("Registration")) {
+                RenderRegistrationControls();
+                ImGui::TreePop();
+            }
+
+            if (ImGui::TreeNode("Stack")) {
+                RenderStackControls();
+                ImGui::TreePop();
+            }
+
+            if (ImGui::TreeNode("Prefetch")) {
+                ImGui::Checkbox("Prefetch neighbouring targets", &m_PrefetchEnabled);
+                ImGui::SliderInt("Targets / folders each side", &m_PrefetchCount, 0, 8);
+                ImGui::SliderInt("Memory cap (MB)", &m_PrefetchMemoryMB, 128, 8192);
+                if (!m_PrefetchStatus.empty()) {
+                    ImGui::TextDisabled("%s", m_PrefetchStatus.c_str());
+                }
+                ImGui::TreePop();
             }
             ImGui::Separator();
             ImGui::TextUnformatted("Preview");
@@ -469,60 +642,840 @@ void LabelDataBrowser::Render() {
     ImGui::End();
 }
 
-void LabelDataBrowser::RenderDirectoryTree(const fs::path& dir) {
-    const auto& entries = GetDirectoryEntriesCached(dir);
-    if (entries.empty()) {
-        // Could be empty directory or unreadable; keep UI lightweight.
-        // Only show a hint for unreadable directories when it seems to exist but yields nothing.
-        // (We avoid probing filesystem again here.)
+void LabelDataBrowser::RenderLevelsControls() {
+    using Mode = Histogram::LevelsPreset::Mode;
+    const char* modes[] = {"Min / max", "Percentile", "Mean +/- k sigma", "ZScale"};
+    int mode = static_cast<int>(m_LevelsPreset.mode);
+    if (ImGui::Combo("Preset", &mode, modes, 4)) {
+        m_LevelsPreset.mode = static_cast<Mode>(mode);
+    }
+    if (m_LevelsPreset.mode == Mode::Percentile) {
+        ImGui::SliderFloat("Low (%)", &m_LevelsPreset.lowPercent, 0.0f, 50.0f, "%.2f");
+        ImGui::SliderFloat("High (%)", &m_LevelsPreset.highPercent, 50.0f, 100.0f, "%.2f");
+    } else if (m_LevelsPreset.mode == Mode::MeanSigma) {
+        ImGui::SliderFloat("k below mean", &m_LevelsPreset.sigmaLow, 0.0f, 10.0f, "%.1f");
+        ImGui::SliderFloat("k above mean", &m_LevelsPreset.sigmaHigh, 0.0f, 50.0f, "%.1f");
     }
+    ImGui::Checkbox("From preview crop (off = whole image)", &m_LevelsPreset.fromRoi);
+
+    const char* slotNames[2] = {"Aligned", "Template"};
+    for (int slot = 0; slot < 2; slot++) {
+        const HistogramView& view = m_HistogramViews[slot];
+        if (!view.valid || view.bins.empty()) continue;
+        ImGui::Text("%s levels: %.4g .. %.4g", slotNames[slot], view.levelLow, view.levelHigh);
+        ImGui::PushID(slot);
+        ImGui::PlotHistogram("##histogram", view.bins.data(), static_cast<int>(view.bins.size()), 0, nullptr, 0.0f,
+                             3.4e38f, ImVec2(0, 60));
+        ImGui::PopID();
 
-    for (const auto& entry : entries) {
-        const fs::path p = entry.path;
-        const std::string& name = entry.name;
-        const bool isDir = entry.isDirectory;
+        // Level markers over the plot.
+        const ImVec2 p0 = ImGui::GetItemRectMin();
+        const ImVec2 p1 = ImGui::GetItemRectMax();
+        ImDrawList* dl = ImGui::GetWindowDrawList();
+        for (float fraction : {view.levelLowFraction, view.levelHighFraction}) {
+            const float x = p0.x + std::clamp(fraction, 0.0f, 1.0f) * (p1.x - p0.x);
+            dl->AddLine(ImVec2(x, p0.y), ImVec2(x, p1.y), IM_COL32(255, 200, 0, 255), 1.5f);
+        }
+        ImGui::TextDisabled("%.4g .. %.4g (log counts)", view.viewMin, view.viewMax);
+    }
+}
 
-        ImGui::PushID(p.string().c_str());
+void LabelDataBrowser::RenderSourceControls() {
+    ImGui::SliderFloat("Threshold (sigma)", &m_SourceParams.thresholdSigma, 1.0f, 20.0f, "%.1f");
+    ImGui::SliderInt("Min area (pixels)", &m_SourceParams.minArea, 1, 100);
+    ImGui::SliderInt("Snap radius (pixels)", &m_SnapRadius, 1, 50);
+    if (ImGui::Button("Detect in ROI")) {
+        m_SourceRequest = SourceRequest::DetectRoi;
+    }
+    ImGui::SameLine();
+    if (m_SourceDetectionRunning) {
+        ImGui::TextDisabled("Detecting whole frame...");
+    } else if (ImGui::Button("Detect whole frame")) {
+        m_SourceRequest = SourceRequest::DetectFrame;
+    }
+    if (!m_SourceStatus.empty()) {
+        ImGui::TextWrapped("%s", m_SourceStatus.c_str());
+    }
+    if (m_Sources.empty()) return;
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                  ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable;
+    if (!ImGui::BeginTable("Sources", 5, flags, ImVec2(0, 160))) return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("x");
+    ImGui::TableSetupColumn("y");
+    ImGui::TableSetupColumn("flux");
+    ImGui::TableSetupColumn("peak");
+    ImGui::TableSetupColumn("area");
+    ImGui::TableHeadersRow();
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(m_Sources.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const SourceDetector::Source& source = m_Sources[i];
+            const int x = static_cast<int>(std::lround(source.x));
+            const int y = static_cast<int>(std::lround(source.y));
+            const bool isCenter = m_HasActivePixelCenter && m_ActivePixelX == x && m_ActivePixelY == y;
+
+            ImGui::TableNextRow();
+            ImGui::PushID(i);
+            ImGui::TableNextColumn();
+            char label[32];
+            std::snprintf(label, sizeof(label), "%.2f", source.x);
+            if (ImGui::Selectable(label, isCenter, ImGuiSelectableFlags_SpanAllColumns)) {
+                SetActivePixelCenter(x, y);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", source.y);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.4g", source.flux);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.4g", source.peak);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", source.area);
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndTable();
+}
 
-        if (isDir) {
-            const bool isSelected = (!m_SelectedPath.empty() && fs::path(m_SelectedPath) == p);
-            ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanFullWidth;
-            if (isSelected) flags |= ImGuiTreeNodeFlags_Selected;
+bool LabelDataBrowser::IsMisregistered(const PhaseCorrelation::Result& result) const {
+    if (!result.valid) return false;
+    return std::hypot(result.dx, result.dy) > m_RegistrationMaxShift || result.peak < m_RegistrationMinPeak;
+}
+
+bool LabelDataBrowser::GetRegistrationTargets(std::vector<RegistrationBatch::Target>& targets) const {
+    targets.clear();
+    for (int i = 0; i < static_cast<int>(m_TxtTargets.size()); i++) {
+        const auto& rec = m_TxtTargets[i];
+        if (!rec.hasPixelCenter) continue;
+        fs::path alignedPath;
+        fs::path templatePath;
+        bool indexPending = false;
+        if (!ResolveTxtTargetFitsPaths(rec, GetFitsFileIndex(), alignedPath, templatePath, &indexPending)) continue;
+        if (indexPending) {
+            targets.clear();
+            return false;
+        }
 
-            bool open = ImGui::TreeNodeEx((name + "/").c_str(), flags);
-            if (ImGui::IsItemClicked()) {
-                m_SelectedPath = p.string();
-                m_SelectedIsFile = false;
-                m_SelectedSize = 0;
-                m_PreviewText.clear();
+        RegistrationBatch::Target target;
+        target.row = i;
+        target.alignedPath = alignedPath.string();
+        target.templatePath = templatePath.string();
+        target.pixelX = rec.pixelX;
+        target.pixelY = rec.pixelY;
+        targets.push_back(std::move(target));
+    }
+    return true;
+}
+
+void LabelDataBrowser::SetRegistrationResults(const std::string& txtPath, std::vector<RegistrationBatch::Entry> results) {
+    // A different txt was opened while the batch ran; its rows no longer match.
+    if (txtPath != m_NewFitsSourceTxtPath) return;
+    m_RegistrationResults = std::move(results);
+}
+
+void LabelDataBrowser::SetRegistrationStatus(bool running, const std::string& status) {
+    m_RegistrationRunning = running;
+    m_RegistrationStatus = status;
+}
+
+void LabelDataBrowser::RenderRegistrationControls() {
+    ImGui::SliderInt("Crop (pixels)", &m_RegistrationCropPixels, PhaseCorrelation::kMinCrop * 2,
+                     PhaseCorrelation::kMaxCrop);
+    ImGui::SliderFloat("Max shift (pixels)", &m_RegistrationMaxShift, 0.1f, 10.0f, "%.2f");
+    ImGui::SliderFloat("Min peak", &m_RegistrationMinPeak, 0.0f, 1.0f, "%.2f");
+    if (m_RegistrationRunning) {
+        if (ImGui::Button("Cancel check")) {
+            m_RegistrationRequest = RegistrationRequest::Cancel;
+        }
+    } else if (ImGui::Button("Check all targets in txt")) {
+        m_RegistrationRequest = RegistrationRequest::CheckAll;
+    }
+    if (!m_RegistrationStatus.empty()) {
+        ImGui::TextWrapped("%s", m_RegistrationStatus.c_str());
+    }
+    if (m_RegistrationResults.empty()) return;
+
+    // Flags follow the thresholds live, without measuring again. Targets that could not be
+    // measured (pair not loaded, blank or flat crop) are counted separately and listed
+    // with the flagged ones.
+    std::vector<int> rows;
+    int flagged = 0;
+    int failed = 0;
+    for (int i = 0; i < static_cast<int>(m_RegistrationResults.size()); i++) {
+        const PhaseCorrelation::Result& result = m_RegistrationResults[i].result;
+        const bool bad = IsMisregistered(result);
+        if (bad) flagged++;
+        if (!result.valid) failed++;
+        if (bad || !result.valid || !m_RegistrationOnlyFlagged) rows.push_back(i);
+    }
+    ImGui::Text("Flagged: %d of %d", flagged, static_cast<int>(m_RegistrationResults.size()));
+    if (failed > 0) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.75f, 0.3f, 1.0f), "Not measured: %d", failed);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Only flagged", &m_RegistrationOnlyFlagged);
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                  ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable;
+    if (!ImGui::BeginTable("Registration", 5, flags, ImVec2(0, 160))) return;
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("idx");
+    ImGui::TableSetupColumn("dx");
+    ImGui::TableSetupColumn("dy");
+    ImGui::TableSetupColumn("shift");
+    ImGui::TableSetupColumn("peak");
+    ImGui::TableHeadersRow();
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(rows.size()));
+    while (clipper.Step()) {
+        for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+            const RegistrationBatch::Entry& entry = m_RegistrationResults[rows[r]];
+            const int txtRow = entry.target.row;
+            const PhaseCorrelation::Result& result = entry.result;
+            const bool bad = IsMisregistered(result);
+            const bool colored = bad || !result.valid;
+
+            ImGui::TableNextRow();
+            ImGui::PushID(rows[r]);
+            if (bad) ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(255, 90, 90, 255));
+            if (!result.valid) ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(255, 190, 80, 255));
+
+            ImGui::TableNextColumn();
+            const char* label = txtRow < static_cast<int>(m_TxtTargets.size()) ? m_TxtTargets[txtRow].index.c_str() : "?";
+            if (ImGui::Selectable(label, txtRow == m_SelectedTxtTargetIndex, ImGuiSelectableFlags_SpanAllColumns)) {
+                SelectTxtTargetIndex(txtRow, /*triggerReload*/ true);
             }
-            if (open) {
-                RenderDirectoryTree(p);
-                ImGui::TreePop();
+            if (result.valid) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%+.2f", result.dx);
+                ImGui::TableNextColumn();
+                ImGui::Text("%+.2f", result.dy);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", std::hypot(result.dx, result.dy));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", result.peak);
+            } else {
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(entry.error.empty() ? "not measured" : entry.error.c_str());
             }
+
+            if (colored) ImGui::PopStyleColor();
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndTable();
+}
+
+void LabelDataBrowser::PollStack() {
+    if (!m_FrameStacker.Poll()) return;
+    const FrameStacker::Result& result = m_FrameStacker.GetResult();
+    if (result.ok) {
+        char text[256];
+        std::snprintf(text, sizeof(text), "%dx%d, %s, %.1f MB buffers, %.1f s", result.width, result.height,
+                      result.message.c_str(), result.bufferBytes / (1024.0 * 1024.0), result.seconds);
+        m_StackStatus = std::string("Wrote ") + fs::path(m_StackOutputPath).filename().string() + ": " + text;
+    } else {
+        m_StackStatus = "Stacking failed: " + result.message;
+        m_StackOutputPath.clear();
+    }
+}
+
+void LabelDataBrowser::RenderStackControls() {
+    const bool running = m_FrameStacker.IsRunning();
+    auto addFrame = [this](const std::string& path) {
+        if (!path.empty() && std::find(m_StackInputs.begin(), m_StackInputs.end(), path) == m_StackInputs.end()) {
+            m_StackInputs.push_back(path);
+        }
+    };
+    ImGui::BeginDisabled(running);
+    if (ImGui::Button("Add aligned")) addFrame(m_NewAlignedFitsPath);
+    ImGui::SameLine();
+    if (ImGui::Button("Add template")) addFrame(m_NewTemplateFitsPath);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear")) m_StackInputs.clear();
+
+    int removed = -1;
+    for (int i = 0; i < static_cast<int>(m_StackInputs.size()); i++) {
+        ImGui::PushID(i);
+        if (ImGui::SmallButton("x")) removed = i;
+        ImGui::SameLine();
+        ImGui::TextUnformatted(fs::path(m_StackInputs[i]).filename().string().c_str());
+        ImGui::PopID();
+    }
+    if (removed >= 0) m_StackInputs.erase(m_StackInputs.begin() + removed);
+
+    const char* methods[] = {"Median", "Sigma clip"};
+    int method = static_cast<int>(m_StackParams.method);
+    if (ImGui::Combo("Method", &method, methods, 2)) {
+        m_StackParams.method = static_cast<FrameStacker::Method>(method);
+    }
+    if (m_StackParams.method == FrameStacker::Method::SigmaClip) {
+        ImGui::SliderFloat("Clip (sigma)", &m_StackParams.clipSigma, 1.0f, 10.0f, "%.1f");
+    }
+    ImGui::Checkbox("Match sky level", &m_StackParams.matchBackground);
+    ImGui::SliderInt("Memory budget (MB)", &m_StackMemoryMB, 32, 4096);
+    ImGui::EndDisabled();
+
+    if (running) {
+        const int total = std::max(m_FrameStacker.GetStripCount(), 1);
+        ImGui::ProgressBar(static_cast<float>(m_FrameStacker.GetStripsDone()) / total, ImVec2(-1, 0));
+        if (ImGui::Button("Cancel stack")) m_FrameStacker.Cancel();
+    } else {
+        ImGui::BeginDisabled(m_StackInputs.size() < 2);
+        if (ImGui::Button("Stack to FITS")) {
+            // The stacker overwrites its output; a timestamp (and a counter on collision)
+            // keeps earlier stacks in the data folder intact.
+            const fs::path first(m_StackInputs.front());
+            char stamp[32];
+            const std::time_t now = std::time(nullptr);
+            std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+            const std::string base = std::string("stack_") + FrameStacker::GetMethodName(m_StackParams.method) + "_" +
+                                     std::to_string(m_StackInputs.size()) + "_" + stamp;
+            fs::path output = first.parent_path() / (base + ".fits");
+            std::error_code ec;
+            for (int n = 2; fs::exists(output, ec); n++) {
+                output = first.parent_path() / (base + "_" + std::to_string(n) + ".fits");
+            }
+            m_StackOutputPath = output.string();
+            m_StackParams.memoryBudgetBytes = static_cast<std::size_t>(m_StackMemoryMB) << 20;
+            m_FrameStacker.Start(m_StackInputs, m_StackOutputPath, m_StackParams);
+            m_StackStatus = "Stacking " + std::to_string(m_StackInputs.size()) + " frames...";
+        }
+        ImGui::EndDisabled();
+        if (!m_StackOutputPath.empty() && m_FrameStacker.GetResult().ok) {
+            ImGui::SameLine();
+            if (ImGui::Button("Use as template")) {
+                m_NewTemplateFitsPath = m_StackOutputPath;
+                m_HasNewFitsPair = true;
+            }
+        }
+    }
+    if (!m_StackStatus.empty()) {
+        ImGui::TextWrapped("%s", m_StackStatus.c_str());
+    }
+}
+
+void LabelDataBrowser::BuildTreeRows(const fs::path& dir, int depth) {
+    for (const auto& entry : GetDirectoryEntriesCached(dir)) {
+        TreeRow row;
+        row.path = entry.path;
+        row.depth = depth;
+        row.isDirectory = entry.isDirectory;
+        row.size = entry.size;
+        if (entry.isDirectory) {
+            row.label = entry.name + "/";
         } else {
-            const bool isSelected = (!m_SelectedPath.empty() && fs::path(m_SelectedPath) == p);
-            ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen |
-                                       ImGuiTreeNodeFlags_SpanFullWidth;
+            const int sourceIndex = m_Catalog ? m_Catalog->FindSourceFile(entry.path) : -1;
+            row.label = (sourceIndex >= 0)
+                            ? entry.name + " (" + std::to_string(m_Catalog->GetSourceFiles()[sourceIndex].rowCount) + ")"
+                            : entry.name;
+        }
+        const bool recurse = entry.isDirectory && m_OpenDirectories.count(entry.path.string()) > 0;
+        m_TreeRows.push_back(std::move(row));
+        if (recurse) BuildTreeRows(entry.path, depth + 1);
+    }
+}
+
+void LabelDataBrowser::RenderDirectoryTree() {
+    // Rebuilt only when a directory is opened/closed or the listing cache was dropped.
+    if (m_TreeRowsDirty || m_DirectoryCache.empty()) {
+        m_TreeRows.clear();
+        BuildTreeRows(fs::path(m_ResolvedRootPath), 0);
+        m_TreeRowsDirty = false;
+
+        // Stop watching folders that were collapsed (or whose parent was).
+        std::vector<fs::path> shown{fs::path(m_ResolvedRootPath)};
+        for (const TreeRow& row : m_TreeRows) {
+            if (row.isDirectory && m_OpenDirectories.count(row.path.string()) > 0) shown.push_back(row.path);
+        }
+        m_DirectoryScanner.Retain(shown);
+    }
+
+    const float indent = ImGui::GetTreeNodeToLabelSpacing();
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(m_TreeRows.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const TreeRow& row = m_TreeRows[i];
+            const std::string key = row.path.string();
+            const bool isSelected = (!m_SelectedPath.empty() && m_SelectedPath == key);
+
+            ImGui::PushID(key.c_str());
+            if (row.depth > 0) ImGui::Indent(indent * row.depth);
+
+            ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_NoTreePushOnOpen;
             if (isSelected) flags |= ImGuiTreeNodeFlags_Selected;
 
-            ImGui::TreeNodeEx(name.c_str(), flags);
-            if (ImGui::IsItemClicked()) {
-                m_SelectedPath = p.string();
-                m_SelectedIsFile = true;
-                m_SelectedSize = entry.size;
-                m_PreviewText = ReadTextFilePreview(p);
-
-                // If selecting a txt, parse a FITS pair for the application to load
-                if (p.extension().string() == ".txt") {
-                    TryParseFitsPairFromTxtSelection(p);
-                } else {
-                    m_LastParseMessage.clear();
+            if (row.isDirectory) {
+                const bool wasOpen = m_OpenDirectories.count(key) > 0;
+                ImGui::SetNextItemOpen(wasOpen);
+                const bool open = ImGui::TreeNodeEx(row.label.c_str(), flags | ImGuiTreeNodeFlags_OpenOnArrow);
+                if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen()) {
+                    m_SelectedPath = key;
+                    m_SelectedIsFile = false;
+                    m_SelectedSize = 0;
+                    m_PreviewText.clear();
+                }
+                if (open != wasOpen) {
+                    if (open) {
+                        m_OpenDirectories.insert(key);
+                    } else {
+                        m_OpenDirectories.erase(key);
+                    }
+                    m_TreeRowsDirty = true;
+                }
+            } else {
+                ImGui::TreeNodeEx(row.label.c_str(), flags | ImGuiTreeNodeFlags_Leaf);
+                if (ImGui::IsItemClicked()) {
+                    SelectTxtFile(row.path, row.size);
                 }
             }
+
+            if (row.depth > 0) ImGui::Unindent(indent * row.depth);
+            ImGui::PopID();
         }
+    }
+}
 
-        ImGui::PopID();
+void LabelDataBrowser::SortTxtTargets() {
+    m_TxtTargetOrderDirty = false;
+    m_TxtTargetOrder.resize(m_TxtTargets.size());
+    for (std::size_t i = 0; i < m_TxtTargetOrder.size(); i++) m_TxtTargetOrder[i] = static_cast<int>(i);
+    if (m_TxtTargetSortColumn < 0) return;
+
+    const int column = m_TxtTargetSortColumn;
+    const bool ascending = m_TxtTargetSortAscending;
+    // Rows without RA/Dec sort after all others.
+    auto raOf = [](const TxtTargetRecord& r) { return r.hasRaDec ? r.ra : 1e300; };
+    auto decOf = [](const TxtTargetRecord& r) { return r.hasRaDec ? r.dec : 1e300; };
+    std::stable_sort(m_TxtTargetOrder.begin(), m_TxtTargetOrder.end(), [&](int ia, int ib) {
+        const TxtTargetRecord& a = m_TxtTargets[ia];
+        const TxtTargetRecord& b = m_TxtTargets[ib];
+        bool less = false;
+        bool greater = false;
+        switch (column) {
+        case 0: // numeric indices: shorter first, then lexicographic
+            less = a.index.size() != b.index.size() ? a.index.size() < b.index.size() : a.index < b.index;
+            greater = a.index.size() != b.index.size() ? a.index.size() > b.index.size() : a.index > b.index;
+            break;
+        case 1: less = a.pixelX < b.pixelX; greater = a.pixelX > b.pixelX; break;
+        case 2: less = a.pixelY < b.pixelY; greater = a.pixelY > b.pixelY; break;
+        case 3: less = raOf(a) < raOf(b); greater = raOf(a) > raOf(b); break;
+        default: less = decOf(a) < decOf(b); greater = decOf(a) > decOf(b); break;
+        }
+        return ascending ? less : greater;
+    });
+}
+
+void LabelDataBrowser::RenderTxtTargetTable() {
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                  ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable |
+                                  ImGuiTableFlags_SortTristate;
+    if (!ImGui::BeginTable("TxtTargets", 5, flags, ImVec2(0, 160))) return;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("idx", ImGuiTableColumnFlags_None, 0.0f, 0);
+    ImGui::TableSetupColumn("pixel_x", ImGuiTableColumnFlags_None, 0.0f, 1);
+    ImGui::TableSetupColumn("pixel_y", ImGuiTableColumnFlags_None, 0.0f, 2);
+    ImGui::TableSetupColumn("ra", ImGuiTableColumnFlags_None, 0.0f, 3);
+    ImGui::TableSetupColumn("dec", ImGuiTableColumnFlags_None, 0.0f, 4);
+    ImGui::TableHeadersRow();
+
+    if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
+        if (specs->SpecsDirty) {
+            m_TxtTargetSortColumn = specs->SpecsCount > 0 ? static_cast<int>(specs->Specs[0].ColumnUserID) : -1;
+            m_TxtTargetSortAscending =
+                specs->SpecsCount == 0 || specs->Specs[0].SortDirection != ImGuiSortDirection_Descending;
+            m_TxtTargetOrderDirty = true;
+            specs->SpecsDirty = false;
+        }
+    }
+    if (m_TxtTargetOrderDirty || m_TxtTargetOrder.size() != m_TxtTargets.size()) SortTxtTargets();
+
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(m_TxtTargetOrder.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            const int i = m_TxtTargetOrder[row];
+            const auto& rec = m_TxtTargets[i];
+            const bool selected = (i == m_SelectedTxtTargetIndex);
+
+            ImGui::TableNextRow();
+            ImGui::PushID(i);
+
+            ImGui::TableNextColumn();
+            if (ImGui::Selectable(rec.index.c_str(), selected, ImGuiSelectableFlags_SpanAllColumns)) {
+                SelectTxtTargetIndex(i, /*triggerReload*/ true);
+            }
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", rec.pixelX);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", rec.pixelY);
+            ImGui::TableNextColumn();
+            if (rec.hasRaDec) {
+                ImGui::Text("%.6f", rec.ra);
+            } else {
+                ImGui::TextUnformatted("-");
+            }
+            ImGui::TableNextColumn();
+            if (rec.hasRaDec) {
+                ImGui::Text("%.6f", rec.dec);
+            } else {
+                ImGui::TextUnformatted("-");
+            }
+
+            ImGui::PopID();
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+void LabelDataBrowser::SelectTxtFile(const fs::path& path, std::uintmax_t size) {
+    m_SelectedPath = path.string();
+    m_SelectedIsFile = true;
+    m_SelectedSize = size;
+    m_PreviewText = ReadTextFilePreview(path);
+
+    // If selecting a txt, parse a FITS pair for the application to load
+    if (path.extension().string() == ".txt") {
+        TryParseFitsPairFromTxtSelection(path);
+    } else {
+        m_LastParseMessage.clear();
+    }
+}
+
+void LabelDataBrowser::StartCatalogLoad() {
+    if (m_CatalogLoad.valid()) return;
+
+    const fs::path root(m_ResolvedRootPath);
+    std::shared_ptr<TargetCatalog> previous = m_Catalog;
+    auto stage = std::make_shared<CatalogStage>();
+    m_CatalogStage = stage;
+    m_CatalogMessage = previous ? "Refreshing..." : "Loading...";
+    m_CatalogLoad = std::async(std::launch::async, [root, previous, stage]() -> std::shared_ptr<TargetCatalog> {
+        const fs::path cacheFile = CatalogCache::GetCachePath(root);
+        std::string err;
+
+        std::shared_ptr<TargetCatalog> base = previous;
+        if (!base) {
+            auto cached = std::make_shared<TargetCatalog>();
+            if (CatalogCache::Load(cacheFile, root, *cached, err)) {
+                base = cached;
+                std::lock_guard<std::mutex> lock(stage->mutex);
+                stage->cached = cached;
+            } else if (fs::exists(cacheFile)) {
+                std::cerr << "Catalog cache ignored: " << err << std::endl;
+            }
+        }
+
+        auto catalog = std::make_shared<TargetCatalog>();
+        TargetCatalog::UpdateStats stats;
+        if (!catalog->UpdateFromRoot(root, base.get(), err, &stats)) {
+            std::cerr << "Catalog load failed: " << err << std::endl;
+            return base ? base : catalog;
+        }
+        if (!base || !stats.IsUnchanged()) {
+            if (!CatalogCache::Save(*catalog, cacheFile, err)) {
+                std::cerr << "Catalog cache not saved: " << err << std::endl;
+            }
+        }
+        return catalog;
+    });
+}
+
+void LabelDataBrowser::PollCatalogLoad() {
+    if (!m_CatalogLoad.valid()) return;
+
+    // A load started before the root changed belongs to the old tree; false if dropped.
+    auto publish = [this](std::shared_ptr<TargetCatalog> catalog, const char* suffix) {
+        std::error_code ec;
+        const fs::path root = fs::absolute(m_ResolvedRootPath, ec);
+        if (catalog->GetRoot() != (ec ? fs::path(m_ResolvedRootPath) : root)) return false;
+        m_Catalog = std::move(catalog);
+        std::ostringstream oss;
+        oss << m_Catalog->GetRowCount() << " targets in " << m_Catalog->GetSourceFiles().size() << " txt, "
+            << (m_Catalog->GetMemoryBytes() + 1023) / 1024 << " KB" << suffix;
+        m_CatalogMessage = oss.str();
+        m_CatalogQueryDirty = true;
+        m_DirectoryCache.clear();
+        return true;
+    };
+
+    if (m_CatalogLoad.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        std::shared_ptr<TargetCatalog> cached;
+        {
+            std::lock_guard<std::mutex> lock(m_CatalogStage->mutex);
+            cached = std::move(m_CatalogStage->cached);
+        }
+        if (cached) publish(std::move(cached), " (cached, refreshing...)");
+        return;
+    }
+
+    m_CatalogStage.reset();
+    if (!publish(m_CatalogLoad.get(), "")) {
+        // Load the current root instead.
+        m_CatalogMessage.clear();
+        if (fs::exists(m_ResolvedRootPath) && fs::is_directory(m_ResolvedRootPath)) StartCatalogLoad();
+    }
+}
+
+void LabelDataBrowser::RunCatalogQuery() {
+    m_CatalogQueryDirty = false;
+    m_CatalogResults.clear();
+    m_CatalogSeparations.clear();
+    if (!m_Catalog) return;
+
+    m_CatalogQuery.good = (m_CatalogLabelFilter != 2);
+    m_CatalogQuery.bad = (m_CatalogLabelFilter != 1);
+    m_CatalogQuery.unknown = (m_CatalogLabelFilter == 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    if (m_CatalogConeEnabled) {
+        std::vector<SkyIndex::Match> matches;
+        m_Catalog->QueryCone(m_ConeRa, m_ConeDec, m_ConeRadiusArcsec, m_CatalogQuery, matches);
+        m_CatalogResults.reserve(matches.size());
+        m_CatalogSeparations.reserve(matches.size());
+        for (const auto& m : matches) {
+            m_CatalogResults.push_back(m.id);
+            m_CatalogSeparations.push_back(m.separationArcsec);
+        }
+    } else {
+        m_Catalog->RunQuery(m_CatalogQuery, m_CatalogResults);
+    }
+    m_CatalogQueryMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    SortCatalogResults();
+}
+
+void LabelDataBrowser::SortCatalogResults() {
+    m_CatalogOrder.resize(m_CatalogResults.size());
+    for (std::size_t i = 0; i < m_CatalogOrder.size(); i++) m_CatalogOrder[i] = static_cast<std::uint32_t>(i);
+    if (!m_Catalog || m_CatalogSortColumn < 0) return;
+
+    const TargetCatalog& catalog = *m_Catalog;
+    const int column = m_CatalogSortColumn;
+    // Rows without a value sort after all others.
+    auto key = [&](std::uint32_t i) -> double {
+        const std::uint32_t row = m_CatalogResults[i];
+        switch (column) {
+        case 0: return static_cast<double>(catalog.GetLabel(row));
+        case 1: return static_cast<double>(catalog.GetEpoch(row));
+        case 2: return static_cast<double>(catalog.GetSourceFileIndex(row)); // source files are path-sorted
+        case 4: return catalog.HasPixelCenter(row) ? catalog.GetPixelX(row) * 65536.0 + catalog.GetPixelY(row) : 1e300;
+        case 5: return catalog.HasRaDec(row) ? catalog.GetRa(row) : 1e300;
+        case 6: return catalog.HasRaDec(row) ? catalog.GetDec(row) : 1e300;
+        default: return i < m_CatalogSeparations.size() ? m_CatalogSeparations[i] : 0.0;
+        }
+    };
+
+    auto compare = [&](std::uint32_t a, std::uint32_t b) {
+        if (column == 3) {
+            const std::string& ia = catalog.GetIndex(m_CatalogResults[a]);
+            const std::string& ib = catalog.GetIndex(m_CatalogResults[b]);
+            return ia.size() != ib.size() ? ia.size() < ib.size() : ia < ib;
+        }
+        return key(a) < key(b);
+    };
+    if (m_CatalogSortAscending) {
+        std::stable_sort(m_CatalogOrder.begin(), m_CatalogOrder.end(), compare);
+    } else {
+        std::stable_sort(m_CatalogOrder.begin(), m_CatalogOrder.end(),
+                         [&](std::uint32_t a, std::uint32_t b) { return compare(b, a); });
+    }
+}
+
+void LabelDataBrowser::RenderCatalogResults() {
+    const bool showSeparation = !m_CatalogSeparations.empty();
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter |
+                                  ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_Sortable |
+                                  ImGuiTableFlags_SortTristate;
+    if (!ImGui::BeginTable("CatalogResults", showSeparation ? 8 : 7, flags, ImVec2(0, 180))) return;
+
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("label", ImGuiTableColumnFlags_None, 0.0f, 0);
+    ImGui::TableSetupColumn("time", ImGuiTableColumnFlags_None, 0.0f, 1);
+    ImGui::TableSetupColumn("txt", ImGuiTableColumnFlags_None, 0.0f, 2);
+    ImGui::TableSetupColumn("idx", ImGuiTableColumnFlags_None, 0.0f, 3);
+    ImGui::TableSetupColumn("pixel", ImGuiTableColumnFlags_None, 0.0f, 4);
+    ImGui::TableSetupColumn("ra", ImGuiTableColumnFlags_None, 0.0f, 5);
+    ImGui::TableSetupColumn("dec", ImGuiTableColumnFlags_None, 0.0f, 6);
+    if (showSeparation) {
+        ImGui::TableSetupColumn("sep\"", ImGuiTableColumnFlags_None, 0.0f, 7);
+    }
+    ImGui::TableHeadersRow();
+
+    if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
+        if (specs->SpecsDirty) {
+            m_CatalogSortColumn = specs->SpecsCount > 0 ? static_cast<int>(specs->Specs[0].ColumnUserID) : -1;
+            m_CatalogSortAscending =
+                specs->SpecsCount == 0 || specs->Specs[0].SortDirection != ImGuiSortDirection_Descending;
+            SortCatalogResults();
+            specs->SpecsDirty = false;
+        }
+    }
+
+    // Only the visible rows are submitted; click to open the target.
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(m_CatalogOrder.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+            const std::uint32_t result = m_CatalogOrder[i];
+            const std::uint32_t row = m_CatalogResults[result];
+            const auto& source = m_Catalog->GetSourceFiles()[m_Catalog->GetSourceFileIndex(row)];
+
+            ImGui::TableNextRow();
+            ImGui::PushID(static_cast<int>(row));
+
+            ImGui::TableNextColumn();
+            if (ImGui::Selectable(TargetCatalog::GetLabelName(m_Catalog->GetLabel(row)), false,
+                                  ImGuiSelectableFlags_SpanAllColumns)) {
+                OpenCatalogRow(row);
+            }
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", static_cast<unsigned long long>(m_Catalog->GetEpoch(row)));
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(source.path.filename().string().c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(m_Catalog->GetIndex(row).c_str());
+            ImGui::TableNextColumn();
+            if (m_Catalog->HasPixelCenter(row)) {
+                ImGui::Text("%d, %d", m_Catalog->GetPixelX(row), m_Catalog->GetPixelY(row));
+            } else {
+                ImGui::TextUnformatted("-");
+            }
+            if (m_Catalog->HasRaDec(row)) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.6f", m_Catalog->GetRa(row));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.6f", m_Catalog->GetDec(row));
+            } else {
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted("-");
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted("-");
+            }
+            if (showSeparation) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", m_CatalogSeparations[result]);
+            }
+
+            ImGui::PopID();
+        }
+    }
+
+    ImGui::EndTable();
+}
+
+void LabelDataBrowser::OpenCatalogRow(std::uint32_t row) {
+    if (!m_Catalog || row >= m_Catalog->GetRowCount()) return;
+
+    const auto& source = m_Catalog->GetSourceFiles()[m_Catalog->GetSourceFileIndex(row)];
+    SelectTxtFile(source.path, source.size);
+
+    const int rowInFile = static_cast<int>(m_Catalog->GetRowInSourceFile(row));
+    if (rowInFile != m_SelectedTxtTargetIndex && rowInFile < static_cast<int>(m_TxtTargets.size())) {
+        SelectTxtTargetIndex(rowInFile, /*triggerReload*/ true);
     }
 }
 
+void LabelDataBrowser::RenderCatalogPanel() {
+    const bool loading = m_CatalogLoad.valid();
+    if (loading) ImGui::BeginDisabled();
+    if (ImGui::Button(m_Catalog ? "Refresh catalog" : "Build catalog")) {
+        StartCatalogLoad();
+    }
+    if (loading) ImGui::EndDisabled();
+    if (!m_CatalogMessage.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(m_CatalogMessage.c_str());
+    }
+    if (!m_Catalog) return;
+
+    // Filters
+    bool changed = false;
+    const char* labelItems[] = {"All", "GOOD", "BAD"};
+    ImGui::SetNextItemWidth(100.0f);
+    changed |= ImGui::Combo("Label", &m_CatalogLabelFilter, labelItems, 3);
+    ImGui::SameLine();
+    int dateMin = static_cast<int>(m_CatalogQuery.dateMin);
+    int dateMax = static_cast<int>(m_CatalogQuery.dateMax);
+    ImGui::SetNextItemWidth(110.0f);
+    if (ImGui::InputInt("Date from", &dateMin, 0, 0)) {
+        m_CatalogQuery.dateMin = static_cast<std::uint32_t>(std::max(dateMin, 0));
+        changed = true;
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(110.0f);
+    if (ImGui::InputInt("to (YYYYMMDD, 0 = any)", &dateMax, 0, 0)) {
+        m_CatalogQuery.dateMax = static_cast<std::uint32_t>(std::max(dateMax, 0));
+        changed = true;
+    }
+
+    changed |= ImGui::Checkbox("Pixel region", &m_CatalogQuery.usePixelRegion);
+    if (m_CatalogQuery.usePixelRegion) {
+        ImGui::SameLine();
+        int region[4] = {m_CatalogQuery.pixelXMin, m_CatalogQuery.pixelXMax, m_CatalogQuery.pixelYMin, m_CatalogQuery.pixelYMax};
+        ImGui::SetNextItemWidth(260.0f);
+        if (ImGui::InputInt4("x min/max, y min/max", region)) {
+            m_CatalogQuery.pixelXMin = region[0];
+            m_CatalogQuery.pixelXMax = region[1];
+            m_CatalogQuery.pixelYMin = region[2];
+            m_CatalogQuery.pixelYMax = region[3];
+            changed = true;
+        }
+    }
+
+    // Cone search around a position, e.g. the selected target (repeat detections, known artifacts).
+    changed |= ImGui::Checkbox("Cone search", &m_CatalogConeEnabled);
+    if (m_CatalogConeEnabled) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        changed |= ImGui::InputDouble("RA##cone", &m_ConeRa, 0.0, 0.0, "%.6f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        changed |= ImGui::InputDouble("Dec##cone", &m_ConeDec, 0.0, 0.0, "%.6f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(80.0f);
+        changed |= ImGui::InputDouble("radius (arcsec)", &m_ConeRadiusArcsec, 0.0, 0.0, "%.1f");
+        const bool hasSelection = m_SelectedTxtTargetIndex >= 0 &&
+                                  m_SelectedTxtTargetIndex < static_cast<int>(m_TxtTargets.size()) &&
+                                  m_TxtTargets[m_SelectedTxtTargetIndex].hasRaDec;
+        ImGui::SameLine();
+        if (!hasSelection) ImGui::BeginDisabled();
+        if (ImGui::Button("Around selected")) {
+            m_ConeRa = m_TxtTargets[m_SelectedTxtTargetIndex].ra;
+            m_ConeDec = m_TxtTargets[m_SelectedTxtTargetIndex].dec;
+            changed = true;
+        }
+        if (!hasSelection) ImGui::EndDisabled();
+    }
+
+    changed |= ImGui::Checkbox("RA/Dec range", &m_CatalogQuery.useRaDecRange);
+    if (m_CatalogQuery.useRaDecRange) {
+        ImGui::SetNextItemWidth(90.0f);
+        changed |= ImGui::InputDouble("RA min", &m_CatalogQuery.raMin, 0.0, 0.0, "%.4f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(90.0f);
+        changed |= ImGui::InputDouble("RA max", &m_CatalogQuery.raMax, 0.0, 0.0, "%.4f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(90.0f);
+        changed |= ImGui::InputDouble("Dec min", &m_CatalogQuery.decMin, 0.0, 0.0, "%.4f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(90.0f);
+        changed |= ImGui::InputDouble("Dec max", &m_CatalogQuery.decMax, 0.0, 0.0, "%.4f");
+    }
+
+    if (changed || m_CatalogQueryDirty) {
+        RunCatalogQuery();
+    }
+
+    ImGui::Text("Matches: %zu (%.2f ms)", m_CatalogResults.size(), m_CatalogQueryMs);
+
+    RenderCatalogResults();
+}
@@ -2,6 +2,7 @@
 #include "UI/UIManager.h"
 #include "Application.h"
 #include "GeometryObject.h"
+#include "PointBudgetGovernor.h"
 #include <imgui.h>
 
 PropertiesPanel::PropertiesPanel(UIManager* uiManager)
@@ -60,6 +61,34 @@ void PropertiesPanel::Render() {
     glm::vec3 camTarget = camera->GetTarget();
     ImGui::Text("Target: %.2f, %.2f, %.2f", camTarget.x, camTarget.y, camTarget.z);
 
+    PointBudgetGovernor* budget = m_UIManager->GetApplication()->GetRenderer()->GetPointBudgetGovernor();
+    if (budget) {
+        ImGui::Separator();
+        ImGui::Text("Rendering");
+
+        bool enabled = budget->IsEnabled();
+        if (ImGui::Checkbox("Adaptive point budget", &enabled)) {
+            budget->SetEnabled(enabled);
+        }
+        float targetMs = budget->GetTargetFrameMs();
+        if (ImGui::SliderFloat("Target GPU ms", &targetMs, 4.0f, 50.0f, "%.1f")) {
+            budget->SetTargetFrameMs(targetMs);
+        }
+        ImGui::Text("GPU frame: %.2f ms", budget->GetLastGpuFrameMs());
+        ImGui::Text("Budget: %.2f M points", budget->GetPointBudget() / 1.0e6);
+        ImGui::Text("Drawn: %.2f / %.2f M", budget->GetLastDrawnPoints() / 1.0e6, budget->GetLastTotalPoints() / 1.0e6);
+    }
+
+    Application* app = m_UIManager->GetApplication();
+    bool lodEnabled = app->IsImageLodEnabled();
+    if (ImGui::Checkbox("Far-view image surface", &lodEnabled)) {
+        app->SetImageLodEnabled(lodEnabled);
+    }
+    float lodThreshold = app->GetImageLodThresholdPx();
+    if (ImGui::SliderFloat("Points above (px/pixel)", &lodThreshold, 0.25f, 8.0f, "%.2f")) {
+        app->SetImageLodThresholdPx(lodThreshold);
+    }
+
     ImGui::End();
 }
 
@@ -22,24 +22,39 @@ void Sidebar::Render() {
     ImGui::Separator();
 
     auto& objects = m_UIManager->GetApplication()->GetGeometryObjects();
-    
-    for (size_t i = 0; i < objects.size(); ++i) {
-        auto& obj = objects[i];
-        
-        ImGui::PushID((int)i);
-        
-        bool isVisible = obj->IsVisible();
-        if (ImGui::Checkbox("##visible", &isVisible)) {
-            obj->SetVisible(isVisible);
-        }
-        
-        ImGui::SameLine();
-        
-        if (ImGui::Selectable(obj->GetName().c_str(), m_SelectedObjectIndex == (int)i)) {
-            m_SelectedObjectIndex = (int)i;
+
+    // Clipped: only visible rows are submitted, whatever the object count.
+    const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter;
+    if (ImGui::BeginTable("ObjectTable", 2, flags, ImVec2(0, -45))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Show", ImGuiTableColumnFlags_WidthFixed, 40.0f);
+        ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)objects.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                auto& obj = objects[i];
+
+                ImGui::TableNextRow();
+                ImGui::PushID(i);
+
+                ImGui::TableNextColumn();
+                bool isVisible = obj->IsVisible();
+                if (ImGui::Checkbox("##visible", &isVisible)) {
+                    obj->SetVisible(isVisible);
+                }
+
+                ImGui::TableNextColumn();
+                if (ImGui::Selectable(obj->GetName().c_str(), m_SelectedObjectIndex == i)) {
+                    m_SelectedObjectIndex = i;
+                }
+
+                ImGui::PopID();
+            }
         }
-        
-        ImGui::PopID();
+        ImGui::EndTable();
     }
 
     ImGui::Separator();
@@ -0,0 +1,341 @@
+#include "Wcs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unordered_map>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr int kTpvTerms = 40;
+
+std::string Trim(const std::string& text) {
+    const auto begin = text.find_first_not_of(' ');
+    if (begin == std::string::npos) return std::string();
+    const auto end = text.find_last_not_of(' ');
+    return text.substr(begin, end - begin + 1);
+}
+
+// KEYWORD = value / comment  ->  keyword -> value (strings without their quotes).
+std::unordered_map<std::string, std::string> ReadCards(const std::vector<std::string>& cards) {
+    std::unordered_map<std::string, std::string> values;
+    for (const std::string& card : cards) {
+        if (card.size() < 10 || card.compare(8, 2, "= ") != 0) continue;
+        const std::string key = Trim(card.substr(0, 8));
+        std::string value = card.substr(10);
+        const auto quote = value.find('\'');
+        if (quote != std::string::npos && Trim(value.substr(0, quote)).empty()) {
+            const auto closing = value.find('\'', quote + 1);
+            value = value.substr(quote + 1, closing == std::string::npos ? std::string::npos : closing - quote - 1);
+        } else {
+            value = value.substr(0, value.find('/'));
+        }
+        values[key] = Trim(value);
+    }
+    return values;
+}
+
+bool ReadNumber(const std::unordered_map<std::string, std::string>& values, const std::string& key, double& out) {
+    const auto it = values.find(key);
+    if (it == values.end() || it->second.empty()) return false;
+    std::string text = it->second;
+    std::replace(text.begin(), text.end(), 'D', 'E'); // Fortran exponents
+    char* end = nullptr;
+    const double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str()) return false;
+    out = value;
+    return true;
+}
+
+// Solve f(a, b) = (targetA, targetB) for (a, b) by Newton's method with a numerical
+// Jacobian, starting from (a, b). step is the difference step in the units of a and b.
+template <typename Function>
+bool SolveNewton(Function&& f, double targetA, double targetB, double step, double tolerance, double& a, double& b) {
+    for (int iteration = 0; iteration < 20; iteration++) {
+        double fa = 0.0, fb = 0.0;
+        f(a, b, fa, fb);
+        const double ra = fa - targetA;
+        const double rb = fb - targetB;
+        if (std::abs(ra) < tolerance && std::abs(rb) < tolerance) return true;
+
+        double pa = 0.0, pb = 0.0, ma = 0.0, mb = 0.0;
+        f(a + step, b, pa, pb);
+        f(a - step, b, ma, mb);
+        const double j00 = (pa - ma) / (2.0 * step);
+        const double j10 = (pb - mb) / (2.0 * step);
+        f(a, b + step, pa, pb);
+        f(a, b - step, ma, mb);
+        const double j01 = (pa - ma) / (2.0 * step);
+        const double j11 = (pb - mb) / (2.0 * step);
+        const double det = j00 * j11 - j01 * j10;
+        if (det == 0.0 || !std::isfinite(det)) return false;
+        a -= (j11 * ra - j01 * rb) / det;
+        b -= (j00 * rb - j10 * ra) / det;
+    }
+    return false;
+}
+} // namespace
+
+Wcs::Wcs()
+    : m_Projection(Projection::None)
+    , m_CrPix{0.0, 0.0}
+    , m_CrVal{0.0, 0.0}
+    , m_Cd{{1.0, 0.0}, {0.0, 1.0}}
+    , m_CdInverse{{1.0, 0.0}, {0.0, 1.0}}
+    , m_SipOrder(0)
+{
+}
+
+const char* Wcs::GetProjectionName() const {
+    switch (m_Projection) {
+    case Projection::Tan: return "TAN";
+    case Projection::Tpv: return "TPV";
+    case Projection::TanSip: return "TAN-SIP";
+    case Projection::None: break;
+    }
+    return "none";
+}
+
+bool Wcs::Parse(const std::vector<std::string>& cards, std::string& message) {
+    *this = Wcs();
+    const auto values = ReadCards(cards);
+
+    const auto ctype1 = values.find("CTYPE1");
+    const auto ctype2 = values.find("CTYPE2");
+    if (ctype1 == values.end() || ctype2 == values.end()) {
+        message = "no CTYPE1/CTYPE2";
+        return false;
+    }
+    const std::string type1 = ctype1->second;
+    const std::string type2 = ctype2->second;
+    if (type1.compare(0, 4, "RA--") != 0 || type2.compare(0, 4, "DEC-") != 0 || type1.size() < 8) {
+        message = "unsupported axes " + type1 + " / " + type2;
+        return false;
+    }
+    const std::string projection = type1.substr(5);
+    Projection kind = Projection::None;
+    if (projection == "TAN") {
+        kind = Projection::Tan;
+    } else if (projection == "TPV") {
+        kind = Projection::Tpv;
+    } else if (projection == "TAN-SIP") {
+        kind = Projection::TanSip;
+    } else {
+        message = "unsupported projection " + projection;
+        return false;
+    }
+
+    if (!ReadNumber(values, "CRPIX1", m_CrPix[0]) || !ReadNumber(values, "CRPIX2", m_CrPix[1]) ||
+        !ReadNumber(values, "CRVAL1", m_CrVal[0]) || !ReadNumber(values, "CRVAL2", m_CrVal[1])) {
+        message = "missing CRPIX/CRVAL";
+        return false;
+    }
+
+    // CD matrix, else PC * CDELT, else CDELT with CROTA2.
+    double cd[4] = {0.0, 0.0, 0.0, 0.0};
+    const bool hasCd = ReadNumber(values, "CD1_1", cd[0]) | ReadNumber(values, "CD1_2", cd[1]) |
+                       ReadNumber(values, "CD2_1", cd[2]) | ReadNumber(values, "CD2_2", cd[3]);
+    if (!hasCd) {
+        double cdelt[2] = {0.0, 0.0};
+        if (!ReadNumber(values, "CDELT1", cdelt[0]) || !ReadNumber(values, "CDELT2", cdelt[1])) {
+            message = "missing CD / CDELT";
+            return false;
+        }
+        double pc[4] = {1.0, 0.0, 0.0, 1.0};
+        const bool hasPc = ReadNumber(values, "PC1_1", pc[0]) | ReadNumber(values, "PC1_2", pc[1]) |
+                           ReadNumber(values, "PC2_1", pc[2]) | ReadNumber(values, "PC2_2", pc[3]);
+        double crota = 0.0;
+        if (!hasPc && ReadNumber(values, "CROTA2", crota)) {
+            const double c = std::cos(crota * kDegToRad);
+            const double s = std::sin(crota * kDegToRad);
+            pc[0] = c;
+            pc[1] = -s * cdelt[1] / cdelt[0];
+            pc[2] = s * cdelt[0] / cdelt[1];
+            pc[3] = c;
+        }
+        cd[0] = cdelt[0] * pc[0];
+        cd[1] = cdelt[0] * pc[1];
+        cd[2] = cdelt[1] * pc[2];
+        cd[3] = cdelt[1] * pc[3];
+    }
+    const double det = cd[0] * cd[3] - cd[1] * cd[2];
+    if (det == 0.0 || !std::isfinite(det)) {
+        message = "singular CD matrix";
+        return false;
+    }
+    m_Cd[0][0] = cd[0];
+    m_Cd[0][1] = cd[1];
+    m_Cd[1][0] = cd[2];
+    m_Cd[1][1] = cd[3];
+    m_CdInverse[0][0] = cd[3] / det;
+    m_CdInverse[0][1] = -cd[1] / det;
+    m_CdInverse[1][0] = -cd[2] / det;
+    m_CdInverse[1][1] = cd[0] / det;
+
+    if (kind == Projection::Tpv) {
+        for (int axis = 0; axis < 2; axis++) {
+            m_Pv[axis].assign(kTpvTerms, 0.0);
+            m_Pv[axis][1] = 1.0; // identity unless given
+            for (int k = 0; k < kTpvTerms; k++) {
+                ReadNumber(values, "PV" + std::to_string(axis + 1) + "_" + std::to_string(k), m_Pv[axis][k]);
+            }
+        }
+    } else if (kind == Projection::TanSip) {
+        double aOrder = 0.0;
+        double bOrder = 0.0;
+        ReadNumber(values, "A_ORDER", aOrder);
+        ReadNumber(values, "B_ORDER", bOrder);
+        m_SipOrder = std::clamp(static_cast<int>(std::max(aOrder, bOrder)), 0, 9);
+        const int n = m_SipOrder + 1;
+        m_SipA.assign(static_cast<std::size_t>(n) * n, 0.0);
+        m_SipB.assign(static_cast<std::size_t>(n) * n, 0.0);
+        for (int p = 0; p < n; p++) {
+            for (int q = 0; p + q < n; q++) {
+                const std::string suffix = std::to_string(p) + "_" + std::to_string(q);
+                ReadNumber(values, "A_" + suffix, m_SipA[static_cast<std::size_t>(p) * n + q]);
+                ReadNumber(values, "B_" + suffix, m_SipB[static_cast<std::size_t>(p) * n + q]);
+            }
+        }
+    }
+
+    m_Projection = kind;
+    message = GetProjectionName();
+    return true;
+}
+
+Wcs Wcs::Binned(int factor) const {
+    Wcs binned(*this);
+    if (!IsValid() || factor <= 1) return binned;
+    const double f = factor;
+    // Pixel offsets scale by f: 1-based centers map as (crpix - 0.5) / f + 0.5.
+    for (int axis = 0; axis < 2; axis++) {
+        binned.m_CrPix[axis] = (m_CrPix[axis] - 0.5) / f + 0.5;
+    }
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            binned.m_Cd[i][j] = m_Cd[i][j] * f;
+            binned.m_CdInverse[i][j] = m_CdInverse[i][j] / f;
+        }
+    }
+    // SIP acts on pixel offsets before CD: A'(u, v) = A(f u, f v) / f.
+    const int n = m_SipOrder + 1;
+    for (int p = 0; p < n && !m_SipA.empty(); p++) {
+        for (int q = 0; p + q < n; q++) {
+            const double scale = std::pow(f, p + q - 1);
+            binned.m_SipA[static_cast<std::size_t>(p) * n + q] *= scale;
+            binned.m_SipB[static_cast<std::size_t>(p) * n + q] *= scale;
+        }
+    }
+    return binned;
+}
+
+Wcs Wcs::Cropped(int x0, int y0) const {
+    Wcs cropped(*this);
+    if (!IsValid()) return cropped;
+    // Distortion acts on offsets from CRPIX, which a crop leaves unchanged.
+    cropped.m_CrPix[0] -= x0;
+    cropped.m_CrPix[1] -= y0;
+    return cropped;
+}
+
+void Wcs::ApplyTpv(double x, double y, double& xi, double& eta) const {
+    // TPV term order: 1, x, y, r, x^2, xy, y^2, x^3, x^2y, xy^2, y^3, r^3, x^4 .. y^4,
+    // x^5 .. y^5, r^5, x^6 .. y^6, x^7 .. y^7, r^7 (PV_39): each odd degree ends with its
+    // radial term. The second axis swaps x and y.
+    auto evaluate = [](const std::vector<double>& pv, double a, double b) {
+        const double r = std::sqrt(a * a + b * b);
+        double powA[8];
+        double powB[8];
+        double powR[8];
+        powA[0] = powB[0] = powR[0] = 1.0;
+        for (int i = 1; i < 8; i++) {
+            powA[i] = powA[i - 1] * a;
+            powB[i] = powB[i - 1] * b;
+            powR[i] = powR[i - 1] * r;
+        }
+        double sum = pv[0];
+        int k = 1;
+        for (int degree = 1; degree <= 7; degree++) {
+            for (int j = 0; j <= degree; j++) {
+                sum += pv[k++] * powA[degree - j] * powB[j];
+            }
+            if (degree % 2 == 1) sum += pv[k++] * powR[degree];
+        }
+        return sum;
+    };
+    xi = evaluate(m_Pv[0], x, y);
+    eta = evaluate(m_Pv[1], y, x);
+}
+
+void Wcs::ApplySip(double u, double v, double& du, double& dv) const {
+    const int n = m_SipOrder + 1;
+    du = 0.0;
+    dv = 0.0;
+    double up = 1.0;
+    for (int p = 0; p < n; p++) {
+        double vq = 1.0;
+        for (int q = 0; p + q < n; q++) {
+            du += m_SipA[static_cast<std::size_t>(p) * n + q] * up * vq;
+            dv += m_SipB[static_cast<std::size_t>(p) * n + q] * up * vq;
+            vq *= v;
+        }
+        up *= u;
+    }
+}
+
+void Wcs::OffsetToIntermediate(double u, double v, double& xi, double& eta) const {
+    if (m_Projection == Projection::TanSip) {
+        double du = 0.0, dv = 0.0;
+        ApplySip(u, v, du, dv);
+        u += du;
+        v += dv;
+    }
+    const double x = m_Cd[0][0] * u + m_Cd[0][1] * v;
+    const double y = m_Cd[1][0] * u + m_Cd[1][1] * v;
+    if (m_Projection == Projection::Tpv) {
+        ApplyTpv(x, y, xi, eta);
+    } else {
+        xi = x;
+        eta = y;
+    }
+}
+
+bool Wcs::PixelToWorld(double x, double y, double& ra, double& dec) const {
+    if (!IsValid()) return false;
+    // FITS pixels are 1-based.
+    double xi = 0.0, eta = 0.0;
+    OffsetToIntermediate(x + 1.0 - m_CrPix[0], y + 1.0 - m_CrPix[1], xi, eta);
+    xi *= kDegToRad;
+    eta *= kDegToRad;
+
+    const double dec0 = m_CrVal[1] * kDegToRad;
+    const double denominator = std::cos(dec0) - eta * std::sin(dec0);
+    ra = m_CrVal[0] + std::atan2(xi, denominator) / kDegToRad;
+    dec = std::atan2(std::sin(dec0) + eta * std::cos(dec0), std::sqrt(xi * xi + denominator * denominator)) / kDegToRad;
+    ra = std::fmod(ra + 360.0, 360.0);
+    return std::isfinite(ra) && std::isfinite(dec);
+}
+
+bool Wcs::WorldToPixel(double ra, double dec, double& x, double& y) const {
+    if (!IsValid()) return false;
+    const double dec0 = m_CrVal[1] * kDegToRad;
+    const double d = dec * kDegToRad;
+    const double dra = (ra - m_CrVal[0]) * kDegToRad;
+    const double cosC = std::sin(dec0) * std::sin(d) + std::cos(dec0) * std::cos(d) * std::cos(dra);
+    if (cosC <= 0.0) return false; // other hemisphere
+    const double xi = std::cos(d) * std::sin(dra) / cosC / kDegToRad;
+    const double eta = (std::cos(dec0) * std::sin(d) - std::sin(dec0) * std::cos(d) * std::cos(dra)) / cosC / kDegToRad;
+
+    // Linear inverse, refined through the distortion when there is one.
+    double u = m_CdInverse[0][0] * xi + m_CdInverse[0][1] * eta;
+    double v = m_CdInverse[1][0] * xi + m_CdInverse[1][1] * eta;
+    if (m_Projection != Projection::Tan) {
+        auto forward = [this](double a, double b, double& fa, double& fb) { OffsetToIntermediate(a, b, fa, fb); };
+        const double pixelScale = std::sqrt(std::abs(m_Cd[0][0] * m_Cd[1][1] - m_Cd[0][1] * m_Cd[1][0]));
+        if (!SolveNewton(forward, xi, eta, 0.5, pixelScale * 1e-6, u, v)) return false;
+    }
+    x = u + m_CrPix[0] - 1.0;
+    y = v + m_CrPix[1] - 1.0;
+    return std::isfinite(x) && std::isfinite(y);
+}
@@ -0,0 +1,82 @@
+#include "ZScale.h"
+
+#include <algorithm>
+#include <cstdint>
+
+bool ZScale::ComputeFromSamples(std::vector<float>& samples, const Params& params, float& outLow, float& outHigh) {
+    if (samples.empty()) return false;
+
+    std::sort(samples.begin(), samples.end());
+    const int npix = static_cast<int>(samples.size());
+    outLow = samples.front();
+    outHigh = samples.back();
+
+    const int center = (npix - 1) / 2;
+    const double median = (npix % 2 == 1) ? samples[center] : 0.5 * (samples[center] + samples[center + 1]);
+
+    const int minPixels = std::max(params.minPixels, static_cast<int>(npix * params.maxRejectFraction));
+    // Rejections grow to a window of this many ranks in total, like astropy's
+    // convolution with a ones(ngrow) kernel in "same" mode.
+    const int grow = std::max(1, static_cast<int>(npix * 0.01));
+    const int growBefore = (grow - 1) / 2;
+    const int growAfter = grow - 1 - growBefore;
+
+    // Line fit of value against rank; outliers (and their neighbours) are rejected and
+    // the fit repeated. Rejections accumulate across iterations, as in IRAF/astropy, and
+    // the loop ends once an iteration rejects nothing new.
+    std::vector<std::uint8_t> rejected(static_cast<std::size_t>(npix), 0);
+    std::vector<std::uint8_t> outlier(static_cast<std::size_t>(npix), 0);
+    int goodPixels = npix;
+    int lastGoodPixels = npix + 1;
+    double slope = 0.0;
+    for (int iteration = 0; iteration < params.maxIterations; iteration++) {
+        if (goodPixels >= lastGoodPixels || goodPixels < minPixels) break;
+
+        double n = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+        for (int i = 0; i < npix; i++) {
+            if (rejected[i]) continue;
+            const double y = samples[i];
+            n += 1.0;
+            sx += i;
+            sy += y;
+            sxx += static_cast<double>(i) * i;
+            sxy += i * y;
+        }
+        const double denom = n * sxx - sx * sx;
+        if (denom <= 0.0) break;
+        slope = (n * sxy - sx * sy) / denom;
+        const double intercept = (sy - slope * sx) / n;
+
+        // Scatter of the residuals of the points still in the fit.
+        double sum = 0.0, sumSq = 0.0;
+        for (int i = 0; i < npix; i++) {
+            if (rejected[i]) continue;
+            const double r = samples[i] - (intercept + slope * i);
+            sum += r;
+            sumSq += r * r;
+        }
+        const double mean = sum / n;
+        const double threshold = params.rejectSigma * std::sqrt(std::max(0.0, sumSq / n - mean * mean));
+
+        for (int i = 0; i < npix; i++) {
+            const double r = samples[i] - (intercept + slope * i);
+            outlier[i] = (rejected[i] || r < -threshold || r > threshold) ? 1 : 0;
+        }
+        for (int i = 0; i < npix; i++) {
+            if (!outlier[i]) continue;
+            const int first = std::max(0, i - growBefore);
+            const int last = std::min(npix - 1, i + growAfter);
+            std::fill(rejected.begin() + first, rejected.begin() + last + 1, 1);
+        }
+
+        lastGoodPixels = goodPixels;
+        goodPixels = npix - static_cast<int>(std::count(rejected.begin(), rejected.end(), 1));
+    }
+
+    if (goodPixels >= minPixels) {
+        if (params.contrast > 0.0f) slope /= params.contrast;
+        outLow = std::max(outLow, static_cast<float>(median - (center - 1) * slope));
+        outHigh = std::min(outHigh, static_cast<float>(median + (npix - center) * slope));
+    }
+    return true;
+}
@@ -1,7 +1,119 @@
 #include "Application.h"
+#include "HeadlessBenchmark.h"
+#include "BatchRenderer.h"
+#include "FrameStacker.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <vector>
 
 int main(int argc, char** argv) {
+    // Offscreen frame-time measurement, no display needed:
+    //   --headless-bench <image> [frames=120] [width=1600] [height=900]
+    if (argc >= 3 && std::string(argv[1]) == "--headless-bench") {
+        const int frames = (argc >= 4) ? std::atoi(argv[3]) : 120;
+        const int width = (argc >= 5) ? std::atoi(argv[4]) : 1600;
+        const int height = (argc >= 6) ? std::atoi(argv[5]) : 900;
+        if (width <= 0 || height <= 0) {
+            std::cerr << "Invalid headless framebuffer size" << std::endl;
+            return -1;
+        }
+        return RunHeadlessBenchmark(argv[2], frames, width, height);
+    }
+
+    // Compare the label txt parsers:
+    //   --bench-txt-parse <txt> [iterations=5] [replicateRows=0]
+    if (argc >= 3 && std::string(argv[1]) == "--bench-txt-parse") {
+        const int iterations = (argc >= 4) ? std::atoi(argv[3]) : 5;
+        const long long rows = (argc >= 5) ? std::atoll(argv[4]) : 0;
+        return RunTxtParseBenchmark(argv[2], iterations, static_cast<std::size_t>(std::max(rows, 0LL)));
+    }
+
+    // Snapshot every target of every label txt, no display needed:
+    //   --batch-render <label-root> --out <dir> [--size WxH] [--threads N] [--roi R] [--cpu]
+    //                  [--heights display|subtract|normalize]
+    if (argc >= 3 && std::string(argv[1]) == "--batch-render") {
+        BatchRenderOptions options;
+        options.labelRoot = argv[2];
+        for (int i = 3; i < argc; i++) {
+            const std::string arg = argv[i];
+            const bool hasValue = (i + 1 < argc);
+            if (arg == "--out" && hasValue) {
+                options.outDir = argv[++i];
+            } else if (arg == "--size" && hasValue) {
+                if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) {
+                    std::cerr << "Invalid --size, expected WxH" << std::endl;
+                    return -1;
+                }
+            } else if (arg == "--threads" && hasValue) {
+                options.threads = std::atoi(argv[++i]);
+            } else if (arg == "--roi" && hasValue) {
+                options.roiRadiusPixels = std::clamp(std::atoi(argv[++i]), 50, 500);
+            } else if (arg == "--cpu") {
+                options.useCpuRasterizer = true;
+            } else if (arg == "--heights" && hasValue) {
+                const std::string mode = argv[++i];
+                if (mode == "display") {
+                    options.heightMode = ImageLoader::HeightMode::Display;
+                } else if (mode == "subtract") {
+                    options.heightMode = ImageLoader::HeightMode::BackgroundSubtracted;
+                } else if (mode == "normalize") {
+                    options.heightMode = ImageLoader::HeightMode::BackgroundNormalized;
+                } else {
+                    std::cerr << "Invalid --heights, expected display, subtract or normalize" << std::endl;
+                    return -1;
+                }
+            } else {
+                std::cerr << "Unknown batch option: " << arg << std::endl;
+                return -1;
+            }
+        }
+        if (options.outDir.empty()) {
+            std::cerr << "--batch-render requires --out <dir>" << std::endl;
+            return -1;
+        }
+        BatchRenderer batch(options);
+        return batch.Run();
+    }
+
+    // Median / sigma-clip stack of registered frames into a FITS, within a memory budget:
+    //   --stack <out.fits> <in1.fits> <in2.fits> ... [--method median|sigma] [--sigma K]
+    //           [--memory MB] [--no-match-background]
+    if (argc >= 3 && std::string(argv[1]) == "--stack") {
+        FrameStacker::Params params;
+        std::vector<std::string> inputs;
+        for (int i = 3; i < argc; i++) {
+            const std::string arg = argv[i];
+            const bool hasValue = (i + 1 < argc);
+            if (arg == "--method" && hasValue) {
+                const std::string method = argv[++i];
+                if (method == "median") {
+                    params.method = FrameStacker::Method::Median;
+                } else if (method == "sigma") {
+                    params.method = FrameStacker::Method::SigmaClip;
+                } else {
+                    std::cerr << "Invalid --method, expected median or sigma" << std::endl;
+                    return -1;
+                }
+            } else if (arg == "--sigma" && hasValue) {
+                params.clipSigma = static_cast<float>(std::max(std::atof(argv[++i]), 0.5));
+            } else if (arg == "--memory" && hasValue) {
+                params.memoryBudgetBytes = static_cast<std::size_t>(std::max(std::atoll(argv[++i]), 1LL)) << 20;
+            } else if (arg == "--no-match-background") {
+                params.matchBackground = false;
+            } else if (arg.compare(0, 2, "--") == 0) {
+                std::cerr << "Unknown stack option: " << arg << std::endl;
+                return -1;
+            } else {
+                inputs.push_back(arg);
+            }
+        }
+        FrameStacker stacker;
+        return stacker.Run(inputs, argv[2], params).ok ? 0 : -1;
+    }
+
     std::cout << "Starting GeoGebra 3D..." << std::endl;
 
     try {